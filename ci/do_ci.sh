@@ -71,7 +71,8 @@ function maybe_copy_binaries_to_directory () {
         "nighthawk_client" \
         "nighthawk_output_transform" \
         "nighthawk_service" \
-        "nighthawk_test_server"; do
+        "nighthawk_test_server" \
+        "nighthawk_trace_import"; do
         cp -vf bazel-bin/${BINARY_NAME} ${BUILD_DIR}
       done
     fi
@@ -302,6 +303,7 @@ function do_fix_docs() {
     bazel run $BAZEL_BUILD_OPTIONS //tools:update_cli_readme_documentation -- --binary bazel-bin/nighthawk_client --readme README.md --mode=fix
     bazel run $BAZEL_BUILD_OPTIONS //tools:update_cli_readme_documentation -- --binary bazel-bin/nighthawk_service --readme README.md --mode=fix
     bazel run $BAZEL_BUILD_OPTIONS //tools:update_cli_readme_documentation -- --binary bazel-bin/nighthawk_output_transform --readme README.md --mode=fix
+    bazel run $BAZEL_BUILD_OPTIONS //tools:update_cli_readme_documentation -- --binary bazel-bin/nighthawk_trace_import --readme README.md --mode=fix
     bazel run $BAZEL_BUILD_OPTIONS //tools:update_cli_readme_documentation -- --binary bazel-bin/nighthawk_test_server --readme source/server/README.md --mode=fix
 }
 
@@ -12,7 +12,7 @@ set -e
 
 DOCKER_IMAGE_PREFIX="${DOCKER_IMAGE_PREFIX:-envoyproxy/nighthawk}"
 
-BINARIES=(nighthawk_test_server nighthawk_client nighthawk_service nighthawk_output_transform nighthawk_adaptive_load_client)
+BINARIES=(nighthawk_test_server nighthawk_client nighthawk_service nighthawk_output_transform nighthawk_adaptive_load_client nighthawk_trace_import)
 BAZEL_BIN="$(bazel info -c opt bazel-bin)"
 WORKSPACE="$(bazel info workspace)"
 TMP_DIR="${WORKSPACE}/tmp-docker-build-context"
@@ -25,6 +25,12 @@ public:
    */
   virtual void terminate() PURE;
 
+  /**
+   * Called on the worker thread when execution has ended, before results are collected. Handles
+   * in-flight requests according to the configured termination semantics.
+   */
+  virtual void onExecutionEnded() PURE;
+
   /**
    * Turns latency measurement on or off.
    *
@@ -32,6 +38,23 @@ public:
    */
   virtual void setShouldMeasureLatencies(bool measure_latencies) PURE;
 
+  /**
+   * Called on the worker thread before another execution starts on a warm worker. Replaces the
+   * statistics with fresh instances of the same type, so results do not carry over between
+   * executions.
+   */
+  virtual void resetStatistics() PURE;
+
+  /**
+   * Called on the worker thread when a phase ends and another one follows. Continues with fresh
+   * statistics, so that each phase gets its own. Requests of the ended phase that are still in
+   * flight complete into the statistics of that phase.
+   *
+   * @return StatisticPtrMap the statistics of the ended phase, keyed by id. These remain owned by
+   * the client, and are valid until resetStatistics() is called.
+   */
+  virtual StatisticPtrMap retireStatistics() PURE;
+
   /**
    * Gets the statistics, keyed by id.
    * @return StatisticPtrMap A map of Statistics keyed by id.
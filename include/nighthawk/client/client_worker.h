@@ -1,11 +1,18 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
+#include "envoy/common/time.h"
 #include "envoy/stats/store.h"
 
 #include "nighthawk/client/benchmark_client.h"
+#include "nighthawk/client/factories.h"
 #include "nighthawk/common/phase.h"
 #include "nighthawk/common/statistic.h"
 #include "nighthawk/common/worker.h"
@@ -13,6 +20,25 @@
 namespace Nighthawk {
 namespace Client {
 
+/**
+ * Values observed by a worker during a reporting interval.
+ */
+struct IntervalReport {
+  // Wall clock time covered by the report.
+  std::chrono::nanoseconds duration;
+  // Values added to the statistics that track intervals, keyed by id.
+  std::map<std::string, StatisticPtr> statistics;
+  // Increments of the worker-specific counter values.
+  std::map<std::string, uint64_t> counters;
+};
+
+using IntervalReportPtr = std::unique_ptr<IntervalReport>;
+
+/**
+ * Receives interval reports. Gets passed nullptr once the worker has completed its execution.
+ */
+using IntervalReportCallback = std::function<void(IntervalReportPtr&&)>;
+
 /**
  * Interface for a threaded benchmark client worker.
  */
@@ -31,15 +57,82 @@ public:
   virtual const std::map<std::string, uint64_t>& threadLocalCounterValues() PURE;
 
   /**
-   * @return const Phase& associated to this worker.
+   * @return const Phase& associated to this worker. When a multi-phase load profile is configured,
+   * this is the first phase.
    */
   virtual const Phase& phase() const PURE;
 
+  /**
+   * @return const std::vector<PhasePtr>& the phases executed by this worker, in order of execution.
+   * Phases that were skipped because execution ended early are not included.
+   */
+  virtual const std::vector<PhasePtr>& phases() const PURE;
+
+  /**
+   * @return const std::vector<std::map<std::string, uint64_t>>& per phase, the increments of the
+   * worker-specific counter values observed during that phase. Indices line up with phases().
+   * Gets filled when the worker has completed its task, empty before that.
+   */
+  virtual const std::vector<std::map<std::string, uint64_t>>& phaseCounterValues() const PURE;
+
+  /**
+   * @return const std::vector<StatisticPtrMap>& per phase, the benchmark client statistics that
+   * track the requests of that phase, keyed by id. Indices line up with phases(). Gets filled when
+   * the worker has completed its task, empty before that.
+   */
+  virtual const std::vector<StatisticPtrMap>& phaseClientStatistics() const PURE;
+
   /**
    * Requests execution cancellation.
    */
   virtual void requestExecutionCancellation() PURE;
 
+  /**
+   * Switches the running execution over to the specified load phase at the specified time. The
+   * current phase ends at that time, and the new phase replaces any phases of the load profile that
+   * did not start yet. This keeps the connections warm, and gives the new phase its own results.
+   * Thread safe. Switches requested after the execution ended are ignored.
+   *
+   * @param load_phase the phase to switch to.
+   * @param switch_time the time at which to switch.
+   */
+  virtual void switchPhase(const nighthawk::client::LoadPhase& load_phase,
+                           const Envoy::MonotonicTime switch_time) PURE;
+
+  /**
+   * Has the worker report the values it observes at a fixed interval while executing, without
+   * interrupting the execution. Must be called before the execution starts, and applies to that
+   * and subsequent executions. The callback is invoked on the worker thread.
+   *
+   * @param report_interval the interval at which to report.
+   * @param callback receives the reports.
+   */
+  virtual void setIntervalReportCallback(const std::chrono::nanoseconds report_interval,
+                                         IntervalReportCallback callback) PURE;
+
+  /**
+   * Starts another execution on the worker once the previous one has completed. The benchmark
+   * client and its connections carry over, while phases, statistics and counter values start
+   * from scratch. Use waitForCompletion() to wait for the execution to complete.
+   *
+   * @param sequencer_factory used to create the sequencers for the execution. Must outlive it.
+   * @param termination_predicate_factory used to create the termination predicates for the
+   * execution. Must outlive it.
+   * @param load_profile optional load profile for the execution.
+   */
+  virtual void
+  startNextExecution(const SequencerFactory& sequencer_factory,
+                     const TerminationPredicateFactory& termination_predicate_factory,
+                     const absl::optional<nighthawk::client::LoadProfile>& load_profile) PURE;
+
+  /**
+   * Keeps the event loop of the worker running once the current execution has completed, until
+   * the next execution starts or the worker shuts down, so that connections are serviced in
+   * between. Call once the results of the execution have been collected, as late responses may
+   * still update its statistics.
+   */
+  virtual void dispatchUntilNextExecution() PURE;
+
   /**
    * Get additional output generated by UserDefinedOutput plugins associated with this client
    * worker.
@@ -108,6 +108,46 @@ public:
   virtual absl::optional<std::string> executionId() const PURE;
   virtual const std::vector<envoy::config::core::v3::TypedExtensionConfig>&
   userDefinedOutputPluginConfigs() const PURE;
+  // Optional multi-phase load profile. When set, it supersedes requestsPerSecond() and duration().
+  virtual const absl::optional<nighthawk::client::LoadProfile>& loadProfile() const PURE;
+  // Whether workers should draw request releases from a single shared budget.
+  virtual bool globalRateCoordination() const PURE;
+  // Number of closed-loop virtual users per worker. 0 disables closed-loop mode.
+  virtual uint32_t virtualUsers() const PURE;
+  virtual std::chrono::nanoseconds thinkTime() const PURE;
+  virtual nighthawk::client::ThinkTimeDistribution::ThinkTimeDistributionOptions
+  thinkTimeDistribution() const PURE;
+  // Seed for reproducible random sources. Unset when executions should not be reproducible.
+  virtual absl::optional<uint64_t> seed() const PURE;
+  // Path to record the release schedule to. Empty when not recording.
+  virtual std::string recordSchedule() const PURE;
+  // Path of a recorded release schedule to replay. Empty when not replaying.
+  virtual std::string replaySchedule() const PURE;
+  // What happens to in-flight requests when execution ends.
+  virtual nighthawk::client::TerminationMode::TerminationModeOptions terminationMode() const PURE;
+  // Maximum time to wait for in-flight requests in bounded drain termination mode.
+  virtual std::chrono::nanoseconds drainTimeout() const PURE;
+  // How worker threads are placed on cpus.
+  virtual nighthawk::client::CpuPinning::CpuPinningOptions cpuPinning() const PURE;
+  // Cpu lists for pinning the workers, one per worker. Empty when not explicitly pinning.
+  virtual std::vector<std::string> workerCpuSets() const PURE;
+  // Cpu list for pinning the flush worker. Empty when not pinning it.
+  virtual std::string flushWorkerCpuSet() const PURE;
+  // Source addresses for the upstream connections of the workers. Empty when not binding.
+  virtual std::vector<std::string> workerSourceAddresses() const PURE;
+  // First source port for the upstream connections of the workers. 0 when not binding.
+  virtual uint32_t workerSourcePortBase() const PURE;
+  // SO_BUSY_POLL value in microseconds for upstream sockets. 0 when not set.
+  virtual uint32_t busyPollUs() const PURE;
+  // Whether SO_INCOMING_CPU is set on upstream sockets to the cpu of the worker.
+  virtual bool incomingCpuAffinity() const PURE;
+  // Interval at which intermediate results are reported. 0 when not reporting.
+  virtual std::chrono::nanoseconds reportInterval() const PURE;
+  // Event loop utilization percentage above which workers are flagged as overloaded. 0 when
+  // workers do not monitor their event loop.
+  virtual uint32_t eventLoopUtilizationThreshold() const PURE;
+  // Whether the workers share a single stream to the remote request source.
+  virtual bool requestSourceSharedStream() const PURE;
 
   /**
    * Converts an Options instance to an equivalent CommandLineOptions instance in terms of option
@@ -36,6 +36,28 @@ public:
       const std::chrono::nanoseconds execution_duration,
       const absl::optional<Envoy::SystemTime>& first_acquisition_time,
       const std::vector<nighthawk::client::UserDefinedOutput>& user_defined_output_results) PURE;
+  /**
+   * Records the cpus a worker thread was pinned to.
+   *
+   * @param name name of the worker. E.g. worker_1.
+   * @param cpus the cpus the worker was pinned to.
+   * @param numa_node the NUMA node holding all of the cpus, if known.
+   */
+  virtual void addWorkerPlacement(absl::string_view name, const std::vector<uint32_t>& cpus,
+                                  const absl::optional<uint32_t>& numa_node) PURE;
+  /**
+   * Records how long the phases of starting up the execution took.
+   *
+   * @param startup_timings the startup timings.
+   */
+  virtual void setStartupTimings(const nighthawk::client::StartupTimings& startup_timings) PURE;
+  /**
+   * Records the calibration that picked the number of workers.
+   *
+   * @param calibration the calibration outcome.
+   */
+  virtual void
+  setConcurrencyCalibration(const nighthawk::client::ConcurrencyCalibration& calibration) PURE;
   /**
    * Directly sets the output value.
    *
@@ -1,10 +1,22 @@
 #pragma once
 
+#include <functional>
+
+#include "nighthawk/client/options.h"
 #include "nighthawk/client/output_collector.h"
 
+#include "api/client/output.pb.h"
+
+#include "absl/status/status.h"
+
 namespace Nighthawk {
 namespace Client {
 
+/**
+ * Receives intermediate output.
+ */
+using IntervalOutputCallback = std::function<void(const nighthawk::client::Output&)>;
+
 /**
  * Process context is shared between the CLI and grpc service. It is capable of executing
  * a full Nighthawk test run.
@@ -19,6 +31,38 @@ public:
    */
   virtual bool run(OutputCollector& collector) PURE;
 
+  /**
+   * Runs another execution on the workers of an earlier run(), which stay warm along with their
+   * connections. Only the pacing, termination and statistics are reconfigured.
+   *
+   * @param options options for the execution. The workers keep using what was created from them
+   * until their next execution starts, so they must stay alive until the next call to runWarm()
+   * returns, or until the process is shut down.
+   * @param collector used to transform output into the desired format.
+   * @return bool true iff execution was successfull.
+   */
+  virtual bool runWarm(const Options& options, OutputCollector& collector) PURE;
+
+  /**
+   * Switches the running execution over to another load phase, at a moment shortly after the
+   * call that is common to all workers. The connections stay warm, and the phases before and after
+   * the switch are reported separately, latencies included.
+   *
+   * @param load_phase the phase to switch to.
+   * @return absl::Status indicating if the switch was requested.
+   */
+  virtual absl::Status switchPhase(const nighthawk::client::LoadPhase& load_phase) PURE;
+
+  /**
+   * Has executions with a report interval stream intermediate output, which holds the counter
+   * increments and latencies observed since the previous intermediate output. Must be called
+   * before the execution starts.
+   *
+   * @param callback receives the intermediate output. Invoked on the thread that runs the
+   * execution, never on worker threads.
+   */
+  virtual void setIntervalOutputCallback(IntervalOutputCallback callback) PURE;
+
   /**
    * Shuts down the worker. Mandatory call before destructing.
    */
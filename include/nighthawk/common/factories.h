@@ -14,6 +14,10 @@
 #include "nighthawk/common/statistic.h"
 #include "nighthawk/common/termination_predicate.h"
 
+#include "api/client/options.pb.h"
+
+#include "absl/types/optional.h"
+
 namespace Nighthawk {
 
 class SequencerFactory {
@@ -23,7 +27,50 @@ public:
                               const SequencerTarget& sequencer_target,
                               TerminationPredicatePtr&& termination_predicate,
                               Envoy::Stats::Scope& scope,
-                              const Envoy::MonotonicTime scheduled_starting_time) const PURE;
+                              const Envoy::MonotonicTime scheduled_starting_time,
+                              const int worker_id) const PURE;
+
+  /**
+   * Creates a sequencer which paces according to the rate shape of a single load profile phase.
+   *
+   * @param time_source time source used by the sequencer and its rate limiter.
+   * @param dispatcher dispatcher of the worker that will run the sequencer.
+   * @param sequencer_target target that will be called for each release.
+   * @param termination_predicate predicate which determines when the phase ends.
+   * @param scope scope that sequencer statistics will be associated to.
+   * @param load_phase specification of the phase.
+   * @param scheduled_starting_time optional point in time at which pacing should start. When not
+   * set, pacing starts upon the first acquisition attempt.
+   * @param worker_id number of the worker that will run the sequencer.
+   * @return SequencerPtr the sequencer.
+   */
+  virtual SequencerPtr
+  createForLoadPhase(Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+                     const SequencerTarget& sequencer_target,
+                     TerminationPredicatePtr&& termination_predicate, Envoy::Stats::Scope& scope,
+                     const nighthawk::client::LoadPhase& load_phase,
+                     const absl::optional<Envoy::MonotonicTime> scheduled_starting_time,
+                     const int worker_id) const PURE;
+
+  /**
+   * Creates a sequencer which sends requests at the times specified by the request source, rather
+   * than pacing them at a rate.
+   *
+   * @param time_source time source used by the sequencer and its rate limiter.
+   * @param dispatcher dispatcher of the worker that will run the sequencer.
+   * @param sequencer_target target that will be called for each release.
+   * @param termination_predicate predicate which determines when the sequencer is done.
+   * @param scope scope that sequencer statistics will be associated to.
+   * @param timing timing of the requests, which must outlive the sequencer.
+   * @param scheduled_starting_time point in time which the offsets of the timing are relative to.
+   * @param worker_id number of the worker that will run the sequencer.
+   * @return SequencerPtr the sequencer.
+   */
+  virtual SequencerPtr createForReleaseTiming(
+      Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+      const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
+      Envoy::Stats::Scope& scope, RequestReleaseTiming& timing,
+      const Envoy::MonotonicTime scheduled_starting_time, const int worker_id) const PURE;
 };
 
 class StatisticFactory {
@@ -35,9 +82,20 @@ public:
 class RequestSourceFactory {
 public:
   virtual ~RequestSourceFactory() = default;
+  /**
+   * @param cluster_manager cluster manager used by remote request sources.
+   * @param dispatcher dispatcher of the worker that will use the request source.
+   * @param scope scope that request source statistics will be associated to.
+   * @param service_cluster_name name of the cluster of the remote request source.
+   * @param worker_id number of the worker that will use the request source. Request sources that
+   * draw random numbers derive their seed from it, so that each worker gets a reproducible
+   * sequence of its own.
+   * @return RequestSourcePtr the request source.
+   */
   virtual RequestSourcePtr create(const Envoy::Upstream::ClusterManagerPtr& cluster_manager,
                                   Envoy::Event::Dispatcher& dispatcher, Envoy::Stats::Scope& scope,
-                                  absl::string_view service_cluster_name) const PURE;
+                                  absl::string_view service_cluster_name,
+                                  const int worker_id) const PURE;
 };
 
 class TerminationPredicateFactory {
@@ -46,6 +104,21 @@ public:
   virtual TerminationPredicatePtr
   create(Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
          const Envoy::MonotonicTime scheduled_starting_time) const PURE;
+
+  /**
+   * Creates the termination predicate chain for a single load profile phase. The chain is the
+   * same as the one yielded by create(), except that the duration of the phase is used.
+   *
+   * @param time_source time source used to evaluate the phase duration.
+   * @param scope scope used to look up the counters referenced by predicates.
+   * @param load_phase specification of the phase.
+   * @param starting_time point in time at which the phase starts.
+   * @return TerminationPredicatePtr the root of the predicate chain.
+   */
+  virtual TerminationPredicatePtr
+  createForLoadPhase(Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
+                     const nighthawk::client::LoadPhase& load_phase,
+                     const Envoy::MonotonicTime starting_time) const PURE;
 };
 
 /**
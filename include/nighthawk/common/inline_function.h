@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "external/envoy/source/common/common/assert.h"
+
+namespace Nighthawk {
+
+template <class Signature, size_t InlineCapacity = 48> class InlineFunction;
+
+/**
+ * Copyable, type-erased callable which stores callables of up to InlineCapacity bytes in place,
+ * like std::function, but with a buffer that is large enough for the lambdas on the request path.
+ * Constructing, copying and destroying such callables never allocates. Larger callables are
+ * stored on the heap, which can be checked for up front via storesInline().
+ */
+template <class R, class... Args, size_t InlineCapacity>
+class InlineFunction<R(Args...), InlineCapacity> {
+public:
+  InlineFunction() = default;
+  InlineFunction(std::nullptr_t) {}
+
+  template <class F,
+            class = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineFunction>::value &&
+                                     std::is_invocable_r<R, std::decay_t<F>&, Args...>::value>>
+  InlineFunction(F&& f) {
+    using Callable = std::decay_t<F>;
+    if constexpr (storesInline<Callable>()) {
+      new (storage_) Callable(std::forward<F>(f));
+      ops_ = &InlineOps<Callable>::ops;
+    } else {
+      *reinterpret_cast<Callable**>(storage_) = new Callable(std::forward<F>(f));
+      ops_ = &HeapOps<Callable>::ops;
+    }
+  }
+
+  InlineFunction(const InlineFunction& other) : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->copy(other.storage_, storage_);
+    }
+  }
+
+  InlineFunction(InlineFunction&& other) noexcept : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->move(other.storage_, storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  InlineFunction& operator=(const InlineFunction& other) {
+    if (this != &other) {
+      InlineFunction copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(InlineFunction&& other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other.ops_ != nullptr) {
+        other.ops_->move(other.storage_, storage_);
+        ops_ = other.ops_;
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(std::nullptr_t) {
+    reset();
+    return *this;
+  }
+
+  ~InlineFunction() { reset(); }
+
+  R operator()(Args... args) const {
+    ASSERT(ops_ != nullptr, "Invoking an empty InlineFunction");
+    return ops_->invoke(storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+  friend bool operator==(const InlineFunction& f, std::nullptr_t) { return !f; }
+  friend bool operator!=(const InlineFunction& f, std::nullptr_t) { return static_cast<bool>(f); }
+
+  /**
+   * @return true when callables of type F are stored in place, without allocating.
+   */
+  template <class F> static constexpr bool storesInline() {
+    return sizeof(F) <= InlineCapacity && alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<F>::value;
+  }
+
+private:
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    void (*copy)(const void* from, void* to);
+    void (*move)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template <class F> struct InlineOps {
+    static F& get(void* storage) { return *std::launder(reinterpret_cast<F*>(storage)); }
+    static R invoke(void* storage, Args&&... args) {
+      return get(storage)(std::forward<Args>(args)...);
+    }
+    static void copy(const void* from, void* to) {
+      new (to) F(get(const_cast<void*>(from)));
+    }
+    static void move(void* from, void* to) {
+      new (to) F(std::move(get(from)));
+      get(from).~F();
+    }
+    static void destroy(void* storage) { get(storage).~F(); }
+    static constexpr Ops ops{&invoke, &copy, &move, &destroy};
+  };
+
+  template <class F> struct HeapOps {
+    static F*& get(void* storage) { return *reinterpret_cast<F**>(storage); }
+    static R invoke(void* storage, Args&&... args) {
+      return (*get(storage))(std::forward<Args>(args)...);
+    }
+    static void copy(const void* from, void* to) {
+      get(to) = new F(*get(const_cast<void*>(from)));
+    }
+    static void move(void* from, void* to) { get(to) = get(from); }
+    static void destroy(void* storage) { delete get(storage); }
+    static constexpr Ops ops{&invoke, &copy, &move, &destroy};
+  };
+
+  void reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) mutable unsigned char storage_[InlineCapacity];
+  const Ops* ops_{nullptr};
+};
+
+} // namespace Nighthawk
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <functional>
+#include "nighthawk/common/inline_function.h"
 
 namespace Nighthawk {
 
@@ -9,6 +9,8 @@ namespace Nighthawk {
  * and false when it was not (e.g. no connection could be made).
  * Success indicates whether the final status of a flow should be considered
  * a success, and is meaningful only when done equals true.
+ * One of these is created for every request, so it stores the callables used on the request
+ * path in place instead of allocating.
  */
-using OperationCallback = std::function<void(bool done, bool success)>;
+using OperationCallback = InlineFunction<void(bool done, bool success)>;
 } // namespace Nighthawk
@@ -6,6 +6,8 @@
 #include "envoy/common/pure.h"
 #include "envoy/common/time.h"
 
+#include "nighthawk/common/statistic.h"
+
 #include "absl/types/optional.h"
 
 namespace Nighthawk {
@@ -44,6 +46,11 @@ public:
    * rate limiter implementations to compute acquisition rate.
    */
   virtual std::chrono::nanoseconds elapsed() PURE;
+
+  /**
+   * @return StatisticPtrMap statistics tracked by the rate limiter, keyed by id.
+   */
+  virtual StatisticPtrMap statistics() const { return {}; }
 };
 
 using RateLimiterPtr = std::unique_ptr<RateLimiter>;
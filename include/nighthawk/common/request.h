@@ -1,12 +1,27 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <string>
 
 #include "envoy/http/header_map.h"
 
+#include "absl/types/optional.h"
+
 namespace Nighthawk {
 
 using HeaderMapPtr = std::shared_ptr<const Envoy::Http::RequestHeaderMap>;
+using BodyPtr = std::shared_ptr<const std::string>;
+
+/**
+ * Expectations about the response to a request, verified when the response completes.
+ */
+struct ResponseExpectations {
+  // The expected response status code.
+  absl::optional<uint32_t> response_code;
+  // The expected size of the response body in bytes.
+  absl::optional<uint64_t> content_length;
+};
 
 /**
  * Defines the specifics of requests to be send by the load generator, as well as
@@ -20,8 +35,24 @@ public:
    * @return HeaderMapPtr shared pointer to a request header specification.
    */
   virtual HeaderMapPtr header() const PURE;
-  virtual const std::string& body() const PURE;
-  // TODO(oschaaf): expectations
+
+  /**
+   * @return BodyPtr shared pointer to the request body, nullptr when the request has none. Request
+   * sources hand out the same body for many requests, so that requests don't copy it.
+   */
+  virtual BodyPtr body() const PURE;
+
+  /**
+   * @return uint32_t the class of the request, which indexes the names returned by
+   * RequestSource::requestClasses() of the request source that produced it.
+   */
+  virtual uint32_t requestClass() const { return 0; }
+
+  /**
+   * @return absl::optional<ResponseExpectations> expectations about the response, which are
+   * verified on completion, or absl::nullopt when the response isn't verified.
+   */
+  virtual absl::optional<ResponseExpectations> expectations() const { return absl::nullopt; }
 };
 
 using RequestPtr = std::unique_ptr<Request>;
@@ -1,14 +1,40 @@
 #pragma once
 
-#include <functional>
+#include <chrono>
+#include <string>
+#include <vector>
 
 #include "envoy/http/header_map.h"
 
+#include "nighthawk/common/inline_function.h"
 #include "nighthawk/common/request.h"
+#include "nighthawk/common/statistic.h"
+
+#include "absl/types/optional.h"
 
 namespace Nighthawk {
 
-using RequestGenerator = std::function<RequestPtr()>;
+/**
+ * Yields the next request specifier, or nullptr when there is none. Called for every request, so
+ * the callables implementing it are stored in place.
+ */
+using RequestGenerator = InlineFunction<RequestPtr()>;
+
+/**
+ * Timing of the requests of a request source that replays requests at recorded times, rather than
+ * leaving their pacing to the rate limiter.
+ */
+class RequestReleaseTiming {
+public:
+  virtual ~RequestReleaseTiming() = default;
+
+  /**
+   * @return absl::optional<std::chrono::nanoseconds> the offset from the start of the execution at
+   * which the next request yielded by the RequestGenerator should be sent, or absl::nullopt when
+   * there are no requests left. Returns the same offset until that request has been yielded.
+   */
+  virtual absl::optional<std::chrono::nanoseconds> nextReleaseOffset() PURE;
+};
 
 /**
  * Represents a request source which yields request-specifiers.
@@ -29,6 +55,26 @@ public:
    * has been done and just before the worker gets destroyed.
    */
   virtual void destroyOnThread() PURE;
+
+  /**
+   * @return RequestReleaseTiming* the timing the requests should be sent with, or nullptr when the
+   * rate limiter paces them. Owned by the request source.
+   */
+  virtual RequestReleaseTiming* releaseTiming() { return nullptr; }
+
+  /**
+   * @return std::vector<std::string> names of the classes that the requests yielded by this source
+   * belong to, indexed by Request::requestClass(), so that latencies can be broken down per class.
+   * Empty when requests are not classified. Must be the same for the request sources of all
+   * workers, and known before any request is yielded.
+   */
+  virtual std::vector<std::string> requestClasses() const { return {}; }
+
+  /**
+   * @return StatisticPtrMap statistics tracked by the request source, keyed by id. Must hold the
+   * same ids for the request sources of all workers, so that they can be merged.
+   */
+  virtual StatisticPtrMap statistics() const { return {}; }
 };
 
 using RequestSourcePtr = std::unique_ptr<RequestSource>;
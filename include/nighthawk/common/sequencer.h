@@ -1,6 +1,6 @@
 #pragma once
 
-#include <functional>
+#include <chrono>
 #include <memory>
 
 #include "envoy/common/pure.h"
@@ -11,7 +11,11 @@
 
 namespace Nighthawk {
 
-using SequencerTarget = std::function<bool(OperationCallback)>;
+/**
+ * Called by the sequencer to start a unit of work. Returns false when the work could not be
+ * started. Called for every request, so the callables implementing it are stored in place.
+ */
+using SequencerTarget = InlineFunction<bool(OperationCallback)>;
 
 /**
  * Abstract Sequencer interface.
@@ -45,6 +49,19 @@ public:
    */
   virtual double completionsPerSecond() const PURE;
 
+  /**
+   * @return std::chrono::nanoseconds time spent pacing: evaluating termination predicates,
+   * acquiring from the rate limiter, and initiating calls to the target. Passes over the rate
+   * limiter that did not initiate any calls are accounted for in idleDuration() instead.
+   */
+  virtual std::chrono::nanoseconds pacingDuration() const PURE;
+
+  /**
+   * @return std::chrono::nanoseconds time spent in passes over the rate limiter that did not
+   * initiate any calls, including the time spent idling as per the idle strategy.
+   */
+  virtual std::chrono::nanoseconds idleDuration() const PURE;
+
   /**
    * Gets the statistics, keyed by id.
    *
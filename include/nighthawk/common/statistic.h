@@ -84,6 +84,15 @@ public:
    */
   virtual bool resistsCatastrophicCancellation() const { return false; }
 
+  /**
+   * Hands out the values added since the previous call, for statistics that track those next to
+   * the values they report. This does not affect what the statistic itself reports. Must be called
+   * from the thread that adds values.
+   * @return StatisticPtr the values added since the previous call, or nullptr when the statistic
+   * does not track intervals.
+   */
+  virtual StatisticPtr takeInterval() const { return nullptr; }
+
   /**
    * @return std::string Gets a string representation of the statistic as a std::string.
    */
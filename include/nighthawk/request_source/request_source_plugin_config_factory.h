@@ -34,6 +34,21 @@ public:
   virtual RequestSourcePtr createRequestSourcePlugin(const Envoy::Protobuf::Message& typed_config,
                                                      Envoy::Api::Api& api,
                                                      Envoy::Http::RequestHeaderMapPtr header) PURE;
+
+  // Instantiates the specific RequestSourcePlugin class for use by a single worker. Plugins that
+  // draw random numbers override this to derive their seed from |worker_id|, so that each worker
+  // gets a sequence of its own which does not depend on the order in which workers are created.
+  // The default ignores |worker_id|.
+  //
+  // @param worker_id number of the worker that will use the request source.
+  //
+  // See createRequestSourcePlugin() for the other parameters, the return value and exceptions.
+  virtual RequestSourcePtr
+  createRequestSourcePluginForWorker(const Envoy::Protobuf::Message& typed_config,
+                                     Envoy::Api::Api& api, Envoy::Http::RequestHeaderMapPtr header,
+                                     const uint32_t /* worker_id */) {
+    return createRequestSourcePlugin(typed_config, api, std::move(header));
+  }
 };
 
 } // namespace Nighthawk
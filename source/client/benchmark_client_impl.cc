@@ -1,5 +1,7 @@
 #include "source/client/benchmark_client_impl.h"
 
+#include <algorithm>
+
 #include "envoy/event/dispatcher.h"
 #include "envoy/thread_local/thread_local.h"
 
@@ -14,6 +16,7 @@
 #include "source/client/stream_decoder.h"
 
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 
 using namespace std::chrono_literals;
@@ -110,32 +113,170 @@ BenchmarkClientHttpImpl::BenchmarkClientHttpImpl(
 }
 
 void BenchmarkClientHttpImpl::terminate() {
+  if (termination_mode_ == nighthawk::client::TerminationMode::BOUNDED_DRAIN ||
+      termination_mode_ == nighthawk::client::TerminationMode::HARD_CUT) {
+    // In-flight requests have been drained or reset in onExecutionEnded().
+    return;
+  }
+  // We don't report what happens after this call in the output, but latencies may still be
+  // reported via callbacks. This may happen after a long time (60s), which HdrHistogram can't
+  // track the way we configure it today, as that exceeds the max that it can record.
+  // No harm is done, but it does result in log lines warning about it. Avoid that, by
+  // disabling latency measurement here.
+  setShouldMeasureLatencies(false);
+  drain(timeout_);
+}
+
+void BenchmarkClientHttpImpl::onExecutionEnded() {
+  switch (termination_mode_) {
+  case nighthawk::client::TerminationMode::BOUNDED_DRAIN:
+    setShouldMeasureLatencies(false);
+    // Always reported in this mode, so that the statistics of all workers line up when merged.
+    drained_response_statistic_ = statistic_.response_statistic->createNewInstanceOfSameType();
+    drained_response_statistic_->setId("benchmark_http_client.drained_request_to_response");
+    if (!in_flight_decoders_.empty()) {
+      response_statistic_at_drain_start_ =
+          statistic_.response_statistic->createNewInstanceOfSameType()->combine(
+              *statistic_.response_statistic);
+      response_statistic_at_drain_start_->setId(statistic_.response_statistic->id());
+      for (const StatisticPtr& statistic : request_class_statistics_) {
+        StatisticPtr snapshot = statistic->createNewInstanceOfSameType()->combine(*statistic);
+        snapshot->setId(statistic->id());
+        request_class_statistics_at_drain_start_.push_back(std::move(snapshot));
+      }
+      drainInFlightRequests();
+    }
+    abandonInFlightRequests();
+    break;
+  case nighthawk::client::TerminationMode::HARD_CUT:
+    setShouldMeasureLatencies(false);
+    abandonInFlightRequests();
+    break;
+  default:
+    // Draining happens in terminate(), after the results have been collected.
+    break;
+  }
+  decoder_arena_->startEpoch();
+}
+
+void BenchmarkClientHttpImpl::resetStatistics() {
+  if (requests_initiated_ == requests_completed_) {
+    retired_statistics_.clear();
+  }
+  retireStatistics();
+  drained_response_statistic_ = nullptr;
+  response_statistic_at_drain_start_ = nullptr;
+  request_class_statistics_at_drain_start_.clear();
+}
+
+StatisticPtrMap BenchmarkClientHttpImpl::retireStatistics() {
+  StatisticPtrMap retired = statistics();
+  for (StatisticPtr* statistic :
+       {&statistic_.connect_statistic, &statistic_.response_statistic,
+        &statistic_.response_header_size_statistic, &statistic_.response_body_size_statistic,
+        &statistic_.latency_1xx_statistic, &statistic_.latency_2xx_statistic,
+        &statistic_.latency_3xx_statistic, &statistic_.latency_4xx_statistic,
+        &statistic_.latency_5xx_statistic, &statistic_.latency_xxx_statistic,
+        &statistic_.origin_latency_statistic}) {
+    StatisticPtr fresh = (*statistic)->createNewInstanceOfSameType();
+    fresh->setId((*statistic)->id());
+    retired_statistics_.push_back(std::move(*statistic));
+    *statistic = std::move(fresh);
+  }
+  for (StatisticPtr& statistic : request_class_statistics_) {
+    StatisticPtr fresh = statistic->createNewInstanceOfSameType();
+    fresh->setId(statistic->id());
+    retired_statistics_.push_back(std::move(statistic));
+    statistic = std::move(fresh);
+  }
+  return retired;
+}
+
+void BenchmarkClientHttpImpl::setRequestClasses(const std::vector<std::string>& request_classes) {
+  request_class_statistics_.clear();
+  for (uint32_t i = 0; i < request_classes.size() && i < kMaxRequestClasses; i++) {
+    const bool folds_remaining_classes =
+        i == kMaxRequestClasses - 1 && request_classes.size() > kMaxRequestClasses;
+    StatisticPtr statistic = statistic_.response_statistic->createNewInstanceOfSameType();
+    statistic->setId(absl::StrCat("benchmark_http_client.request_class.",
+                                  folds_remaining_classes ? "other" : request_classes[i]));
+    request_class_statistics_.push_back(std::move(statistic));
+  }
+}
+
+void BenchmarkClientHttpImpl::drain(const std::chrono::milliseconds timeout) {
   absl::optional<Envoy::Upstream::HttpPoolData> pool_data = pool();
   if (pool_data.has_value() && pool_data.value().hasActiveConnections()) {
-    // We don't report what happens after this call in the output, but latencies may still be
-    // reported via callbacks. This may happen after a long time (60s), which HdrHistogram can't
-    // track the way we configure it today, as that exceeds the max that it can record.
-    // No harm is done, but it does result in log lines warning about it. Avoid that, by
-    // disabling latency measurement here.
-    setShouldMeasureLatencies(false);
-    pool_data.value().addIdleCallback([this]() -> void {
-      drain_timer_->disableTimer();
-      dispatcher_.exit();
-    });
+    // The pool keeps idle callbacks for as long as it lives, so only one is ever added. It only
+    // acts while we wait for the pool below.
+    if (!pool_idle_callback_added_) {
+      pool_idle_callback_added_ = true;
+      pool_data.value().addIdleCallback([this]() -> void {
+        if (waiting_for_idle_pool_) {
+          drain_timer_->disableTimer();
+          dispatcher_.exit();
+        }
+      });
+    }
     // Set up a timer with a callback which caps the time we wait for the pool to drain.
     drain_timer_ = dispatcher_.createTimer([this]() -> void {
       ENVOY_LOG(info, "Wait for the connection pool drain timed out, proceeding to hard shutdown.");
       dispatcher_.exit();
     });
-    drain_timer_->enableTimer(timeout_);
+    drain_timer_->enableTimer(timeout);
+    waiting_for_idle_pool_ = true;
     dispatcher_.run(Envoy::Event::Dispatcher::RunType::RunUntilExit);
+    waiting_for_idle_pool_ = false;
+  }
+}
+
+void BenchmarkClientHttpImpl::drainInFlightRequests() {
+  if (in_flight_decoders_.empty()) {
+    return;
+  }
+  if (bounded_drain_timer_ == nullptr) {
+    bounded_drain_timer_ = dispatcher_.createTimer([this]() -> void {
+      ENVOY_LOG(info, "Bounded drain timed out, abandoning the requests that are still in flight.");
+      dispatcher_.exit();
+    });
+  }
+  bounded_drain_timer_->enableTimer(
+      std::chrono::duration_cast<std::chrono::milliseconds>(drain_timeout_));
+  // Completions exit the dispatcher once the last in-flight request is done, see
+  // onInFlightRequestDone().
+  draining_ = true;
+  dispatcher_.run(Envoy::Event::Dispatcher::RunType::RunUntilExit);
+  draining_ = false;
+  bounded_drain_timer_->disableTimer();
+}
+
+void BenchmarkClientHttpImpl::onInFlightRequestDone() {
+  if (draining_ && in_flight_decoders_.empty()) {
+    dispatcher_.exit();
+  }
+}
+
+void BenchmarkClientHttpImpl::abandonInFlightRequests() {
+  benchmark_client_counters_.requests_abandoned_at_termination_.add(requests_initiated_ -
+                                                                     requests_completed_);
+  // Reset the streams right away, so that late responses can't end up in the counters and
+  // statistics of a later execution. Their completions aren't counted as stream resets.
+  abandoning_in_flight_requests_ = true;
+  while (!in_flight_decoders_.empty()) {
+    in_flight_decoders_.front()->resetStream();
   }
+  abandoning_in_flight_requests_ = false;
 }
 
 StatisticPtrMap BenchmarkClientHttpImpl::statistics() const {
   StatisticPtrMap statistics;
   statistics[statistic_.connect_statistic->id()] = statistic_.connect_statistic.get();
-  statistics[statistic_.response_statistic->id()] = statistic_.response_statistic.get();
+  statistics[statistic_.response_statistic->id()] = response_statistic_at_drain_start_ != nullptr
+                                                        ? response_statistic_at_drain_start_.get()
+                                                        : statistic_.response_statistic.get();
+  if (drained_response_statistic_ != nullptr) {
+    statistics[drained_response_statistic_->id()] = drained_response_statistic_.get();
+  }
   statistics[statistic_.response_header_size_statistic->id()] =
       statistic_.response_header_size_statistic.get();
   statistics[statistic_.response_body_size_statistic->id()] =
@@ -147,6 +288,12 @@ StatisticPtrMap BenchmarkClientHttpImpl::statistics() const {
   statistics[statistic_.latency_5xx_statistic->id()] = statistic_.latency_5xx_statistic.get();
   statistics[statistic_.latency_xxx_statistic->id()] = statistic_.latency_xxx_statistic.get();
   statistics[statistic_.origin_latency_statistic->id()] = statistic_.origin_latency_statistic.get();
+  for (uint32_t i = 0; i < request_class_statistics_.size(); i++) {
+    const Statistic* statistic = request_class_statistics_at_drain_start_.empty()
+                                     ? request_class_statistics_[i].get()
+                                     : request_class_statistics_at_drain_start_[i].get();
+    statistics[statistic->id()] = statistic;
+  }
   return statistics;
 };
 
@@ -187,16 +334,30 @@ bool BenchmarkClientHttpImpl::tryStartRequest(CompletionCallback caller_completi
     }
   }
 
-  auto stream_decoder = new StreamDecoder(
+  // Classes beyond the last statistic are folded into it when there are too many of them.
+  const uint32_t request_class =
+      std::min<uint32_t>(request->requestClass(), kMaxRequestClasses - 1);
+  Statistic* request_class_statistic = request_class < request_class_statistics_.size()
+                                           ? request_class_statistics_[request_class].get()
+                                           : nullptr;
+
+  auto stream_decoder = new (*decoder_arena_) StreamDecoder(
       dispatcher_, api_.timeSource(), *this, std::move(caller_completion_callback),
       *statistic_.connect_statistic, *statistic_.response_statistic,
       *statistic_.response_header_size_statistic, *statistic_.response_body_size_statistic,
       *statistic_.origin_latency_statistic, request->header(), request->body(),
-      shouldMeasureLatencies(), content_length, generator_, tracer_, latency_response_header_name_);
+      shouldMeasureLatencies(), content_length, *generator_, tracer_,
+      latency_response_header_name_, request_class_statistic, request->expectations());
   requests_initiated_++;
-  pool_data.value().newStream(*stream_decoder, *stream_decoder,
-                              {/*can_send_early_data_=*/false,
-                               /*can_use_http3_=*/true});
+  stream_decoder->track(in_flight_decoders_);
+  Envoy::Http::ConnectionPool::Cancellable* pool_handle =
+      pool_data.value().newStream(*stream_decoder, *stream_decoder,
+                                  {/*can_send_early_data_=*/false,
+                                   /*can_use_http3_=*/true});
+  // Without a handle, the decoder may have been called back and be gone already.
+  if (pool_handle != nullptr) {
+    stream_decoder->setPoolHandle(pool_handle);
+  }
   return true;
 }
 
@@ -204,7 +365,9 @@ void BenchmarkClientHttpImpl::onComplete(bool success,
                                          const Envoy::Http::ResponseHeaderMap& headers) {
   requests_completed_++;
   if (!success) {
-    benchmark_client_counters_.stream_resets_.inc();
+    if (!abandoning_in_flight_requests_) {
+      benchmark_client_counters_.stream_resets_.inc();
+    }
   } else {
     ASSERT(headers.Status());
     const int64_t status = Envoy::Http::Utility::getResponseStatus(headers);
@@ -229,6 +392,7 @@ void BenchmarkClientHttpImpl::onComplete(bool success,
       benchmark_client_counters_.user_defined_plugin_handle_headers_failure_.inc();
     }
   }
+  onInFlightRequestDone();
 }
 
 void BenchmarkClientHttpImpl::handleResponseData(const Envoy::Buffer::Instance& response_data) {
@@ -240,6 +404,17 @@ void BenchmarkClientHttpImpl::handleResponseData(const Envoy::Buffer::Instance&
   }
 }
 
+void BenchmarkClientHttpImpl::onExpectationMismatch(const ExpectationMismatch mismatch) {
+  switch (mismatch) {
+  case ExpectationMismatch::ResponseCode:
+    benchmark_client_counters_.expectation_response_code_mismatch_.inc();
+    break;
+  case ExpectationMismatch::ContentLength:
+    benchmark_client_counters_.expectation_content_length_mismatch_.inc();
+    break;
+  }
+}
+
 void BenchmarkClientHttpImpl::onPoolFailure(Envoy::Http::ConnectionPool::PoolFailureReason reason) {
   switch (reason) {
   case Envoy::Http::ConnectionPool::PoolFailureReason::Overflow:
@@ -254,10 +429,15 @@ void BenchmarkClientHttpImpl::onPoolFailure(Envoy::Http::ConnectionPool::PoolFai
   default:
     PANIC("not reached");
   }
+  onInFlightRequestDone();
 }
 
 void BenchmarkClientHttpImpl::exportLatency(const uint32_t response_code,
                                             const uint64_t latency_ns) {
+  if (draining_) {
+    drained_response_statistic_->addValue(latency_ns);
+    return;
+  }
   if (response_code > 99 && response_code <= 199) {
     statistic_.latency_1xx_statistic->addValue(latency_ns);
   } else if (response_code > 199 && response_code <= 299) {
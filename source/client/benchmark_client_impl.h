@@ -24,6 +24,7 @@
 #include "api/client/options.pb.h"
 
 #include "source/client/stream_decoder.h"
+#include "source/common/slab_arena.h"
 #include "source/common/statistic_impl.h"
 
 namespace Nighthawk {
@@ -42,7 +43,10 @@ using namespace std::chrono_literals;
   COUNTER(pool_overflow)                                                                           \
   COUNTER(pool_connection_failure)                                                                 \
   COUNTER(user_defined_plugin_handle_headers_failure)                                              \
-  COUNTER(user_defined_plugin_handle_data_failure)
+  COUNTER(user_defined_plugin_handle_data_failure)                                                 \
+  COUNTER(requests_abandoned_at_termination)                                                       \
+  COUNTER(expectation_response_code_mismatch)                                                      \
+  COUNTER(expectation_content_length_mismatch)
 
 // For counter metrics, Nighthawk use Envoy Counter directly. For histogram metrics, Nighthawk uses
 // its own Statistic instead of Envoy Histogram. Here BenchmarkClientCounters contains only counters
@@ -104,6 +108,10 @@ class BenchmarkClientHttpImpl : public BenchmarkClient,
                                 public StreamDecoderCompletionCallback,
                                 public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
 public:
+  // Maximum number of request classes that latencies are broken down by. Classes beyond this
+  // share a single statistic, to bound the number of histograms per worker.
+  static constexpr uint32_t kMaxRequestClasses = 16;
+
   BenchmarkClientHttpImpl(Envoy::Api::Api& api, Envoy::Event::Dispatcher& dispatcher,
                           Envoy::Stats::Scope& scope, BenchmarkClientStatistic& statistic,
                           Envoy::Http::Protocol protocol,
@@ -124,9 +132,33 @@ public:
     max_requests_per_connection_ = max_requests_per_connection;
   }
   void setTimeout(std::chrono::seconds timeout) { timeout_ = timeout; }
+  void setTerminationMode(nighthawk::client::TerminationMode::TerminationModeOptions mode,
+                          std::chrono::nanoseconds drain_timeout) {
+    termination_mode_ = mode;
+    drain_timeout_ = drain_timeout;
+  }
+  /**
+   * Replaces the random generator used for generating request ids, for example with a seeded one
+   * to make request ids reproducible across executions.
+   * @param generator the random generator to use.
+   */
+  void setRandomGenerator(Envoy::Random::RandomGeneratorPtr&& generator) {
+    generator_ = std::move(generator);
+  }
+  /**
+   * Breaks the request-to-response latencies down by the class of the requests, in addition to
+   * reporting them in aggregate. A statistic is allocated up front for each class, reported as
+   * benchmark_http_client.request_class.<name>. When there are more than kMaxRequestClasses
+   * classes, the last statistic is named "other" and collects the latencies of the remaining ones.
+   * @param request_classes names of the classes, indexed by Request::requestClass().
+   */
+  void setRequestClasses(const std::vector<std::string>& request_classes);
 
   // BenchmarkClient
   void terminate() override;
+  void onExecutionEnded() override;
+  void resetStatistics() override;
+  StatisticPtrMap retireStatistics() override;
   StatisticPtrMap statistics() const override;
   bool shouldMeasureLatencies() const override { return measure_latencies_; }
   void setShouldMeasureLatencies(bool measure_latencies) override {
@@ -145,6 +177,7 @@ public:
   void onPoolFailure(Envoy::Http::ConnectionPool::PoolFailureReason reason) override;
   void exportLatency(const uint32_t response_code, const uint64_t latency_ns) override;
   void handleResponseData(const Envoy::Buffer::Instance& response_data) override;
+  void onExpectationMismatch(const ExpectationMismatch mismatch) override;
 
   // Helpers
   absl::optional<::Envoy::Upstream::HttpPoolData> pool() {
@@ -157,6 +190,26 @@ public:
   }
 
 private:
+  /**
+   * Runs the dispatcher until the connection pool is idle, or the timeout expires.
+   * @param timeout maximum time to wait for the connection pool to become idle.
+   */
+  void drain(std::chrono::milliseconds timeout);
+  /**
+   * Runs the dispatcher until no requests are in flight anymore, or the drain timeout expires.
+   * Latencies of the responses that arrive meanwhile go to drained_response_statistic_.
+   */
+  void drainInFlightRequests();
+  /**
+   * Called when a request completes or fails, after its stream decoder stopped being tracked as in
+   * flight. Ends a bounded drain once nothing is in flight anymore.
+   */
+  void onInFlightRequestDone();
+  /**
+   * Counts requests that are still in flight as abandoned, and resets their streams.
+   */
+  void abandonInFlightRequests();
+
   Envoy::Api::Api& api_;
   Envoy::Event::Dispatcher& dispatcher_;
   Envoy::Stats::ScopeSharedPtr scope_;
@@ -168,7 +221,8 @@ private:
   uint32_t max_active_requests_{UINT32_MAX};
   uint32_t max_requests_per_connection_{UINT32_MAX};
   Envoy::Event::TimerPtr timer_;
-  Envoy::Random::RandomGeneratorImpl generator_;
+  Envoy::Random::RandomGeneratorPtr generator_{
+      std::make_unique<Envoy::Random::RandomGeneratorImpl>()};
   uint64_t requests_completed_{};
   uint64_t requests_initiated_{};
   bool measure_latencies_{};
@@ -180,7 +234,38 @@ private:
   const bool provide_resource_backpressure_;
   const std::string latency_response_header_name_;
   Envoy::Event::TimerPtr drain_timer_;
+  // Set once drain() added its idle callback to the connection pool.
+  bool pool_idle_callback_added_{};
+  // Set while drain() waits for the connection pool to become idle.
+  bool waiting_for_idle_pool_{};
+  // Caps the time a bounded drain waits for in-flight requests.
+  Envoy::Event::TimerPtr bounded_drain_timer_;
   std::vector<UserDefinedOutputNamePluginPair> user_defined_output_plugins_;
+  nighthawk::client::TerminationMode::TerminationModeOptions termination_mode_{
+      nighthawk::client::TerminationMode::DRAIN};
+  std::chrono::nanoseconds drain_timeout_{1s};
+  // Set while draining in bounded drain mode, to route latencies of drained responses to
+  // drained_response_statistic_.
+  bool draining_{};
+  StatisticPtr drained_response_statistic_;
+  // Decoders of the requests that are in flight, which remove themselves once they complete.
+  InFlightStreamDecoders in_flight_decoders_;
+  // Set while abandoning in-flight requests, which completes them as failed.
+  bool abandoning_in_flight_requests_{};
+  // Snapshot of the request-to-response latencies as they were when the bounded drain started.
+  // In-flight stream decoders hold on to the live statistic, so that one keeps changing.
+  StatisticPtr response_statistic_at_drain_start_;
+  // Statistics replaced by retireStatistics(). Stream decoders of requests that were in flight at
+  // that time still refer to these, so they are kept alive until resetStatistics() finds no
+  // requests in flight.
+  std::vector<StatisticPtr> retired_statistics_;
+  // Request-to-response latencies per request class, indexed by Request::requestClass().
+  std::vector<StatisticPtr> request_class_statistics_;
+  // Snapshot of request_class_statistics_ as it was when the bounded drain started.
+  std::vector<StatisticPtr> request_class_statistics_at_drain_start_;
+  // Stream decoders are allocated from here, so that starting a request does not need to allocate
+  // one from the heap.
+  SlabArenaPtr decoder_arena_{SlabArena::create(sizeof(StreamDecoder))};
 };
 
 } // namespace Client
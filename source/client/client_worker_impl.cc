@@ -12,6 +12,28 @@ namespace Client {
 
 using namespace std::chrono_literals;
 
+namespace {
+
+/**
+ * @param end counter values at the end of a period.
+ * @param start counter values at the start of the period.
+ * @return std::map<std::string, uint64_t> the non-zero increments of the counters in between.
+ */
+std::map<std::string, uint64_t> counterIncrements(const std::map<std::string, uint64_t>& end,
+                                                  const std::map<std::string, uint64_t>& start) {
+  std::map<std::string, uint64_t> increments;
+  for (const auto& counter : end) {
+    const auto it = start.find(counter.first);
+    const uint64_t delta = counter.second - (it == start.end() ? 0 : it->second);
+    if (delta > 0) {
+      increments[counter.first] = delta;
+    }
+  }
+  return increments;
+}
+
+} // namespace
+
 ClientWorkerImpl::ClientWorkerImpl(
     Envoy::Api::Api& api, Envoy::ThreadLocal::Instance& tls,
     Envoy::Upstream::ClusterManagerPtr& cluster_manager,
@@ -19,34 +41,88 @@ ClientWorkerImpl::ClientWorkerImpl(
     const TerminationPredicateFactory& termination_predicate_factory,
     const SequencerFactory& sequencer_factory,
     const RequestSourceFactory& request_generator_factory, Envoy::Stats::Store& store,
-    const int worker_number, const Envoy::MonotonicTime starting_time,
+    const int worker_number, WorkerStartBarrier& start_barrier,
     Envoy::Tracing::TracerSharedPtr& tracer, const HardCodedWarmupStyle hardcoded_warmup_style,
+    const absl::optional<nighthawk::client::LoadProfile>& load_profile,
     std::vector<UserDefinedOutputNamePluginPair> user_defined_output_plugins)
     : WorkerImpl(api, tls, store),
       time_source_(std::make_unique<CachedTimeSourceImpl>(*dispatcher_)),
-      termination_predicate_factory_(termination_predicate_factory),
-      sequencer_factory_(sequencer_factory), worker_scope_(store_.createScope("cluster.")),
+      termination_predicate_factory_(&termination_predicate_factory),
+      sequencer_factory_(&sequencer_factory), worker_scope_(store_.createScope("cluster.")),
       worker_number_scope_(worker_scope_->createScope(fmt::format("{}.", worker_number))),
-      worker_number_(worker_number), tracer_(tracer),
+      worker_number_(worker_number), start_barrier_(start_barrier), tracer_(tracer),
       request_generator_(
           request_generator_factory.create(cluster_manager, *dispatcher_, *worker_number_scope_,
-                                           fmt::format("{}.requestsource", worker_number))),
+                                           fmt::format("{}.requestsource", worker_number),
+                                           worker_number)),
       benchmark_client_(benchmark_client_factory.create(
           api, *dispatcher_, *worker_number_scope_, cluster_manager, tracer_,
           fmt::format("{}", worker_number), worker_number, *request_generator_,
           std::move(user_defined_output_plugins))),
-      phase_(
-          std::make_unique<PhaseImpl>("main",
-                                      sequencer_factory_.create(
-                                          *time_source_, *dispatcher_,
-                                          [this](CompletionCallback f) -> bool {
-                                            return benchmark_client_->tryStartRequest(std::move(f));
-                                          },
-                                          termination_predicate_factory_.create(
-                                              *time_source_, *worker_number_scope_, starting_time),
-                                          *worker_number_scope_, starting_time),
-                                      true)),
-      hardcoded_warmup_style_(hardcoded_warmup_style) {}
+      sequencer_target_([this](CompletionCallback f) -> bool {
+        return benchmark_client_->tryStartRequest(std::move(f));
+      }),
+      hardcoded_warmup_style_(hardcoded_warmup_style) {
+  if (load_profile.has_value()) {
+    load_phases_.assign(load_profile.value().phases().begin(), load_profile.value().phases().end());
+  }
+}
+
+PhasePtr ClientWorkerImpl::createFirstPhase(const Envoy::MonotonicTime starting_time) {
+  RequestReleaseTiming* release_timing = request_generator_->releaseTiming();
+  if (load_phases_.empty() && release_timing != nullptr) {
+    // The request source replays requests at recorded times, which take the place of the rate.
+    // Workers claim the requests in one shared order, so their offsets must count from the same
+    // time: the common start, without the per-worker stagger.
+    const Envoy::MonotonicTime common_starting_time =
+        start_barrier_.startTime().value_or(starting_time);
+    return std::make_unique<PhaseImpl>(
+        "main",
+        sequencer_factory_->createForReleaseTiming(
+            *time_source_, *dispatcher_, sequencer_target_,
+            withPhaseSwitch(termination_predicate_factory_->create(
+                *time_source_, *worker_number_scope_, common_starting_time)),
+            *worker_number_scope_, *release_timing, common_starting_time, worker_number_),
+        true);
+  }
+  if (load_phases_.empty()) {
+    return std::make_unique<PhaseImpl>(
+        "main",
+        sequencer_factory_->create(
+            *time_source_, *dispatcher_, sequencer_target_,
+            withPhaseSwitch(termination_predicate_factory_->create(
+                *time_source_, *worker_number_scope_, starting_time)),
+            *worker_number_scope_, starting_time, worker_number_),
+        true);
+  }
+  // Subsequent phases are created when their predecessor completes, so their pacing and
+  // duration start counting at that point.
+  return createLoadPhase(0, starting_time);
+}
+
+PhasePtr ClientWorkerImpl::createLoadPhase(
+    const size_t index, const absl::optional<Envoy::MonotonicTime> scheduled_starting_time) {
+  const nighthawk::client::LoadPhase& load_phase = load_phases_[index];
+  const std::string id =
+      load_phase.has_id() ? load_phase.id().value() : fmt::format("phase_{}", index);
+  const Envoy::MonotonicTime starting_time =
+      scheduled_starting_time.value_or(time_source_->monotonicTime());
+  return std::make_unique<PhaseImpl>(
+      id,
+      sequencer_factory_->createForLoadPhase(
+          *time_source_, *dispatcher_, sequencer_target_,
+          withPhaseSwitch(termination_predicate_factory_->createForLoadPhase(
+              *time_source_, *worker_number_scope_, load_phase, starting_time)),
+          *worker_number_scope_, load_phase, scheduled_starting_time, worker_number_),
+      true);
+}
+
+TerminationPredicatePtr
+ClientWorkerImpl::withPhaseSwitch(TerminationPredicatePtr&& termination_predicate) {
+  termination_predicate->appendToChain(
+      std::make_unique<DeadlineTerminationPredicateImpl>(*time_source_, phase_switch_time_));
+  return std::move(termination_predicate);
+}
 
 void ClientWorkerImpl::simpleWarmup() {
   ENVOY_LOG(debug, "> worker {}: warmup start.", worker_number_);
@@ -59,16 +135,206 @@ void ClientWorkerImpl::simpleWarmup() {
 }
 
 void ClientWorkerImpl::work() {
-  benchmark_client_->setShouldMeasureLatencies(false);
-  request_generator_->initOnThread();
-  if (hardcoded_warmup_style_ == HardCodedWarmupStyle::ON) {
-    simpleWarmup();
+  if (executions_++ == 0) {
+    benchmark_client_->setShouldMeasureLatencies(false);
+    request_generator_->initOnThread();
+    if (hardcoded_warmup_style_ == HardCodedWarmupStyle::ON) {
+      simpleWarmup();
+    }
+  } else {
+    // The results of the previous execution have been collected by now.
+    phases_.clear();
+    phase_counter_values_.clear();
+    phase_client_statistics_.clear();
+    merged_phase_statistics_.clear();
+    benchmark_client_->resetStatistics();
+    counters_at_execution_start_ = snapshotCounterValues();
+  }
+  // The first phase is created once all workers are ready, because its pacing and duration are
+  // relative to the common starting time.
+  phases_.push_back(createFirstPhase(start_barrier_.arriveAndWait(worker_number_)));
+  if (event_loop_utilization_threshold_ > 0) {
+    startEventLoopMonitoring();
+  }
+  if (interval_report_callback_ != nullptr) {
+    // Discard whatever the statistics tracked before the execution started, like the warmup.
+    reportInterval();
+  }
+
+  std::map<std::string, uint64_t> counters_at_phase_start = snapshotCounterValues();
+  // Note that phases_ may grow while we iterate, as we create load profile phases on the fly.
+  for (size_t i = 0; i < phases_.size(); i++) {
+    const Phase& phase = *phases_[i];
+    benchmark_client_->setShouldMeasureLatencies(phase.shouldMeasureLatencies());
+    phase.run();
+    std::map<std::string, uint64_t> counters_at_phase_end = snapshotCounterValues();
+    phase_counter_values_.push_back(
+        counterIncrements(counters_at_phase_end, counters_at_phase_start));
+    counters_at_phase_start = std::move(counters_at_phase_end);
+    absl::optional<Envoy::MonotonicTime> next_phase_start;
+    {
+      Envoy::Thread::LockGuard guard(phase_switch_lock_);
+      if (pending_phase_.has_value()) {
+        // The switched-to phase replaces the phases that did not start yet. Entries before it
+        // hold defaults when no load profile is configured, they are not used again.
+        load_phases_.resize(i + 1);
+        load_phases_.push_back(std::move(pending_phase_.value()));
+        pending_phase_.reset();
+        const Envoy::MonotonicTime switch_time =
+            phase_switch_time_.exchange(Envoy::MonotonicTime::max());
+        // When the phase ended before the switch time, the next phase waits for it.
+        if (switch_time > time_source_->monotonicTime()) {
+          next_phase_start = switch_time;
+        }
+      }
+    }
+    if (i + 1 < load_phases_.size() && !executionEnded()) {
+      // Latencies of the next phase must not mix with the ones of this phase.
+      phase_client_statistics_.push_back(benchmark_client_->retireStatistics());
+      phases_.push_back(createLoadPhase(i + 1, next_phase_start));
+    }
+  }
+  if (event_loop_monitor_ != nullptr) {
+    stopEventLoopMonitoring();
+  }
+  {
+    // Switches that arrive from here on are too late for this execution.
+    Envoy::Thread::LockGuard guard(phase_switch_lock_);
+    pending_phase_.reset();
+    phase_switch_time_.store(Envoy::MonotonicTime::max());
+  }
+  benchmark_client_->onExecutionEnded();
+  phase_client_statistics_.push_back(benchmark_client_->statistics());
+  if (interval_report_callback_ != nullptr) {
+    report_timer_.reset();
+    interval_report_callback_(nullptr);
+  }
+
+  if (phases_.size() > 1) {
+    const auto merge = [this](const StatisticPtrMap& statistics) {
+      for (const auto& statistic : statistics) {
+        StatisticPtr& merged = merged_phase_statistics_[statistic.first];
+        merged = merged == nullptr
+                     ? statistic.second->createNewInstanceOfSameType()->combine(*statistic.second)
+                     : merged->combine(*statistic.second);
+        merged->setId(statistic.first);
+      }
+    };
+    for (size_t i = 0; i < phases_.size(); i++) {
+      merge(phases_[i]->sequencer().statistics());
+      merge(phase_client_statistics_[i]);
+    }
   }
-  benchmark_client_->setShouldMeasureLatencies(phase_->shouldMeasureLatencies());
-  phase_->run();
 
   // Save a final snapshot of the worker-specific counter accumulations before
-  // we exit the thread.
+  // we exit the thread. This includes activity caused by handling in-flight requests above.
+  threadLocalCounterValues_ =
+      counterIncrements(snapshotCounterValues(), counters_at_execution_start_);
+  // Note that benchmark_client_ is not terminated here, but in shutdownThread() below. This is to
+  // to prevent the shutdown artifacts from influencing the test result counters. The main thread
+  // still needs to be able to read the counters for reporting the global numbers, and those
+  // should be consistent.
+}
+
+void ClientWorkerImpl::startEventLoopMonitoring() {
+  if (event_loop_monitor_ == nullptr) {
+    // The cached time source is not refreshed while the event loop waits, so use the real one.
+    event_loop_monitor_ =
+        std::make_unique<EventLoopMonitor>(*dispatcher_, dispatcher_->timeSource());
+  }
+  event_loop_monitor_->start();
+  monitoring_start_ = dispatcher_->timeSource().monotonicTime();
+  cpu_usage_at_monitoring_start_ = ThreadCpuUsage::currentThread();
+}
+
+void ClientWorkerImpl::stopEventLoopMonitoring() {
+  event_loop_monitor_->stop();
+  const std::chrono::nanoseconds monitored =
+      dispatcher_->timeSource().monotonicTime() - monitoring_start_;
+  const auto add = [this](const std::string& name, const uint64_t value) {
+    worker_number_scope_->counterFromString(name).add(value);
+  };
+  const auto add_duration = [&add](const std::string& name, const std::chrono::nanoseconds value) {
+    add(name, std::chrono::duration_cast<std::chrono::microseconds>(value).count());
+  };
+  std::chrono::nanoseconds pacing{0};
+  std::chrono::nanoseconds idle{0};
+  for (const PhasePtr& phase : phases_) {
+    pacing += phase->sequencer().pacingDuration();
+    idle += phase->sequencer().idleDuration();
+  }
+  const std::chrono::nanoseconds busy = event_loop_monitor_->busyDuration();
+  add("event_loop.iterations", event_loop_monitor_->iterations());
+  add_duration("event_loop.busy_us", busy);
+  add_duration("event_loop.pacing_us", pacing);
+  add_duration("event_loop.idle_us", idle);
+  // What remains of the busy time went to I/O and the other callbacks.
+  add_duration("event_loop.io_us", std::max(busy - pacing - idle, std::chrono::nanoseconds(0)));
+  const absl::StatusOr<ThreadCpuUsage> cpu_usage = ThreadCpuUsage::currentThread();
+  if (cpu_usage.ok() && cpu_usage_at_monitoring_start_.ok()) {
+    add_duration("thread.cpu_user_us",
+                 cpu_usage->user_time - cpu_usage_at_monitoring_start_->user_time);
+    add_duration("thread.cpu_system_us",
+                 cpu_usage->system_time - cpu_usage_at_monitoring_start_->system_time);
+    add("thread.voluntary_context_switches",
+        cpu_usage->voluntary_context_switches -
+            cpu_usage_at_monitoring_start_->voluntary_context_switches);
+    add("thread.involuntary_context_switches",
+        cpu_usage->involuntary_context_switches -
+            cpu_usage_at_monitoring_start_->involuntary_context_switches);
+  }
+  // Idling per the idle strategy keeps the event loop busy, but leaves room for more work.
+  const double utilization =
+      monitored.count() > 0 ? 100.0 * (busy - idle).count() / monitored.count() : 0;
+  if (utilization > event_loop_utilization_threshold_) {
+    add("event_loop.overloaded", 1);
+    ENVOY_LOG(warn,
+              "> worker {}: event loop utilization was {:.1f}%, which exceeds the threshold of "
+              "{}%. Results may be skewed, consider adding workers.",
+              worker_number_, utilization, event_loop_utilization_threshold_);
+  }
+}
+
+void ClientWorkerImpl::reportInterval() {
+  // The first call of an execution only sets the baseline.
+  const bool first = report_timer_ == nullptr;
+  auto report = std::make_unique<IntervalReport>();
+  const auto take_intervals = [&report](const StatisticPtrMap& statistics) {
+    for (const auto& statistic : statistics) {
+      StatisticPtr interval = statistic.second->takeInterval();
+      if (interval == nullptr) {
+        continue;
+      }
+      StatisticPtr& merged = report->statistics[statistic.first];
+      merged = merged == nullptr ? std::move(interval) : merged->combine(*interval);
+      merged->setId(statistic.first);
+    }
+  };
+  take_intervals(benchmark_client_->statistics());
+  // Phases that completed since the previous report still hold their last values.
+  for (const PhasePtr& phase : phases_) {
+    take_intervals(phase->sequencer().statistics());
+  }
+  for (const StatisticPtrMap& statistics : phase_client_statistics_) {
+    take_intervals(statistics);
+  }
+  const Envoy::MonotonicTime now = time_source_->monotonicTime();
+  std::map<std::string, uint64_t> counters = snapshotCounterValues();
+  report->counters = counterIncrements(counters, counters_at_last_report_);
+  report->duration = now - last_report_time_;
+  counters_at_last_report_ = std::move(counters);
+  last_report_time_ = now;
+  if (first) {
+    report_timer_ = dispatcher_->createTimer([this]() { reportInterval(); });
+  } else {
+    interval_report_callback_(std::move(report));
+  }
+  report_timer_->enableHRTimer(
+      std::chrono::duration_cast<std::chrono::microseconds>(report_interval_));
+}
+
+std::map<std::string, uint64_t> ClientWorkerImpl::snapshotCounterValues() const {
+  std::map<std::string, uint64_t> counter_values;
   for (const auto& stat : store_.counters()) {
     // First, we strip the cluster prefix
     std::string stat_name = std::string(absl::StripPrefix(stat->name(), "cluster."));
@@ -76,14 +342,19 @@ void ClientWorkerImpl::work() {
     // Second, we strip our own prefix if it's there, else we skip.
     const std::string worker_prefix = fmt::format("{}.", worker_number_);
     if (stat->value() && absl::StartsWith(stat_name, worker_prefix)) {
-      threadLocalCounterValues_[std::string(absl::StripPrefix(stat_name, worker_prefix))] =
-          stat->value();
+      counter_values[std::string(absl::StripPrefix(stat_name, worker_prefix))] = stat->value();
     }
   }
-  // Note that benchmark_client_ is not terminated here, but in shutdownThread() below. This is to
-  // to prevent the shutdown artifacts from influencing the test result counters. The main thread
-  // still needs to be able to read the counters for reporting the global numbers, and those
-  // should be consistent.
+  return counter_values;
+}
+
+bool ClientWorkerImpl::executionEnded() const {
+  const auto incremented = [this](const std::string& name) {
+    const auto it = counters_at_execution_start_.find(name);
+    return worker_number_scope_->counterFromString(name).value() >
+           (it == counters_at_execution_start_.end() ? 0 : it->second);
+  };
+  return incremented("sequencer.failed_terminations") || incremented("graceful_stop_requested");
 }
 
 void ClientWorkerImpl::shutdownThread() {
@@ -99,13 +370,52 @@ void ClientWorkerImpl::requestExecutionCancellation() {
       [this]() { worker_number_scope_->counterFromString("graceful_stop_requested").inc(); });
 }
 
+void ClientWorkerImpl::switchPhase(const nighthawk::client::LoadPhase& load_phase,
+                                   const Envoy::MonotonicTime switch_time) {
+  Envoy::Thread::LockGuard guard(phase_switch_lock_);
+  pending_phase_ = load_phase;
+  phase_switch_time_.store(switch_time);
+}
+
+void ClientWorkerImpl::setIntervalReportCallback(const std::chrono::nanoseconds report_interval,
+                                                 IntervalReportCallback callback) {
+  report_interval_ = report_interval;
+  interval_report_callback_ = std::move(callback);
+}
+
+void ClientWorkerImpl::startNextExecution(
+    const SequencerFactory& sequencer_factory,
+    const TerminationPredicateFactory& termination_predicate_factory,
+    const absl::optional<nighthawk::client::LoadProfile>& load_profile) {
+  // The worker thread is idle until startNextRound() hands it the next round of work.
+  sequencer_factory_ = &sequencer_factory;
+  termination_predicate_factory_ = &termination_predicate_factory;
+  load_phases_.clear();
+  if (load_profile.has_value()) {
+    load_phases_.assign(load_profile.value().phases().begin(), load_profile.value().phases().end());
+  }
+  startNextRound();
+}
+
 StatisticPtrMap ClientWorkerImpl::statistics() const {
   StatisticPtrMap statistics;
-  StatisticPtrMap s1 = benchmark_client_->statistics();
-  Sequencer& sequencer = phase_->sequencer();
-  StatisticPtrMap s2 = sequencer.statistics();
-  statistics.insert(s1.begin(), s1.end());
-  statistics.insert(s2.begin(), s2.end());
+  if (merged_phase_statistics_.empty()) {
+    StatisticPtrMap s1 = benchmark_client_->statistics();
+    statistics.insert(s1.begin(), s1.end());
+    Sequencer& sequencer = phases_.front()->sequencer();
+    StatisticPtrMap s2 = sequencer.statistics();
+    statistics.insert(s2.begin(), s2.end());
+  } else {
+    for (const auto& statistic : merged_phase_statistics_) {
+      statistics[statistic.first] = statistic.second.get();
+    }
+  }
+  const StatisticPtrMap request_source_statistics = request_generator_->statistics();
+  statistics.insert(request_source_statistics.begin(), request_source_statistics.end());
+  if (event_loop_monitor_ != nullptr) {
+    statistics["event_loop.busy"] = &event_loop_monitor_->busyStatistic();
+    statistics["event_loop.callback_count"] = &event_loop_monitor_->callbacksStatistic();
+  }
   return statistics;
 }
 
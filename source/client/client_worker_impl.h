@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "envoy/api/api.h"
@@ -18,6 +21,10 @@
 #include "nighthawk/common/termination_predicate.h"
 #include "nighthawk/user_defined_output/user_defined_output_plugin.h"
 
+#include "external/envoy/source/common/common/thread.h"
+
+#include "source/client/event_loop_monitor.h"
+#include "source/client/worker_start_barrier.h"
 #include "source/common/worker_impl.h"
 
 namespace Nighthawk {
@@ -34,9 +41,9 @@ public:
                    const SequencerFactory& sequencer_factory,
                    const RequestSourceFactory& request_generator_factory,
                    Envoy::Stats::Store& store, const int worker_number,
-                   const Envoy::MonotonicTime starting_time,
-                   Envoy::Tracing::TracerSharedPtr& tracer,
+                   WorkerStartBarrier& start_barrier, Envoy::Tracing::TracerSharedPtr& tracer,
                    const HardCodedWarmupStyle hardcoded_warmup_style,
+                   const absl::optional<nighthawk::client::LoadProfile>& load_profile,
                    std::vector<UserDefinedOutputNamePluginPair> user_defined_output_plugins);
   StatisticPtrMap statistics() const override;
 
@@ -44,12 +51,46 @@ public:
     return threadLocalCounterValues_;
   }
 
-  const Phase& phase() const override { return *phase_; }
+  const Phase& phase() const override { return *phases_.front(); }
+
+  const std::vector<PhasePtr>& phases() const override { return phases_; }
+
+  const std::vector<std::map<std::string, uint64_t>>& phaseCounterValues() const override {
+    return phase_counter_values_;
+  }
+
+  const std::vector<StatisticPtrMap>& phaseClientStatistics() const override {
+    return phase_client_statistics_;
+  }
 
   void shutdownThread() override;
 
   void requestExecutionCancellation() override;
 
+  void switchPhase(const nighthawk::client::LoadPhase& load_phase,
+                   const Envoy::MonotonicTime switch_time) override;
+
+  void setIntervalReportCallback(const std::chrono::nanoseconds report_interval,
+                                 IntervalReportCallback callback) override;
+
+  /**
+   * Has the worker monitor its event loop, cpu time and context switches during executions, and
+   * flag executions during which the event loop was busier than the threshold. Must be called
+   * before start().
+   *
+   * @param threshold_percent utilization percentage above which the worker is considered to be
+   * overloaded. 0 disables monitoring.
+   */
+  void setEventLoopUtilizationThreshold(const uint32_t threshold_percent) {
+    event_loop_utilization_threshold_ = threshold_percent;
+  }
+
+  void startNextExecution(
+      const SequencerFactory& sequencer_factory,
+      const TerminationPredicateFactory& termination_predicate_factory,
+      const absl::optional<nighthawk::client::LoadProfile>& load_profile) override;
+  void dispatchUntilNextExecution() override { dispatchWhileIdle(); }
+
   /**
    * Returns additional output from any specified User Defined Output plugins.
    */
@@ -60,20 +101,98 @@ protected:
 
 private:
   void simpleWarmup();
+  /**
+   * Creates the first phase of execution.
+   *
+   * @param starting_time the time at which the phase should start. Replayed release timing counts
+   * from the common start of the workers instead.
+   * @return PhasePtr the phase.
+   */
+  PhasePtr createFirstPhase(const Envoy::MonotonicTime starting_time);
+  /**
+   * Creates the phase at the specified index of the configured load profile.
+   *
+   * @param index index of the phase in the load profile.
+   * @param scheduled_starting_time optional scheduled starting time. When not set, the phase will
+   * start right away.
+   * @return PhasePtr the phase.
+   */
+  PhasePtr createLoadPhase(const size_t index,
+                           const absl::optional<Envoy::MonotonicTime> scheduled_starting_time);
+  /**
+   * Links a predicate which terminates the phase when a requested phase switch takes effect.
+   *
+   * @param termination_predicate the termination predicate of the phase.
+   * @return TerminationPredicatePtr the termination predicate with the phase switch linked.
+   */
+  TerminationPredicatePtr withPhaseSwitch(TerminationPredicatePtr&& termination_predicate);
+  /**
+   * Starts monitoring the event loop and cpu usage for the execution.
+   */
+  void startEventLoopMonitoring();
+  /**
+   * Stops monitoring, and accounts for the observations in the counters of the worker. Flags the
+   * worker as overloaded when the event loop utilization exceeded the threshold.
+   */
+  void stopEventLoopMonitoring();
+  /**
+   * Reports the values observed since the previous report to the interval report callback, and
+   * re-arms the report timer.
+   */
+  void reportInterval();
+  /**
+   * @return std::map<std::string, uint64_t> a snapshot of the non-zero counter values associated
+   * to this worker, with the worker-specific prefix stripped.
+   */
+  std::map<std::string, uint64_t> snapshotCounterValues() const;
+  /**
+   * @return bool true iff a failure predicate fired or cancellation was requested, which ends
+   * execution as a whole instead of just the current phase.
+   */
+  bool executionEnded() const;
 
   std::unique_ptr<Envoy::TimeSource> time_source_;
-  const TerminationPredicateFactory& termination_predicate_factory_;
-  const SequencerFactory& sequencer_factory_;
+  // Pointers, because executions after the first one may use other factories.
+  const TerminationPredicateFactory* termination_predicate_factory_;
+  const SequencerFactory* sequencer_factory_;
   Envoy::Stats::ScopeSharedPtr worker_scope_;
   Envoy::Stats::ScopeSharedPtr worker_number_scope_;
   const int worker_number_;
+  WorkerStartBarrier& start_barrier_;
   Envoy::Tracing::TracerSharedPtr& tracer_;
   RequestSourcePtr request_generator_;
   BenchmarkClientPtr benchmark_client_;
-  PhasePtr phase_;
+  const SequencerTarget sequencer_target_;
+  std::vector<nighthawk::client::LoadPhase> load_phases_;
+  std::vector<PhasePtr> phases_;
+  std::vector<std::map<std::string, uint64_t>> phase_counter_values_;
+  // Benchmark client statistics per phase. The client owns these.
+  std::vector<StatisticPtrMap> phase_client_statistics_;
+  // Sequencer and benchmark client statistics combined across phases. Only populated when more
+  // than a single phase got executed.
+  std::map<std::string, StatisticPtr> merged_phase_statistics_;
   Envoy::LocalInfo::LocalInfoPtr local_info_;
   std::map<std::string, uint64_t> threadLocalCounterValues_;
   const HardCodedWarmupStyle hardcoded_warmup_style_;
+  uint32_t executions_{0};
+  // Counter values as they were when the current execution started. Empty for the first
+  // execution, so that its counters include the warmup like they always did.
+  std::map<std::string, uint64_t> counters_at_execution_start_;
+  // Phase requested via switchPhase(), and the time at which the running phase should end to make
+  // room for it. The time is observed lock-free by the termination predicates of the phases.
+  Envoy::Thread::MutexBasicLockable phase_switch_lock_;
+  absl::optional<nighthawk::client::LoadPhase> pending_phase_ ABSL_GUARDED_BY(phase_switch_lock_);
+  std::atomic<Envoy::MonotonicTime> phase_switch_time_{Envoy::MonotonicTime::max()};
+  uint32_t event_loop_utilization_threshold_{0};
+  // Created on the worker thread, when monitoring is enabled.
+  std::unique_ptr<EventLoopMonitor> event_loop_monitor_;
+  Envoy::MonotonicTime monitoring_start_;
+  absl::StatusOr<ThreadCpuUsage> cpu_usage_at_monitoring_start_;
+  std::chrono::nanoseconds report_interval_{0};
+  IntervalReportCallback interval_report_callback_;
+  Envoy::Event::TimerPtr report_timer_;
+  Envoy::MonotonicTime last_report_time_;
+  std::map<std::string, uint64_t> counters_at_last_report_;
 };
 
 using ClientWorkerImplPtr = std::unique_ptr<ClientWorkerImpl>;
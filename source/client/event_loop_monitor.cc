@@ -0,0 +1,107 @@
+#include "source/client/event_loop_monitor.h"
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "external/envoy/source/common/event/dispatcher_impl.h"
+
+#include "source/common/statistic_impl.h"
+
+#include "event2/event.h"
+#include "event2/watch.h"
+#include "fmt/format.h"
+
+namespace Nighthawk {
+namespace Client {
+
+#ifdef __linux__
+
+absl::StatusOr<ThreadCpuUsage> ThreadCpuUsage::currentThread() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+    return absl::InternalError(fmt::format("getrusage failed: {}", errno));
+  }
+  const auto to_microseconds = [](const struct timeval& time) {
+    return std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec);
+  };
+  ThreadCpuUsage cpu_usage;
+  cpu_usage.user_time = to_microseconds(usage.ru_utime);
+  cpu_usage.system_time = to_microseconds(usage.ru_stime);
+  cpu_usage.voluntary_context_switches = usage.ru_nvcsw;
+  cpu_usage.involuntary_context_switches = usage.ru_nivcsw;
+  return cpu_usage;
+}
+
+#else
+
+absl::StatusOr<ThreadCpuUsage> ThreadCpuUsage::currentThread() {
+  return absl::UnimplementedError("Per-thread cpu usage is not supported on this platform");
+}
+
+#endif
+
+EventLoopMonitor::EventLoopMonitor(Envoy::Event::Dispatcher& dispatcher,
+                                   Envoy::TimeSource& time_source)
+    : dispatcher_(dispatcher), time_source_(time_source) {
+  resetObservations();
+}
+
+EventLoopMonitor::~EventLoopMonitor() { stop(); }
+
+void EventLoopMonitor::start() {
+  stop();
+  resetObservations();
+  auto* dispatcher = dynamic_cast<Envoy::Event::DispatcherImpl*>(&dispatcher_);
+  if (dispatcher == nullptr) {
+    return;
+  }
+  prepare_watcher_ = evwatch_prepare_new(&dispatcher->base(), &EventLoopMonitor::onPrepare, this);
+  check_watcher_ = evwatch_check_new(&dispatcher->base(), &EventLoopMonitor::onCheck, this);
+}
+
+void EventLoopMonitor::stop() {
+  if (prepare_watcher_ != nullptr) {
+    evwatch_free(prepare_watcher_);
+    prepare_watcher_ = nullptr;
+  }
+  if (check_watcher_ != nullptr) {
+    evwatch_free(check_watcher_);
+    check_watcher_ = nullptr;
+  }
+}
+
+void EventLoopMonitor::resetObservations() {
+  iterations_ = 0;
+  busy_duration_ = std::chrono::nanoseconds(0);
+  busy_since_ = absl::nullopt;
+  busy_statistic_ = std::make_unique<HdrStatistic>();
+  busy_statistic_->setId("event_loop.busy");
+  callbacks_statistic_ = std::make_unique<HdrStatistic>();
+  callbacks_statistic_->setId("event_loop.callback_count");
+}
+
+void EventLoopMonitor::onPrepare(evwatch*, const evwatch_prepare_cb_info*, void* arg) {
+  // The loop is about to wait for events, which ends the busy part of the iteration.
+  auto* monitor = static_cast<EventLoopMonitor*>(arg);
+  if (!monitor->busy_since_.has_value()) {
+    return;
+  }
+  const std::chrono::nanoseconds busy =
+      monitor->time_source_.monotonicTime() - monitor->busy_since_.value();
+  monitor->busy_since_ = absl::nullopt;
+  monitor->busy_duration_ += busy;
+  monitor->busy_statistic_->addValue(busy.count());
+  monitor->iterations_++;
+}
+
+void EventLoopMonitor::onCheck(evwatch* watcher, const evwatch_check_cb_info*, void* arg) {
+  // The loop is done waiting, and about to run the callbacks of the events that became active.
+  auto* monitor = static_cast<EventLoopMonitor*>(arg);
+  monitor->busy_since_ = monitor->time_source_.monotonicTime();
+  monitor->callbacks_statistic_->addValue(static_cast<uint64_t>(
+      event_base_get_num_events(evwatch_base(watcher), EVENT_BASE_COUNT_ACTIVE)));
+}
+
+} // namespace Client
+} // namespace Nighthawk
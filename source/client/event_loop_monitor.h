@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+
+#include "nighthawk/common/statistic.h"
+
+#include "absl/status/statusor.h"
+#include "absl/types/optional.h"
+
+struct evwatch;
+struct evwatch_prepare_cb_info;
+struct evwatch_check_cb_info;
+
+namespace Nighthawk {
+namespace Client {
+
+/**
+ * Cpu time and context switches of a thread.
+ */
+struct ThreadCpuUsage {
+  std::chrono::microseconds user_time{0};
+  std::chrono::microseconds system_time{0};
+  uint64_t voluntary_context_switches{0};
+  uint64_t involuntary_context_switches{0};
+
+  /**
+   * @return absl::StatusOr<ThreadCpuUsage> the usage of the calling thread so far. Fails with
+   * kUnimplemented on platforms that do not support per-thread usage.
+   */
+  static absl::StatusOr<ThreadCpuUsage> currentThread();
+};
+
+/**
+ * Observes the iterations of the event loop of a dispatcher: how long each iteration was busy
+ * running callbacks as opposed to waiting for events, and how many callbacks it ran. Must be
+ * created, started, stopped and destroyed on the thread that runs the dispatcher.
+ */
+class EventLoopMonitor {
+public:
+  /**
+   * @param dispatcher the dispatcher to observe. When it does not run a libevent based event loop,
+   * the monitor observes nothing.
+   * @param time_source used to time the iterations.
+   */
+  EventLoopMonitor(Envoy::Event::Dispatcher& dispatcher, Envoy::TimeSource& time_source);
+  ~EventLoopMonitor();
+
+  /**
+   * Starts observing, from scratch.
+   */
+  void start();
+
+  /**
+   * Stops observing. The observations stay available.
+   */
+  void stop();
+
+  /**
+   * @return uint64_t the number of iterations observed.
+   */
+  uint64_t iterations() const { return iterations_; }
+
+  /**
+   * @return std::chrono::nanoseconds the total time the observed iterations were busy.
+   */
+  std::chrono::nanoseconds busyDuration() const { return busy_duration_; }
+
+  /**
+   * @return const Statistic& how long each observed iteration was busy, in nanoseconds.
+   */
+  const Statistic& busyStatistic() const { return *busy_statistic_; }
+
+  /**
+   * @return const Statistic& the number of callbacks each observed iteration ran.
+   */
+  const Statistic& callbacksStatistic() const { return *callbacks_statistic_; }
+
+private:
+  void resetObservations();
+  static void onPrepare(evwatch* watcher, const evwatch_prepare_cb_info* info, void* arg);
+  static void onCheck(evwatch* watcher, const evwatch_check_cb_info* info, void* arg);
+
+  Envoy::Event::Dispatcher& dispatcher_;
+  Envoy::TimeSource& time_source_;
+  evwatch* prepare_watcher_{nullptr};
+  evwatch* check_watcher_{nullptr};
+  // Set when the loop is done waiting for events, and about to run callbacks.
+  absl::optional<Envoy::MonotonicTime> busy_since_;
+  uint64_t iterations_{0};
+  std::chrono::nanoseconds busy_duration_{0};
+  StatisticPtr busy_statistic_;
+  StatisticPtr callbacks_statistic_;
+};
+
+} // namespace Client
+} // namespace Nighthawk
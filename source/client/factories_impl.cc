@@ -1,5 +1,6 @@
 #include "source/client/factories_impl.h"
 
+#include "nighthawk/common/exception.h"
 #include "nighthawk/user_defined_output/user_defined_output_plugin.h"
 
 #include "external/envoy/source/common/http/header_map_impl.h"
@@ -12,6 +13,7 @@
 #include "source/common/platform_util_impl.h"
 #include "source/common/rate_limiter_impl.h"
 #include "source/common/request_source_impl.h"
+#include "source/common/seeded_random_generator_impl.h"
 #include "source/common/sequencer_impl.h"
 #include "source/common/statistic_impl.h"
 #include "source/common/termination_predicate_impl.h"
@@ -41,16 +43,14 @@ BenchmarkClientPtr BenchmarkClientFactoryImpl::create(
   // NullStatistic).
   // TODO(#292): Create options and have the StatisticFactory consider those when instantiating
   // statistics.
-  BenchmarkClientStatistic statistic(statistic_factory.create(), statistic_factory.create(),
-                                     std::make_unique<StreamingStatistic>(),
-                                     std::make_unique<StreamingStatistic>(),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id),
-                                     std::make_unique<SinkableHdrStatistic>(scope, worker_id));
+  const auto sinkable = [&statistic_factory, &scope, worker_id]() {
+    return statistic_factory.wrap(std::make_unique<SinkableHdrStatistic>(scope, worker_id));
+  };
+  BenchmarkClientStatistic statistic(
+      statistic_factory.create(), statistic_factory.create(),
+      statistic_factory.wrap(std::make_unique<StreamingStatistic>()),
+      statistic_factory.wrap(std::make_unique<StreamingStatistic>()), sinkable(),
+      sinkable(), sinkable(), sinkable(), sinkable(), sinkable(), sinkable());
   auto benchmark_client = std::make_unique<BenchmarkClientHttpImpl>(
       api, dispatcher, scope, statistic, options_.protocol(), cluster_manager, tracer, cluster_name,
       request_generator.get(), !options_.openLoop(), options_.responseHeaderWithLatencyInput(),
@@ -61,21 +61,131 @@ BenchmarkClientPtr BenchmarkClientFactoryImpl::create(
   benchmark_client->setMaxActiveRequests(options_.maxActiveRequests());
   benchmark_client->setMaxRequestsPerConnection(options_.maxRequestsPerConnection());
   benchmark_client->setTimeout(options_.timeout());
+  benchmark_client->setTerminationMode(options_.terminationMode(), options_.drainTimeout());
+  benchmark_client->setRequestClasses(request_generator.requestClasses());
+  if (options_.seed().has_value()) {
+    benchmark_client->setRandomGenerator(std::make_unique<SeededRandomGeneratorImpl>(
+        SeededRandomGeneratorImpl::seedForWorker(options_.seed().value(), worker_id)));
+  }
 
   return benchmark_client;
 }
 
 SequencerFactoryImpl::SequencerFactoryImpl(const Options& options)
-    : OptionBasedFactoryImpl(options) {}
+    : OptionBasedFactoryImpl(options),
+      shared_rate_limiter_state_(options.globalRateCoordination()
+                                     ? std::make_shared<SharedRateLimiterState>(
+                                           Frequency(options.requestsPerSecond()))
+                                     : nullptr),
+      recorded_schedule_(!options.recordSchedule().empty() ? std::make_shared<ReleaseSchedule>()
+                                                           : nullptr) {}
 
 SequencerPtr SequencerFactoryImpl::create(
     Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
     const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
-    Envoy::Stats::Scope& scope, const Envoy::MonotonicTime scheduled_starting_time) const {
+    Envoy::Stats::Scope& scope, const Envoy::MonotonicTime scheduled_starting_time,
+    const int worker_id) const {
+  if (options_.virtualUsers() > 0) {
+    return createClosedLoop(time_source, dispatcher, sequencer_target,
+                            std::move(termination_predicate), scope, scheduled_starting_time,
+                            worker_id);
+  }
+  Frequency frequency(requestsPerSecondForWorker(worker_id));
+  RateLimiterPtr rate_limiter;
+  if (replay_schedule_ != nullptr) {
+    rate_limiter =
+        std::make_unique<ReplayRateLimiterImpl>(time_source, replay_schedule_, worker_id);
+  } else if (shared_rate_limiter_state_ != nullptr) {
+    rate_limiter =
+        std::make_unique<SharedLinearRateLimiterImpl>(time_source, shared_rate_limiter_state_);
+  } else {
+    rate_limiter = std::make_unique<LinearRateLimiter>(time_source, frequency);
+  }
+  rate_limiter = std::make_unique<ScheduledStartingRateLimiter>(std::move(rate_limiter),
+                                                                scheduled_starting_time);
+  return createWithRateLimiter(time_source, dispatcher, sequencer_target,
+                               std::move(termination_predicate), scope, std::move(rate_limiter),
+                               worker_id);
+}
+
+SequencerPtr SequencerFactoryImpl::createForLoadPhase(
+    Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+    const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
+    Envoy::Stats::Scope& scope, const nighthawk::client::LoadPhase& load_phase,
+    const absl::optional<Envoy::MonotonicTime> scheduled_starting_time,
+    const int worker_id) const {
+  RateLimiterPtr rate_limiter = createLoadPhaseRateLimiter(time_source, load_phase);
+  if (scheduled_starting_time.has_value()) {
+    rate_limiter = std::make_unique<ScheduledStartingRateLimiter>(std::move(rate_limiter),
+                                                                  scheduled_starting_time.value());
+  }
+  return createWithRateLimiter(time_source, dispatcher, sequencer_target,
+                               std::move(termination_predicate), scope, std::move(rate_limiter),
+                               worker_id);
+}
+
+SequencerPtr SequencerFactoryImpl::createForReleaseTiming(
+    Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+    const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
+    Envoy::Stats::Scope& scope, RequestReleaseTiming& timing,
+    const Envoy::MonotonicTime scheduled_starting_time, const int worker_id) const {
   StatisticFactoryImpl statistic_factory(options_);
-  Frequency frequency(options_.requestsPerSecond());
+  // Burst size and jitter would skew the timing, so they are not applied.
   RateLimiterPtr rate_limiter = std::make_unique<ScheduledStartingRateLimiter>(
-      std::make_unique<LinearRateLimiter>(time_source, frequency), scheduled_starting_time);
+      std::make_unique<ReleaseTimingRateLimiterImpl>(time_source, timing,
+                                                     statistic_factory.create()),
+      scheduled_starting_time);
+  if (recorded_schedule_ != nullptr) {
+    ASSERT(static_cast<uint32_t>(worker_id) < recorded_schedule_->workers());
+    rate_limiter = std::make_unique<RecordingRateLimiterImpl>(std::move(rate_limiter),
+                                                              recorded_schedule_, worker_id);
+  }
+  return std::make_unique<SequencerImpl>(
+      platform_util_, dispatcher, time_source, std::move(rate_limiter), sequencer_target,
+      statistic_factory.create(), statistic_factory.create(), options_.sequencerIdleStrategy(),
+      std::move(termination_predicate), scope);
+}
+
+SequencerPtr SequencerFactoryImpl::createClosedLoop(
+    Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+    const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
+    Envoy::Stats::Scope& scope, const Envoy::MonotonicTime scheduled_starting_time,
+    const int worker_id) const {
+  StatisticFactoryImpl statistic_factory(options_);
+  auto schedule = std::make_shared<VirtualUserSchedule>(
+      time_source, options_.virtualUsers(), options_.thinkTime(),
+      options_.thinkTimeDistribution() == nighthawk::client::ThinkTimeDistribution::EXPONENTIAL
+          ? VirtualUserSchedule::ThinkTimeDistribution::EXPONENTIAL
+          : VirtualUserSchedule::ThinkTimeDistribution::CONSTANT,
+      options_.seed().has_value()
+          ? SeededRandomGeneratorImpl::seedForWorker(options_.seed().value(), worker_id)
+          : std::mt19937_64::default_seed);
+  RateLimiterPtr rate_limiter = std::make_unique<ScheduledStartingRateLimiter>(
+      std::make_unique<ClosedLoopRateLimiterImpl>(time_source, schedule), scheduled_starting_time);
+  if (recorded_schedule_ != nullptr) {
+    ASSERT(static_cast<uint32_t>(worker_id) < recorded_schedule_->workers());
+    rate_limiter = std::make_unique<RecordingRateLimiterImpl>(std::move(rate_limiter),
+                                                              recorded_schedule_, worker_id);
+  }
+  // Wrap the target, so that virtual users start thinking when their request completes.
+  SequencerTarget closed_loop_target = [schedule,
+                                        sequencer_target](OperationCallback completion_callback) {
+    return sequencer_target([schedule, completion_callback](bool done, bool success) {
+      schedule->completeUser();
+      completion_callback(done, success);
+    });
+  };
+  return std::make_unique<SequencerImpl>(
+      platform_util_, dispatcher, time_source, std::move(rate_limiter),
+      std::move(closed_loop_target), statistic_factory.create(), statistic_factory.create(),
+      options_.sequencerIdleStrategy(), std::move(termination_predicate), scope);
+}
+
+SequencerPtr SequencerFactoryImpl::createWithRateLimiter(
+    Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+    const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
+    Envoy::Stats::Scope& scope, RateLimiterPtr&& rate_limiter, const int worker_id) const {
+  StatisticFactoryImpl statistic_factory(options_);
   const uint64_t burst_size = options_.burstSize();
 
   if (burst_size) {
@@ -85,20 +195,96 @@ SequencerPtr SequencerFactoryImpl::create(
   const std::chrono::nanoseconds jitter_uniform = options_.jitterUniform();
   if (jitter_uniform.count() > 0) {
     rate_limiter = std::make_unique<DistributionSamplingRateLimiterImpl>(
-        std::make_unique<UniformRandomDistributionSamplerImpl>(jitter_uniform.count()),
+        std::make_unique<UniformRandomDistributionSamplerImpl>(
+            jitter_uniform.count(),
+            options_.seed().has_value()
+                ? SeededRandomGeneratorImpl::seedForWorker(options_.seed().value(), worker_id)
+                : std::default_random_engine::default_seed),
         std::move(rate_limiter));
   }
 
+  // Record the outermost rate limiter, so that the recording reflects burst and jitter as well.
+  if (recorded_schedule_ != nullptr) {
+    ASSERT(static_cast<uint32_t>(worker_id) < recorded_schedule_->workers());
+    rate_limiter = std::make_unique<RecordingRateLimiterImpl>(std::move(rate_limiter),
+                                                              recorded_schedule_, worker_id);
+  }
+
   return std::make_unique<SequencerImpl>(
       platform_util_, dispatcher, time_source, std::move(rate_limiter), sequencer_target,
       statistic_factory.create(), statistic_factory.create(), options_.sequencerIdleStrategy(),
       std::move(termination_predicate), scope);
 }
 
+void SequencerFactoryImpl::setWorkers(const uint32_t workers) {
+  ASSERT(workers > 0);
+  if (shared_rate_limiter_state_ != nullptr) {
+    shared_rate_limiter_state_->setParticipants(workers);
+  }
+  if (recorded_schedule_ != nullptr) {
+    recorded_schedule_->addWorker(workers - 1);
+  }
+}
+
+uint64_t SequencerFactoryImpl::requestsPerSecondForWorker(const int worker_id) const {
+  const uint64_t requests_per_second = options_.requestsPerSecond();
+  if (rate_split_workers_ == 0) {
+    return requests_per_second;
+  }
+  // The first workers each take one of the requests per second that do not divide evenly.
+  return requests_per_second / rate_split_workers_ +
+         (static_cast<uint64_t>(worker_id) < requests_per_second % rate_split_workers_ ? 1 : 0);
+}
+
+RateLimiterPtr SequencerFactoryImpl::createLoadPhaseRateLimiter(
+    Envoy::TimeSource& time_source, const nighthawk::client::LoadPhase& load_phase) const {
+  const std::chrono::nanoseconds phase_duration(
+      Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(load_phase.duration()));
+  std::vector<RateCurvePoint> points;
+  switch (load_phase.rate_shape_case()) {
+  case nighthawk::client::LoadPhase::kConstant:
+    return std::make_unique<LinearRateLimiter>(
+        time_source, Frequency(load_phase.constant().requests_per_second().value()));
+  case nighthawk::client::LoadPhase::kLinearRamp:
+    // A ramp is a curve with two points, spanning the duration of the phase.
+    points.push_back(
+        {0ns, static_cast<double>(load_phase.linear_ramp().start_requests_per_second().value())});
+    points.push_back(
+        {phase_duration,
+         static_cast<double>(load_phase.linear_ramp().end_requests_per_second().value())});
+    break;
+  case nighthawk::client::LoadPhase::kSine:
+    return std::make_unique<SineRateLimiterImpl>(
+        time_source, Frequency(load_phase.sine().base_requests_per_second().value()),
+        load_phase.sine().amplitude_requests_per_second().value(),
+        std::chrono::nanoseconds(
+            Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(load_phase.sine().period())));
+  case nighthawk::client::LoadPhase::kRpsCurve:
+    for (const nighthawk::client::LoadPhase::RpsCurve::Point& point :
+         load_phase.rps_curve().points()) {
+      points.push_back(
+          {std::chrono::nanoseconds(
+               Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(point.offset())),
+           point.requests_per_second()});
+    }
+    break;
+  default:
+    throw NighthawkException("Load phase lacks a rate shape");
+  }
+  return std::make_unique<PiecewiseLinearRateLimiterImpl>(time_source, std::move(points));
+}
+
 StatisticFactoryImpl::StatisticFactoryImpl(const Options& options)
     : OptionBasedFactoryImpl(options) {}
 
-StatisticPtr StatisticFactoryImpl::create() const { return std::make_unique<HdrStatistic>(); }
+StatisticPtr StatisticFactoryImpl::create() const { return wrap(std::make_unique<HdrStatistic>()); }
+
+StatisticPtr StatisticFactoryImpl::wrap(StatisticPtr&& statistic) const {
+  if (options_.reportInterval().count() > 0) {
+    return std::make_unique<IntervalTrackingStatistic>(std::move(statistic));
+  }
+  return std::move(statistic);
+}
 
 OutputFormatterPtr OutputFormatterFactoryImpl::create(
     const nighthawk::client::OutputFormat_OutputFormatOptions output_format) const {
@@ -124,8 +310,14 @@ OutputFormatterPtr OutputFormatterFactoryImpl::create(
   }
 }
 
-RequestSourceFactoryImpl::RequestSourceFactoryImpl(const Options& options, Envoy::Api::Api& api)
-    : OptionBasedFactoryImpl(options), api_(api) {}
+RequestSourceFactoryImpl::RequestSourceFactoryImpl(const Options& options, Envoy::Api::Api& api,
+                                                   const uint32_t workers)
+    : OptionBasedFactoryImpl(options), api_(api),
+      // Buffer a second worth of requests for all workers, like their own streams would.
+      shared_remote_request_stream_(options.requestSourceSharedStream()
+                                        ? std::make_shared<SharedRemoteRequestStream>(
+                                              options.requestsPerSecond() * workers)
+                                        : nullptr) {}
 
 void RequestSourceFactoryImpl::setRequestHeader(Envoy::Http::RequestHeaderMap& header,
                                                 absl::string_view key,
@@ -139,7 +331,8 @@ void RequestSourceFactoryImpl::setRequestHeader(Envoy::Http::RequestHeaderMap& h
 RequestSourcePtr
 RequestSourceFactoryImpl::create(const Envoy::Upstream::ClusterManagerPtr& cluster_manager,
                                  Envoy::Event::Dispatcher& dispatcher, Envoy::Stats::Scope& scope,
-                                 absl::string_view service_cluster_name) const {
+                                 absl::string_view service_cluster_name,
+                                 const int worker_id) const {
   Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
   if (options_.uri().has_value()) {
     // We set headers based on the URI, but we don't have all the prerequisites to call the
@@ -179,12 +372,12 @@ RequestSourceFactoryImpl::create(const Envoy::Upstream::ClusterManagerPtr& clust
     RELEASE_ASSERT(!service_cluster_name.empty(), "expected cluster name to be set");
     // We pass in options_.requestsPerSecond() as the header buffer length so the grpc client
     // will shoot for maintaining an amount of headers of at least one second.
-    return std::make_unique<RemoteRequestSourceImpl>(cluster_manager, dispatcher, scope,
-                                                     service_cluster_name, std::move(header),
-                                                     options_.requestsPerSecond());
+    return std::make_unique<RemoteRequestSourceImpl>(
+        cluster_manager, dispatcher, scope, service_cluster_name, std::move(header),
+        options_.requestsPerSecond(), shared_remote_request_stream_);
   } else if (options_.requestSourcePluginConfig().has_value()) {
     absl::StatusOr<RequestSourcePtr> plugin_or = LoadRequestSourcePlugin(
-        options_.requestSourcePluginConfig().value(), api_, std::move(header));
+        options_.requestSourcePluginConfig().value(), api_, std::move(header), worker_id);
     if (!plugin_or.ok()) {
       throw NighthawkException(
           absl::StrCat("Request Source plugin loading error should have been caught "
@@ -199,34 +392,61 @@ RequestSourceFactoryImpl::create(const Envoy::Upstream::ClusterManagerPtr& clust
 }
 absl::StatusOr<RequestSourcePtr> RequestSourceFactoryImpl::LoadRequestSourcePlugin(
     const envoy::config::core::v3::TypedExtensionConfig& config, Envoy::Api::Api& api,
-    Envoy::Http::RequestHeaderMapPtr header) const {
+    Envoy::Http::RequestHeaderMapPtr header, const int worker_id) const {
   try {
     auto& config_factory =
         Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
             config.name());
-    return config_factory.createRequestSourcePlugin(config.typed_config(), api, std::move(header));
+    return config_factory.createRequestSourcePluginForWorker(config.typed_config(), api,
+                                                             std::move(header), worker_id);
   } catch (const Envoy::EnvoyException& e) {
     return absl::InvalidArgumentError(
         absl::StrCat("Could not load plugin: ", config.name(), ": ", e.what()));
   }
 }
 
-TerminationPredicateFactoryImpl::TerminationPredicateFactoryImpl(const Options& options)
-    : OptionBasedFactoryImpl(options) {}
+TerminationPredicateFactoryImpl::TerminationPredicateFactoryImpl(
+    const Options& options, const bool relative_to_current_counter_values)
+    : OptionBasedFactoryImpl(options),
+      relative_to_current_counter_values_(relative_to_current_counter_values) {}
 
 TerminationPredicatePtr
 TerminationPredicateFactoryImpl::create(Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
                                         const Envoy::MonotonicTime scheduled_starting_time) const {
+  return createInternal(time_source, scope,
+                        options_.noDuration()
+                            ? absl::nullopt
+                            : absl::optional<std::chrono::microseconds>(options_.duration()),
+                        scheduled_starting_time);
+}
+
+TerminationPredicatePtr TerminationPredicateFactoryImpl::createForLoadPhase(
+    Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
+    const nighthawk::client::LoadPhase& load_phase,
+    const Envoy::MonotonicTime starting_time) const {
+  return createInternal(
+      time_source, scope,
+      std::chrono::microseconds(
+          Envoy::Protobuf::util::TimeUtil::DurationToMicroseconds(load_phase.duration())),
+      starting_time);
+}
+
+TerminationPredicatePtr TerminationPredicateFactoryImpl::createInternal(
+    Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
+    const absl::optional<std::chrono::microseconds> duration,
+    const Envoy::MonotonicTime starting_time) const {
   // We'll always link a predicate which checks for requests to cancel.
+  Envoy::Stats::Counter& graceful_stop_requested =
+      scope.counterFromString("graceful_stop_requested");
   TerminationPredicatePtr root_predicate =
       std::make_unique<StatsCounterAbsoluteThresholdTerminationPredicateImpl>(
-          scope.counterFromString("graceful_stop_requested"), 0,
+          graceful_stop_requested, counterThreshold(graceful_stop_requested, 0),
           TerminationPredicate::Status::TERMINATE);
 
   TerminationPredicate* current_predicate = root_predicate.get();
-  if (!options_.noDuration()) {
+  if (duration.has_value()) {
     current_predicate = &current_predicate->link(std::make_unique<DurationTerminationPredicateImpl>(
-        time_source, options_.duration(), scheduled_starting_time));
+        time_source, duration.value(), starting_time));
   }
 
   current_predicate = linkConfiguredPredicates(*current_predicate, options_.failurePredicates(),
@@ -248,12 +468,18 @@ TerminationPredicate* TerminationPredicateFactoryImpl::linkConfiguredPredicates(
               termination_status == TerminationPredicate::Status::TERMINATE ? "termination"
                                                                             : "failure",
               predicate.first, predicate.second);
+    Envoy::Stats::Counter& counter = scope.counterFromString(predicate.first);
     current_predicate = &current_predicate->link(
         std::make_unique<StatsCounterAbsoluteThresholdTerminationPredicateImpl>(
-            scope.counterFromString(predicate.first), predicate.second, termination_status));
+            counter, counterThreshold(counter, predicate.second), termination_status));
   }
   return current_predicate;
 }
 
+uint64_t TerminationPredicateFactoryImpl::counterThreshold(const Envoy::Stats::Counter& counter,
+                                                           const uint64_t threshold) const {
+  return relative_to_current_counter_values_ ? counter.value() + threshold : threshold;
+}
+
 } // namespace Client
 } // namespace Nighthawk
@@ -6,6 +6,7 @@
 
 #include "nighthawk/client/factories.h"
 #include "nighthawk/common/factories.h"
+#include "nighthawk/common/rate_limiter.h"
 #include "nighthawk/common/termination_predicate.h"
 #include "nighthawk/common/uri.h"
 
@@ -13,6 +14,8 @@
 #include "external/envoy/source/common/config/utility.h"
 
 #include "source/common/platform_util_impl.h"
+#include "source/common/rate_limiter_impl.h"
+#include "source/common/request_source_impl.h"
 
 namespace Nighthawk {
 namespace Client {
@@ -44,13 +47,100 @@ public:
   SequencerPtr create(Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
                       const SequencerTarget& sequencer_target,
                       TerminationPredicatePtr&& termination_predicate, Envoy::Stats::Scope& scope,
-                      const Envoy::MonotonicTime scheduled_starting_time) const override;
+                      const Envoy::MonotonicTime scheduled_starting_time,
+                      const int worker_id) const override;
+  SequencerPtr createForLoadPhase(
+      Envoy::TimeSource& time_source, Envoy::Event::Dispatcher& dispatcher,
+      const SequencerTarget& sequencer_target, TerminationPredicatePtr&& termination_predicate,
+      Envoy::Stats::Scope& scope, const nighthawk::client::LoadPhase& load_phase,
+      const absl::optional<Envoy::MonotonicTime> scheduled_starting_time,
+      const int worker_id) const override;
+  SequencerPtr createForReleaseTiming(Envoy::TimeSource& time_source,
+                                      Envoy::Event::Dispatcher& dispatcher,
+                                      const SequencerTarget& sequencer_target,
+                                      TerminationPredicatePtr&& termination_predicate,
+                                      Envoy::Stats::Scope& scope, RequestReleaseTiming& timing,
+                                      const Envoy::MonotonicTime scheduled_starting_time,
+                                      const int worker_id) const override;
+
+  /**
+   * Makes sequencers created after this call replay the release schedule of a previous execution,
+   * instead of pacing requests at the configured rate.
+   * @param schedule the schedule to replay. It must hold an entry for each worker.
+   */
+  void setReplaySchedule(ReleaseScheduleSharedPtr schedule) { replay_schedule_ = schedule; }
+
+  /**
+   * @return ReleaseScheduleSharedPtr the schedule that sequencers record their releases to, or
+   * nullptr when recording has not been requested.
+   */
+  ReleaseScheduleSharedPtr recordedSchedule() const { return recorded_schedule_; }
+
+  /**
+   * Makes sequencers created after this call split the configured rate over the workers, instead
+   * of pacing each worker at the configured rate. Used when the number of workers is chosen
+   * adaptively.
+   * @param workers the number of workers to split the rate over. Must not exceed the rate.
+   */
+  void splitRateOverWorkers(const uint32_t workers) { rate_split_workers_ = workers; }
+
+  /**
+   * Sizes the state that the sequencers of all workers share, like the budget of global rate
+   * coordination and the recorded schedule. That state can't safely grow once workers run, so this
+   * must be called on the main thread before any of them creates a sequencer.
+   * @param workers the number of workers.
+   */
+  void setWorkers(const uint32_t workers);
+
+private:
+  /**
+   * @return uint64_t the rate the sequencer of the worker should pace requests at.
+   */
+  uint64_t requestsPerSecondForWorker(const int worker_id) const;
+  /**
+   * Applies the rate limiter wrappers configured via options (burst size, uniform jitter), and
+   * constructs a sequencer around the result.
+   */
+  SequencerPtr createWithRateLimiter(Envoy::TimeSource& time_source,
+                                     Envoy::Event::Dispatcher& dispatcher,
+                                     const SequencerTarget& sequencer_target,
+                                     TerminationPredicatePtr&& termination_predicate,
+                                     Envoy::Stats::Scope& scope, RateLimiterPtr&& rate_limiter,
+                                     const int worker_id) const;
+  /**
+   * Constructs a sequencer which drives the configured number of closed-loop virtual users.
+   */
+  SequencerPtr createClosedLoop(Envoy::TimeSource& time_source,
+                                Envoy::Event::Dispatcher& dispatcher,
+                                const SequencerTarget& sequencer_target,
+                                TerminationPredicatePtr&& termination_predicate,
+                                Envoy::Stats::Scope& scope,
+                                const Envoy::MonotonicTime scheduled_starting_time,
+                                const int worker_id) const;
+  RateLimiterPtr createLoadPhaseRateLimiter(Envoy::TimeSource& time_source,
+                                            const nighthawk::client::LoadPhase& load_phase) const;
+
+  // Budget shared across the sequencers of all workers, set when global rate coordination has
+  // been requested.
+  const SharedRateLimiterStateSharedPtr shared_rate_limiter_state_;
+  // Schedule the sequencers of all workers record their releases to, if requested.
+  const ReleaseScheduleSharedPtr recorded_schedule_;
+  ReleaseScheduleSharedPtr replay_schedule_;
+  // When set, the configured rate is split over this number of workers.
+  uint32_t rate_split_workers_{0};
 };
 
 class StatisticFactoryImpl : public OptionBasedFactoryImpl, public StatisticFactory {
 public:
   StatisticFactoryImpl(const Options& options);
   StatisticPtr create() const override;
+  /**
+   * Wraps a statistic so that it tracks intervals when the options specify a report interval.
+   *
+   * @param statistic the statistic to wrap.
+   * @return StatisticPtr the statistic, wrapped when needed.
+   */
+  StatisticPtr wrap(StatisticPtr&& statistic) const;
 };
 
 class OutputFormatterFactoryImpl : public OutputFormatterFactory {
@@ -61,13 +151,24 @@ public:
 
 class RequestSourceFactoryImpl : public OptionBasedFactoryImpl, public RequestSourceFactory {
 public:
-  RequestSourceFactoryImpl(const Options& options, Envoy::Api::Api& api);
+  /**
+   * @param options the options to create request sources for.
+   * @param api Api parameter that contains timesystem, filesystem, and threadfactory.
+   * @param workers the number of workers that request sources are created for. Sizes the buffer
+   * of the remote request stream when the workers share it.
+   */
+  RequestSourceFactoryImpl(const Options& options, Envoy::Api::Api& api,
+                           const uint32_t workers = 1);
   RequestSourcePtr create(const Envoy::Upstream::ClusterManagerPtr& cluster_manager,
                           Envoy::Event::Dispatcher& dispatcher, Envoy::Stats::Scope& scope,
-                          absl::string_view service_cluster_name) const override;
+                          absl::string_view service_cluster_name,
+                          const int worker_id) const override;
 
 private:
   Envoy::Api::Api& api_;
+  // Stream that the remote request sources of all workers dequeue from, set when the workers
+  // share a single stream to the remote request source.
+  const SharedRemoteRequestStreamSharedPtr shared_remote_request_stream_;
   void setRequestHeader(Envoy::Http::RequestHeaderMap& header, absl::string_view key,
                         absl::string_view value) const;
   /**
@@ -79,24 +180,46 @@ private:
    * @param api Api parameter that contains timesystem, filesystem, and threadfactory.
    * @param header Any headers in request specifiers yielded by the request
    * source plugin will override what is specified here.
+   * @param worker_id number of the worker that will use the plugin.
 
    * @return absl::StatusOr<RequestSourcePtr> Initialized plugin or error status due to missing
    * plugin or config proto validation error.
    */
   absl::StatusOr<RequestSourcePtr>
   LoadRequestSourcePlugin(const envoy::config::core::v3::TypedExtensionConfig& config,
-                          Envoy::Api::Api& api, Envoy::Http::RequestHeaderMapPtr header) const;
+                          Envoy::Api::Api& api, Envoy::Http::RequestHeaderMapPtr header,
+                          const int worker_id) const;
 };
 
 class TerminationPredicateFactoryImpl : public OptionBasedFactoryImpl,
                                         public TerminationPredicateFactory {
 public:
-  TerminationPredicateFactoryImpl(const Options& options);
+  /**
+   * @param options the options to create predicates for.
+   * @param relative_to_current_counter_values when true, counter thresholds apply to how much the
+   * counters increment after the predicates are created, instead of to their absolute values. Used
+   * for executions on warm workers, where counters carry over from earlier executions.
+   */
+  TerminationPredicateFactoryImpl(const Options& options,
+                                  const bool relative_to_current_counter_values = false);
   TerminationPredicatePtr create(Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
                                  const Envoy::MonotonicTime scheduled_starting_time) const override;
+  TerminationPredicatePtr
+  createForLoadPhase(Envoy::TimeSource& time_source, Envoy::Stats::Scope& scope,
+                     const nighthawk::client::LoadPhase& load_phase,
+                     const Envoy::MonotonicTime starting_time) const override;
   TerminationPredicate* linkConfiguredPredicates(
       TerminationPredicate& last_predicate, const TerminationPredicateMap& predicates,
       const TerminationPredicate::Status termination_status, Envoy::Stats::Scope& scope) const;
+
+private:
+  TerminationPredicatePtr createInternal(Envoy::TimeSource& time_source,
+                                         Envoy::Stats::Scope& scope,
+                                         const absl::optional<std::chrono::microseconds> duration,
+                                         const Envoy::MonotonicTime starting_time) const;
+  uint64_t counterThreshold(const Envoy::Stats::Counter& counter, const uint64_t threshold) const;
+
+  const bool relative_to_current_counter_values_;
 };
 
 } // namespace Client
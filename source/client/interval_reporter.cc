@@ -0,0 +1,115 @@
+#include "source/client/interval_reporter.h"
+
+#include <map>
+#include <string>
+
+#include "external/envoy/source/common/common/assert.h"
+#include "external/envoy/source/common/common/lock_guard.h"
+
+#include "source/client/output_collector_impl.h"
+
+namespace Nighthawk {
+namespace Client {
+
+IntervalReporter::IntervalReporter(Envoy::TimeSource& time_source, const Options& options,
+                                   const uint32_t workers, IntervalOutputCallback callback)
+    : time_source_(time_source), options_(options), callback_(std::move(callback)),
+      workers_(workers) {}
+
+void IntervalReporter::onReport(const uint32_t worker_number, IntervalReportPtr&& report) {
+  Envoy::Thread::LockGuard guard(lock_);
+  ASSERT(worker_number < workers_.size());
+  WorkerReports& worker = workers_[worker_number];
+  if (report == nullptr) {
+    worker.done = true;
+  } else {
+    worker.pending.push_back(std::move(report));
+  }
+  reports_changed_.notifyAll();
+}
+
+void IntervalReporter::emitUntilDone() {
+  while (true) {
+    std::vector<IntervalReportPtr> reports;
+    {
+      Envoy::Thread::LockGuard guard(lock_);
+      while (!intervalComplete() && !allDone()) {
+        reports_changed_.wait(lock_);
+      }
+      if (!intervalComplete()) {
+        return;
+      }
+      reports = takeInterval();
+    }
+    // Merging and serializing the output may take a while, so it happens without holding the lock
+    // that the workers need to queue their reports.
+    emitInterval(std::move(reports));
+  }
+}
+
+uint64_t IntervalReporter::emitted() const {
+  Envoy::Thread::LockGuard guard(lock_);
+  return emitted_;
+}
+
+bool IntervalReporter::intervalComplete() const {
+  bool any_pending = false;
+  for (const WorkerReports& worker : workers_) {
+    if (worker.pending.empty() && !worker.done) {
+      return false;
+    }
+    any_pending = any_pending || !worker.pending.empty();
+  }
+  return any_pending;
+}
+
+bool IntervalReporter::allDone() const {
+  for (const WorkerReports& worker : workers_) {
+    if (!worker.done) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<IntervalReportPtr> IntervalReporter::takeInterval() {
+  std::vector<IntervalReportPtr> reports;
+  for (WorkerReports& worker : workers_) {
+    if (!worker.pending.empty()) {
+      reports.push_back(std::move(worker.pending.front()));
+      worker.pending.pop_front();
+    }
+  }
+  return reports;
+}
+
+void IntervalReporter::emitInterval(std::vector<IntervalReportPtr>&& reports) {
+  ASSERT(!reports.empty());
+  std::map<std::string, StatisticPtr> statistics;
+  std::map<std::string, uint64_t> counters;
+  std::chrono::nanoseconds total_duration{0};
+  for (const IntervalReportPtr& report : reports) {
+    for (auto& statistic : report->statistics) {
+      StatisticPtr& merged = statistics[statistic.first];
+      merged = merged == nullptr ? std::move(statistic.second) : merged->combine(*statistic.second);
+      merged->setId(statistic.first);
+    }
+    for (const auto& counter : report->counters) {
+      counters[counter.first] += counter.second;
+    }
+    total_duration += report->duration;
+  }
+  std::vector<StatisticPtr> merged_statistics;
+  for (auto& statistic : statistics) {
+    merged_statistics.push_back(std::move(statistic.second));
+  }
+  OutputCollectorImpl collector(time_source_, options_);
+  collector.addResult("global", merged_statistics, counters, total_duration / reports.size(),
+                      absl::nullopt, {});
+  callback_(collector.toProto());
+  Envoy::Thread::LockGuard guard(lock_);
+  emitted_++;
+}
+
+} // namespace Client
+} // namespace Nighthawk
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "envoy/common/time.h"
+
+#include "nighthawk/client/client_worker.h"
+#include "nighthawk/client/options.h"
+#include "nighthawk/client/process.h"
+
+#include "external/envoy/source/common/common/thread.h"
+
+namespace Nighthawk {
+namespace Client {
+
+/**
+ * Merges the interval reports of the workers into intermediate output. The n-th output combines
+ * the n-th report of every worker, and gets emitted once all workers that are still executing
+ * delivered theirs. This way workers never wait for each other, and reporting never stops them:
+ * workers only queue their reports, while merging and emitting happens on the thread that calls
+ * emitUntilDone().
+ *
+ * Thread safe.
+ */
+class IntervalReporter {
+public:
+  /**
+   * @param time_source used to timestamp the output. Must be thread safe.
+   * @param options the options of the execution, which get included in the output.
+   * @param workers the number of workers that report.
+   * @param callback receives the intermediate output. Invoked on the thread that calls
+   * emitUntilDone().
+   */
+  IntervalReporter(Envoy::TimeSource& time_source, const Options& options, const uint32_t workers,
+                   IntervalOutputCallback callback);
+
+  /**
+   * Queues a report of a worker. Called on the thread of the worker.
+   *
+   * @param worker_number number of the reporting worker.
+   * @param report the report, or nullptr when the worker has completed its execution.
+   */
+  void onReport(const uint32_t worker_number, IntervalReportPtr&& report);
+
+  /**
+   * Emits intervals on the calling thread as they complete, and returns once all workers have
+   * completed their execution and everything they reported has been emitted.
+   */
+  void emitUntilDone();
+
+  /**
+   * @return uint64_t the number of outputs emitted so far.
+   */
+  uint64_t emitted() const;
+
+private:
+  struct WorkerReports {
+    std::deque<IntervalReportPtr> pending;
+    bool done{false};
+  };
+
+  /**
+   * @return bool true iff every worker either delivered its next report or is done, and at least
+   * one of them delivered.
+   */
+  bool intervalComplete() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  /**
+   * @return bool true iff every worker has completed its execution.
+   */
+  bool allDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  /**
+   * Dequeues the reports of the next interval, which must be complete.
+   */
+  std::vector<IntervalReportPtr> takeInterval() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  /**
+   * Merges the reports of an interval, and hands the result to the callback.
+   */
+  void emitInterval(std::vector<IntervalReportPtr>&& reports);
+
+  Envoy::TimeSource& time_source_;
+  const Options& options_;
+  const IntervalOutputCallback callback_;
+  mutable Envoy::Thread::MutexBasicLockable lock_;
+  Envoy::Thread::CondVar reports_changed_;
+  std::vector<WorkerReports> workers_ ABSL_GUARDED_BY(lock_);
+  uint64_t emitted_ ABSL_GUARDED_BY(lock_){0};
+};
+
+} // namespace Client
+} // namespace Nighthawk
@@ -3,7 +3,9 @@
 #include <cerrno>
 #include <cstdint>
 #include <exception>
+#include <fstream>
 
+#include "external/envoy/source/common/network/utility.h"
 #include "external/envoy/source/common/protobuf/message_validator_impl.h"
 #include "external/envoy/source/common/protobuf/protobuf.h"
 #include "external/envoy/source/common/protobuf/utility.h"
@@ -11,12 +13,16 @@
 #include "api/client/options.pb.validate.h"
 
 #include "source/client/output_formatter_impl.h"
+#include "source/common/cpu_topology_impl.h"
 #include "source/common/uri_impl.h"
 #include "source/common/utility.h"
 #include "source/common/version_info.h"
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
 #include "absl/types/optional.h"
 #include "fmt/ranges.h"
@@ -125,7 +131,10 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv) {
           "The number of concurrent event loops that should be used. Specify 'auto' to let "
           "Nighthawk leverage all vCPUs that have affinity to the Nighthawk process. Note that "
           "increasing this results in an effective load multiplier combined with the configured "
-          "--rps and --connections values. Default: {}. ",
+          "--rps and --connections values. Specify 'adaptive' to first drive a single worker to "
+          "saturation against the target for a few seconds, and then use the smallest number of "
+          "workers that can sustain the requested rate with headroom. In that case --rps "
+          "specifies the global rate, which is split over the workers. Default: {}. ",
           concurrency_),
       false, "", "string", cmd);
 
@@ -345,7 +354,8 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv) {
   TCLAP::ValueArg<std::string> request_source(
       "", "request-source",
       "Remote gRPC source that will deliver to-be-replayed traffic. Each worker will separately "
-      "connect to this source. For example grpc://127.0.0.1:8443/. "
+      "connect to this source, unless --request-source-shared-stream is set. For example "
+      "grpc://127.0.0.1:8443/. "
       "Mutually exclusive with --request_source_plugin_config.",
       false, "", "uri format", cmd);
   TCLAP::ValueArg<std::string> request_source_plugin_config(
@@ -412,6 +422,146 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv) {
       "fail_data:\"false\"}}",
       false, "string", cmd);
 
+  TCLAP::ValueArg<std::string> load_profile(
+      "", "load-profile",
+      "Multi-phase load profile in json. The phases are executed back to back using the same "
+      "workers and connection pools, and supersede --rps and --duration. Each phase specifies its "
+      "duration and a rate shape, which is one of constant, linear_ramp, sine, or rps_curve. "
+      "Frequencies are per worker. Results are reported per phase in addition to the results "
+      "covering the whole execution. Example (json): "
+      "{phases:[{id:\"warmup\",duration:\"10s\",linear_ramp:{start_requests_per_second:1,"
+      "end_requests_per_second:100}},{duration:\"30s\",constant:{requests_per_second:100}},"
+      "{duration:\"60s\",rps_curve:{file:\"/path/to/curve.csv\"}}]}",
+      false, "", "string", cmd);
+  TCLAP::SwitchArg global_rate_coordination(
+      "", "global-rate-coordination",
+      "Coordinate request releases across all workers by drawing from a single shared budget, "
+      "instead of statically splitting the rate over the workers. When a worker lags behind, the "
+      "other workers pick up the releases it could not issue, so that the aggregate rate tracks "
+      "--rps times the number of workers. Not supported in combination with --load-profile. "
+      "Default is false.",
+      cmd);
+  TCLAP::ValueArg<uint32_t> virtual_users(
+      "", "virtual-users",
+      "Run in closed-loop mode, simulating the specified number of virtual users per worker. Each "
+      "virtual user issues a request, waits for it to complete plus --think-time, and then issues "
+      "its next request. No rate limiting is applied, which means that --rps, --burst-size and "
+      "--jitter-uniform do not apply. Default is 0, which disables closed-loop mode.",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<std::string> think_time(
+      "", "think-time",
+      "Time a virtual user waits after a completion before it issues its next request. Only "
+      "applies in combination with --virtual-users. For example, specify 0.5s. Default is 0s.",
+      false, "", "duration", cmd);
+  std::vector<std::string> think_time_distributions = {"constant", "exponential"};
+  TCLAP::ValuesConstraint<std::string> think_time_distributions_allowed(think_time_distributions);
+  TCLAP::ValueArg<std::string> think_time_distribution(
+      "", "think-time-distribution",
+      "Distribution used to sample think times. When set to exponential, --think-time specifies "
+      "the mean. Default is constant.",
+      false, "", &think_time_distributions_allowed, cmd);
+  TCLAP::ValueArg<uint64_t> seed(
+      "", "seed",
+      "Seed for all randomness that affects what is offered to the target: request release timing "
+      "jitter, closed-loop think times, and the uuids used for tracing. Each worker derives its "
+      "own seed from this, so two executions with identical options and seed produce the same "
+      "offered load. Default is unset, in which case jitter and think times are drawn from fixed "
+      "default seeds, the same on every worker, and uuids are drawn from a non-deterministic "
+      "generator.",
+      false, 0, "uint64_t", cmd);
+  TCLAP::ValueArg<std::string> record_schedule(
+      "", "record-schedule",
+      "Path of a file to record the exact request release schedule of each worker to. The file "
+      "can be passed to --replay-schedule to offer the exact same load in a later execution. Not "
+      "supported in combination with --load-profile.",
+      false, "", "path", cmd);
+  TCLAP::ValueArg<std::string> replay_schedule(
+      "", "replay-schedule",
+      "Path of a file written earlier via --record-schedule. Instead of pacing requests according "
+      "to --rps, each worker releases requests at the recorded points in time. The number of "
+      "workers must match the recording. Mutually exclusive with --record-schedule, and not "
+      "supported in combination with --load-profile, --virtual-users, "
+      "--global-rate-coordination, --burst-size and --jitter-uniform.",
+      false, "", "path", cmd);
+  std::vector<std::string> termination_modes = {"drain", "bounded-drain", "hard-cut"};
+  TCLAP::ValuesConstraint<std::string> termination_modes_allowed(termination_modes);
+  TCLAP::ValueArg<std::string> termination_mode(
+      "", "termination-mode",
+      "What happens to in-flight requests when execution ends. With drain, the client waits up "
+      "to --timeout for in-flight requests to complete after results have been reported. With "
+      "bounded-drain, the client waits up to --drain-timeout before results are reported, and "
+      "reports the latencies of drained responses separately. With hard-cut, in-flight requests "
+      "are abandoned right away and counted separately. Default is drain.",
+      false, "", &termination_modes_allowed, cmd);
+  TCLAP::ValueArg<std::string> drain_timeout(
+      "", "drain-timeout",
+      "Maximum time to wait for in-flight requests to complete when --termination-mode is "
+      "bounded-drain. For example, specify 0.5s. Default is 1s.",
+      false, "", "duration", cmd);
+  std::vector<std::string> cpu_pinnings = {"none", "numa-compact"};
+  TCLAP::ValuesConstraint<std::string> cpu_pinnings_allowed(cpu_pinnings);
+  TCLAP::ValueArg<std::string> cpu_pinning(
+      "", "cpu-pinning",
+      "How worker threads are placed on cpus. With numa-compact, each worker is pinned to a "
+      "single cpu out of the cpus the process may run on, filling up NUMA nodes one after the "
+      "other, and per-worker state is allocated while running on the worker's cpu so that it "
+      "lands in node-local memory. Cannot be combined with --worker-cpu-set. Default is none.",
+      false, "", &cpu_pinnings_allowed, cmd);
+  TCLAP::MultiArg<std::string> worker_cpu_sets(
+      "", "worker-cpu-set",
+      "Pins a worker to a cpu list, for example \"0-3,8\". Specify once per worker: the n-th "
+      "occurrence applies to the n-th worker, and the number of occurrences must match the "
+      "number of workers. Per-worker state is allocated while running on the worker's cpus.",
+      false, "cpulist", cmd);
+  TCLAP::ValueArg<std::string> flush_worker_cpu_set(
+      "", "flush-worker-cpu-set",
+      "Pins the worker that flushes statistics to sinks to a cpu list, for example \"7\".",
+      false, "", "cpulist", cmd);
+  TCLAP::MultiArg<std::string> worker_source_addresses(
+      "", "worker-source-address",
+      "Source address for the upstream connections of a worker. May be specified multiple "
+      "times: the worker with index i binds its connections to occurrence i modulo the number "
+      "of occurrences. Combined with receive side scaling rules on the NIC, this allows "
+      "steering the responses for a worker to a queue serviced by the worker's cpu. Overrides "
+      "the source address of --upstream-bind-config.",
+      false, "ip", cmd);
+  TCLAP::ValueArg<uint32_t> worker_source_port_base(
+      "", "worker-source-port-base",
+      "When set, the worker with index i binds its upstream connection to source port "
+      "worker-source-port-base + i. Requires --connections 1.",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> busy_poll_us(
+      "", "busy-poll-us",
+      "Sets SO_BUSY_POLL on upstream sockets, so that reads busy-poll the device queue for up to "
+      "the specified number of microseconds instead of waiting for an interrupt. Linux only.",
+      false, 0, "uint32_t", cmd);
+  TCLAP::SwitchArg incoming_cpu_affinity(
+      "", "incoming-cpu-affinity",
+      "Sets SO_INCOMING_CPU on upstream sockets to the cpu the worker is pinned to. Requires "
+      "--cpu-pinning numa-compact or --worker-cpu-set. Linux only. Default is false.",
+      cmd);
+  TCLAP::ValueArg<std::string> report_interval(
+      "", "report-interval",
+      "Interval at which nighthawk_service streams intermediate results while an execution runs. "
+      "Each report holds the counter increments and latency histograms since the previous one. "
+      "Only applies to executions run by nighthawk_service. For example, specify 10s. Default is "
+      "0s, which disables intermediate reports.",
+      false, "", "duration", cmd);
+  TCLAP::ValueArg<uint32_t> event_loop_utilization_threshold(
+      "", "event-loop-utilization-threshold",
+      "When set, workers measure how busy their event loop is, along with their cpu time and "
+      "context switches, and report these as statistics and counters. Workers whose event loop "
+      "was busy for more than the specified percentage of the execution are flagged as "
+      "overloaded, which indicates that more workers are needed for accurate results. Valid "
+      "values are 1-100.",
+      false, 0, "uint32_t", cmd);
+  TCLAP::SwitchArg request_source_shared_stream(
+      "", "request-source-shared-stream",
+      "Fetch the requests of all workers over a single stream to the --request-source, instead of "
+      "connecting each worker separately. Workers dequeue the requests in the order in which the "
+      "service yields them. Requires --request-source. Default is false.",
+      cmd);
+
   Utility::parseCommand(cmd, argc, argv);
 
   if (h2_use_multiple_connections.isSet()) {
@@ -584,6 +734,84 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv) {
   TCLAP_SET_IF_SPECIFIED(labels, labels_);
   TCLAP_SET_IF_SPECIFIED(simple_warmup, simple_warmup_);
   TCLAP_SET_IF_SPECIFIED(no_duration, no_duration_);
+  TCLAP_SET_IF_SPECIFIED(global_rate_coordination, global_rate_coordination_);
+  TCLAP_SET_IF_SPECIFIED(virtual_users, virtual_users_);
+  if (seed.isSet()) {
+    seed_ = seed.getValue();
+  }
+  TCLAP_SET_IF_SPECIFIED(record_schedule, record_schedule_);
+  TCLAP_SET_IF_SPECIFIED(replay_schedule, replay_schedule_);
+  if (think_time.isSet()) {
+    Envoy::Protobuf::Duration duration;
+    if (Envoy::Protobuf::util::TimeUtil::FromString(think_time.getValue(), &duration)) {
+      if (duration.nanos() >= 0 && duration.seconds() >= 0) {
+        think_time_ = std::chrono::nanoseconds(
+            Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(duration));
+      } else {
+        throw MalformedArgvException("--think-time is out of range");
+      }
+    } else {
+      throw MalformedArgvException("Invalid value for --think-time");
+    }
+  }
+  if (think_time_distribution.isSet()) {
+    std::string upper_cased = think_time_distribution.getValue();
+    absl::AsciiStrToUpper(&upper_cased);
+    // TCLAP validation ought to have caught this earlier.
+    RELEASE_ASSERT(nighthawk::client::ThinkTimeDistribution::ThinkTimeDistributionOptions_Parse(
+                       upper_cased, &think_time_distribution_),
+                   "Failed to parse think time distribution");
+  }
+  if (termination_mode.isSet()) {
+    std::string upper_cased = absl::StrReplaceAll(termination_mode.getValue(), {{"-", "_"}});
+    absl::AsciiStrToUpper(&upper_cased);
+    // TCLAP validation ought to have caught this earlier.
+    RELEASE_ASSERT(nighthawk::client::TerminationMode::TerminationModeOptions_Parse(
+                       upper_cased, &termination_mode_),
+                   "Failed to parse termination mode");
+  }
+  if (cpu_pinning.isSet()) {
+    std::string upper_cased = absl::StrReplaceAll(cpu_pinning.getValue(), {{"-", "_"}});
+    absl::AsciiStrToUpper(&upper_cased);
+    // TCLAP validation ought to have caught this earlier.
+    RELEASE_ASSERT(
+        nighthawk::client::CpuPinning::CpuPinningOptions_Parse(upper_cased, &cpu_pinning_),
+        "Failed to parse cpu pinning");
+  }
+  TCLAP_SET_IF_SPECIFIED(worker_cpu_sets, worker_cpu_sets_);
+  TCLAP_SET_IF_SPECIFIED(flush_worker_cpu_set, flush_worker_cpu_set_);
+  TCLAP_SET_IF_SPECIFIED(worker_source_addresses, worker_source_addresses_);
+  TCLAP_SET_IF_SPECIFIED(worker_source_port_base, worker_source_port_base_);
+  TCLAP_SET_IF_SPECIFIED(busy_poll_us, busy_poll_us_);
+  TCLAP_SET_IF_SPECIFIED(incoming_cpu_affinity, incoming_cpu_affinity_);
+  TCLAP_SET_IF_SPECIFIED(event_loop_utilization_threshold, event_loop_utilization_threshold_);
+  TCLAP_SET_IF_SPECIFIED(request_source_shared_stream, request_source_shared_stream_);
+  if (report_interval.isSet()) {
+    Envoy::Protobuf::Duration duration;
+    if (Envoy::Protobuf::util::TimeUtil::FromString(report_interval.getValue(), &duration)) {
+      if (duration.nanos() >= 0 && duration.seconds() >= 0) {
+        report_interval_ = std::chrono::nanoseconds(
+            Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(duration));
+      } else {
+        throw MalformedArgvException("--report-interval is out of range");
+      }
+    } else {
+      throw MalformedArgvException("Invalid value for --report-interval");
+    }
+  }
+  if (drain_timeout.isSet()) {
+    Envoy::Protobuf::Duration duration;
+    if (Envoy::Protobuf::util::TimeUtil::FromString(drain_timeout.getValue(), &duration)) {
+      if (duration.nanos() >= 0 && duration.seconds() >= 0) {
+        drain_timeout_ = std::chrono::nanoseconds(
+            Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(duration));
+      } else {
+        throw MalformedArgvException("--drain-timeout is out of range");
+      }
+    } else {
+      throw MalformedArgvException("Invalid value for --drain-timeout");
+    }
+  }
   if (stats_sinks.isSet()) {
     for (const std::string& stats_sink : stats_sinks.getValue()) {
       envoy::config::metrics::v3::StatsSink sink;
@@ -711,6 +939,17 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv) {
     }
   }
 
+  if (!load_profile.getValue().empty()) {
+    try {
+      load_profile_.emplace(nighthawk::client::LoadProfile());
+      Envoy::MessageUtil::loadFromJson(load_profile.getValue(), load_profile_.value(),
+                                       Envoy::ProtobufMessage::getStrictValidationVisitor());
+    } catch (const Envoy::EnvoyException& e) {
+      throw MalformedArgvException(e.what());
+    }
+    inlineLoadProfileCurveFiles();
+  }
+
   if (tunnel_protocol.isSet()) {
     std::string upper_cased = tunnel_protocol.getValue();
     absl::AsciiStrToUpper(&upper_cased);
@@ -927,6 +1166,45 @@ OptionsImpl::OptionsImpl(const nighthawk::client::CommandLineOptions& options) {
   h2_use_multiple_connections_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
       options, experimental_h2_use_multiple_connections, h2_use_multiple_connections_);
   simple_warmup_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, simple_warmup, simple_warmup_);
+  global_rate_coordination_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, global_rate_coordination,
+                                                              global_rate_coordination_);
+  virtual_users_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, virtual_users, virtual_users_);
+  if (options.has_think_time()) {
+    think_time_ = std::chrono::nanoseconds(
+        Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(options.think_time()));
+  }
+  think_time_distribution_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, think_time_distribution,
+                                                             think_time_distribution_);
+  if (options.has_seed()) {
+    seed_ = options.seed().value();
+  }
+  record_schedule_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, record_schedule, record_schedule_);
+  replay_schedule_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, replay_schedule, replay_schedule_);
+  termination_mode_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, termination_mode, termination_mode_);
+  if (options.has_drain_timeout()) {
+    drain_timeout_ = std::chrono::nanoseconds(
+        Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(options.drain_timeout()));
+  }
+  cpu_pinning_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, cpu_pinning, cpu_pinning_);
+  std::copy(options.worker_cpu_sets().begin(), options.worker_cpu_sets().end(),
+            std::back_inserter(worker_cpu_sets_));
+  flush_worker_cpu_set_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, flush_worker_cpu_set, flush_worker_cpu_set_);
+  std::copy(options.worker_source_addresses().begin(), options.worker_source_addresses().end(),
+            std::back_inserter(worker_source_addresses_));
+  worker_source_port_base_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, worker_source_port_base, worker_source_port_base_);
+  busy_poll_us_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, busy_poll_us, busy_poll_us_);
+  incoming_cpu_affinity_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, incoming_cpu_affinity, incoming_cpu_affinity_);
+  event_loop_utilization_threshold_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      options, event_loop_utilization_threshold, event_loop_utilization_threshold_);
+  request_source_shared_stream_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      options, request_source_shared_stream, request_source_shared_stream_);
+  if (options.has_report_interval()) {
+    report_interval_ = std::chrono::nanoseconds(
+        Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(options.report_interval()));
+  }
   if (options.has_no_duration()) {
     no_duration_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(options, no_duration, no_duration_);
   }
@@ -947,9 +1225,54 @@ OptionsImpl::OptionsImpl(const nighthawk::client::CommandLineOptions& options) {
        options.user_defined_plugin_configs()) {
     user_defined_output_plugin_configs_.push_back(typed_config);
   }
+  if (options.has_load_profile()) {
+    load_profile_.emplace(nighthawk::client::LoadProfile());
+    load_profile_.value().MergeFrom(options.load_profile());
+    inlineLoadProfileCurveFiles();
+  }
   validate();
 }
 
+void OptionsImpl::inlineLoadProfileCurveFiles() {
+  for (nighthawk::client::LoadPhase& phase : *load_profile_.value().mutable_phases()) {
+    if (!phase.has_rps_curve() || phase.rps_curve().file().empty()) {
+      continue;
+    }
+    nighthawk::client::LoadPhase::RpsCurve* curve = phase.mutable_rps_curve();
+    if (curve->points_size() > 0) {
+      throw MalformedArgvException("rps_curve file and points are mutually exclusive");
+    }
+    std::ifstream file(curve->file());
+    if (!file.is_open()) {
+      throw MalformedArgvException(
+          fmt::format("Unable to open rps_curve file '{}'", curve->file()));
+    }
+    std::string line;
+    uint32_t line_number = 0;
+    while (std::getline(file, line)) {
+      line_number++;
+      const absl::string_view stripped = absl::StripAsciiWhitespace(line);
+      if (stripped.empty() || absl::StartsWith(stripped, "#")) {
+        continue;
+      }
+      const std::vector<absl::string_view> fields = absl::StrSplit(stripped, ',');
+      double offset_seconds;
+      double requests_per_second;
+      if (fields.size() != 2 ||
+          !absl::SimpleAtod(absl::StripAsciiWhitespace(fields[0]), &offset_seconds) ||
+          !absl::SimpleAtod(absl::StripAsciiWhitespace(fields[1]), &requests_per_second)) {
+        throw MalformedArgvException(fmt::format("Malformed line {} in rps_curve file '{}': '{}'",
+                                                 line_number, curve->file(), line));
+      }
+      nighthawk::client::LoadPhase::RpsCurve::Point* point = curve->add_points();
+      *point->mutable_offset() = Envoy::Protobuf::util::TimeUtil::NanosecondsToDuration(
+          static_cast<int64_t>(offset_seconds * 1e9));
+      point->set_requests_per_second(requests_per_second);
+    }
+    curve->clear_file();
+  }
+}
+
 void OptionsImpl::setNonTrivialDefaults() {
   concurrency_ = "1";
   // By default, we don't tolerate error status codes and connection failures, and will report
@@ -970,8 +1293,15 @@ void OptionsImpl::validate() const {
         "The experimental_h2_use_multiple_connections option is deprecated, set "
         "max_concurrent_streams to one instead.");
   }
-  // concurrency must be either 'auto' or a positive integer.
-  if (concurrency_ != "auto") {
+  // concurrency must be either 'auto', 'adaptive' or a positive integer.
+  if (concurrency_ == "adaptive") {
+    if (load_profile_.has_value() || virtual_users_ > 0 || global_rate_coordination_ ||
+        !replay_schedule_.empty()) {
+      throw MalformedArgvException(
+          "--concurrency adaptive is not supported in combination with --load-profile, "
+          "--virtual-users, --global-rate-coordination or --replay-schedule");
+    }
+  } else if (concurrency_ != "auto") {
     int parsed_concurrency;
     try {
       parsed_concurrency = std::stoi(concurrency_);
@@ -993,6 +1323,8 @@ void OptionsImpl::validate() const {
     } catch (const UriException&) {
       throw MalformedArgvException("Invalid replay source URI");
     }
+  } else if (request_source_shared_stream_) {
+    throw MalformedArgvException("--request-source-shared-stream requires --request-source");
   }
   if (uri_.has_value()) {
     try {
@@ -1013,6 +1345,79 @@ void OptionsImpl::validate() const {
     }
   }
 
+  if (!record_schedule_.empty() && load_profile_.has_value()) {
+    throw MalformedArgvException(
+        "--record-schedule is not supported in combination with --load-profile");
+  }
+  if (!replay_schedule_.empty()) {
+    if (!record_schedule_.empty()) {
+      throw MalformedArgvException(
+          "--replay-schedule and --record-schedule are mutually exclusive");
+    }
+    if (load_profile_.has_value() || virtual_users_ > 0 || global_rate_coordination_ ||
+        burst_size_ > 0 || jitter_uniform_.count() > 0) {
+      throw MalformedArgvException(
+          "--replay-schedule is not supported in combination with --load-profile, "
+          "--virtual-users, --global-rate-coordination, --burst-size or --jitter-uniform");
+    }
+  }
+  if (virtual_users_ > 0) {
+    if (load_profile_.has_value() || global_rate_coordination_) {
+      throw MalformedArgvException("--virtual-users is not supported in combination with "
+                                   "--load-profile or --global-rate-coordination");
+    }
+    if (burst_size_ > 0 || jitter_uniform_.count() > 0) {
+      throw MalformedArgvException(
+          "--virtual-users is not supported in combination with --burst-size or --jitter-uniform");
+    }
+  }
+  if (cpu_pinning_ == nighthawk::client::CpuPinning::NUMA_COMPACT && !worker_cpu_sets_.empty()) {
+    throw MalformedArgvException("--cpu-pinning numa-compact and --worker-cpu-set cannot both "
+                                 "be specified");
+  }
+  for (const std::string& cpu_set : worker_cpu_sets_) {
+    const absl::StatusOr<CpuSet> cpus = CpuTopology::parseCpuList(cpu_set);
+    if (!cpus.ok()) {
+      throw MalformedArgvException(
+          fmt::format("Invalid value for --worker-cpu-set: {}", cpus.status().message()));
+    }
+  }
+  if (!flush_worker_cpu_set_.empty()) {
+    const absl::StatusOr<CpuSet> cpus = CpuTopology::parseCpuList(flush_worker_cpu_set_);
+    if (!cpus.ok()) {
+      throw MalformedArgvException(
+          fmt::format("Invalid value for --flush-worker-cpu-set: {}", cpus.status().message()));
+    }
+  }
+  for (const std::string& address : worker_source_addresses_) {
+    if (Envoy::Network::Utility::parseInternetAddressNoThrow(address) == nullptr) {
+      throw MalformedArgvException(
+          fmt::format("Invalid value for --worker-source-address: '{}'", address));
+    }
+  }
+  if (worker_source_port_base_ > 0 && connections_ != 1) {
+    throw MalformedArgvException("--worker-source-port-base requires --connections 1");
+  }
+  if (incoming_cpu_affinity_ && worker_cpu_sets_.empty() &&
+      cpu_pinning_ != nighthawk::client::CpuPinning::NUMA_COMPACT) {
+    throw MalformedArgvException(
+        "--incoming-cpu-affinity requires --cpu-pinning numa-compact or --worker-cpu-set");
+  }
+  if (load_profile_.has_value() && global_rate_coordination_) {
+    throw MalformedArgvException(
+        "--global-rate-coordination is not supported in combination with --load-profile");
+  }
+  if (load_profile_.has_value()) {
+    absl::flat_hash_set<std::string> phase_ids;
+    for (const nighthawk::client::LoadPhase& phase : load_profile_.value().phases()) {
+      if (phase.has_id() && !phase_ids.insert(phase.id().value()).second) {
+        throw MalformedArgvException(
+            fmt::format("Duplicate load profile phase id: '{}'", phase.id().value()));
+      }
+      validateLoadPhase(phase);
+    }
+  }
+
   try {
     Envoy::MessageUtil::validate(*toCommandLineOptionsInternal(),
                                  Envoy::ProtobufMessage::getStrictValidationVisitor());
@@ -1021,6 +1426,26 @@ void OptionsImpl::validate() const {
   }
 }
 
+void OptionsImpl::validateLoadPhase(const nighthawk::client::LoadPhase& phase) {
+  if (phase.has_sine() && phase.sine().amplitude_requests_per_second().value() >
+                              phase.sine().base_requests_per_second().value()) {
+    throw MalformedArgvException("sine amplitude may not exceed the base frequency");
+  }
+  if (phase.has_rps_curve()) {
+    if (phase.rps_curve().points().empty()) {
+      throw MalformedArgvException("rps_curve requires at least one point");
+    }
+    for (int i = 1; i < phase.rps_curve().points_size(); i++) {
+      if (Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(
+              phase.rps_curve().points(i).offset()) <=
+          Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(
+              phase.rps_curve().points(i - 1).offset())) {
+        throw MalformedArgvException("rps_curve offsets must be strictly increasing");
+      }
+    }
+  }
+}
+
 CommandLineOptionsPtr OptionsImpl::toCommandLineOptions() const {
   return toCommandLineOptionsInternal();
 }
@@ -1134,6 +1559,53 @@ CommandLineOptionsPtr OptionsImpl::toCommandLineOptionsInternal() const {
     *command_line_options->add_labels() = label;
   }
   command_line_options->mutable_simple_warmup()->set_value(simple_warmup_);
+  command_line_options->mutable_global_rate_coordination()->set_value(global_rate_coordination_);
+  if (virtual_users_ > 0) {
+    command_line_options->mutable_virtual_users()->set_value(virtual_users_);
+    *command_line_options->mutable_think_time() =
+        Envoy::Protobuf::util::TimeUtil::NanosecondsToDuration(think_time_.count());
+    command_line_options->mutable_think_time_distribution()->set_value(think_time_distribution_);
+  }
+  if (seed_.has_value()) {
+    command_line_options->mutable_seed()->set_value(seed_.value());
+  }
+  if (!record_schedule_.empty()) {
+    command_line_options->mutable_record_schedule()->set_value(record_schedule_);
+  }
+  if (!replay_schedule_.empty()) {
+    command_line_options->mutable_replay_schedule()->set_value(replay_schedule_);
+  }
+  command_line_options->mutable_termination_mode()->set_value(termination_mode_);
+  *command_line_options->mutable_drain_timeout() =
+      Envoy::Protobuf::util::TimeUtil::NanosecondsToDuration(drain_timeout_.count());
+  command_line_options->mutable_cpu_pinning()->set_value(cpu_pinning_);
+  for (const std::string& cpu_set : worker_cpu_sets_) {
+    *command_line_options->add_worker_cpu_sets() = cpu_set;
+  }
+  if (!flush_worker_cpu_set_.empty()) {
+    command_line_options->mutable_flush_worker_cpu_set()->set_value(flush_worker_cpu_set_);
+  }
+  for (const std::string& address : worker_source_addresses_) {
+    *command_line_options->add_worker_source_addresses() = address;
+  }
+  if (worker_source_port_base_ > 0) {
+    command_line_options->mutable_worker_source_port_base()->set_value(worker_source_port_base_);
+  }
+  if (busy_poll_us_ > 0) {
+    command_line_options->mutable_busy_poll_us()->set_value(busy_poll_us_);
+  }
+  command_line_options->mutable_incoming_cpu_affinity()->set_value(incoming_cpu_affinity_);
+  if (report_interval_.count() > 0) {
+    *command_line_options->mutable_report_interval() =
+        Envoy::Protobuf::util::TimeUtil::NanosecondsToDuration(report_interval_.count());
+  }
+  if (event_loop_utilization_threshold_ > 0) {
+    command_line_options->mutable_event_loop_utilization_threshold()->set_value(
+        event_loop_utilization_threshold_);
+  }
+  if (request_source_shared_stream_) {
+    command_line_options->mutable_request_source_shared_stream()->set_value(true);
+  }
   if (no_duration_) {
     command_line_options->mutable_no_duration()->set_value(no_duration_);
   }
@@ -1159,6 +1631,9 @@ CommandLineOptionsPtr OptionsImpl::toCommandLineOptionsInternal() const {
        user_defined_output_plugin_configs_) {
     *command_line_options->add_user_defined_plugin_configs() = config;
   }
+  if (load_profile_.has_value()) {
+    *(command_line_options->mutable_load_profile()) = load_profile_.value();
+  }
   return command_line_options;
 }
 
@@ -128,12 +128,55 @@ public:
   userDefinedOutputPluginConfigs() const override {
     return user_defined_output_plugin_configs_;
   }
+  const absl::optional<nighthawk::client::LoadProfile>& loadProfile() const override {
+    return load_profile_;
+  }
+  bool globalRateCoordination() const override { return global_rate_coordination_; }
+  uint32_t virtualUsers() const override { return virtual_users_; }
+  std::chrono::nanoseconds thinkTime() const override { return think_time_; }
+  nighthawk::client::ThinkTimeDistribution::ThinkTimeDistributionOptions
+  thinkTimeDistribution() const override {
+    return think_time_distribution_;
+  }
+  absl::optional<uint64_t> seed() const override { return seed_; }
+  std::string recordSchedule() const override { return record_schedule_; }
+  std::string replaySchedule() const override { return replay_schedule_; }
+  nighthawk::client::TerminationMode::TerminationModeOptions terminationMode() const override {
+    return termination_mode_;
+  }
+  std::chrono::nanoseconds drainTimeout() const override { return drain_timeout_; }
+  nighthawk::client::CpuPinning::CpuPinningOptions cpuPinning() const override {
+    return cpu_pinning_;
+  }
+  std::vector<std::string> workerCpuSets() const override { return worker_cpu_sets_; }
+  std::string flushWorkerCpuSet() const override { return flush_worker_cpu_set_; }
+  std::vector<std::string> workerSourceAddresses() const override {
+    return worker_source_addresses_;
+  }
+  uint32_t workerSourcePortBase() const override { return worker_source_port_base_; }
+  uint32_t busyPollUs() const override { return busy_poll_us_; }
+  bool incomingCpuAffinity() const override { return incoming_cpu_affinity_; }
+  std::chrono::nanoseconds reportInterval() const override { return report_interval_; }
+  uint32_t eventLoopUtilizationThreshold() const override {
+    return event_loop_utilization_threshold_;
+  }
+  bool requestSourceSharedStream() const override { return request_source_shared_stream_; }
+
+  /**
+   * Performs the checks on a load phase that proto validation does not cover. Does not inline
+   * rps_curve files, a phase that references one is rejected for lacking points.
+   *
+   * @param phase the load phase to validate.
+   * @throws MalformedArgvException when the phase is not valid.
+   */
+  static void validateLoadPhase(const nighthawk::client::LoadPhase& phase);
 
 private:
   void parsePredicates(const TCLAP::MultiArg<std::string>& arg,
                        TerminationPredicateMap& predicates);
   void setNonTrivialDefaults();
   void validate() const;
+  void inlineLoadProfileCurveFiles();
   Client::CommandLineOptionsPtr toCommandLineOptionsInternal() const;
 
   uint32_t requests_per_second_{5};
@@ -203,6 +246,29 @@ private:
   absl::optional<Envoy::SystemTime> scheduled_start_;
   absl::optional<std::string> execution_id_;
   std::vector<envoy::config::core::v3::TypedExtensionConfig> user_defined_output_plugin_configs_;
+  absl::optional<nighthawk::client::LoadProfile> load_profile_;
+  bool global_rate_coordination_{false};
+  uint32_t virtual_users_{0};
+  std::chrono::nanoseconds think_time_{0};
+  nighthawk::client::ThinkTimeDistribution::ThinkTimeDistributionOptions think_time_distribution_{
+      nighthawk::client::ThinkTimeDistribution::CONSTANT};
+  absl::optional<uint64_t> seed_;
+  std::string record_schedule_;
+  std::string replay_schedule_;
+  nighthawk::client::TerminationMode::TerminationModeOptions termination_mode_{
+      nighthawk::client::TerminationMode::DRAIN};
+  std::chrono::nanoseconds drain_timeout_{std::chrono::seconds(1)};
+  nighthawk::client::CpuPinning::CpuPinningOptions cpu_pinning_{
+      nighthawk::client::CpuPinning::NONE};
+  std::vector<std::string> worker_cpu_sets_;
+  std::string flush_worker_cpu_set_;
+  std::vector<std::string> worker_source_addresses_;
+  uint32_t worker_source_port_base_{0};
+  uint32_t busy_poll_us_{0};
+  bool incoming_cpu_affinity_{false};
+  std::chrono::nanoseconds report_interval_{0};
+  uint32_t event_loop_utilization_threshold_{0};
+  bool request_source_shared_stream_{false};
 };
 
 } // namespace Client
@@ -23,6 +23,19 @@ OutputCollectorImpl::OutputCollectorImpl(Envoy::TimeSource& time_source, const O
 
 nighthawk::client::Output OutputCollectorImpl::toProto() const { return output_; }
 
+void OutputCollectorImpl::addWorkerPlacement(absl::string_view name,
+                                             const std::vector<uint32_t>& cpus,
+                                             const absl::optional<uint32_t>& numa_node) {
+  nighthawk::client::WorkerPlacement* placement = output_.add_worker_placements();
+  placement->set_name(name.data(), name.size());
+  for (const uint32_t cpu : cpus) {
+    placement->add_cpus(cpu);
+  }
+  if (numa_node.has_value()) {
+    placement->mutable_numa_node()->set_value(numa_node.value());
+  }
+}
+
 void OutputCollectorImpl::addResult(
     absl::string_view name, const std::vector<StatisticPtr>& statistics,
     const std::map<std::string, uint64_t>& counters,
@@ -38,13 +51,14 @@ void OutputCollectorImpl::addResult(
             .count());
   }
   for (auto& statistic : statistics) {
-    // TODO(#292): Looking at if the statistic id ends with "_size" to determine how it should be
-    // serialized is kind of hacky. Maybe we should have a lookup table of sorts, to determine how
-    // statistics should we serialized. Doing so may give us a canonical place to consolidate their
-    // ids as well too.
+    // TODO(#292): Looking at if the statistic id ends with "_size" or "_count" to determine how it
+    // should be serialized is kind of hacky. Maybe we should have a lookup table of sorts, to
+    // determine how statistics should we serialized. Doing so may give us a canonical place to
+    // consolidate their ids as well too.
     Statistic::SerializationDomain serialization_domain =
-        absl::EndsWith(statistic->id(), "_size") ? Statistic::SerializationDomain::RAW
-                                                 : Statistic::SerializationDomain::DURATION;
+        absl::EndsWith(statistic->id(), "_size") || absl::EndsWith(statistic->id(), "_count")
+            ? Statistic::SerializationDomain::RAW
+            : Statistic::SerializationDomain::DURATION;
     *(result->add_statistics()) = statistic->toProto(serialization_domain);
   }
   for (const auto& counter : counters) {
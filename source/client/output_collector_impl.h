@@ -24,6 +24,15 @@ public:
                  const absl::optional<Envoy::SystemTime>& first_acquisition_time,
                  const std::vector<nighthawk::client::UserDefinedOutput>&
                      user_defined_output_results) override;
+  void addWorkerPlacement(absl::string_view name, const std::vector<uint32_t>& cpus,
+                          const absl::optional<uint32_t>& numa_node) override;
+  void setStartupTimings(const nighthawk::client::StartupTimings& startup_timings) override {
+    *output_.mutable_startup_timings() = startup_timings;
+  }
+  void
+  setConcurrencyCalibration(const nighthawk::client::ConcurrencyCalibration& calibration) override {
+    *output_.mutable_concurrency_calibration() = calibration;
+  }
   void setOutput(const nighthawk::client::Output& output) override { output_ = output; }
 
   nighthawk::client::Output toProto() const override;
@@ -17,6 +17,7 @@
 #include "source/common/version_info.h"
 
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/strip.h"
 
@@ -25,6 +26,12 @@ namespace Client {
 
 using ::nighthawk::client::Protocol;
 
+namespace {
+
+constexpr absl::string_view kRequestClassStatIdPrefix = "benchmark_http_client.request_class.";
+
+} // namespace
+
 std::vector<std::string> OutputFormatterImpl::getLowerCaseOutputFormats() {
   const Envoy::Protobuf::EnumDescriptor* enum_descriptor =
       nighthawk::client::OutputFormat::OutputFormatOptions_descriptor();
@@ -137,10 +144,23 @@ std::string ConsoleOutputFormatterImpl::statIdtoFriendlyStatName(absl::string_vi
     return "Initiation to completion";
   } else if (stat_id == "sequencer.blocking") {
     return "Blocking. Results are skewed when significant numbers are reported here.";
+  } else if (stat_id == "sequencer.schedule_deviation") {
+    return "Delay relative to the recorded request times";
   } else if (stat_id == "benchmark_http_client.response_body_size") {
     return "Response body size in bytes";
   } else if (stat_id == "benchmark_http_client.response_header_size") {
     return "Response header size in bytes";
+  } else if (stat_id == "event_loop.busy") {
+    return "Event loop busy time per iteration";
+  } else if (stat_id == "event_loop.callback_count") {
+    return "Event loop callbacks per iteration";
+  } else if (stat_id == "request_source.stall") {
+    return "Request source stalls";
+  } else if (stat_id == "request_source.queued_request_count") {
+    return "Requests queued by the request source";
+  } else if (absl::StartsWith(stat_id, kRequestClassStatIdPrefix)) {
+    return absl::StrCat("Request start to response end, ",
+                        stat_id.substr(kRequestClassStatIdPrefix.size()));
   }
 
   return std::string(stat_id);
@@ -242,10 +262,23 @@ std::string CsvOutputFormatterImpl::statIdtoFriendlyStatName(absl::string_view s
     return "Initiation to completion";
   } else if (stat_id == "sequencer.blocking") {
     return "Blocking. Results are skewed when significant numbers are reported here.";
+  } else if (stat_id == "sequencer.schedule_deviation") {
+    return "Delay relative to the recorded request times";
   } else if (stat_id == "benchmark_http_client.response_body_size") {
     return "Response body size in bytes";
   } else if (stat_id == "benchmark_http_client.response_header_size") {
     return "Response header size in bytes";
+  } else if (stat_id == "event_loop.busy") {
+    return "Event loop busy time per iteration";
+  } else if (stat_id == "event_loop.callback_count") {
+    return "Event loop callbacks per iteration";
+  } else if (stat_id == "request_source.stall") {
+    return "Request source stalls";
+  } else if (stat_id == "request_source.queued_request_count") {
+    return "Requests queued by the request source";
+  } else if (absl::StartsWith(stat_id, kRequestClassStatIdPrefix)) {
+    return absl::StrCat("Request start to response end, ",
+                        stat_id.substr(kRequestClassStatIdPrefix.size()));
   }
 
   return std::string(stat_id);
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include "envoy/common/platform.h"
+
 #include "nighthawk/client/options.h"
 #include "nighthawk/common/uri.h"
 
@@ -27,9 +29,11 @@ namespace {
 using ::envoy::config::bootstrap::v3::Bootstrap;
 using ::envoy::config::cluster::v3::CircuitBreakers;
 using ::envoy::config::cluster::v3::Cluster;
+using ::envoy::config::core::v3::BindConfig;
 using ::envoy::config::core::v3::Http2ProtocolOptions;
 using ::envoy::config::core::v3::Http3ProtocolOptions;
 using ::envoy::config::core::v3::SocketAddress;
+using ::envoy::config::core::v3::SocketOption;
 using ::envoy::config::core::v3::TransportSocket;
 using ::envoy::config::endpoint::v3::ClusterLoadAssignment;
 using ::envoy::config::endpoint::v3::LocalityLbEndpoints;
@@ -188,6 +192,77 @@ Cluster createNighthawkClusterForWorker(const Client::Options& options,
   return cluster;
 }
 
+void addSocketOption(BindConfig& bind_config, absl::string_view description, int level,
+                     int name, int64_t value) {
+  SocketOption* socket_option = bind_config.add_socket_options();
+  socket_option->set_description(description.data(), description.size());
+  socket_option->set_level(level);
+  socket_option->set_name(name);
+  socket_option->set_int_value(value);
+  socket_option->set_state(SocketOption::STATE_PREBIND);
+}
+
+// Creates the bind configuration for the upstream connections of the specified worker. Returns
+// absl::nullopt when no per-worker binding or socket options are configured, in which case the
+// cluster falls back to the bind configuration of the cluster manager.
+absl::StatusOr<absl::optional<BindConfig>>
+createBindConfigForWorker(const Client::Options& options, const std::vector<UriPtr>& uris,
+                          int worker_number, const CpuSet& worker_cpus) {
+  const std::vector<std::string> source_addresses = options.workerSourceAddresses();
+  if (source_addresses.empty() && options.workerSourcePortBase() == 0 &&
+      options.busyPollUs() == 0 && !options.incomingCpuAffinity()) {
+    return absl::nullopt;
+  }
+  BindConfig bind_config;
+  if (options.upstreamBindConfig().has_value()) {
+    bind_config = options.upstreamBindConfig().value();
+  }
+  if (!source_addresses.empty() || options.workerSourcePortBase() > 0) {
+    SocketAddress* source_address = bind_config.mutable_source_address();
+    if (!source_addresses.empty()) {
+      source_address->set_address(source_addresses[worker_number % source_addresses.size()]);
+    } else if (source_address->address().empty()) {
+      // Only the port is fixed, bind to the wildcard address of the family of the targets.
+      const bool is_v6 = !uris.empty() && uris[0]->address()->ip()->version() ==
+                                              Envoy::Network::Address::IpVersion::v6;
+      source_address->set_address(is_v6 ? "::" : "0.0.0.0");
+    }
+    if (options.workerSourcePortBase() > 0) {
+      const uint32_t port = options.workerSourcePortBase() + worker_number;
+      if (port > 65535) {
+        return absl::InvalidArgumentError(
+            fmt::format("--worker-source-port-base {} leaves no source port for worker {}",
+                        options.workerSourcePortBase(), worker_number));
+      }
+      source_address->set_port_value(port);
+      // Allows rebinding the port while an earlier connection from it lingers in TIME_WAIT.
+      addSocketOption(bind_config, "SO_REUSEADDR", SOL_SOCKET, SO_REUSEADDR, 1);
+    } else {
+      source_address->set_port_value(0);
+    }
+  }
+  if (options.busyPollUs() > 0) {
+#ifdef SO_BUSY_POLL
+    addSocketOption(bind_config, "SO_BUSY_POLL", SOL_SOCKET, SO_BUSY_POLL, options.busyPollUs());
+#else
+    return absl::UnimplementedError("--busy-poll-us is not supported on this platform");
+#endif
+  }
+  if (options.incomingCpuAffinity()) {
+#ifdef SO_INCOMING_CPU
+    if (worker_cpus.empty()) {
+      return absl::InvalidArgumentError(
+          fmt::format("--incoming-cpu-affinity requires worker {} to be pinned", worker_number));
+    }
+    addSocketOption(bind_config, "SO_INCOMING_CPU", SOL_SOCKET, SO_INCOMING_CPU,
+                    worker_cpus.front());
+#else
+    return absl::UnimplementedError("--incoming-cpu-affinity is not supported on this platform");
+#endif
+  }
+  return bind_config;
+}
+
 // Extracts URIs of the targets and the request source (if specified) from the
 // Nighthawk options.
 // Resolves all the extracted URIs.
@@ -239,7 +314,7 @@ absl::StatusOr<Bootstrap> createBootstrapConfiguration(
     Envoy::Event::Dispatcher& dispatcher, Envoy::Api::Api& api, const Client::Options& options,
     Envoy::Network::DnsResolverFactory& dns_resolver_factory,
     const envoy::config::core::v3::TypedExtensionConfig& typed_dns_resolver_config,
-    int number_of_workers) {
+    int number_of_workers, const std::vector<CpuSet>& worker_cpu_sets) {
   absl::StatusOr<Envoy::Network::DnsResolverSharedPtr> dns_resolver =
       dns_resolver_factory.createDnsResolver(dispatcher, api, typed_dns_resolver_config);
   if (!dns_resolver.ok()) {
@@ -275,6 +350,17 @@ absl::StatusOr<Bootstrap> createBootstrapConfiguration(
       }
       *nighthawk_cluster.mutable_transport_socket() = *transport_socket;
     }
+    absl::StatusOr<absl::optional<BindConfig>> bind_config = createBindConfigForWorker(
+        options, is_tunneling ? encap_uris : uris, worker_number,
+        static_cast<size_t>(worker_number) < worker_cpu_sets.size()
+            ? worker_cpu_sets[worker_number]
+            : CpuSet{});
+    if (!bind_config.ok()) {
+      return bind_config.status();
+    }
+    if (bind_config->has_value()) {
+      *nighthawk_cluster.mutable_upstream_bind_config() = bind_config->value();
+    }
     *bootstrap.mutable_static_resources()->add_clusters() = nighthawk_cluster;
 
     if (request_source_uri != nullptr) {
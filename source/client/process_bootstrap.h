@@ -14,6 +14,7 @@
 #include "external/envoy/source/common/network/dns_resolver/dns_factory_util.h"
 #include "external/envoy_api/envoy/config/bootstrap/v3/bootstrap.pb.h"
 
+#include "source/common/cpu_topology_impl.h"
 #include "source/common/uri_impl.h"
 
 namespace Nighthawk {
@@ -33,6 +34,8 @@ namespace Nighthawk {
  * also needed when creating the resolver.
  * @param number_of_workers indicates how many Nighthawk workers will be
  *        upstreaming requests. A separate cluster is generated for each worker.
+ * @param worker_cpu_sets the cpus each worker is pinned to, indexed by worker
+ *        number. Empty when the workers are not pinned.
  *
  * @return the created bootstrap configuration.
  */
@@ -40,7 +43,7 @@ absl::StatusOr<envoy::config::bootstrap::v3::Bootstrap> createBootstrapConfigura
     Envoy::Event::Dispatcher& dispatcher, Envoy::Api::Api& api, const Client::Options& options,
     Envoy::Network::DnsResolverFactory& dns_resolver_factory,
     const envoy::config::core::v3::TypedExtensionConfig& typed_dns_resolver_config,
-    int number_of_workers);
+    int number_of_workers, const std::vector<CpuSet>& worker_cpu_sets = {});
 
 /**
  * Creates Encapsulation envoy bootstrap configuration.
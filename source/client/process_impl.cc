@@ -2,9 +2,12 @@
 
 #include <sys/file.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <random>
 
@@ -16,6 +19,7 @@
 #include "envoy/stats/store.h"
 
 #include "nighthawk/client/output_collector.h"
+#include "nighthawk/common/exception.h"
 #include "nighthawk/common/factories.h"
 #include "nighthawk/user_defined_output/user_defined_output_plugin.h"
 
@@ -34,6 +38,7 @@
 #include "external/envoy/source/common/network/dns_resolver/dns_factory_util.h"
 #include "external/envoy/source/common/network/utility.h"
 #include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/source/common/protobuf/utility.h"
 #include "external/envoy/source/common/runtime/runtime_impl.h"
 #include "external/envoy/source/common/singleton/manager_impl.h"
 #include "external/envoy/source/common/stats/tag_producer_impl.h"
@@ -61,6 +66,7 @@
 #include "api/client/output.pb.h"
 
 #include "source/common/frequency.h"
+#include "source/common/release_schedule_impl.h"
 #include "source/common/uri_impl.h"
 #include "source/common/utility.h"
 
@@ -69,6 +75,7 @@
 #include "source/client/client_worker_impl.h"
 #include "source/client/factories_impl.h"
 #include "source/client/options_impl.h"
+#include "source/client/output_collector_impl.h"
 #include "source/client/sni_utility.h"
 
 #include "source/user_defined_output/user_defined_output_plugin_creator.h"
@@ -87,14 +94,19 @@ using ::envoy::config::core::v3::TypedExtensionConfig;
 class BootstrapFactory : public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
 public:
   // Determines the concurrency Nighthawk should use based on configuration
-  // (options) and the available machine resources.
-  static uint32_t determineConcurrency(const Options& options) {
+  // (options) and the available machine resources, or the calibration when the concurrency is
+  // adaptive.
+  static uint32_t determineConcurrency(
+      const Options& options,
+      const absl::optional<nighthawk::client::ConcurrencyCalibration>& calibration) {
     uint32_t cpu_cores_with_affinity = Envoy::OptionsImplPlatform::getCpuCount();
     bool autoscale = options.concurrency() == "auto";
     // TODO(oschaaf): Maybe, in the case where the concurrency flag is left out, but
     // affinity is set / we don't have affinity with all cores, we should default to autoscale.
     // (e.g. we are called via taskset).
-    uint32_t concurrency = autoscale ? cpu_cores_with_affinity : std::stoi(options.concurrency());
+    uint32_t concurrency = calibration.has_value() ? calibration->workers()
+                           : autoscale             ? cpu_cores_with_affinity
+                                                   : std::stoi(options.concurrency());
 
     if (autoscale) {
       ENVOY_LOG(info, "Detected {} (v)CPUs with affinity..", cpu_cores_with_affinity);
@@ -103,12 +115,16 @@ public:
         options.noDuration() ? "No time limit"
                              : fmt::format("Time limit: {} seconds", options.duration().count());
     ENVOY_LOG(info, "Starting {} threads / event loops. {}.", concurrency, duration_as_string);
+    // With adaptive concurrency the rate is split over the workers.
+    const uint64_t global_requests_per_second =
+        calibration.has_value() ? options.requestsPerSecond()
+                                : static_cast<uint64_t>(options.requestsPerSecond()) * concurrency;
     ENVOY_LOG(info, "Global targets: {} connections and {} calls per second.",
-              options.connections() * concurrency, options.requestsPerSecond() * concurrency);
+              options.connections() * concurrency, global_requests_per_second);
 
     if (concurrency > 1) {
       ENVOY_LOG(info, "   (Per-worker targets: {} connections and {} calls per second)",
-                options.connections(), options.requestsPerSecond());
+                options.connections(), global_requests_per_second / concurrency);
     }
 
     return concurrency;
@@ -577,11 +593,12 @@ private:
   bool prefetch_connections_{};
 };
 
-ProcessImpl::ProcessImpl(const Options& options, Envoy::Event::TimeSystem& time_system,
+ProcessImpl::ProcessImpl(const Options& options, const uint32_t number_of_workers,
+                         Envoy::Event::TimeSystem& time_system,
                          Envoy::Network::DnsResolverFactory& dns_resolver_factory,
                          TypedExtensionConfig typed_dns_resolver_config,
                          const std::shared_ptr<Envoy::ProcessWide>& process_wide)
-    : options_(options), number_of_workers_(BootstrapFactory::determineConcurrency(options_)),
+    : options_(options), number_of_workers_(number_of_workers),
       process_wide_(process_wide == nullptr ? std::make_shared<Envoy::ProcessWide>()
                                             : process_wide),
       time_system_(time_system), stats_allocator_(symbol_table_), store_root_(stats_allocator_),
@@ -591,7 +608,8 @@ ProcessImpl::ProcessImpl(const Options& options, Envoy::Event::TimeSystem& time_
                                               bootstrap_)),
       dispatcher_(api_->allocateDispatcher("main_thread")), benchmark_client_factory_(options),
       termination_predicate_factory_(options), sequencer_factory_(options),
-      request_generator_factory_(options, *api_), init_manager_("nh_init_manager"),
+      request_generator_factory_(options, *api_, number_of_workers),
+      init_manager_("nh_init_manager"),
       local_info_(new Envoy::LocalInfo::LocalInfoImpl(
           store_root_.symbolTable(), node_, node_context_params_,
           Envoy::Network::Utility::getLocalAddress(Envoy::Network::Address::IpVersion::v4),
@@ -620,13 +638,39 @@ absl::StatusOr<ProcessPtr> ProcessImpl::CreateProcessImpl(
     const Options& options, Envoy::Network::DnsResolverFactory& dns_resolver_factory,
     TypedExtensionConfig typed_dns_resolver_config, Envoy::Event::TimeSystem& time_system,
     const std::shared_ptr<Envoy::ProcessWide>& process_wide) {
-  std::unique_ptr<ProcessImpl> process(new ProcessImpl(options, time_system, dns_resolver_factory,
-                                                       std::move(typed_dns_resolver_config),
-                                                       process_wide));
+  absl::optional<nighthawk::client::ConcurrencyCalibration> calibration;
+  if (options.concurrency() == "adaptive") {
+    absl::StatusOr<nighthawk::client::ConcurrencyCalibration> calibration_or_status =
+        calibrateConcurrency(options, dns_resolver_factory, typed_dns_resolver_config, time_system,
+                             process_wide);
+    if (!calibration_or_status.ok()) {
+      ENVOY_LOG(error, "Failed to calibrate the concurrency: {}",
+                calibration_or_status.status().message());
+      return calibration_or_status.status();
+    }
+    calibration = *std::move(calibration_or_status);
+  }
+  std::unique_ptr<ProcessImpl> process(
+      new ProcessImpl(options, BootstrapFactory::determineConcurrency(options, calibration),
+                      time_system, dns_resolver_factory, std::move(typed_dns_resolver_config),
+                      process_wide));
+  if (calibration.has_value()) {
+    process->concurrency_calibration_ = calibration;
+    process->sequencer_factory_.splitRateOverWorkers(calibration->workers());
+  }
+
+  // Placement is needed up front, because the cluster of a worker may depend on its cpus.
+  const absl::Status placement_status = process->determineCpuPlacement();
+  if (!placement_status.ok()) {
+    ENVOY_LOG(error, "Failed to determine cpu placement: {}", placement_status.message());
+    process->shutdown();
+    return placement_status;
+  }
 
   absl::StatusOr<Bootstrap> bootstrap = createBootstrapConfiguration(
       *process->dispatcher_, *process->api_, process->options_, process->dns_resolver_factory_,
-      process->typed_dns_resolver_config_, process->number_of_workers_);
+      process->typed_dns_resolver_config_, process->number_of_workers_,
+      process->worker_cpu_sets_);
   if (!bootstrap.ok()) {
     ENVOY_LOG(error, "Failed to create bootstrap configuration: {}", bootstrap.status().message());
     process->shutdown();
@@ -647,9 +691,123 @@ absl::StatusOr<ProcessPtr> ProcessImpl::CreateProcessImpl(
   process->bootstrap_ = *bootstrap;
   process->user_defined_output_factories_ = getUserDefinedFactoryConfigPairs(options);
 
+  if (!options.replaySchedule().empty()) {
+    absl::StatusOr<std::unique_ptr<ReleaseSchedule>> schedule =
+        ReleaseSchedule::readFromFile(options.replaySchedule());
+    if (!schedule.ok()) {
+      ENVOY_LOG(error, "Failed to load release schedule: {}", schedule.status().message());
+      process->shutdown();
+      return schedule.status();
+    }
+    if ((*schedule)->workers() != static_cast<uint32_t>(process->number_of_workers_)) {
+      const absl::Status status = absl::InvalidArgumentError(fmt::format(
+          "Release schedule '{}' was recorded with {} worker(s), but this execution uses {}",
+          options.replaySchedule(), (*schedule)->workers(), process->number_of_workers_));
+      ENVOY_LOG(error, status.message());
+      process->shutdown();
+      return status;
+    }
+    process->sequencer_factory_.setReplaySchedule(std::move(*schedule));
+  }
+
   return process;
 }
 
+absl::StatusOr<nighthawk::client::ConcurrencyCalibration> ProcessImpl::calibrateConcurrency(
+    const Options& options, Envoy::Network::DnsResolverFactory& dns_resolver_factory,
+    const TypedExtensionConfig& typed_dns_resolver_config, Envoy::Event::TimeSystem& time_system,
+    const std::shared_ptr<Envoy::ProcessWide>& process_wide) {
+  // Calibrate on a single worker that offers far more load than it can sustain, for a short
+  // while. Options that would affect the outcome or leave traces are left out.
+  CommandLineOptionsPtr command_line_options = options.toCommandLineOptions();
+  command_line_options->mutable_concurrency()->set_value("1");
+  command_line_options->mutable_requests_per_second()->set_value(kCalibrationRequestsPerSecond);
+  *command_line_options->mutable_duration() = Envoy::Protobuf::util::TimeUtil::SecondsToDuration(
+      std::chrono::duration_cast<std::chrono::seconds>(kCalibrationDuration).count());
+  command_line_options->clear_burst_size();
+  command_line_options->clear_jitter_uniform();
+  command_line_options->clear_termination_predicates();
+  command_line_options->clear_stats_sinks();
+  command_line_options->clear_scheduled_start();
+  command_line_options->clear_user_defined_plugin_configs();
+  command_line_options->clear_record_schedule();
+  command_line_options->clear_worker_cpu_sets();
+  command_line_options->clear_report_interval();
+  command_line_options->clear_event_loop_utilization_threshold();
+  OptionsImpl calibration_options(*command_line_options);
+
+  ENVOY_LOG(info, "Calibrating the concurrency for {} seconds.",
+            std::chrono::duration_cast<std::chrono::seconds>(kCalibrationDuration).count());
+  absl::StatusOr<ProcessPtr> process =
+      CreateProcessImpl(calibration_options, dns_resolver_factory, typed_dns_resolver_config,
+                        time_system, process_wide);
+  if (!process.ok()) {
+    return process.status();
+  }
+  OutputCollectorImpl collector(time_system, calibration_options);
+  const bool succeeded = (*process)->run(collector);
+  (*process)->shutdown();
+  if (!succeeded) {
+    return absl::UnavailableError("The calibration execution failed");
+  }
+
+  uint64_t responses = 0;
+  std::chrono::nanoseconds execution_duration = 0ns;
+  for (const nighthawk::client::Result& result : collector.toProto().results()) {
+    if (result.name() != "global") {
+      continue;
+    }
+    execution_duration = std::chrono::nanoseconds(
+        Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(result.execution_duration()));
+    for (const nighthawk::client::Statistic& statistic : result.statistics()) {
+      if (statistic.id() == "benchmark_http_client.request_to_response") {
+        responses = statistic.count();
+      }
+    }
+  }
+  if (responses == 0 || execution_duration <= 0ns) {
+    return absl::UnavailableError("No responses were received during the calibration execution");
+  }
+
+  const double sustainable_requests_per_second =
+      responses / std::chrono::duration<double>(execution_duration).count();
+  const uint32_t requested_requests_per_second = options.requestsPerSecond();
+  const uint32_t cpu_cores_with_affinity = Envoy::OptionsImplPlatform::getCpuCount();
+  const uint32_t workers = adaptiveConcurrency(
+      sustainable_requests_per_second, requested_requests_per_second, cpu_cores_with_affinity);
+  const uint32_t needed_workers =
+      adaptiveConcurrency(sustainable_requests_per_second, requested_requests_per_second,
+                          std::numeric_limits<uint32_t>::max());
+  if (needed_workers > workers) {
+    ENVOY_LOG(warn,
+              "Sustaining {} requests per second needs {} workers, but only {} (v)CPUs are "
+              "available. Nighthawk itself may be the bottleneck.",
+              requested_requests_per_second, needed_workers, cpu_cores_with_affinity);
+  }
+  ENVOY_LOG(info, "A single worker sustained {:.1f} requests per second, using {} worker(s).",
+            sustainable_requests_per_second, workers);
+
+  nighthawk::client::ConcurrencyCalibration calibration;
+  *calibration.mutable_duration() =
+      Envoy::Protobuf::util::TimeUtil::NanosecondsToDuration(execution_duration.count());
+  calibration.set_sustainable_requests_per_second(sustainable_requests_per_second);
+  calibration.set_requested_requests_per_second(requested_requests_per_second);
+  calibration.set_workers(workers);
+  return calibration;
+}
+
+uint32_t ProcessImpl::adaptiveConcurrency(const double sustainable_requests_per_second,
+                                          const uint32_t requested_requests_per_second,
+                                          const uint32_t cpu_count) {
+  const double workers =
+      std::ceil(requested_requests_per_second /
+                (sustainable_requests_per_second * kCalibrationTargetUtilization));
+  // Every worker needs to be paced at one request per second at least.
+  const uint32_t rate_cap = std::max<uint32_t>(1, requested_requests_per_second);
+  const uint32_t cap = std::min(rate_cap, std::max<uint32_t>(1, cpu_count));
+  return workers >= cap ? cap : std::max<uint32_t>(1, static_cast<uint32_t>(workers));
+}
+
 ProcessImpl::~ProcessImpl() {
   RELEASE_ASSERT(shutdown_, "shutdown not called before destruction.");
 }
@@ -705,16 +863,42 @@ bool ProcessImpl::requestExecutionCancellation() {
   return true;
 }
 
-Envoy::MonotonicTime
+absl::Status ProcessImpl::switchPhase(const nighthawk::client::LoadPhase& load_phase) {
+  if (options_.virtualUsers() > 0 || options_.globalRateCoordination() ||
+      !options_.recordSchedule().empty() || !options_.replaySchedule().empty()) {
+    return absl::FailedPreconditionError(
+        "Phase switches are not supported in closed-loop mode, with global rate coordination, or "
+        "when recording or replaying a release schedule");
+  }
+  try {
+    Envoy::MessageUtil::validate(load_phase, Envoy::ProtobufMessage::getStrictValidationVisitor());
+    OptionsImpl::validateLoadPhase(load_phase);
+  } catch (const Envoy::ProtoValidationException& e) {
+    return absl::InvalidArgumentError(e.what());
+  } catch (const MalformedArgvException& e) {
+    return absl::InvalidArgumentError(e.what());
+  }
+  Envoy::Thread::LockGuard guard(workers_lock_);
+  if (cancelled_ || workers_.empty()) {
+    return absl::FailedPreconditionError("There is no running execution to switch phases in");
+  }
+  // All workers switch at the same moment, so that the phases line up across them.
+  const Envoy::MonotonicTime switch_time = time_system_.monotonicTime() + kPhaseSwitchMargin;
+  for (auto& worker : workers_) {
+    worker->switchPhase(load_phase, switch_time);
+  }
+  return absl::OkStatus();
+}
+
+absl::optional<Envoy::MonotonicTime>
 ProcessImpl::computeFirstWorkerStart(Envoy::Event::TimeSystem& time_system,
-                                     const absl::optional<Envoy::SystemTime>& scheduled_start,
-                                     const uint32_t concurrency) {
+                                     const absl::optional<Envoy::SystemTime>& scheduled_start) {
+  if (!scheduled_start.has_value()) {
+    return absl::nullopt;
+  }
   const std::chrono::nanoseconds first_worker_delay =
-      scheduled_start.has_value() ? scheduled_start.value() - time_system.systemTime()
-                                  : 500ms + (concurrency * 50ms);
-  const Envoy::MonotonicTime monotonic_now = time_system.monotonicTime();
-  const Envoy::MonotonicTime first_worker_start = monotonic_now + first_worker_delay;
-  return first_worker_start;
+      scheduled_start.value() - time_system.systemTime();
+  return time_system.monotonicTime() + first_worker_delay;
 }
 
 std::chrono::nanoseconds ProcessImpl::computeInterWorkerDelay(const uint32_t concurrency,
@@ -723,32 +907,154 @@ std::chrono::nanoseconds ProcessImpl::computeInterWorkerDelay(const uint32_t con
   return std::chrono::duration_cast<std::chrono::nanoseconds>(inter_worker_delay_usec * 1us);
 }
 
+std::chrono::nanoseconds ProcessImpl::interWorkerDelay(const Options& options,
+                                                       const uint32_t concurrency) const {
+  // With global rate coordination the workers draw from a shared budget, so there is no need
+  // to offset their starting times.
+  if (options.globalRateCoordination()) {
+    return 0ns;
+  }
+  return computeInterWorkerDelay(concurrency, concurrency_calibration_.has_value()
+                                                  ? options.requestsPerSecond() / concurrency
+                                                  : options.requestsPerSecond());
+}
+
 absl::Status ProcessImpl::createWorkers(const uint32_t concurrency,
                                         const absl::optional<Envoy::SystemTime>& scheduled_start) {
   ASSERT(workers_.empty());
-  const Envoy::MonotonicTime first_worker_start =
-      computeFirstWorkerStart(time_system_, scheduled_start, concurrency);
-  const std::chrono::nanoseconds inter_worker_delay =
-      computeInterWorkerDelay(concurrency, options_.requestsPerSecond());
+  // Workers create their sequencers on their own threads, once they are all ready.
+  sequencer_factory_.setWorkers(concurrency);
+  start_barrier_ = std::make_unique<WorkerStartBarrier>(
+      time_system_, concurrency, interWorkerDelay(options_, concurrency),
+      computeFirstWorkerStart(time_system_, scheduled_start));
+  // When pinning, each worker is constructed while the main thread temporarily runs on the cpus
+  // of that worker. The kernel places pages on the node of the cpu that first touches them, so
+  // the state a worker allocates up front (statistics, request sources, connection pools) ends up
+  // in memory local to the node the worker will run on.
+  absl::optional<CpuSet> main_thread_affinity;
+  if (!worker_cpu_sets_.empty()) {
+    absl::StatusOr<CpuSet> affinity = CpuTopology::currentThreadAffinity();
+    if (affinity.ok()) {
+      main_thread_affinity = *std::move(affinity);
+    }
+  }
+  absl::Status status = absl::OkStatus();
   int worker_number = 0;
   while (workers_.size() < concurrency) {
     absl::StatusOr<std::vector<UserDefinedOutputNamePluginPair>> plugins =
         createUserDefinedOutputPlugins(user_defined_output_factories_, worker_number);
     if (!plugins.ok()) {
-      return plugins.status();
+      status = plugins.status();
+      break;
     }
-    workers_.push_back(std::make_unique<ClientWorkerImpl>(
+    const CpuSet cpus = worker_cpu_sets_.empty() ? CpuSet{} : worker_cpu_sets_[worker_number];
+    if (!cpus.empty() && main_thread_affinity.has_value()) {
+      const absl::Status affinity_status = CpuTopology::setCurrentThreadAffinity(cpus);
+      if (!affinity_status.ok()) {
+        ENVOY_LOG(warn, "Unable to construct worker {} on its cpus: {}", worker_number,
+                  affinity_status.message());
+      }
+    }
+    auto worker = std::make_unique<ClientWorkerImpl>(
         *api_, tls_, cluster_manager_, benchmark_client_factory_, termination_predicate_factory_,
         sequencer_factory_, request_generator_factory_, store_root_, worker_number,
-        first_worker_start + (inter_worker_delay * worker_number), tracer_,
+        *start_barrier_, tracer_,
         options_.simpleWarmup() ? ClientWorkerImpl::HardCodedWarmupStyle::ON
                                 : ClientWorkerImpl::HardCodedWarmupStyle::OFF,
-        std::move(*plugins)));
+        options_.loadProfile(), std::move(*plugins));
+    worker->setCpuAffinity(cpus);
+    worker->setEventLoopUtilizationThreshold(options_.eventLoopUtilizationThreshold());
+    workers_.push_back(std::move(worker));
     worker_number++;
   }
+  if (main_thread_affinity.has_value()) {
+    const absl::Status restore_status =
+        CpuTopology::setCurrentThreadAffinity(*main_thread_affinity);
+    if (!restore_status.ok()) {
+      ENVOY_LOG(warn, "Unable to restore the cpu affinity of the main thread: {}",
+                restore_status.message());
+    }
+  }
+  return status;
+}
+
+absl::Status ProcessImpl::determineCpuPlacement() {
+  if (!options_.workerCpuSets().empty()) {
+    if (options_.workerCpuSets().size() != static_cast<size_t>(number_of_workers_)) {
+      return absl::InvalidArgumentError(
+          fmt::format("--worker-cpu-set was specified {} time(s), but this execution uses {} "
+                      "worker(s)",
+                      options_.workerCpuSets().size(), number_of_workers_));
+    }
+    for (const std::string& cpu_list : options_.workerCpuSets()) {
+      absl::StatusOr<CpuSet> cpus = CpuTopology::parseCpuList(cpu_list);
+      if (!cpus.ok()) {
+        return cpus.status();
+      }
+      worker_cpu_sets_.push_back(*std::move(cpus));
+    }
+  } else if (options_.cpuPinning() == nighthawk::client::CpuPinning::NUMA_COMPACT) {
+    const absl::StatusOr<CpuSet> allowed_cpus = CpuTopology::currentThreadAffinity();
+    if (!allowed_cpus.ok()) {
+      return allowed_cpus.status();
+    }
+    cpu_topology_.emplace(CpuTopology::fromSystem());
+    worker_cpu_sets_ = cpu_topology_->compactLayout(*allowed_cpus, number_of_workers_);
+    if (static_cast<size_t>(number_of_workers_) > allowed_cpus->size()) {
+      ENVOY_LOG(warn, "{} workers share {} cpus", number_of_workers_, allowed_cpus->size());
+    }
+  }
+  if (!options_.flushWorkerCpuSet().empty()) {
+    absl::StatusOr<CpuSet> cpus = CpuTopology::parseCpuList(options_.flushWorkerCpuSet());
+    if (!cpus.ok()) {
+      return cpus.status();
+    }
+    flush_worker_cpu_set_ = *std::move(cpus);
+  }
+  if (!cpu_topology_.has_value() && (!worker_cpu_sets_.empty() || !flush_worker_cpu_set_.empty())) {
+    cpu_topology_.emplace(CpuTopology::fromSystem());
+  }
   return absl::OkStatus();
 }
 
+void ProcessImpl::addStartupTimings(OutputCollector& collector) const {
+  if (start_barrier_ == nullptr) {
+    return;
+  }
+  const auto to_duration = [](const std::chrono::nanoseconds duration) {
+    return Envoy::Protobuf::util::TimeUtil::NanosecondsToDuration(duration.count());
+  };
+  const StartupTimestamps& timestamps = startup_timestamps_;
+  nighthawk::client::StartupTimings timings;
+  *timings.mutable_create_workers() = to_duration(timestamps.workers_created - timestamps.begin);
+  *timings.mutable_initialize_cluster_manager() =
+      to_duration(timestamps.cluster_manager_initialized - timestamps.workers_created);
+  const absl::optional<Envoy::MonotonicTime> last_arrival = start_barrier_->lastArrivalTime();
+  if (last_arrival.has_value()) {
+    *timings.mutable_workers_ready() =
+        to_duration(last_arrival.value() - timestamps.workers_started);
+  }
+  const absl::optional<Envoy::MonotonicTime> start = start_barrier_->startTime();
+  if (start.has_value()) {
+    *timings.mutable_time_to_first_start() = to_duration(start.value() - timestamps.begin);
+  }
+  collector.setStartupTimings(timings);
+}
+
+void ProcessImpl::addWorkerPlacements(OutputCollector& collector) const {
+  if (!cpu_topology_.has_value()) {
+    return;
+  }
+  for (size_t i = 0; i < worker_cpu_sets_.size(); i++) {
+    collector.addWorkerPlacement(fmt::format("worker_{}", i), worker_cpu_sets_[i],
+                                 cpu_topology_->nodeOf(worker_cpu_sets_[i]));
+  }
+  if (!flush_worker_cpu_set_.empty() && flush_worker_ != nullptr) {
+    collector.addWorkerPlacement("flush_worker", flush_worker_cpu_set_,
+                                 cpu_topology_->nodeOf(flush_worker_cpu_set_));
+  }
+}
+
 void ProcessImpl::configureComponentLogLevels(spdlog::level::level_enum level) {
   // TODO(oschaaf): Add options to tweak the log level of the various log tags
   // that are available.
@@ -772,34 +1078,84 @@ ProcessImpl::vectorizeStatisticPtrMap(const StatisticPtrMap& statistics) const {
 
 std::vector<StatisticPtr>
 ProcessImpl::mergeWorkerStatistics(const std::vector<ClientWorkerPtr>& workers) const {
-  // First we init merged_statistics with newly created statistics instances.
-  // We do that by adding the same amount of Statistic instances that the first worker has.
-  // (We always have at least one worker, and all workers have the same number of Statistic
-  // instances associated to them, in the same order).
-  std::vector<StatisticPtr> merged_statistics;
-  StatisticPtrMap w0_statistics;
-  if (!workers.empty()) {
-    w0_statistics = workers[0]->statistics();
-  }
-  for (const auto& w0_statistic : w0_statistics) {
-    auto new_statistic = w0_statistic.second->createNewInstanceOfSameType();
-    new_statistic->setId(w0_statistic.first);
-    merged_statistics.push_back(std::move(new_statistic));
-  }
-
-  // Merge the statistics of all workers into the statistics vector we initialized above.
-  for (auto& w : workers) {
-    uint32_t i = 0;
-    for (const auto& wx_statistic : w->statistics()) {
-      auto merged = merged_statistics[i]->combine(*(wx_statistic.second));
-      merged->setId(merged_statistics[i]->id());
-      merged_statistics[i] = std::move(merged);
-      i++;
+  std::vector<StatisticPtrMap> worker_statistics;
+  for (const ClientWorkerPtr& worker : workers) {
+    worker_statistics.push_back(worker->statistics());
+  }
+  return mergeStatistics(worker_statistics);
+}
+
+std::vector<StatisticPtr>
+ProcessImpl::mergeStatistics(const std::vector<StatisticPtrMap>& statistics) const {
+  // Statistics are matched up by id. Entries may lack some, for example a worker that ended its
+  // execution in an earlier load phase than the others reports the drained latencies there.
+  std::map<std::string, StatisticPtr> merged_by_id;
+  for (const StatisticPtrMap& wx_statistics : statistics) {
+    for (const auto& wx_statistic : wx_statistics) {
+      StatisticPtr& merged = merged_by_id[wx_statistic.first];
+      if (merged == nullptr) {
+        merged = wx_statistic.second->createNewInstanceOfSameType();
+      }
+      merged = merged->combine(*(wx_statistic.second));
+      merged->setId(wx_statistic.first);
     }
   }
+  std::vector<StatisticPtr> merged_statistics;
+  for (auto& merged : merged_by_id) {
+    merged_statistics.push_back(std::move(merged.second));
+  }
   return merged_statistics;
 }
 
+void ProcessImpl::addLoadPhaseResults(OutputCollector& collector) const {
+  // All workers execute the same phases in the same order, but some may have ended early.
+  size_t phase_count = 0;
+  for (const ClientWorkerPtr& worker : workers_) {
+    phase_count = std::max(phase_count, worker->phases().size());
+  }
+  for (size_t phase_index = 0; phase_index < phase_count; phase_index++) {
+    std::string phase_id;
+    std::vector<StatisticPtrMap> phase_statistics;
+    std::map<std::string, uint64_t> phase_counters;
+    std::chrono::nanoseconds total_execution_duration = 0ns;
+    absl::optional<Envoy::SystemTime> first_acquisition_time = absl::nullopt;
+    for (size_t worker_index = 0; worker_index < workers_.size(); worker_index++) {
+      const ClientWorker& worker = *workers_[worker_index];
+      if (phase_index >= worker.phases().size()) {
+        continue;
+      }
+      const Phase& phase = *worker.phases()[phase_index];
+      const Sequencer& sequencer = phase.sequencer();
+      const std::map<std::string, uint64_t>& counters = worker.phaseCounterValues()[phase_index];
+      StatisticPtrMap statistics = sequencer.statistics();
+      const StatisticPtrMap& client_statistics = worker.phaseClientStatistics()[phase_index];
+      statistics.insert(client_statistics.begin(), client_statistics.end());
+      const absl::optional<Envoy::SystemTime> worker_first_acquisition_time =
+          sequencer.rate_limiter().firstAcquisitionTime();
+      phase_id = std::string(phase.id());
+      if (workers_.size() > 1) {
+        collector.addResult(fmt::format("worker_{}.{}", worker_index, phase_id),
+                            vectorizeStatisticPtrMap(statistics), counters,
+                            sequencer.executionDuration(), worker_first_acquisition_time, {});
+      }
+      if (worker_first_acquisition_time.has_value()) {
+        first_acquisition_time =
+            first_acquisition_time.has_value()
+                ? std::min(first_acquisition_time.value(), worker_first_acquisition_time.value())
+                : worker_first_acquisition_time.value();
+      }
+      phase_statistics.push_back(std::move(statistics));
+      for (const auto& counter : counters) {
+        phase_counters[counter.first] += counter.second;
+      }
+      total_execution_duration += sequencer.executionDuration();
+    }
+    collector.addResult(fmt::format("global.{}", phase_id), mergeStatistics(phase_statistics),
+                        phase_counters, total_execution_duration / phase_statistics.size(),
+                        first_acquisition_time, {});
+  }
+}
+
 void ProcessImpl::addTracingCluster(envoy::config::bootstrap::v3::Bootstrap& bootstrap,
                                     const Uri& uri) const {
   auto* cluster = bootstrap.mutable_static_resources()->add_clusters();
@@ -963,6 +1319,7 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
         return;
       }
       shutdown_ = false;
+      startup_timestamps_.begin = time_system_.monotonicTime();
 
       // Needs to happen as early as possible (before createWorkers()) in the instantiation to
       // preempt the objects that require stats.
@@ -985,6 +1342,8 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
         result = false;
         return;
       }
+      startup_timestamps_.workers_created = time_system_.monotonicTime();
+      setupIntervalReporting(options_);
       tls_.registerThread(*dispatcher_, true);
       store_root_.initializeThreading(*dispatcher_, tls_);
 
@@ -1052,6 +1411,7 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
         result = false;
         return;
       }
+      startup_timestamps_.cluster_manager_initialized = time_system_.monotonicTime();
 
       std::list<std::unique_ptr<Envoy::Stats::Sink>> stats_sinks;
       setupStatsSinks(bootstrap_, stats_sinks);
@@ -1064,9 +1424,13 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
         // There should be only a single live flush worker instance at any time.
         flush_worker_ = std::make_unique<FlushWorkerImpl>(
             stats_flush_interval, *api_, tls_, store_root_, stats_sinks, *cluster_manager_);
+        flush_worker_->setCpuAffinity(flush_worker_cpu_set_);
         flush_worker_->start();
       }
 
+      // Workers initialize and warm up in parallel on their own threads, and start generating
+      // load once all of them are ready.
+      startup_timestamps_.workers_started = time_system_.monotonicTime();
       for (auto& w : workers_) {
         w->start();
       }
@@ -1084,6 +1448,7 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
     return false;
   }
 
+  emitIntervalsUntilDone();
   for (auto& w : workers_) {
     w->waitForCompletion();
   }
@@ -1095,6 +1460,26 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
     flush_worker_->waitForCompletion();
   }
 
+  if (sequencer_factory_.recordedSchedule() != nullptr) {
+    const absl::Status status =
+        sequencer_factory_.recordedSchedule()->writeToFile(options_.recordSchedule());
+    if (!status.ok()) {
+      ENVOY_LOG(error, "Failed to record the release schedule: {}", status.message());
+      return false;
+    }
+  }
+
+  addWorkerPlacements(collector);
+  addStartupTimings(collector);
+  if (concurrency_calibration_.has_value()) {
+    collector.setConcurrencyCalibration(*concurrency_calibration_);
+  }
+  const bool collected = collectResults(collector, options_);
+  dispatchUntilNextExecution();
+  return collected;
+}
+
+bool ProcessImpl::collectResults(OutputCollector& collector, const Options& options) {
   int i = 0;
   std::chrono::nanoseconds total_execution_duration = 0ns;
   absl::optional<Envoy::SystemTime> first_acquisition_time = absl::nullopt;
@@ -1133,9 +1518,17 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
   // sure the global aggregated numbers line up, we must take care not to shut down the benchmark
   // client before we do this, as that will increment certain counters like connections closed,
   // etc.
-  const std::map<std::string, uint64_t>& counters = Utility().mapCountersFromStore(
-      store_root_, [](absl::string_view, uint64_t value) { return value > 0; });
-  StatisticFactoryImpl statistic_factory(options_);
+  // For executions on warm workers, only the increments since the execution started count.
+  std::map<std::string, uint64_t> counters;
+  for (const auto& counter : Utility().mapCountersFromStore(
+           store_root_, [](absl::string_view, uint64_t value) { return value > 0; })) {
+    const auto it = counters_at_execution_start_.find(counter.first);
+    const uint64_t delta =
+        counter.second - (it == counters_at_execution_start_.end() ? 0 : it->second);
+    if (delta > 0) {
+      counters[counter.first] = delta;
+    }
+  }
   std::vector<nighthawk::client::UserDefinedOutput> global_user_defined_outputs =
       compileGlobalUserDefinedPluginOutputs(user_defined_outputs_by_plugin,
                                             user_defined_output_factories_);
@@ -1143,6 +1536,19 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
     collector.addResult("global", mergeWorkerStatistics(workers_), counters,
                         total_execution_duration / workers_.size(), first_acquisition_time,
                         global_user_defined_outputs);
+    // Phase switches split executions without a load profile into phases as well.
+    if (options.loadProfile().has_value() ||
+        std::any_of(workers_.begin(), workers_.end(),
+                    [](const ClientWorkerPtr& worker) { return worker->phases().size() > 1; })) {
+      addLoadPhaseResults(collector);
+    }
+  }
+  const auto overloaded = counters.find("event_loop.overloaded");
+  if (overloaded != counters.end()) {
+    ENVOY_LOG(warn,
+              "{} of {} workers exceeded the event loop utilization threshold of {}%. Nighthawk "
+              "itself may have been the bottleneck, consider a higher --concurrency.",
+              overloaded->second, workers_.size(), options.eventLoopUtilizationThreshold());
   }
   if (counters.find("sequencer.failed_terminations") == counters.end()) {
     return true;
@@ -1163,6 +1569,113 @@ bool ProcessImpl::runInternal(OutputCollector& collector, const UriPtr& tracing_
   }
 }
 
+absl::Status ProcessImpl::checkWarmCompatibility(const Options& warm_options,
+                                                 const Options& options) {
+  if (!warm_options.statsSinks().empty() || !warm_options.tunnelUri().empty() ||
+      warm_options.scheduled_start().has_value() || !warm_options.recordSchedule().empty() ||
+      !warm_options.replaySchedule().empty()) {
+    return absl::FailedPreconditionError(
+        "Workers using stats sinks, a tunnel, a scheduled start, or recording or replaying a "
+        "release schedule cannot be reused");
+  }
+  std::vector<CommandLineOptionsPtr> protos;
+  protos.push_back(warm_options.toCommandLineOptions());
+  protos.push_back(options.toCommandLineOptions());
+  for (const CommandLineOptionsPtr& proto : protos) {
+    proto->clear_requests_per_second();
+    proto->clear_duration();
+    proto->clear_no_duration();
+    proto->clear_burst_size();
+    proto->clear_jitter_uniform();
+    proto->clear_termination_predicates();
+    proto->clear_failure_predicates();
+    proto->clear_no_default_failure_predicates();
+    proto->clear_load_profile();
+    proto->clear_simple_warmup();
+    proto->clear_execution_id();
+    proto->clear_output_format();
+    proto->clear_labels();
+  }
+  if (!Envoy::Protobuf::util::MessageDifferencer::Equivalent(*protos[0], *protos[1])) {
+    return absl::InvalidArgumentError(
+        "Options differ in more than pacing, duration, termination predicates and output");
+  }
+  return absl::OkStatus();
+}
+
+void ProcessImpl::setupIntervalReporting(const Options& options) {
+  // The workers are idle here, so the reporter of a previous execution is no longer in use.
+  interval_reporter_.reset();
+  if (interval_output_callback_ == nullptr || options.reportInterval().count() == 0) {
+    for (auto& worker : workers_) {
+      worker->setIntervalReportCallback(0ns, nullptr);
+    }
+    return;
+  }
+  interval_reporter_ = std::make_unique<IntervalReporter>(time_system_, options, workers_.size(),
+                                                          interval_output_callback_);
+  for (uint32_t i = 0; i < workers_.size(); i++) {
+    IntervalReporter* reporter = interval_reporter_.get();
+    workers_[i]->setIntervalReportCallback(
+        options.reportInterval(),
+        [reporter, i](IntervalReportPtr&& report) { reporter->onReport(i, std::move(report)); });
+  }
+}
+
+void ProcessImpl::emitIntervalsUntilDone() {
+  if (interval_reporter_ != nullptr) {
+    interval_reporter_->emitUntilDone();
+  }
+}
+
+void ProcessImpl::dispatchUntilNextExecution() {
+  for (auto& worker : workers_) {
+    worker->dispatchUntilNextExecution();
+  }
+}
+
+bool ProcessImpl::runWarm(const Options& options, OutputCollector& collector) {
+  {
+    Envoy::Thread::LockGuard guard(workers_lock_);
+    if (cancelled_ || workers_.empty()) {
+      ENVOY_LOG(error, "No warm workers available.");
+      return false;
+    }
+  }
+  const absl::Status status = checkWarmCompatibility(options_, options);
+  if (!status.ok()) {
+    ENVOY_LOG(error, "Cannot reuse the warm workers: {}", status.message());
+    return false;
+  }
+  counters_at_execution_start_ = Utility().mapCountersFromStore(
+      store_root_, [](absl::string_view, uint64_t value) { return value > 0; });
+  // The factories of the previous execution stay alive until the workers have discarded their
+  // phases, which happens when they start the next execution.
+  auto sequencer_factory = std::make_unique<SequencerFactoryImpl>(options);
+  if (concurrency_calibration_.has_value()) {
+    sequencer_factory->splitRateOverWorkers(concurrency_calibration_->workers());
+  }
+  sequencer_factory->setWorkers(workers_.size());
+  auto termination_predicate_factory = std::make_unique<TerminationPredicateFactoryImpl>(
+      options, /*relative_to_current_counter_values=*/true);
+  // The pacing may differ from that of the previous execution.
+  start_barrier_->reset(interWorkerDelay(options, workers_.size()));
+  setupIntervalReporting(options);
+  for (auto& worker : workers_) {
+    worker->startNextExecution(*sequencer_factory, *termination_predicate_factory,
+                               options.loadProfile());
+  }
+  emitIntervalsUntilDone();
+  for (auto& worker : workers_) {
+    worker->waitForCompletion();
+  }
+  warm_sequencer_factory_ = std::move(sequencer_factory);
+  warm_termination_predicate_factory_ = std::move(termination_predicate_factory);
+  const bool collected = collectResults(collector, options);
+  dispatchUntilNextExecution();
+  return collected;
+}
+
 bool ProcessImpl::run(OutputCollector& collector) {
   UriPtr tracing_uri;
 
@@ -42,7 +42,10 @@
 #include "source/client/benchmark_client_impl.h"
 #include "source/client/factories_impl.h"
 #include "source/client/flush_worker_impl.h"
+#include "source/client/interval_reporter.h"
 #include "source/client/process_bootstrap.h"
+#include "source/client/worker_start_barrier.h"
+#include "source/common/cpu_topology_impl.h"
 
 namespace Nighthawk {
 namespace Client {
@@ -89,6 +92,59 @@ public:
    */
   bool run(OutputCollector& collector) override;
 
+  bool runWarm(const Options& options, OutputCollector& collector) override;
+
+  /**
+   * Checks if an execution can run on the warm workers of a process created with other options.
+   * Options that control the pacing, duration, termination and output of an execution may differ,
+   * all other options must be the same.
+   *
+   * @param warm_options the options the process was created with.
+   * @param options the options of the next execution.
+   * @return absl::Status an error explaining why the execution cannot run on the warm workers.
+   */
+  static absl::Status checkWarmCompatibility(const Options& warm_options, const Options& options);
+
+  /**
+   * Margin between a phase switch request and the moment the workers switch, which allows all of
+   * them to learn about it in time.
+   */
+  static constexpr std::chrono::milliseconds kPhaseSwitchMargin{10};
+
+  /**
+   * Time a single worker is driven to saturation for, to calibrate --concurrency adaptive.
+   */
+  static constexpr std::chrono::seconds kCalibrationDuration{3};
+  /**
+   * Rate offered by the calibrating worker. High enough to saturate a worker against any target.
+   */
+  static constexpr uint32_t kCalibrationRequestsPerSecond = 1000000;
+  /**
+   * Fraction of the calibrated sustainable rate that adaptively chosen workers are loaded to,
+   * which leaves them headroom to keep up with the requested rate.
+   */
+  static constexpr double kCalibrationTargetUtilization = 0.7;
+
+  /**
+   * Computes the number of workers that --concurrency adaptive uses: enough to offer the requested
+   * rate with each worker loaded to kCalibrationTargetUtilization of the calibrated sustainable
+   * rate. At least one, and at most one per request per second and one per (v)CPU.
+   *
+   * @param sustainable_requests_per_second the rate a single worker sustained while calibrating.
+   * @param requested_requests_per_second the rate requested for the execution.
+   * @param cpu_count the number of (v)CPUs available.
+   * @return uint32_t the number of workers to use.
+   */
+  static uint32_t adaptiveConcurrency(const double sustainable_requests_per_second,
+                                      const uint32_t requested_requests_per_second,
+                                      const uint32_t cpu_count);
+
+  absl::Status switchPhase(const nighthawk::client::LoadPhase& load_phase) override;
+
+  void setIntervalOutputCallback(IntervalOutputCallback callback) override {
+    interval_output_callback_ = std::move(callback);
+  }
+
   /**
    * Should be called before destruction to cleanly shut down.
    */
@@ -98,7 +154,8 @@ public:
 
 private:
   // Use CreateProcessImpl to construct an instance of ProcessImpl.
-  ProcessImpl(const Options& options, Envoy::Event::TimeSystem& time_system,
+  ProcessImpl(const Options& options, const uint32_t number_of_workers,
+              Envoy::Event::TimeSystem& time_system,
               Envoy::Network::DnsResolverFactory& dns_resolver_factory,
               envoy::config::core::v3::TypedExtensionConfig typed_dns_resolver_config,
               const std::shared_ptr<Envoy::ProcessWide>& process_wide = nullptr);
@@ -117,9 +174,87 @@ private:
    */
   absl::Status createWorkers(const uint32_t concurrency,
                              const absl::optional<Envoy::SystemTime>& schedule);
+  /**
+   * Determines the cpus the workers and the flush worker should be pinned to, based on the
+   * options and the topology of the host.
+   *
+   * @return absl::Status an error when the options are inconsistent with the number of workers.
+   */
+  absl::Status determineCpuPlacement();
+  /**
+   * Records the cpus the workers were pinned to in the output.
+   *
+   * @param collector the collector to add the placements to.
+   */
+  void addWorkerPlacements(OutputCollector& collector) const;
+  /**
+   * Determines the number of workers for --concurrency adaptive. Runs a short execution in which
+   * a single worker offers far more load than it can sustain, and derives the sustainable rate of
+   * a worker from the rate at which it received responses.
+   *
+   * @param options the options of the execution to calibrate for.
+   * @param dns_resolver_factory factory for the DNS resolver of the calibration execution.
+   * @param typed_dns_resolver_config the config that defined the dns_resolver_factory.
+   * @param time_system the time system to use.
+   * @param process_wide the active Envoy::ProcessWide instance, if any.
+   * @return absl::StatusOr<nighthawk::client::ConcurrencyCalibration> the calibration outcome, or
+   * an error when the calibration execution failed or received no responses.
+   */
+  static absl::StatusOr<nighthawk::client::ConcurrencyCalibration> calibrateConcurrency(
+      const Options& options, Envoy::Network::DnsResolverFactory& dns_resolver_factory,
+      const envoy::config::core::v3::TypedExtensionConfig& typed_dns_resolver_config,
+      Envoy::Event::TimeSystem& time_system,
+      const std::shared_ptr<Envoy::ProcessWide>& process_wide);
+  /**
+   * Records how long the phases of starting up the execution took in the output.
+   *
+   * @param collector the collector to add the timings to.
+   */
+  void addStartupTimings(OutputCollector& collector) const;
+  /**
+   * Has the workers report to a fresh interval reporter during the next execution, when
+   * intermediate output is requested and the options specify a report interval.
+   *
+   * @param options the options of the next execution.
+   */
+  void setupIntervalReporting(const Options& options);
+  /**
+   * Emits the intermediate output of the running execution on the calling thread, if any, until
+   * the workers complete their execution.
+   */
+  void emitIntervalsUntilDone();
+  /**
+   * Adds the results of the workers' latest execution to the output.
+   *
+   * @param collector the collector to add the results to.
+   * @param options the options of the execution.
+   * @return bool true iff execution should be considered successful.
+   */
+  bool collectResults(OutputCollector& collector, const Options& options);
+  /**
+   * Has the workers service their connections until the next execution, once its results have been
+   * collected.
+   */
+  void dispatchUntilNextExecution();
   std::vector<StatisticPtr> vectorizeStatisticPtrMap(const StatisticPtrMap& statistics) const;
   std::vector<StatisticPtr>
   mergeWorkerStatistics(const std::vector<ClientWorkerPtr>& workers) const;
+  /**
+   * Merges statistics across multiple sources, like workers. Statistics with the same id get
+   * merged.
+   *
+   * @param statistics the statistics to merge.
+   * @return std::vector<StatisticPtr> the merged statistics.
+   */
+  std::vector<StatisticPtr> mergeStatistics(const std::vector<StatisticPtrMap>& statistics) const;
+  /**
+   * Adds results for each phase of the configured load profile to the collector. For each phase
+   * a global result is added, plus per-worker results when more than a single worker is used.
+   * These hold the sequencer and benchmark client statistics of the phase.
+   *
+   * @param collector the collector to add the results to.
+   */
+  void addLoadPhaseResults(OutputCollector& collector) const;
   void setupForHRTimers();
   /**
    * If there are sinks configured in bootstrap, populate stats_sinks with sinks
@@ -135,19 +270,17 @@ private:
                    const absl::optional<Envoy::SystemTime>& schedule);
 
   /**
-   * Compute the offset at which execution should start. We adhere to the scheduled start passed in
-   * as an argument when specified, otherwise we need a delay that will be sufficient for all the
-   * workers to get up and running.
+   * Compute the time at which execution should start when a start has been scheduled. Otherwise
+   * execution starts as soon as all workers are ready, see WorkerStartBarrier.
    *
    * @param time_system Time system used to obtain the current time.
    * @param scheduled_start Optional scheduled start.
-   * @param concurrency The number of workers that will be used during execution.
-   * @return Envoy::MonotonicTime Time at which execution should start.
+   * @return absl::optional<Envoy::MonotonicTime> Time at which execution should start, or
+   * absl::nullopt when no start was scheduled.
    */
-  static Envoy::MonotonicTime
+  static absl::optional<Envoy::MonotonicTime>
   computeFirstWorkerStart(Envoy::Event::TimeSystem& time_system,
-                          const absl::optional<Envoy::SystemTime>& scheduled_start,
-                          const uint32_t concurrency);
+                          const absl::optional<Envoy::SystemTime>& scheduled_start);
 
   /**
    * We offset the start of each thread so that workers will execute tasks evenly spaced in
@@ -165,11 +298,20 @@ private:
    */
   static std::chrono::nanoseconds computeInterWorkerDelay(const uint32_t concurrency,
                                                           const uint32_t rps);
+  /**
+   * @param options options of the execution.
+   * @param concurrency the number of workers.
+   * @return std::chrono::nanoseconds the offset between the start times of consecutive workers.
+   */
+  std::chrono::nanoseconds interWorkerDelay(const Options& options,
+                                            const uint32_t concurrency) const;
 
   const envoy::config::core::v3::Node node_;
   const Envoy::Protobuf::RepeatedPtrField<std::string> node_context_params_;
   const Options& options_;
   const int number_of_workers_;
+  // Set when the number of workers was chosen adaptively.
+  absl::optional<nighthawk::client::ConcurrencyCalibration> concurrency_calibration_;
   std::shared_ptr<Envoy::ProcessWide> process_wide_;
   Envoy::PlatformImpl platform_impl_;
   Envoy::Event::TimeSystem& time_system_;
@@ -182,10 +324,32 @@ private:
   envoy::config::bootstrap::v3::Bootstrap bootstrap_;
   Envoy::Api::ApiPtr api_;
   Envoy::Event::DispatcherPtr dispatcher_;
+  // Factories for the latest execution on warm workers. The workers' phases refer to these until
+  // the next execution starts. They refer to the options passed to runWarm().
+  std::unique_ptr<SequencerFactoryImpl> warm_sequencer_factory_;
+  std::unique_ptr<TerminationPredicateFactoryImpl> warm_termination_predicate_factory_;
+  // Counter values as they were when the latest execution on warm workers started. Empty for the
+  // first execution.
+  std::map<std::string, uint64_t> counters_at_execution_start_;
+  // Releases the workers once all of them are ready. Created along with the workers, and
+  // declared before them as they hold a reference to it.
+  std::unique_ptr<WorkerStartBarrier> start_barrier_;
+  IntervalOutputCallback interval_output_callback_;
+  // Merges the interval reports of the workers of the latest execution. Declared before the
+  // workers, as they hold a reference to it.
+  std::unique_ptr<IntervalReporter> interval_reporter_;
   std::vector<ClientWorkerPtr> workers_;
+  // Moments at which the phases of starting up the execution completed.
+  struct StartupTimestamps {
+    Envoy::MonotonicTime begin;
+    Envoy::MonotonicTime workers_created;
+    Envoy::MonotonicTime cluster_manager_initialized;
+    Envoy::MonotonicTime workers_started;
+  } startup_timestamps_;
   const BenchmarkClientFactoryImpl benchmark_client_factory_;
   const TerminationPredicateFactoryImpl termination_predicate_factory_;
-  const SequencerFactoryImpl sequencer_factory_;
+  // Not const, because a replay schedule may be set on it after construction.
+  SequencerFactoryImpl sequencer_factory_;
   const RequestSourceFactoryImpl request_generator_factory_;
   Envoy::Init::ManagerImpl init_manager_;
   Envoy::LocalInfo::LocalInfoPtr local_info_;
@@ -216,6 +380,12 @@ private:
   Envoy::Thread::MutexBasicLockable workers_lock_;
   bool cancelled_{false};
   std::unique_ptr<FlushWorkerImpl> flush_worker_;
+  // Cpus to pin each worker to, indexed by worker number. Empty when the workers are not pinned.
+  std::vector<CpuSet> worker_cpu_sets_;
+  // Cpus to pin the flush worker to. Empty when it is not pinned.
+  CpuSet flush_worker_cpu_set_;
+  // Topology of the host, only discovered when something gets pinned.
+  absl::optional<CpuTopology> cpu_topology_;
   Envoy::Router::ContextImpl router_context_;
   Envoy::OptionsImpl envoy_options_;
   // Null server implementation used as a placeholder. Its methods should never get called
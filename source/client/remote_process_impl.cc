@@ -38,6 +38,15 @@ bool RemoteProcessImpl::run(OutputCollector& collector) {
   return false;
 }
 
+bool RemoteProcessImpl::runWarm(const Options&, OutputCollector&) {
+  ENVOY_LOG(error, "Warm executions are not supported for remote processes");
+  return false;
+}
+
+absl::Status RemoteProcessImpl::switchPhase(const nighthawk::client::LoadPhase&) {
+  return absl::UnimplementedError("Phase switches are not supported for remote processes");
+}
+
 bool RemoteProcessImpl::requestExecutionCancellation() {
   ENVOY_LOG(error, "Remote process cancellation not supported yet");
   // TODO(#380): Send a cancel request to the gRPC service.
@@ -30,6 +30,23 @@ public:
    * will log available error details.
    */
   bool run(OutputCollector& collector) override;
+  /**
+   * Warm executions are not supported when delegating to a remote nighthawk service.
+   *
+   * @return false
+   */
+  bool runWarm(const Options& options, OutputCollector& collector) override;
+  /**
+   * Phase switches are not supported when delegating to a remote nighthawk service.
+   *
+   * @return absl::Status kUnimplemented.
+   */
+  absl::Status switchPhase(const nighthawk::client::LoadPhase& load_phase) override;
+  /**
+   * Intermediate output is not supported when delegating to a remote nighthawk service, a no-op
+   * in this implementation.
+   */
+  void setIntervalOutputCallback(IntervalOutputCallback) override {}
   /**
    * Shuts down the service, a no-op in this implementation.
    */
@@ -2,11 +2,14 @@
 
 #include <grpc++/grpc++.h>
 
+#include <algorithm>
+
 #include "envoy/config/core/v3/base.pb.h"
 
 #include "source/client/client.h"
 #include "source/client/options_impl.h"
 #include "source/client/output_collector_impl.h"
+#include "source/client/process_impl.h"
 #include "source/common/request_source_impl.h"
 
 #include "absl/strings/str_cat.h"
@@ -14,6 +17,15 @@
 namespace Nighthawk {
 namespace Client {
 
+ServiceImpl::~ServiceImpl() {
+  if (future_.valid()) {
+    future_.wait();
+  }
+  if (warm_process_ != nullptr) {
+    warm_process_->shutdown();
+  }
+}
+
 void ServiceImpl::handleExecutionRequest(const nighthawk::client::ExecutionRequest& request) {
   std::unique_ptr<Envoy::Thread::LockGuard> busy_lock;
   {
@@ -28,31 +40,81 @@ void ServiceImpl::handleExecutionRequest(const nighthawk::client::ExecutionReque
   nighthawk::client::ExecutionResponse response;
   OptionsPtr options;
   try {
-    options = std::make_unique<OptionsImpl>(request.start_request().options());
+    options = std::make_unique<OptionsImpl>(request.has_update_request()
+                                                ? request.update_request().options()
+                                                : request.start_request().options());
   } catch (const MalformedArgvException& e) {
     response.mutable_error_detail()->set_code(grpc::StatusCode::INTERNAL);
     response.mutable_error_detail()->set_message(e.what());
     writeResponse(response);
     return;
   }
-  envoy::config::core::v3::TypedExtensionConfig typed_dns_resolver_config;
-  Envoy::Network::DnsResolverFactory& dns_resolver_factory =
-      Envoy::Network::createDefaultDnsResolverFactory(typed_dns_resolver_config);
+  if (options->executionId().has_value()) {
+    response.set_execution_id(options->executionId().value());
+  }
 
-  absl::StatusOr<ProcessPtr> process_or_status = ProcessImpl::CreateProcessImpl(
-      *options, dns_resolver_factory, std::move(typed_dns_resolver_config), time_system_,
-      process_wide_);
-  if (!process_or_status.ok()) {
-    response.mutable_error_detail()->set_code(grpc::StatusCode::INTERNAL);
+  ProcessPtr process;
+  OptionsPtr process_options;
+  bool warm = false;
+  if (warm_process_ != nullptr) {
+    const absl::Status status =
+        ProcessImpl::checkWarmCompatibility(*warm_process_options_, *options);
+    if (status.ok()) {
+      process = std::move(warm_process_);
+      process_options = std::move(warm_process_options_);
+      warm = true;
+    } else {
+      ENVOY_LOG(info, "Not reusing the warm process: {}", status.message());
+      warm_process_->shutdown();
+      warm_process_.reset();
+      warm_process_options_.reset();
+      warm_execution_options_.reset();
+    }
+  }
+  if (!warm && request.has_update_request()) {
+    response.mutable_error_detail()->set_code(grpc::StatusCode::FAILED_PRECONDITION);
     response.mutable_error_detail()->set_message(
-        fmt::format("Unable to create ProcessImpl: {}", process_or_status.status().ToString()));
+        "An update request needs a warm process with compatible options to run on.");
     writeResponse(response);
     return;
   }
-  ProcessPtr process = std::move(*process_or_status);
+  if (!warm) {
+    envoy::config::core::v3::TypedExtensionConfig typed_dns_resolver_config;
+    Envoy::Network::DnsResolverFactory& dns_resolver_factory =
+        Envoy::Network::createDefaultDnsResolverFactory(typed_dns_resolver_config);
+
+    absl::StatusOr<ProcessPtr> process_or_status = ProcessImpl::CreateProcessImpl(
+        *options, dns_resolver_factory, std::move(typed_dns_resolver_config), time_system_,
+        process_wide_);
+    if (!process_or_status.ok()) {
+      response.mutable_error_detail()->set_code(grpc::StatusCode::INTERNAL);
+      response.mutable_error_detail()->set_message(
+          fmt::format("Unable to create ProcessImpl: {}", process_or_status.status().ToString()));
+      writeResponse(response);
+      return;
+    }
+    process = std::move(*process_or_status);
+  }
 
+  process->setIntervalOutputCallback(
+      [this, execution_id = response.execution_id()](const nighthawk::client::Output& output) {
+        nighthawk::client::ExecutionResponse intermediate_response;
+        intermediate_response.set_execution_id(execution_id);
+        intermediate_response.set_intermediate(true);
+        *intermediate_response.mutable_output() = output;
+        writeResponse(intermediate_response);
+      });
   OutputCollectorImpl output_collector(time_system_, *options);
-  const bool ok = process->run(output_collector);
+  {
+    Envoy::Thread::LockGuard guard(active_process_lock_);
+    active_process_ = process.get();
+  }
+  const bool ok =
+      warm ? process->runWarm(*options, output_collector) : process->run(output_collector);
+  {
+    Envoy::Thread::LockGuard guard(active_process_lock_);
+    active_process_ = nullptr;
+  }
   if (!ok) {
     response.mutable_error_detail()->set_code(grpc::StatusCode::INTERNAL);
     // TODO(https://github.com/envoyproxy/nighthawk/issues/181): wire through error descriptions, so
@@ -71,7 +133,18 @@ void ServiceImpl::handleExecutionRequest(const nighthawk::client::ExecutionReque
         "benchmark request.");
   }
   *(response.mutable_output()) = output_collector.toProto();
-  process->shutdown();
+  // Results are only there when the workers got to run, in which case they can be reused.
+  if (keep_warm_ && response.output().results_size() > 0) {
+    warm_process_ = std::move(process);
+    if (warm) {
+      warm_process_options_ = std::move(process_options);
+      warm_execution_options_ = std::move(options);
+    } else {
+      warm_process_options_ = std::move(options);
+    }
+  } else {
+    process->shutdown();
+  }
   // We release before writing the response to avoid a race with the client's follow up request
   // coming in before we release the lock, which would lead up to us declining service when
   // we should not.
@@ -81,6 +154,7 @@ void ServiceImpl::handleExecutionRequest(const nighthawk::client::ExecutionReque
 
 void ServiceImpl::writeResponse(const nighthawk::client::ExecutionResponse& response) {
   ENVOY_LOG(debug, "Write response: {}", absl::StrCat(response));
+  Envoy::Thread::LockGuard guard(write_lock_);
   if (!stream_->Write(response)) {
     ENVOY_LOG(warn, "Failed to write response to the stream");
   }
@@ -97,7 +171,7 @@ grpc::Status ServiceImpl::finishGrpcStream(const bool success, absl::string_view
                  : grpc::Status(grpc::StatusCode::INTERNAL, std::string(description));
 }
 
-// TODO(oschaaf): implement a way to cancel test runs, and update rps config on the fly.
+// TODO(oschaaf): implement a way to cancel test runs.
 // TODO(oschaaf): unit-test Process, create MockProcess & use in service_test.cc / client_test.cc
 // TODO(oschaaf): should we merge incoming request options with defaults?
 // TODO(oschaaf): aggregate the client's logs and forward them in the grpc response.
@@ -110,7 +184,24 @@ grpc::Status ServiceImpl::ExecutionStream(
 
   while (stream->Read(&request)) {
     ENVOY_LOG(debug, "Read ExecutionRequest data {}", absl::StrCat(request));
-    if (request.has_start_request()) {
+    if (request.has_update_request() && request.update_request().has_phase()) {
+      absl::Status status =
+          absl::FailedPreconditionError("A phase switch needs a running execution.");
+      {
+        Envoy::Thread::LockGuard guard(active_process_lock_);
+        if (active_process_ != nullptr) {
+          status = active_process_->switchPhase(request.update_request().phase());
+        }
+      }
+      if (!status.ok()) {
+        return finishGrpcStream(false, status.message());
+      }
+      // The results of the switched-to phase are part of the response of the execution.
+      continue;
+    }
+    // With keep-warm, updates carrying options run another execution on the warm process.
+    if (request.has_start_request() ||
+        (request.has_update_request() && request.update_request().has_options() && keep_warm_)) {
       // If busy_lock_ is held we can't start a new benchmark run because one is active already.
       if (busy_lock_.tryLock()) {
         busy_lock_.unlock();
@@ -161,12 +252,13 @@ grpc::Status RequestSourceServiceImpl::RequestStream(
     // these nearly empty headers will basically be a near no-op (note that the client will merge
     // headers we send here into into own header configuration). The client can be configured to
     // connect to a custom grpc service as a remote data source instead of this one, and its workers
-    // will comply. That in itself may be useful. But we could offer the following features here:
-    // 1. Yet another remote request source, so we balance to-be-replayed headers over workers
-    //    and only have a single stream to a remote service here.
-    // 2. Read a and dispatch a header stream from disk.
+    // will comply. That in itself may be useful. Workers can also share a single stream, see
+    // --request-source-shared-stream. But we could offer the following feature here:
+    // 1. Read a and dispatch a header stream from disk.
     RequestSourcePtr request_source = createStaticEmptyRequestSource(request.quantity());
     RequestGenerator request_generator = request_source->get();
+    const uint32_t max_batch_size = std::max<uint32_t>(request.max_batch_size(), 1);
+    nighthawk::request_source::RequestStreamResponse batch;
     RequestPtr request;
     while (ok && (request = request_generator()) != nullptr) {
       HeaderMapPtr headers = request->header();
@@ -179,7 +271,18 @@ grpc::Status RequestSourceServiceImpl::RequestStream(
         return Envoy::Http::RequestHeaderMap::Iterate::Continue;
       });
       // TODO(oschaaf): add static configuration for other fields plus expectations
-      ok = ok && stream->Write(response);
+      if (max_batch_size == 1) {
+        ok = stream->Write(response);
+      } else {
+        *batch.add_requests() = std::move(response);
+        if (static_cast<uint32_t>(batch.requests_size()) == max_batch_size) {
+          ok = stream->Write(batch);
+          batch.Clear();
+        }
+      }
+    }
+    if (ok && batch.requests_size() > 0) {
+      ok = stream->Write(batch);
     }
     if (!ok) {
       ENVOY_LOG(error, "Failed to send the complete set of replay data.");
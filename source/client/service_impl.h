@@ -18,6 +18,7 @@
 #include "external/envoy/source/common/event/real_time_system.h"
 #include "external/envoy/source/exe/process_wide.h"
 
+#include "nighthawk/client/options.h"
 #include "nighthawk/client/process.h"
 #include "nighthawk/common/request_source.h"
 
@@ -34,17 +35,25 @@ class ServiceImpl final : public nighthawk::client::NighthawkService::Service,
 public:
   /**
    * Constructs a new ServiceImpl instance
+   *
+   * @param keep_warm when true, the process of an execution is kept alive afterwards, and later
+   * executions that only differ in pacing, duration, termination predicates and output reuse its
+   * workers and connections.
    */
-  ServiceImpl() : process_wide_(std::make_shared<Envoy::ProcessWide>()) {
+  ServiceImpl(const bool keep_warm = false)
+      : process_wide_(std::make_shared<Envoy::ProcessWide>()), keep_warm_(keep_warm) {
     logging_context_ = std::make_unique<Envoy::Logger::Context>(
         spdlog::level::from_str("info"), "[%T.%f][%t][%L] %v", log_lock_, false);
   }
 
-  ServiceImpl(std::unique_ptr<Envoy::Logger::Context>&& logging_context)
-      : process_wide_(std::make_shared<Envoy::ProcessWide>()) {
+  ServiceImpl(std::unique_ptr<Envoy::Logger::Context>&& logging_context,
+              const bool keep_warm = false)
+      : process_wide_(std::make_shared<Envoy::ProcessWide>()), keep_warm_(keep_warm) {
     logging_context_ = std::move(logging_context);
   }
 
+  ~ServiceImpl() override;
+
   grpc::Status
   ExecutionStream(grpc::ServerContext* context,
                   grpc::ServerReaderWriter<nighthawk::client::ExecutionResponse,
@@ -59,8 +68,20 @@ private:
   std::unique_ptr<Envoy::Logger::Context> logging_context_;
   std::shared_ptr<Envoy::ProcessWide> process_wide_;
   Envoy::Event::RealTimeSystem time_system_; // NO_CHECK_FORMAT(real_time)
+  const bool keep_warm_;
+  // The options the warm process was created with, which must outlive it, and the options of the
+  // latest execution on it, which must stay alive until the next execution on it has completed.
+  // Only accessed while busy_lock_ is held.
+  OptionsPtr warm_process_options_;
+  OptionsPtr warm_execution_options_;
+  ProcessPtr warm_process_;
+  // The process of the running execution, which phase switches are forwarded to.
+  Envoy::Thread::MutexBasicLockable active_process_lock_;
+  Process* active_process_ ABSL_GUARDED_BY(active_process_lock_){nullptr};
   grpc::ServerReaderWriter<nighthawk::client::ExecutionResponse,
                            nighthawk::client::ExecutionRequest>* stream_;
+  // Intermediate responses are written from the thread that runs the execution.
+  Envoy::Thread::MutexBasicLockable write_lock_;
   std::future<void> future_;
   // accepted_lock_ and accepted_event_ are used to synchronize the threads
   // when starting up a future to service a test, and ensure the code servicing it
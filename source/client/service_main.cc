@@ -36,10 +36,17 @@ ServiceMain::ServiceMain(int argc, const char** argv) {
   TCLAP::ValueArg<std::string> service_arg(
       "", "service", "Specifies which service to run. Default 'traffic-generator-service'.", false,
       "traffic-generator-service", &service_names_allowed, cmd);
+
+  TCLAP::SwitchArg keep_warm_arg(
+      "", "keep-warm",
+      "Keep the process of the last successful execution warm, so that update requests with "
+      "compatible options can run on its workers and connections. Only applies to the "
+      "traffic-generator-service. Default false.",
+      cmd);
   Utility::parseCommand(cmd, argc, argv);
 
   if (service_arg.getValue() == "traffic-generator-service") {
-    service_ = std::make_unique<ServiceImpl>();
+    service_ = std::make_unique<ServiceImpl>(keep_warm_arg.getValue());
   } else if (service_arg.getValue() == "dummy-request-source") {
     service_ = std::make_unique<RequestSourceServiceImpl>();
   }
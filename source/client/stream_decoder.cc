@@ -73,13 +73,17 @@ void StreamDecoder::decodeTrailers(Envoy::Http::ResponseTrailerMapPtr&& headers)
 
 void StreamDecoder::onComplete(bool success) {
   ASSERT(!success || complete_);
+  // The request is no longer in flight by the time the completion callbacks run.
+  untrack();
   if (success && measure_latencies_) {
-    latency_statistic_.addValue((time_source_.monotonicTime() - request_start_).count());
+    const uint64_t latency_ns = (time_source_.monotonicTime() - request_start_).count();
+    latency_statistic_.addValue(latency_ns);
+    if (request_class_latency_statistic_ != nullptr) {
+      request_class_latency_statistic_->addValue(latency_ns);
+    }
     // At this point StreamDecoder::decodeHeaders() should have been called.
     if (stream_info_.responseCode().has_value()) {
-      decoder_completion_callback_.exportLatency(
-          stream_info_.responseCode().value(),
-          (time_source_.monotonicTime() - request_start_).count());
+      decoder_completion_callback_.exportLatency(stream_info_.responseCode().value(), latency_ns);
     } else {
       ENVOY_LOG_EVERY_POW_2(warn, "response_code is not available in onComplete");
     }
@@ -87,6 +91,9 @@ void StreamDecoder::onComplete(bool success) {
   stream_info_.upstreamInfo()->upstreamTiming().onLastUpstreamRxByteReceived(time_source_);
   response_body_sizes_statistic_.addValue(stream_info_.bytesSent());
   stream_info_.onRequestComplete();
+  if (success && expectations_.has_value()) {
+    verifyExpectations();
+  }
   if (response_headers_ != nullptr) {
     decoder_completion_callback_.onComplete(success, *response_headers_);
   } else {
@@ -99,6 +106,18 @@ void StreamDecoder::onComplete(bool success) {
   dispatcher_.deferredDelete(std::unique_ptr<StreamDecoder>(this));
 }
 
+void StreamDecoder::verifyExpectations() {
+  if (expectations_->response_code.has_value() &&
+      stream_info_.responseCode() != expectations_->response_code) {
+    decoder_completion_callback_.onExpectationMismatch(ExpectationMismatch::ResponseCode);
+  }
+  // The response body size is tracked as the bytes sent, see decodeData().
+  if (expectations_->content_length.has_value() &&
+      stream_info_.bytesSent() != expectations_->content_length.value()) {
+    decoder_completion_callback_.onExpectationMismatch(ExpectationMismatch::ContentLength);
+  }
+}
+
 void StreamDecoder::onResetStream(Envoy::Http::StreamResetReason reason,
                                   absl::string_view /* transport_failure_reason */) {
 
@@ -109,6 +128,8 @@ void StreamDecoder::onResetStream(Envoy::Http::StreamResetReason reason,
 void StreamDecoder::onPoolFailure(Envoy::Http::ConnectionPool::PoolFailureReason reason,
                                   absl::string_view /* transport_failure_reason */,
                                   Envoy::Upstream::HostDescriptionConstSharedPtr) {
+  pool_handle_ = nullptr;
+  untrack();
   decoder_completion_callback_.onPoolFailure(reason);
   stream_info_.setResponseFlag(Envoy::StreamInfo::CoreResponseFlag::UpstreamConnectionFailure);
   finalizeActiveSpan();
@@ -120,10 +141,13 @@ void StreamDecoder::onPoolReady(Envoy::Http::RequestEncoder& encoder,
                                 Envoy::Upstream::HostDescriptionConstSharedPtr,
                                 Envoy::StreamInfo::StreamInfo&,
                                 absl::optional<Envoy::Http::Protocol>) {
+  pool_handle_ = nullptr;
+  request_encoder_ = &encoder;
   encoder.getStream().addCallbacks(*this);
   stream_info_.upstreamInfo()->upstreamTiming().onFirstUpstreamTxByteSent(
       time_source_); // XXX(oschaaf): is this correct?
-  const bool end_stream = request_body_size_ == 0 && request_body_.empty();
+  const bool has_request_body = request_body_ != nullptr && !request_body_->empty();
+  const bool end_stream = request_body_size_ == 0 && !has_request_body;
   const Envoy::Http::Status status = encoder.encodeHeaders(*request_headers_, end_stream);
   if (!status.ok()) {
     ENVOY_LOG_EVERY_POW_2(error,
@@ -131,14 +155,14 @@ void StreamDecoder::onPoolReady(Envoy::Http::RequestEncoder& encoder,
                           "HTTP headers in {}.",
                           *request_headers_);
   }
-  if (request_body_size_ > 0 || !request_body_.empty()) {
+  if (request_body_size_ > 0 || has_request_body) {
     // TODO(https://github.com/envoyproxy/nighthawk/issues/138): This will show up in the zipkin UI
     // as 'response_size'. We add it here, optimistically assuming it will all be send. Ideally,
     // we'd track the encoder events of the stream to dig up and forward more information. For now,
     // we take the risk of erroneously reporting that we did send all the bytes, instead of always
     // reporting 0 bytes.
     Envoy::Buffer::OwnedImpl body_buffer;
-    if (request_body_.empty()) {
+    if (!has_request_body) {
       // Revisit this when we have non-uniform request distributions and on-the-fly reconfiguration
       // in place. The string size below MUST match the cap we put on
       // RequestOptions::request_body_size in api/client/options.proto!
@@ -149,8 +173,8 @@ void StreamDecoder::onPoolReady(Envoy::Http::RequestEncoder& encoder,
       body_buffer.addBufferFragment(*fragment);
 
     } else {
-      stream_info_.addBytesReceived(request_body_.size());
-      body_buffer.add(absl::string_view(request_body_));
+      stream_info_.addBytesReceived(request_body_->size());
+      body_buffer.add(absl::string_view(*request_body_));
     }
     encoder.encodeData(body_buffer, true);
   }
@@ -161,6 +185,47 @@ void StreamDecoder::onPoolReady(Envoy::Http::RequestEncoder& encoder,
   }
 }
 
+void StreamDecoder::track(InFlightStreamDecoders& in_flight_decoders) {
+  ASSERT(in_flight_decoders_ == nullptr);
+  in_flight_decoders_ = &in_flight_decoders;
+  next_in_flight_ = in_flight_decoders.head_;
+  if (next_in_flight_ != nullptr) {
+    next_in_flight_->previous_in_flight_ = this;
+  }
+  in_flight_decoders.head_ = this;
+}
+
+void StreamDecoder::untrack() {
+  if (in_flight_decoders_ == nullptr) {
+    return;
+  }
+  if (previous_in_flight_ != nullptr) {
+    previous_in_flight_->next_in_flight_ = next_in_flight_;
+  } else {
+    in_flight_decoders_->head_ = next_in_flight_;
+  }
+  if (next_in_flight_ != nullptr) {
+    next_in_flight_->previous_in_flight_ = previous_in_flight_;
+  }
+  in_flight_decoders_ = nullptr;
+  previous_in_flight_ = nullptr;
+  next_in_flight_ = nullptr;
+}
+
+void StreamDecoder::resetStream() {
+  untrack();
+  if (request_encoder_ != nullptr) {
+    // Resetting the stream runs our onResetStream() callback.
+    request_encoder_->getStream().resetStream(Envoy::Http::StreamResetReason::LocalReset);
+    return;
+  }
+  if (pool_handle_ != nullptr) {
+    pool_handle_->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    pool_handle_ = nullptr;
+  }
+  onResetStream(Envoy::Http::StreamResetReason::LocalReset, "");
+}
+
 // TODO(https://github.com/envoyproxy/nighthawk/issues/139): duplicated from
 // envoy/source/common/router/router.cc
 Envoy::StreamInfo::CoreResponseFlag
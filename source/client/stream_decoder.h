@@ -17,9 +17,19 @@
 #include "external/envoy/source/common/stream_info/stream_info_impl.h"
 #include "external/envoy/source/common/tracing/http_tracer_impl.h"
 
+#include "source/common/slab_arena.h"
+
 namespace Nighthawk {
 namespace Client {
 
+/**
+ * The ways in which a response can fail to meet the expectations of its request.
+ */
+enum class ExpectationMismatch {
+  ResponseCode,
+  ContentLength,
+};
+
 class StreamDecoderCompletionCallback {
 public:
   virtual ~StreamDecoderCompletionCallback() = default;
@@ -27,12 +37,35 @@ public:
   virtual void onPoolFailure(Envoy::Http::ConnectionPool::PoolFailureReason reason) PURE;
   virtual void exportLatency(const uint32_t response_code, const uint64_t latency_ns) PURE;
   virtual void handleResponseData(const Envoy::Buffer::Instance& response_data) PURE;
+  /**
+   * Called for each expectation that a completed response did not meet, before onComplete().
+   * @param mismatch the kind of expectation that was not met.
+   */
+  virtual void onExpectationMismatch(const ExpectationMismatch mismatch) PURE;
 };
 
-// TODO(oschaaf): create a StreamDecoderPool?
+class StreamDecoder;
+
+/**
+ * List of the stream decoders of in-flight requests. The list is intrusive: decoders link
+ * themselves through pointers they hold, so that tracking a request does not allocate.
+ */
+class InFlightStreamDecoders {
+public:
+  bool empty() const { return head_ == nullptr; }
+  StreamDecoder* front() const { return head_; }
+
+private:
+  friend class StreamDecoder;
+  StreamDecoder* head_{};
+};
 
 /**
- * A self destructing response decoder that discards the response body.
+ * A self destructing response decoder that discards the response body. Decoders are allocated
+ * from the slab arena of the benchmark client when one is passed to new, and from the heap
+ * otherwise. When a request class latency statistic is passed, measured latencies are also added
+ * to it, to break them down by the class of the request. When response expectations are passed,
+ * successfully completed responses are verified against them.
  */
 class StreamDecoder : public Envoy::Http::ResponseDecoder,
                       public Envoy::Http::StreamCallbacks,
@@ -40,20 +73,17 @@ class StreamDecoder : public Envoy::Http::ResponseDecoder,
                       public Envoy::Event::DeferredDeletable,
                       public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
 public:
-  // TODO(pelintehcoder): Optimize request body handling by reconsidering the use of std::string.
-  // - Evaluate whether absl::string_view or const std::string& can be used instead of storing full
-  // copies.
-  // - Ensure that lifetime concerns are properly handled to avoid dangling references.
-  // - This will reduce unnecessary copies while maintaining safety.
   StreamDecoder(Envoy::Event::Dispatcher& dispatcher, Envoy::TimeSource& time_source,
                 StreamDecoderCompletionCallback& decoder_completion_callback,
                 OperationCallback caller_completion_callback, Statistic& connect_statistic,
                 Statistic& latency_statistic, Statistic& response_header_sizes_statistic,
                 Statistic& response_body_sizes_statistic, Statistic& origin_latency_statistic,
-                HeaderMapPtr request_headers, std::string request_body, bool measure_latencies,
+                HeaderMapPtr request_headers, BodyPtr request_body, bool measure_latencies,
                 uint32_t request_body_size, Envoy::Random::RandomGenerator& random_generator,
                 Envoy::Tracing::TracerSharedPtr& tracer,
-                absl::string_view latency_response_header_name)
+                absl::string_view latency_response_header_name,
+                Statistic* request_class_latency_statistic = nullptr,
+                const absl::optional<ResponseExpectations>& expectations = absl::nullopt)
       : dispatcher_(dispatcher), time_source_(time_source),
         decoder_completion_callback_(decoder_completion_callback),
         caller_completion_callback_(std::move(caller_completion_callback)),
@@ -70,13 +100,22 @@ public:
         stream_info_(time_source_, downstream_address_setter_,
                      Envoy::StreamInfo::FilterState::LifeSpan::FilterChain),
         random_generator_(random_generator), tracer_(tracer),
-        latency_response_header_name_(latency_response_header_name) {
+        latency_response_header_name_(latency_response_header_name),
+        request_class_latency_statistic_(request_class_latency_statistic),
+        expectations_(expectations) {
     if (measure_latencies_ && tracer_ != nullptr) {
       setupForTracing();
     }
     stream_info_.setUpstreamInfo(std::make_shared<Envoy::StreamInfo::UpstreamInfoImpl>());
   }
 
+  ~StreamDecoder() override { untrack(); }
+
+  static void* operator new(size_t size) { return SlabArena::allocateFromHeap(size); }
+  static void* operator new(size_t size, SlabArena& arena) { return arena.allocate(size); }
+  static void operator delete(void* block) { SlabArena::release(block); }
+  static void operator delete(void* block, SlabArena&) { SlabArena::release(block); }
+
   // Http::StreamDecoder
   void decode1xxHeaders(Envoy::Http::ResponseHeaderMapPtr&&) override {}
   void decodeHeaders(Envoy::Http::ResponseHeaderMapPtr&& headers, bool end_stream) override;
@@ -101,6 +140,25 @@ public:
                    Envoy::StreamInfo::StreamInfo& stream_info,
                    absl::optional<Envoy::Http::Protocol> protocol) override;
 
+  /**
+   * Adds the decoder to a list of in-flight decoders, from which it removes itself once its request
+   * completes.
+   * @param in_flight_decoders the list to add the decoder to.
+   */
+  void track(InFlightStreamDecoders& in_flight_decoders);
+  /**
+   * @param pool_handle handle of the pending request returned by the connection pool, used to
+   * cancel it when it is reset before a connection is ready. nullptr when there is none.
+   */
+  void setPoolHandle(Envoy::Http::ConnectionPool::Cancellable* pool_handle) {
+    pool_handle_ = pool_handle;
+  }
+  /**
+   * Resets the stream of the request, or cancels the request when it is still waiting for a
+   * connection. Either way, the request completes as failed before this returns.
+   */
+  void resetStream();
+
   static Envoy::StreamInfo::CoreResponseFlag
   streamResetReasonToResponseFlag(Envoy::Http::StreamResetReason reset_reason);
   void finalizeActiveSpan();
@@ -108,6 +166,8 @@ public:
 
 private:
   void onComplete(bool success);
+  void verifyExpectations();
+  void untrack();
   static const std::string& staticUploadContent() {
     static const auto s = new std::string(4194304, 'a');
     return *s;
@@ -123,7 +183,8 @@ private:
   Statistic& response_body_sizes_statistic_;
   Statistic& origin_latency_statistic_;
   HeaderMapPtr request_headers_;
-  const std::string request_body_;
+  // Shared with the request source, which may hand out the same body for many requests.
+  const BodyPtr request_body_;
   Envoy::Http::ResponseHeaderMapPtr response_headers_;
   Envoy::Http::ResponseTrailerMapPtr trailer_headers_;
   const Envoy::MonotonicTime connect_start_;
@@ -138,6 +199,14 @@ private:
   Envoy::Tracing::TracerSharedPtr& tracer_;
   Envoy::Tracing::SpanPtr active_span_;
   const std::string latency_response_header_name_;
+  Statistic* const request_class_latency_statistic_;
+  const absl::optional<ResponseExpectations> expectations_;
+  Envoy::Http::RequestEncoder* request_encoder_{};
+  Envoy::Http::ConnectionPool::Cancellable* pool_handle_{};
+  // Set while the decoder is linked into a list of in-flight decoders.
+  InFlightStreamDecoders* in_flight_decoders_{};
+  StreamDecoder* previous_in_flight_{};
+  StreamDecoder* next_in_flight_{};
 };
 
 } // namespace Client
@@ -0,0 +1,371 @@
+#include "source/client/trace_import_main.h"
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "nighthawk/common/exception.h"
+
+#include "external/envoy/source/common/http/utility.h"
+
+#include "source/common/utility.h"
+#include "source/common/version_info.h"
+#include "source/request_source/request_trace.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "fmt/ranges.h"
+#include "nlohmann/json.hpp"
+#include "tclap/CmdLine.h"
+
+namespace Nighthawk {
+namespace Client {
+
+namespace {
+
+constexpr absl::string_view kEnvoyJsonFormat = "envoy-json";
+constexpr absl::string_view kHarFormat = "har";
+
+// A request read from an access log.
+struct ImportedRequest {
+  absl::Time time;
+  std::vector<std::pair<std::string, std::string>> headers;
+  absl::optional<std::string> body;
+};
+
+absl::optional<absl::Time> parseTime(const std::string& value) {
+  absl::Time time;
+  std::string error;
+  if (!absl::ParseTime(absl::RFC3339_full, value, &time, &error)) {
+    return absl::nullopt;
+  }
+  return time;
+}
+
+// Adds a header taken from an access log to the request. Pseudo headers are set explicitly by the
+// importers. Hop by hop headers and the content length, which is derived from the body upon
+// replay, are dropped.
+void addHeader(ImportedRequest& request, absl::string_view name, absl::string_view value) {
+  static const auto* dropped = new absl::flat_hash_set<std::string>(
+      {"connection", "content-length", "host", "keep-alive", "proxy-connection", "te",
+       "transfer-encoding", "upgrade"});
+  const std::string lower_case_name = absl::AsciiStrToLower(name);
+  if (lower_case_name.empty() || lower_case_name[0] == ':' || dropped->contains(lower_case_name)) {
+    return;
+  }
+  request.headers.emplace_back(lower_case_name, std::string(value));
+}
+
+// Writes requests to the trace in order of their start time, sorting them within a window of a
+// bounded number of requests.
+class ReorderingTraceWriter {
+public:
+  ReorderingTraceWriter(RequestTraceWriter& writer, const uint32_t window)
+      : writer_(writer), window_(std::max<uint32_t>(window, 1)) {}
+
+  void add(ImportedRequest&& request) {
+    pending_.push_back({std::move(request), sequence_++});
+    std::push_heap(pending_.begin(), pending_.end(), laterThan);
+    if (pending_.size() > window_) {
+      writeEarliest();
+    }
+  }
+
+  void flush() {
+    while (!pending_.empty()) {
+      writeEarliest();
+    }
+  }
+
+  // The number of requests that arrived after a later request had already been written.
+  uint64_t clamped() const { return clamped_; }
+
+private:
+  struct Pending {
+    ImportedRequest request;
+    // Keeps requests with the same start time in input order.
+    uint64_t sequence;
+  };
+
+  static bool laterThan(const Pending& a, const Pending& b) {
+    return std::tie(a.request.time, a.sequence) > std::tie(b.request.time, b.sequence);
+  }
+
+  void writeEarliest() {
+    std::pop_heap(pending_.begin(), pending_.end(), laterThan);
+    ImportedRequest request = std::move(pending_.back().request);
+    pending_.pop_back();
+    if (!start_.has_value()) {
+      start_ = last_ = request.time;
+    }
+    if (request.time < last_) {
+      clamped_++;
+      request.time = last_;
+    }
+    last_ = request.time;
+    writer_.addRecord(request.headers, request.body,
+                      std::chrono::nanoseconds(absl::ToInt64Nanoseconds(request.time - *start_)));
+  }
+
+  RequestTraceWriter& writer_;
+  const size_t window_;
+  std::vector<Pending> pending_;
+  uint64_t sequence_{0};
+  absl::optional<absl::Time> start_;
+  absl::Time last_;
+  uint64_t clamped_{0};
+};
+
+// Returns the value of a string field of an Envoy access log entry, if set.
+absl::optional<std::string> envoyJsonField(const nlohmann::json& entry, const char* key) {
+  const auto it = entry.find(key);
+  // Envoy logs "-" or null for values that are not available.
+  if (it == entry.end() || !it->is_string() || it->get_ref<const std::string&>() == "-") {
+    return absl::nullopt;
+  }
+  return it->get<std::string>();
+}
+
+// Reads an Envoy JSON access log, with one entry per line. Returns the number of lines that could
+// not be imported.
+uint64_t importEnvoyJson(std::istream& input, ReorderingTraceWriter& writer) {
+  uint64_t skipped = 0;
+  std::string line;
+  while (std::getline(input, line)) {
+    if (absl::StripAsciiWhitespace(line).empty()) {
+      continue;
+    }
+    const nlohmann::json entry = nlohmann::json::parse(line, nullptr, /*allow_exceptions=*/false);
+    if (!entry.is_object()) {
+      skipped++;
+      continue;
+    }
+    const absl::optional<std::string> start_time = envoyJsonField(entry, "start_time");
+    const absl::optional<std::string> method = envoyJsonField(entry, "method");
+    const absl::optional<std::string> path = envoyJsonField(entry, "path");
+    const absl::optional<absl::Time> time =
+        start_time.has_value() ? parseTime(*start_time) : absl::nullopt;
+    if (!time.has_value() || !method.has_value() || !path.has_value()) {
+      skipped++;
+      continue;
+    }
+    ImportedRequest request{*time, {{":method", *method}, {":path", *path}}, absl::nullopt};
+    const absl::optional<std::string> authority = envoyJsonField(entry, "authority");
+    if (authority.has_value()) {
+      request.headers.emplace_back(":authority", *authority);
+    }
+    const absl::optional<std::string> user_agent = envoyJsonField(entry, "user_agent");
+    if (user_agent.has_value()) {
+      addHeader(request, "user-agent", *user_agent);
+    }
+    const auto headers = entry.find("request_headers");
+    if (headers != entry.end() && headers->is_object()) {
+      for (const auto& header : headers->items()) {
+        if (header.value().is_string() && header.value().get_ref<const std::string&>() != "-") {
+          addHeader(request, header.key(), header.value().get_ref<const std::string&>());
+        }
+      }
+    }
+    writer.add(std::move(request));
+  }
+  return skipped;
+}
+
+// SAX handler which imports the entries of a HAR file as they are parsed, so that the file never
+// needs to be held in memory.
+class HarImporter : public nlohmann::json_sax<nlohmann::json> {
+public:
+  explicit HarImporter(ReorderingTraceWriter& writer) : writer_(writer) {}
+
+  // The number of entries that could not be imported.
+  uint64_t skipped() const { return skipped_; }
+  // The parse error, if parsing failed.
+  const std::string& error() const { return error_; }
+
+  bool null() override { return true; }
+  bool boolean(bool) override { return true; }
+  bool number_integer(number_integer_t) override { return true; }
+  bool number_unsigned(number_unsigned_t) override { return true; }
+  bool number_float(number_float_t, const string_t&) override { return true; }
+  bool binary(binary_t&) override { return true; }
+
+  bool string(string_t& value) override {
+    if (at({"log", "entries", kElement, "startedDateTime"})) {
+      entry_.time = value;
+    } else if (at({"log", "entries", kElement, "request", "method"})) {
+      entry_.method = value;
+    } else if (at({"log", "entries", kElement, "request", "url"})) {
+      entry_.url = value;
+    } else if (at({"log", "entries", kElement, "request", "postData", "text"})) {
+      entry_.body = value;
+    } else if (at({"log", "entries", kElement, "request", "headers", kElement, "name"})) {
+      header_name_ = value;
+    } else if (at({"log", "entries", kElement, "request", "headers", kElement, "value"})) {
+      header_value_ = value;
+    }
+    return true;
+  }
+
+  bool start_object(std::size_t) override {
+    // The key of the member being parsed is set by key().
+    path_.emplace_back();
+    return true;
+  }
+
+  bool key(string_t& value) override {
+    path_.back() = value;
+    return true;
+  }
+
+  bool end_object() override {
+    path_.pop_back();
+    if (at({"log", "entries", kElement, "request", "headers", kElement})) {
+      if (header_name_.has_value() && header_value_.has_value()) {
+        entry_.headers.emplace_back(*header_name_, *header_value_);
+      }
+      header_name_.reset();
+      header_value_.reset();
+    } else if (at({"log", "entries", kElement})) {
+      importEntry();
+      entry_ = {};
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    path_.emplace_back(kElement);
+    return true;
+  }
+
+  bool end_array() override {
+    path_.pop_back();
+    return true;
+  }
+
+  bool parse_error(std::size_t position, const std::string&,
+                   const nlohmann::detail::exception& exception) override {
+    error_ = fmt::format("at byte {}: {}", position, exception.what());
+    return false;
+  }
+
+private:
+  static constexpr absl::string_view kElement = "[]";
+
+  struct Entry {
+    absl::optional<std::string> time;
+    absl::optional<std::string> method;
+    absl::optional<std::string> url;
+    std::vector<std::pair<std::string, std::string>> headers;
+    absl::optional<std::string> body;
+  };
+
+  bool at(std::initializer_list<absl::string_view> path) const {
+    return std::equal(path_.begin(), path_.end(), path.begin(), path.end());
+  }
+
+  void importEntry() {
+    const absl::optional<absl::Time> time =
+        entry_.time.has_value() ? parseTime(*entry_.time) : absl::nullopt;
+    if (!time.has_value() || !entry_.method.has_value() || !entry_.url.has_value() ||
+        !absl::StrContains(*entry_.url, "://")) {
+      skipped_++;
+      return;
+    }
+    absl::string_view authority;
+    absl::string_view path;
+    Envoy::Http::Utility::extractHostPathFromUri(*entry_.url, authority, path);
+    ImportedRequest request{*time,
+                            {{":method", *entry_.method},
+                             {":path", std::string(path)},
+                             {":authority", std::string(authority)}},
+                            std::move(entry_.body)};
+    for (const auto& header : entry_.headers) {
+      addHeader(request, header.first, header.second);
+    }
+    writer_.add(std::move(request));
+  }
+
+  ReorderingTraceWriter& writer_;
+  // Member names of the objects, and kElement for the arrays, enclosing the current value.
+  std::vector<std::string> path_;
+  Entry entry_;
+  absl::optional<std::string> header_name_;
+  absl::optional<std::string> header_value_;
+  uint64_t skipped_{0};
+  std::string error_;
+};
+
+} // namespace
+
+TraceImportMain::TraceImportMain(int argc, const char* const* argv, std::istream& input)
+    : input_(input) {
+  const char* descr = "L7 (HTTP/HTTPS/HTTP2) performance characterization tool that compiles "
+                      "access logs read from stdin into request traces.";
+  TCLAP::CmdLine cmd(descr, ' ', VersionInfo::version()); // NOLINT
+  std::vector<std::string> input_formats = {std::string(kEnvoyJsonFormat),
+                                            std::string(kHarFormat)};
+  TCLAP::ValuesConstraint<std::string> input_formats_allowed(input_formats);
+  TCLAP::ValueArg<std::string> input_format(
+      "", "input-format",
+      fmt::format("Input format. Possible values: {}. envoy-json expects one JSON object per line "
+                  "with the keys start_time, method, path, and optionally authority, user_agent "
+                  "and a request_headers object.",
+                  input_formats),
+      true, "", &input_formats_allowed, cmd);
+  TCLAP::ValueArg<std::string> output(
+      "", "output", "Path of the request trace file to write. Mandatory.", true, "", "string", cmd);
+  TCLAP::ValueArg<uint32_t> reorder_window(
+      "", "reorder-window",
+      "Number of access log entries that are buffered to sort requests by their start time. "
+      "Entries that start earlier than a request written before them get moved up to its time. "
+      "Default: 100000.",
+      false, 100000, "uint32_t", cmd);
+  Utility::parseCommand(cmd, argc, argv);
+  input_format_ = input_format.getValue();
+  output_path_ = output.getValue();
+  reorder_window_ = reorder_window.getValue();
+  if (reorder_window_ == 0) {
+    throw MalformedArgvException("--reorder-window must be greater than 0.");
+  }
+}
+
+uint32_t TraceImportMain::run() {
+  RequestTraceWriter trace_writer;
+  ReorderingTraceWriter writer(trace_writer, reorder_window_);
+  uint64_t skipped = 0;
+  if (input_format_ == kHarFormat) {
+    HarImporter importer(writer);
+    if (!nlohmann::json::sax_parse(input_, &importer)) {
+      std::cerr << "Input error: " << importer.error() << std::endl;
+      return 1;
+    }
+    skipped = importer.skipped();
+  } else {
+    skipped = importEnvoyJson(input_, writer);
+  }
+  writer.flush();
+  if (trace_writer.records() == 0) {
+    std::cerr << "Input error: no requests found" << std::endl;
+    return 1;
+  }
+  const absl::Status status = trace_writer.writeToFile(output_path_);
+  if (!status.ok()) {
+    std::cerr << status.message() << std::endl;
+    return 1;
+  }
+  std::cerr << fmt::format("Wrote {} requests to '{}'. Skipped {} malformed entries, moved up {} "
+                           "entries which arrived outside of the reorder window.",
+                           trace_writer.records(), output_path_, skipped, writer.clamped())
+            << std::endl;
+  return 0;
+}
+
+} // namespace Client
+} // namespace Nighthawk
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+#include "external/envoy/source/common/common/logger.h"
+
+namespace Nighthawk {
+namespace Client {
+
+/**
+ * Compiles the requests of an access log read from the input into a request trace file, which can
+ * be replayed with nighthawk.mapped-trace-request-source-plugin. The input is processed in a
+ * single pass with bounded memory, so that access logs of any size can be imported.
+ *
+ * Supported input formats:
+ * - envoy-json: Envoy access logs with one JSON object per line, as produced by a json_format
+ *   with the keys start_time (%START_TIME%), method (%REQ(:METHOD)%), path (%REQ(:PATH)%),
+ *   and optionally authority (%REQ(:AUTHORITY)%), user_agent (%REQ(USER-AGENT)%), and a
+ *   request_headers object mapping additional header names to values.
+ * - har: HTTP Archive files, importing the request method, url, headers and post data text of
+ *   each entry.
+ *
+ * Requests are written in order of their start time, with the times relative to the earliest
+ * request, so that replay can preserve the inter-arrival timing. Access logs are written when
+ * requests complete rather than when they start, so entries are reordered within a bounded
+ * window. Entries that arrive too late to be reordered are moved up to the time of the last
+ * request written before them.
+ */
+class TraceImportMain : public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
+public:
+  TraceImportMain(int argc, const char* const* argv, std::istream& input);
+  uint32_t run();
+
+private:
+  std::string input_format_;
+  std::string output_path_;
+  uint32_t reorder_window_;
+  std::istream& input_;
+};
+
+} // namespace Client
+} // namespace Nighthawk
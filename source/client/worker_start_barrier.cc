@@ -0,0 +1,62 @@
+#include "source/client/worker_start_barrier.h"
+
+#include "external/envoy/source/common/common/assert.h"
+#include "external/envoy/source/common/common/lock_guard.h"
+
+namespace Nighthawk {
+namespace Client {
+
+WorkerStartBarrier::WorkerStartBarrier(Envoy::TimeSource& time_source, const uint32_t workers,
+                                       const std::chrono::nanoseconds inter_worker_delay,
+                                       const absl::optional<Envoy::MonotonicTime> scheduled_start)
+    : time_source_(time_source), workers_(workers), inter_worker_delay_(inter_worker_delay),
+      start_time_(scheduled_start) {}
+
+Envoy::MonotonicTime WorkerStartBarrier::arriveAndWait(const uint32_t worker_number) {
+  const Envoy::MonotonicTime now = time_source_.monotonicTime();
+  Envoy::Thread::LockGuard guard(lock_);
+  if (!first_arrival_time_.has_value()) {
+    first_arrival_time_ = now;
+  }
+  arrived_++;
+  if (arrived_ == workers_) {
+    last_arrival_time_ = now;
+    if (!start_time_.has_value()) {
+      start_time_ = now + kStartMargin;
+    }
+    all_arrived_.notifyAll();
+  } else if (!start_time_.has_value()) {
+    while (arrived_ < workers_) {
+      all_arrived_.wait(lock_);
+    }
+  }
+  return start_time_.value() + inter_worker_delay_ * worker_number;
+}
+
+void WorkerStartBarrier::reset(const std::chrono::nanoseconds inter_worker_delay) {
+  Envoy::Thread::LockGuard guard(lock_);
+  ASSERT(arrived_ == 0 || arrived_ == workers_);
+  inter_worker_delay_ = inter_worker_delay;
+  arrived_ = 0;
+  first_arrival_time_ = absl::nullopt;
+  last_arrival_time_ = absl::nullopt;
+  start_time_ = absl::nullopt;
+}
+
+absl::optional<Envoy::MonotonicTime> WorkerStartBarrier::firstArrivalTime() const {
+  Envoy::Thread::LockGuard guard(lock_);
+  return first_arrival_time_;
+}
+
+absl::optional<Envoy::MonotonicTime> WorkerStartBarrier::lastArrivalTime() const {
+  Envoy::Thread::LockGuard guard(lock_);
+  return last_arrival_time_;
+}
+
+absl::optional<Envoy::MonotonicTime> WorkerStartBarrier::startTime() const {
+  Envoy::Thread::LockGuard guard(lock_);
+  return start_time_;
+}
+
+} // namespace Client
+} // namespace Nighthawk
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/common/time.h"
+
+#include "external/envoy/source/common/common/thread.h"
+
+#include "absl/types/optional.h"
+
+namespace Nighthawk {
+namespace Client {
+
+/**
+ * Coordinates the moment at which workers start generating load. Workers perform their
+ * initialization in parallel on their own threads, and then arrive at the barrier. Once the last
+ * worker has arrived, all of them are released with a common start time that lies a small margin
+ * in the future, which gives every worker the opportunity to get into its sequencer loop. Workers
+ * start at that time plus their offset as derived from the inter-worker delay.
+ *
+ * When a scheduled start is specified, workers do not wait for each other, and start at the
+ * scheduled time instead.
+ *
+ * Thread safe.
+ */
+class WorkerStartBarrier {
+public:
+  /**
+   * Margin between the moment the last worker became ready and the common start time.
+   */
+  static constexpr std::chrono::milliseconds kStartMargin{10};
+
+  /**
+   * @param time_source used to determine when workers become ready. Must be thread safe.
+   * @param workers the number of workers that will arrive at the barrier.
+   * @param inter_worker_delay offset between the start times of consecutive workers.
+   * @param scheduled_start optional scheduled start. When set, workers start at the scheduled time
+   * instead of once all of them are ready.
+   */
+  WorkerStartBarrier(Envoy::TimeSource& time_source, const uint32_t workers,
+                     const std::chrono::nanoseconds inter_worker_delay,
+                     const absl::optional<Envoy::MonotonicTime> scheduled_start);
+
+  /**
+   * Marks the calling worker as ready, and blocks until all workers are.
+   *
+   * @param worker_number number of the calling worker.
+   * @return Envoy::MonotonicTime the time at which the calling worker should start.
+   */
+  Envoy::MonotonicTime arriveAndWait(const uint32_t worker_number);
+
+  /**
+   * Prepares the barrier for the workers to arrive once more, for an execution on warm workers.
+   * Must not be called while workers are waiting at the barrier. Any scheduled start is dropped.
+   * @param inter_worker_delay offset between the start times of consecutive workers in the next
+   * execution, which may pace requests differently.
+   */
+  void reset(const std::chrono::nanoseconds inter_worker_delay);
+
+  /**
+   * @return absl::optional<Envoy::MonotonicTime> the time at which the first worker arrived, if
+   * any arrived yet.
+   */
+  absl::optional<Envoy::MonotonicTime> firstArrivalTime() const;
+
+  /**
+   * @return absl::optional<Envoy::MonotonicTime> the time at which the last worker arrived, if all
+   * of them arrived.
+   */
+  absl::optional<Envoy::MonotonicTime> lastArrivalTime() const;
+
+  /**
+   * @return absl::optional<Envoy::MonotonicTime> the time at which the first worker starts, once
+   * known.
+   */
+  absl::optional<Envoy::MonotonicTime> startTime() const;
+
+private:
+  Envoy::TimeSource& time_source_;
+  const uint32_t workers_;
+  mutable Envoy::Thread::MutexBasicLockable lock_;
+  std::chrono::nanoseconds inter_worker_delay_ ABSL_GUARDED_BY(lock_);
+  Envoy::Thread::CondVar all_arrived_;
+  uint32_t arrived_ ABSL_GUARDED_BY(lock_){0};
+  absl::optional<Envoy::MonotonicTime> first_arrival_time_ ABSL_GUARDED_BY(lock_);
+  absl::optional<Envoy::MonotonicTime> last_arrival_time_ ABSL_GUARDED_BY(lock_);
+  absl::optional<Envoy::MonotonicTime> start_time_ ABSL_GUARDED_BY(lock_);
+};
+
+} // namespace Client
+} // namespace Nighthawk
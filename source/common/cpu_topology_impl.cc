@@ -0,0 +1,180 @@
+#include "source/common/cpu_topology_impl.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "fmt/format.h"
+
+namespace Nighthawk {
+
+namespace {
+
+// Upper bound on the node numbers probed in sysfs. Node numbers may be sparse.
+constexpr uint32_t kMaxNumaNodes = 1024;
+// Upper bound on cpu numbers we accept, mostly to reject typos like "0-40000".
+constexpr uint32_t kMaxCpus = 8192;
+
+} // namespace
+
+CpuTopology CpuTopology::fromSystem(const std::string& sysfs_node_path) {
+  std::vector<NumaNode> nodes;
+  for (uint32_t id = 0; id < kMaxNumaNodes; id++) {
+    std::ifstream file(fmt::format("{}/node{}/cpulist", sysfs_node_path, id));
+    if (!file.is_open()) {
+      continue;
+    }
+    const std::string contents((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+    absl::StatusOr<CpuSet> cpus = parseCpuList(contents);
+    // Memory-only nodes have an empty cpu list.
+    if (cpus.ok()) {
+      nodes.push_back({id, *std::move(cpus)});
+    }
+  }
+  if (nodes.empty()) {
+    absl::StatusOr<CpuSet> cpus = currentThreadAffinity();
+    nodes.push_back({0, cpus.ok() ? *std::move(cpus) : CpuSet{}});
+  }
+  return CpuTopology(std::move(nodes));
+}
+
+absl::optional<uint32_t> CpuTopology::nodeOf(const CpuSet& cpus) const {
+  if (cpus.empty()) {
+    return absl::nullopt;
+  }
+  for (const NumaNode& node : nodes_) {
+    if (std::includes(node.cpus.begin(), node.cpus.end(), cpus.begin(), cpus.end())) {
+      return node.id;
+    }
+  }
+  return absl::nullopt;
+}
+
+std::vector<CpuSet> CpuTopology::compactLayout(const CpuSet& allowed_cpus,
+                                               const uint32_t workers) const {
+  // Order the allowed cpus by node, and put cpus we know no node for at the end.
+  CpuSet ordered;
+  for (const NumaNode& node : nodes_) {
+    std::set_intersection(node.cpus.begin(), node.cpus.end(), allowed_cpus.begin(),
+                          allowed_cpus.end(), std::back_inserter(ordered));
+  }
+  for (const uint32_t cpu : allowed_cpus) {
+    if (std::find(ordered.begin(), ordered.end(), cpu) == ordered.end()) {
+      ordered.push_back(cpu);
+    }
+  }
+  std::vector<CpuSet> layout;
+  if (ordered.empty()) {
+    return layout;
+  }
+  layout.reserve(workers);
+  for (uint32_t i = 0; i < workers; i++) {
+    layout.push_back({ordered[i % ordered.size()]});
+  }
+  return layout;
+}
+
+absl::StatusOr<CpuSet> CpuTopology::parseCpuList(absl::string_view cpu_list) {
+  CpuSet cpus;
+  for (absl::string_view range :
+       absl::StrSplit(absl::StripAsciiWhitespace(cpu_list), ',', absl::SkipWhitespace())) {
+    range = absl::StripAsciiWhitespace(range);
+    const std::vector<absl::string_view> bounds = absl::StrSplit(range, absl::MaxSplits('-', 1));
+    uint32_t first;
+    uint32_t last;
+    if (!absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.size() == 2 ? bounds[1] : bounds[0], &last) || first > last ||
+        last >= kMaxCpus) {
+      return absl::InvalidArgumentError(
+          fmt::format("Invalid range '{}' in cpu list '{}'", range, cpu_list));
+    }
+    for (uint32_t cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    return absl::InvalidArgumentError(fmt::format("Empty cpu list '{}'", cpu_list));
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+std::string CpuTopology::toCpuList(const CpuSet& cpus) {
+  std::vector<std::string> ranges;
+  for (size_t i = 0; i < cpus.size();) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+      j++;
+    }
+    ranges.push_back(i == j ? absl::StrCat(cpus[i]) : absl::StrCat(cpus[i], "-", cpus[j]));
+    i = j + 1;
+  }
+  return absl::StrJoin(ranges, ",");
+}
+
+#ifdef __linux__
+
+absl::StatusOr<CpuSet> CpuTopology::currentThreadAffinity() {
+  cpu_set_t* set = CPU_ALLOC(kMaxCpus);
+  const size_t size = CPU_ALLOC_SIZE(kMaxCpus);
+  CPU_ZERO_S(size, set);
+  const int rc = pthread_getaffinity_np(pthread_self(), size, set);
+  CpuSet cpus;
+  if (rc == 0) {
+    for (uint32_t cpu = 0; cpu < kMaxCpus; cpu++) {
+      if (CPU_ISSET_S(cpu, size, set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  CPU_FREE(set);
+  if (rc != 0) {
+    return absl::InternalError(fmt::format("pthread_getaffinity_np failed: {}", rc));
+  }
+  return cpus;
+}
+
+absl::Status CpuTopology::setCurrentThreadAffinity(const CpuSet& cpus) {
+  if (cpus.empty()) {
+    return absl::InvalidArgumentError("Cannot set an empty cpu affinity");
+  }
+  cpu_set_t* set = CPU_ALLOC(kMaxCpus);
+  const size_t size = CPU_ALLOC_SIZE(kMaxCpus);
+  CPU_ZERO_S(size, set);
+  for (const uint32_t cpu : cpus) {
+    CPU_SET_S(cpu, size, set);
+  }
+  const int rc = pthread_setaffinity_np(pthread_self(), size, set);
+  CPU_FREE(set);
+  if (rc != 0) {
+    return absl::InvalidArgumentError(fmt::format(
+        "pthread_setaffinity_np failed for cpus '{}': {}", toCpuList(cpus), rc));
+  }
+  return absl::OkStatus();
+}
+
+#else
+
+absl::StatusOr<CpuSet> CpuTopology::currentThreadAffinity() {
+  return absl::UnimplementedError("Thread affinity is not supported on this platform");
+}
+
+absl::Status CpuTopology::setCurrentThreadAffinity(const CpuSet&) {
+  return absl::UnimplementedError("Thread affinity is not supported on this platform");
+}
+
+#endif
+
+} // namespace Nighthawk
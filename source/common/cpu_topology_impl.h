@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Nighthawk {
+
+using CpuSet = std::vector<uint32_t>;
+
+/**
+ * Describes the NUMA nodes of the host and the cpus that belong to each of them, and offers
+ * helpers for placing worker threads onto cpus.
+ */
+class CpuTopology {
+public:
+  struct NumaNode {
+    uint32_t id;
+    CpuSet cpus;
+  };
+
+  CpuTopology(std::vector<NumaNode> nodes) : nodes_(std::move(nodes)) {}
+
+  /**
+   * Discovers the topology of the host by reading sysfs. When the node information is not
+   * available, a single node holding the cpus the process may run on is assumed.
+   * @param sysfs_node_path directory holding the node<N>/cpulist entries.
+   * @return CpuTopology the discovered topology.
+   */
+  static CpuTopology fromSystem(const std::string& sysfs_node_path = "/sys/devices/system/node");
+
+  /**
+   * @return const std::vector<NumaNode>& the nodes, ordered by id.
+   */
+  const std::vector<NumaNode>& nodes() const { return nodes_; }
+
+  /**
+   * @param cpus cpu set.
+   * @return absl::optional<uint32_t> the id of the node holding all of the cpus, or absl::nullopt
+   * when the cpus span multiple nodes or are unknown.
+   */
+  absl::optional<uint32_t> nodeOf(const CpuSet& cpus) const;
+
+  /**
+   * Computes a compact layout: each worker gets a single cpu, and nodes are filled up one after
+   * the other so that workers share as few nodes as possible. When there are more workers than
+   * cpus, cpus are handed out again from the start.
+   * @param allowed_cpus cpus that may be used.
+   * @param workers number of workers to place.
+   * @return std::vector<CpuSet> the cpu set for each worker.
+   */
+  std::vector<CpuSet> compactLayout(const CpuSet& allowed_cpus, uint32_t workers) const;
+
+  /**
+   * Parses a cpu list in the format used by the Linux kernel, for example "0-3,8,10-11".
+   * @param cpu_list the cpu list.
+   * @return absl::StatusOr<CpuSet> the sorted, de-duplicated cpus, or an error when the list is
+   * malformed or empty.
+   */
+  static absl::StatusOr<CpuSet> parseCpuList(absl::string_view cpu_list);
+
+  /**
+   * @param cpus cpu set.
+   * @return std::string the cpus formatted as a cpu list, e.g. "0-3,8".
+   */
+  static std::string toCpuList(const CpuSet& cpus);
+
+  /**
+   * @return absl::StatusOr<CpuSet> the cpus the calling thread may run on.
+   */
+  static absl::StatusOr<CpuSet> currentThreadAffinity();
+
+  /**
+   * Restricts the calling thread to the given cpus.
+   * @param cpus cpu set, must not be empty.
+   * @return absl::Status indicating success or failure. Fails with kUnimplemented on platforms
+   * that do not support thread affinity.
+   */
+  static absl::Status setCurrentThreadAffinity(const CpuSet& cpus);
+
+private:
+  std::vector<NumaNode> nodes_;
+};
+
+} // namespace Nighthawk
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "external/envoy/source/common/common/non_copyable.h"
+
+namespace Nighthawk {
+
+/**
+ * Bounded lock-free queue with any number of producers and consumers, based on Dmitry Vyukov's
+ * bounded MPMC queue. Each slot carries a sequence number which tells producers and consumers
+ * whether it is theirs to fill or drain, so that pushing and popping take a single compare and
+ * swap in the uncontended case. Values are popped in the order in which they were pushed.
+ */
+template <class T> class MpmcRing : public Envoy::NonCopyable {
+public:
+  /**
+   * @param capacity the number of values the ring can hold. Rounded up to a power of two, and to
+   * at least two.
+   */
+  explicit MpmcRing(const size_t capacity)
+      : mask_(roundUpToPowerOfTwo(capacity) - 1), slots_(new Slot[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Thread safe.
+   * @param value the value to push. Only moved from when it was pushed.
+   * @return bool false when the ring is full.
+   */
+  bool tryPush(T&& value) {
+    size_t position = push_position_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots_[position & mask_];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+      if (difference == 0) {
+        if (push_position_.compare_exchange_weak(position, position + 1,
+                                                 std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The slot still holds the value pushed one lap ago.
+        return false;
+      } else {
+        position = push_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Thread safe.
+   * @param value receives the oldest value in the ring.
+   * @return bool false when the ring is empty.
+   */
+  bool tryPop(T& value) {
+    size_t position = pop_position_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots_[position & mask_];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const int64_t difference =
+          static_cast<int64_t>(sequence) - static_cast<int64_t>(position + 1);
+      if (difference == 0) {
+        if (pop_position_.compare_exchange_weak(position, position + 1,
+                                                std::memory_order_relaxed)) {
+          value = std::move(slot.value);
+          slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The slot has not been filled yet.
+        return false;
+      } else {
+        position = pop_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @return size_t the number of values in the ring. Only approximate while values are being
+   * pushed or popped concurrently.
+   */
+  size_t size() const {
+    const size_t popped = pop_position_.load(std::memory_order_relaxed);
+    const size_t pushed = push_position_.load(std::memory_order_relaxed);
+    return pushed > popped ? std::min(pushed - popped, capacity()) : 0;
+  }
+
+  /**
+   * @return size_t the number of values the ring can hold.
+   */
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  static size_t roundUpToPowerOfTwo(const size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    return rounded;
+  }
+
+  const size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  // Producers and consumers each contend on their own cache line.
+  alignas(64) std::atomic<size_t> push_position_{0};
+  alignas(64) std::atomic<size_t> pop_position_{0};
+};
+
+} // namespace Nighthawk
@@ -24,10 +24,17 @@ NighthawkServiceClientImpl::PerformNighthawkBenchmark(
   }
 
   bool got_response = false;
-  while (stream->Read(&response)) {
+  nighthawk::client::ExecutionResponse received;
+  while (stream->Read(&received)) {
+    // Intermediate responses get streamed when a report interval is configured. Only the final
+    // response is of interest here.
+    if (received.intermediate()) {
+      continue;
+    }
     RELEASE_ASSERT(!got_response,
                    "Nighthawk Service has started responding with more than one message.");
     got_response = true;
+    response = std::move(received);
   }
   if (!got_response) {
     return absl::InternalError("Nighthawk Service did not send a gRPC response.");
@@ -52,6 +52,78 @@ void BurstingRateLimiter::releaseOne() {
   previously_releasing_ = absl::nullopt;
 }
 
+RecordingRateLimiterImpl::RecordingRateLimiterImpl(RateLimiterPtr&& rate_limiter,
+                                                   ReleaseScheduleSharedPtr schedule,
+                                                   const uint32_t worker_id)
+    : ForwardingRateLimiterImpl(std::move(rate_limiter)), schedule_(std::move(schedule)),
+      worker_id_(worker_id) {
+  ASSERT(schedule_ != nullptr && worker_id_ < schedule_->workers());
+}
+
+bool RecordingRateLimiterImpl::tryAcquireOne() {
+  if (rate_limiter_->tryAcquireOne()) {
+    schedule_->record(worker_id_, rate_limiter_->elapsed());
+    return true;
+  }
+  return false;
+}
+
+void RecordingRateLimiterImpl::releaseOne() {
+  schedule_->unrecordLast(worker_id_);
+  rate_limiter_->releaseOne();
+}
+
+ReplayRateLimiterImpl::ReplayRateLimiterImpl(Envoy::TimeSource& time_source,
+                                             ReleaseScheduleSharedPtr schedule,
+                                             const uint32_t worker_id)
+    : RateLimiterBaseImpl(time_source), schedule_(std::move(schedule)),
+      offsets_(schedule_->offsets(worker_id)) {}
+
+bool ReplayRateLimiterImpl::tryAcquireOne() {
+  if (next_ < offsets_.size() && elapsed() >= offsets_[next_]) {
+    next_++;
+    return true;
+  }
+  return false;
+}
+
+void ReplayRateLimiterImpl::releaseOne() {
+  ASSERT(next_ > 0);
+  next_--;
+}
+
+ReleaseTimingRateLimiterImpl::ReleaseTimingRateLimiterImpl(Envoy::TimeSource& time_source,
+                                                           RequestReleaseTiming& timing,
+                                                           StatisticPtr&& deviation_statistic)
+    : RateLimiterBaseImpl(time_source), timing_(timing),
+      deviation_statistic_(std::move(deviation_statistic)) {
+  deviation_statistic_->setId("sequencer.schedule_deviation");
+}
+
+bool ReleaseTimingRateLimiterImpl::tryAcquireOne() {
+  const absl::optional<std::chrono::nanoseconds> offset = timing_.nextReleaseOffset();
+  if (!offset.has_value()) {
+    return false;
+  }
+  const std::chrono::nanoseconds elapsed_time = elapsed();
+  if (elapsed_time < offset.value()) {
+    return false;
+  }
+  if (!retrying_) {
+    deviation_statistic_->addValue((elapsed_time - offset.value()).count());
+  }
+  retrying_ = false;
+  return true;
+}
+
+void ReleaseTimingRateLimiterImpl::releaseOne() { retrying_ = true; }
+
+StatisticPtrMap ReleaseTimingRateLimiterImpl::statistics() const {
+  StatisticPtrMap statistics;
+  statistics[deviation_statistic_->id()] = deviation_statistic_.get();
+  return statistics;
+}
+
 ScheduledStartingRateLimiter::ScheduledStartingRateLimiter(
     RateLimiterPtr&& rate_limiter, const Envoy::MonotonicTime scheduled_starting_time)
     : ForwardingRateLimiterImpl(std::move(rate_limiter)),
@@ -112,6 +184,116 @@ void LinearRateLimiter::releaseOne() {
   acquired_count_--;
 }
 
+SharedRateLimiterState::SharedRateLimiterState(const Frequency frequency)
+    : frequency_(frequency) {
+  if (frequency.value() <= 0) {
+    throw NighthawkException(fmt::format("frequency must be > 0, value: {}", frequency.value()));
+  }
+}
+
+bool SharedRateLimiterState::tryAcquireOne(const Envoy::MonotonicTime now) {
+  const int64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+  int64_t start_time_ns = start_time_ns_.load(std::memory_order_acquire);
+  if (start_time_ns == kNotStarted) {
+    // The first participant to get here sets the starting time. When we lose the race,
+    // compare_exchange_strong() loads the starting time that the winner set.
+    if (start_time_ns_.compare_exchange_strong(start_time_ns, now_ns)) {
+      start_time_ns = now_ns;
+    }
+  }
+  // Apply the same half-interval phase shift as LinearRateLimiter does.
+  const double elapsed_seconds = std::max<int64_t>(now_ns - start_time_ns, 0) / 1e9;
+  const double total_frequency =
+      frequency_.value() * participants_.load(std::memory_order_relaxed);
+  const uint64_t allowed =
+      static_cast<uint64_t>(std::floor(elapsed_seconds * total_frequency + 0.5));
+  uint64_t acquired = acquired_count_.load(std::memory_order_relaxed);
+  while (acquired < allowed) {
+    if (acquired_count_.compare_exchange_weak(acquired, acquired + 1,
+                                              std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+SharedLinearRateLimiterImpl::SharedLinearRateLimiterImpl(
+    Envoy::TimeSource& time_source, SharedRateLimiterStateSharedPtr shared_state)
+    : RateLimiterBaseImpl(time_source), shared_state_(std::move(shared_state)) {
+  ASSERT(shared_state_ != nullptr);
+}
+
+bool SharedLinearRateLimiterImpl::tryAcquireOne() {
+  // Calling elapsed() tracks the time of the first acquisition attempt of this worker.
+  elapsed();
+  return shared_state_->tryAcquireOne(timeSource().monotonicTime());
+}
+
+VirtualUserSchedule::VirtualUserSchedule(Envoy::TimeSource& time_source,
+                                         const uint32_t virtual_users,
+                                         const std::chrono::nanoseconds think_time,
+                                         const ThinkTimeDistribution think_time_distribution,
+                                         const uint64_t seed)
+    : time_source_(time_source), think_time_(think_time),
+      think_time_distribution_(think_time_distribution), generator_(seed),
+      ready_users_(virtual_users) {
+  if (virtual_users == 0) {
+    throw NighthawkException("virtual_users must be > 0");
+  }
+  if (think_time < 0ns) {
+    throw NighthawkException(
+        fmt::format("think_time must not be negative, value: {}", think_time.count()));
+  }
+}
+
+bool VirtualUserSchedule::tryClaimReadyUser() {
+  if (ready_users_ == 0 && !thinking_users_.empty()) {
+    const Envoy::MonotonicTime now = time_source_.monotonicTime();
+    // Move all virtual users that are done thinking over to the ready set.
+    while (!thinking_users_.empty() && thinking_users_.top() <= now) {
+      thinking_users_.pop();
+      ready_users_++;
+    }
+  }
+  if (ready_users_ == 0) {
+    return false;
+  }
+  ready_users_--;
+  return true;
+}
+
+void VirtualUserSchedule::returnUser() { ready_users_++; }
+
+void VirtualUserSchedule::completeUser() {
+  const std::chrono::nanoseconds think_time = sampleThinkTime();
+  if (think_time == 0ns) {
+    ready_users_++;
+  } else {
+    thinking_users_.push(time_source_.monotonicTime() + think_time);
+  }
+}
+
+std::chrono::nanoseconds VirtualUserSchedule::sampleThinkTime() {
+  if (think_time_distribution_ == ThinkTimeDistribution::CONSTANT || think_time_ == 0ns) {
+    return think_time_;
+  }
+  return std::chrono::nanoseconds(
+      static_cast<int64_t>(exponential_distribution_(generator_) * think_time_.count()));
+}
+
+ClosedLoopRateLimiterImpl::ClosedLoopRateLimiterImpl(Envoy::TimeSource& time_source,
+                                                     VirtualUserScheduleSharedPtr schedule)
+    : RateLimiterBaseImpl(time_source), schedule_(std::move(schedule)) {
+  ASSERT(schedule_ != nullptr);
+}
+
+bool ClosedLoopRateLimiterImpl::tryAcquireOne() {
+  // Calling elapsed() tracks the time of the first acquisition attempt.
+  elapsed();
+  return schedule_->tryClaimReadyUser();
+}
+
 LinearRampingRateLimiterImpl::LinearRampingRateLimiterImpl(Envoy::TimeSource& time_source,
                                                            const std::chrono::nanoseconds ramp_time,
                                                            const Frequency frequency)
@@ -150,6 +332,102 @@ void LinearRampingRateLimiterImpl::releaseOne() {
   acquired_count_--;
 }
 
+bool ShapedRateLimiterBaseImpl::tryAcquireOne() {
+  if (acquireable_count_ > 0) {
+    acquireable_count_--;
+    acquired_count_++;
+    return true;
+  }
+  // Like LinearRateLimiter, we shift phase by half an interval so that acquisitions won't line up
+  // with whole seconds when pacing at a constant frequency.
+  acquireable_count_ =
+      static_cast<int64_t>(std::floor(expectedAcquisitions(elapsed()) + 0.5)) - acquired_count_;
+  return acquireable_count_ > 0 ? tryAcquireOne() : false;
+}
+
+void ShapedRateLimiterBaseImpl::releaseOne() {
+  acquireable_count_++;
+  acquired_count_--;
+}
+
+PiecewiseLinearRateLimiterImpl::PiecewiseLinearRateLimiterImpl(Envoy::TimeSource& time_source,
+                                                               std::vector<RateCurvePoint> points)
+    : ShapedRateLimiterBaseImpl(time_source), points_(std::move(points)) {
+  if (points_.empty()) {
+    throw NighthawkException("at least one point is required");
+  }
+  if (points_[0].offset < 0ns) {
+    throw NighthawkException(
+        fmt::format("offsets must be non-negative, value: {}", points_[0].offset.count()));
+  }
+  cumulative_.reserve(points_.size());
+  // The frequency of the first point applies up to its offset.
+  cumulative_.push_back(points_[0].frequency * (points_[0].offset.count() / 1e9));
+  for (size_t i = 0; i < points_.size(); i++) {
+    if (points_[i].frequency < 0) {
+      throw NighthawkException(
+          fmt::format("frequency must be >= 0, value: {}", points_[i].frequency));
+    }
+    if (i > 0) {
+      if (points_[i].offset <= points_[i - 1].offset) {
+        throw NighthawkException("offsets must be strictly increasing");
+      }
+      const double segment_seconds = (points_[i].offset - points_[i - 1].offset).count() / 1e9;
+      cumulative_.push_back(cumulative_[i - 1] +
+                            segment_seconds * (points_[i - 1].frequency + points_[i].frequency) /
+                                2.0);
+    }
+  }
+}
+
+double
+PiecewiseLinearRateLimiterImpl::expectedAcquisitions(const std::chrono::nanoseconds elapsed_time) {
+  if (elapsed_time < points_[0].offset) {
+    return points_[0].frequency * (elapsed_time.count() / 1e9);
+  }
+  // Elapsed time never decreases, so we can resume scanning from where we left off.
+  while (current_point_ + 1 < points_.size() &&
+         points_[current_point_ + 1].offset <= elapsed_time) {
+    current_point_++;
+  }
+  const RateCurvePoint& from = points_[current_point_];
+  const double seconds_into_segment = (elapsed_time - from.offset).count() / 1e9;
+  if (current_point_ + 1 == points_.size()) {
+    return cumulative_[current_point_] + seconds_into_segment * from.frequency;
+  }
+  const RateCurvePoint& to = points_[current_point_ + 1];
+  const double slope = (to.frequency - from.frequency) / ((to.offset - from.offset).count() / 1e9);
+  const double current_frequency = from.frequency + slope * seconds_into_segment;
+  // Trapezoid between the starting point of the segment and the current point in time.
+  return cumulative_[current_point_] +
+         seconds_into_segment * (from.frequency + current_frequency) / 2.0;
+}
+
+SineRateLimiterImpl::SineRateLimiterImpl(Envoy::TimeSource& time_source, const Frequency base,
+                                         const double amplitude,
+                                         const std::chrono::nanoseconds period)
+    : ShapedRateLimiterBaseImpl(time_source), base_(base), amplitude_(amplitude), period_(period) {
+  if (base_.value() <= 0) {
+    throw NighthawkException(fmt::format("frequency must be > 0, value: {}", base_.value()));
+  }
+  if (amplitude_ < 0 || amplitude_ > base_.value()) {
+    throw NighthawkException(fmt::format(
+        "amplitude must be >= 0 and <= the base frequency, value: {}", amplitude_));
+  }
+  if (period_ <= 0ns) {
+    throw NighthawkException(fmt::format("period must be positive, value: {}", period_.count()));
+  }
+}
+
+double SineRateLimiterImpl::expectedAcquisitions(const std::chrono::nanoseconds elapsed_time) {
+  const double two_pi = 2.0 * M_PI;
+  const double seconds = elapsed_time.count() / 1e9;
+  const double period_seconds = period_.count() / 1e9;
+  // Integral of base + amplitude * sin(2*pi*t/period) over [0, seconds].
+  return base_.value() * seconds +
+         amplitude_ * period_seconds / two_pi * (1.0 - std::cos(two_pi * seconds / period_seconds));
+}
+
 DelegatingRateLimiterImpl::DelegatingRateLimiterImpl(
     RateLimiterPtr&& rate_limiter, RateLimiterDelegate random_distribution_generator)
     : ForwardingRateLimiterImpl(std::move(rate_limiter)),
@@ -1,15 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <limits>
 #include <list>
+#include <queue>
 #include <random>
+#include <vector>
 
 #include "envoy/common/time.h"
 
 #include "nighthawk/common/rate_limiter.h"
+#include "nighthawk/common/request_source.h"
 
 #include "external/envoy/source/common/common/logger.h"
 
 #include "source/common/frequency.h"
+#include "source/common/release_schedule_impl.h"
 
 #include "absl/random/random.h"
 #include "absl/random/zipf_distribution.h"
@@ -64,6 +70,148 @@ protected:
   const Frequency frequency_;
 };
 
+/**
+ * Budget of acquisitions shared by multiple rate limiters, which may live on different threads.
+ * The budget grows linearly at the sum of the frequencies of the participants, starting at the
+ * first acquisition attempt made by any of them. Participants draw from it on a first-come
+ * first-served basis, which means that when one of them lags behind, the others will pick up the
+ * acquisitions it could not make in time.
+ */
+class SharedRateLimiterState {
+public:
+  /**
+   * @param frequency the frequency each participant contributes to the shared budget.
+   */
+  SharedRateLimiterState(const Frequency frequency);
+
+  /**
+   * Sets the number of participants, each of which adds the per-participant frequency to the
+   * shared budget. Must be called before any participant attempts to acquire.
+   * @param participants the number of participants.
+   */
+  void setParticipants(const uint32_t participants) { participants_ = participants; }
+
+  /**
+   * Thread safe.
+   * @param now the current monotonic time.
+   * @return true if an acquisition could be made from the shared budget.
+   */
+  bool tryAcquireOne(const Envoy::MonotonicTime now);
+
+  /**
+   * Thread safe. Returns an acquisition to the shared budget.
+   */
+  void releaseOne() { acquired_count_--; }
+
+private:
+  static constexpr int64_t kNotStarted = std::numeric_limits<int64_t>::min();
+  const Frequency frequency_;
+  std::atomic<uint32_t> participants_{0};
+  // Monotonic time of the first acquisition attempt, in nanoseconds since the epoch.
+  std::atomic<int64_t> start_time_ns_{kNotStarted};
+  std::atomic<uint64_t> acquired_count_{0};
+};
+
+using SharedRateLimiterStateSharedPtr = std::shared_ptr<SharedRateLimiterState>;
+
+/**
+ * Rate limiter which draws acquisitions from a budget shared with rate limiters associated to
+ * other workers. See SharedRateLimiterState.
+ */
+class SharedLinearRateLimiterImpl : public RateLimiterBaseImpl {
+public:
+  /**
+   * @param time_source time source used to compute elapsed time.
+   * @param shared_state the shared budget, with its participants already set.
+   */
+  SharedLinearRateLimiterImpl(Envoy::TimeSource& time_source,
+                              SharedRateLimiterStateSharedPtr shared_state);
+  bool tryAcquireOne() override;
+  void releaseOne() override { shared_state_->releaseOne(); }
+
+private:
+  const SharedRateLimiterStateSharedPtr shared_state_;
+};
+
+/**
+ * Tracks a fixed population of virtual users for closed-loop execution. Each virtual user issues a
+ * request, waits for it to complete, and then thinks for a while before it is ready to issue its
+ * next request. Instead of arming a timer per virtual user, the points in time at which thinking
+ * users become ready are kept in a min-heap, which gets polled by whoever drives acquisitions
+ * (normally the sequencer, on its own timer). This keeps the overhead per virtual user at a
+ * single heap entry, which allows for large populations.
+ */
+class VirtualUserSchedule {
+public:
+  enum class ThinkTimeDistribution { CONSTANT, EXPONENTIAL };
+
+  /**
+   * @param time_source time source used to determine when thinking users become ready.
+   * @param virtual_users size of the population, must be > 0. All virtual users start out ready.
+   * @param think_time the think time, or the mean think time when the distribution is
+   * exponential. Must not be negative.
+   * @param think_time_distribution distribution used to sample think times.
+   * @param seed seed for sampling think times.
+   */
+  VirtualUserSchedule(Envoy::TimeSource& time_source, const uint32_t virtual_users,
+                      const std::chrono::nanoseconds think_time,
+                      const ThinkTimeDistribution think_time_distribution,
+                      const uint64_t seed = std::mt19937_64::default_seed);
+
+  /**
+   * Claims a virtual user which is ready to issue a request, if any.
+   * @return true if a virtual user was claimed.
+   */
+  bool tryClaimReadyUser();
+
+  /**
+   * Returns a claimed virtual user that was not able to issue its request. It will be ready again
+   * right away.
+   */
+  void returnUser();
+
+  /**
+   * Indicates that the request of a claimed virtual user has completed. The user will be ready to
+   * issue its next request after a sampled think time.
+   */
+  void completeUser();
+
+  /**
+   * @return uint32_t the number of virtual users that are currently thinking.
+   */
+  uint32_t thinkingUsers() const { return thinking_users_.size(); }
+
+private:
+  std::chrono::nanoseconds sampleThinkTime();
+
+  Envoy::TimeSource& time_source_;
+  const std::chrono::nanoseconds think_time_;
+  const ThinkTimeDistribution think_time_distribution_;
+  std::mt19937_64 generator_;
+  std::exponential_distribution<double> exponential_distribution_;
+  uint32_t ready_users_;
+  std::priority_queue<Envoy::MonotonicTime, std::vector<Envoy::MonotonicTime>,
+                      std::greater<Envoy::MonotonicTime>>
+      thinking_users_;
+};
+
+using VirtualUserScheduleSharedPtr = std::shared_ptr<VirtualUserSchedule>;
+
+/**
+ * Rate limiter which allows an acquisition whenever a virtual user is ready to issue a request.
+ * Used for closed-loop execution, where the pace is determined by request completions and think
+ * times instead of by a frequency.
+ */
+class ClosedLoopRateLimiterImpl : public RateLimiterBaseImpl {
+public:
+  ClosedLoopRateLimiterImpl(Envoy::TimeSource& time_source, VirtualUserScheduleSharedPtr schedule);
+  bool tryAcquireOne() override;
+  void releaseOne() override { schedule_->returnUser(); }
+
+private:
+  const VirtualUserScheduleSharedPtr schedule_;
+};
+
 /**
  * A rate limiter which linearly ramps up to the desired frequency over the specified ramp_time.
  */
@@ -82,6 +230,92 @@ private:
   const Frequency frequency_;
 };
 
+/**
+ * Base class for rate limiters that pace according to a frequency which varies over time.
+ * Derivations supply the integral of their frequency over the elapsed time, which yields the
+ * number of acquisitions that should have been allowed up to that point.
+ */
+class ShapedRateLimiterBaseImpl : public RateLimiterBaseImpl,
+                                  public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
+public:
+  ShapedRateLimiterBaseImpl(Envoy::TimeSource& time_source) : RateLimiterBaseImpl(time_source) {}
+  bool tryAcquireOne() override;
+  void releaseOne() override;
+
+protected:
+  /**
+   * @param elapsed_time time elapsed since the first acquisition attempt. Successive calls will
+   * pass non-decreasing values.
+   * @return double the total number of acquisitions that should have been allowed by
+   * elapsed_time.
+   */
+  virtual double expectedAcquisitions(const std::chrono::nanoseconds elapsed_time) PURE;
+
+private:
+  int64_t acquireable_count_{0};
+  uint64_t acquired_count_{0};
+};
+
+/**
+ * A single point of a frequency curve.
+ */
+struct RateCurvePoint {
+  // Offset relative to the first acquisition attempt.
+  std::chrono::nanoseconds offset;
+  // Frequency at the offset, in Hz.
+  double frequency;
+};
+
+/**
+ * Rate limiter which follows a frequency curve, linearly interpolating between points. Before the
+ * first point the frequency of the first point applies, after the last point the frequency of
+ * the last point is held.
+ */
+class PiecewiseLinearRateLimiterImpl : public ShapedRateLimiterBaseImpl {
+public:
+  /**
+   * @param time_source time source used to compute elapsed time.
+   * @param points the curve. Must be non-empty, have strictly increasing non-negative offsets, and
+   * non-negative frequencies. Violating that results in a NighthawkException.
+   */
+  PiecewiseLinearRateLimiterImpl(Envoy::TimeSource& time_source,
+                                 std::vector<RateCurvePoint> points);
+
+protected:
+  double expectedAcquisitions(const std::chrono::nanoseconds elapsed_time) override;
+
+private:
+  const std::vector<RateCurvePoint> points_;
+  // Integral of the frequency up to the offset of the point at the same index.
+  std::vector<double> cumulative_;
+  // Index of the last point at or before the most recently observed elapsed time.
+  size_t current_point_{0};
+};
+
+/**
+ * Rate limiter which paces according to base + amplitude * sin(2 * pi * t / period).
+ */
+class SineRateLimiterImpl : public ShapedRateLimiterBaseImpl {
+public:
+  /**
+   * @param time_source time source used to compute elapsed time.
+   * @param base base frequency, must be > 0.
+   * @param amplitude amplitude in Hz. Must not exceed the base frequency, so that the resulting
+   * frequency never becomes negative.
+   * @param period the period of the oscillation, must be > 0.
+   */
+  SineRateLimiterImpl(Envoy::TimeSource& time_source, const Frequency base, const double amplitude,
+                      const std::chrono::nanoseconds period);
+
+protected:
+  double expectedAcquisitions(const std::chrono::nanoseconds elapsed_time) override;
+
+private:
+  const Frequency base_;
+  const double amplitude_;
+  const std::chrono::nanoseconds period_;
+};
+
 /**
  * Base for a rate limiter which wraps another rate limiter, and forwards
  * some calls.
@@ -95,11 +329,82 @@ public:
   absl::optional<Envoy::SystemTime> firstAcquisitionTime() const override {
     return rate_limiter_->firstAcquisitionTime();
   }
+  StatisticPtrMap statistics() const override { return rate_limiter_->statistics(); }
 
 protected:
   const RateLimiterPtr rate_limiter_;
 };
 
+/**
+ * Rate limiter which records the offsets of the acquisitions made via the wrapped rate limiter
+ * into a release schedule.
+ */
+class RecordingRateLimiterImpl : public ForwardingRateLimiterImpl {
+public:
+  /**
+   * @param rate_limiter the rate limiter to forward to.
+   * @param schedule the schedule to record to.
+   * @param worker_id the worker whose entry in the schedule should be recorded to. The worker
+   * must have been added to the schedule.
+   */
+  RecordingRateLimiterImpl(RateLimiterPtr&& rate_limiter, ReleaseScheduleSharedPtr schedule,
+                           const uint32_t worker_id);
+  bool tryAcquireOne() override;
+  void releaseOne() override;
+
+private:
+  const ReleaseScheduleSharedPtr schedule_;
+  const uint32_t worker_id_;
+};
+
+/**
+ * Rate limiter which replays the release offsets that were recorded for a worker, timed relative
+ * to the first acquisition attempt. Once all recorded releases have been replayed no further
+ * acquisitions are allowed.
+ */
+class ReplayRateLimiterImpl : public RateLimiterBaseImpl {
+public:
+  /**
+   * @param time_source time source used to compute elapsed time.
+   * @param schedule the schedule to replay.
+   * @param worker_id the worker whose releases should be replayed.
+   */
+  ReplayRateLimiterImpl(Envoy::TimeSource& time_source, ReleaseScheduleSharedPtr schedule,
+                        const uint32_t worker_id);
+  bool tryAcquireOne() override;
+  void releaseOne() override;
+
+private:
+  const ReleaseScheduleSharedPtr schedule_;
+  const std::vector<std::chrono::nanoseconds>& offsets_;
+  size_t next_{0};
+};
+
+/**
+ * Rate limiter which releases the requests of a request source at the offsets specified by its
+ * timing, timed relative to the first acquisition attempt. Tracks how late each release is
+ * compared to its offset in the "sequencer.schedule_deviation" statistic.
+ */
+class ReleaseTimingRateLimiterImpl : public RateLimiterBaseImpl {
+public:
+  /**
+   * @param time_source time source used to compute elapsed time.
+   * @param timing timing of the request source, which must outlive the rate limiter.
+   * @param deviation_statistic statistic that receives the lateness of the releases.
+   */
+  ReleaseTimingRateLimiterImpl(Envoy::TimeSource& time_source, RequestReleaseTiming& timing,
+                               StatisticPtr&& deviation_statistic);
+  bool tryAcquireOne() override;
+  void releaseOne() override;
+  StatisticPtrMap statistics() const override;
+
+private:
+  RequestReleaseTiming& timing_;
+  StatisticPtr deviation_statistic_;
+  // Set when the last release could not be used, so that its retry is not tracked again.
+  bool retrying_{false};
+};
+
 /**
  * BurstingRatelimiter can be wrapped around another rate limiter. It has two modes:
  * 1. First it will be accumulating acquisitions by forwarding calls to the wrapped
@@ -173,8 +478,9 @@ private:
 
 class UniformRandomDistributionSamplerImpl : public DiscreteNumericDistributionSampler {
 public:
-  UniformRandomDistributionSamplerImpl(const uint64_t upper_bound)
-      : distribution_(0, upper_bound) {}
+  UniformRandomDistributionSamplerImpl(
+      const uint64_t upper_bound, const uint64_t seed = std::default_random_engine::default_seed)
+      : generator_(seed), distribution_(0, upper_bound) {}
   uint64_t getValue() override { return distribution_(generator_); }
   uint64_t min() const override { return distribution_.min(); }
   uint64_t max() const override { return distribution_.max(); }
@@ -0,0 +1,174 @@
+#include "source/common/release_schedule_impl.h"
+
+#include <fstream>
+#include <iterator>
+
+#include "external/envoy/source/common/common/assert.h"
+
+#include "fmt/format.h"
+
+namespace Nighthawk {
+
+namespace {
+
+constexpr char kMagic[] = {'N', 'H', 'R', 'S'};
+constexpr uint32_t kVersion = 1;
+
+void writeVarint(std::string& buffer, uint64_t value) {
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+void writeFixed32(std::string& buffer, const uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+// Minimal cursor over the contents of a schedule file. Reads fail instead of running past the end.
+class Reader {
+public:
+  Reader(const std::string& data) : data_(data) {}
+
+  bool readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (position_ >= data_.size()) {
+        return false;
+      }
+      const uint8_t byte = static_cast<uint8_t>(data_[position_++]);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool readFixed32(uint32_t& value) {
+    if (data_.size() - position_ < 4) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+      value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[position_++])) << (8 * i);
+    }
+    return true;
+  }
+
+  bool readMagic() {
+    if (data_.size() - position_ < sizeof(kMagic) ||
+        data_.compare(position_, sizeof(kMagic), kMagic, sizeof(kMagic)) != 0) {
+      return false;
+    }
+    position_ += sizeof(kMagic);
+    return true;
+  }
+
+  bool atEnd() const { return position_ == data_.size(); }
+
+private:
+  const std::string& data_;
+  size_t position_{0};
+};
+
+} // namespace
+
+void ReleaseSchedule::addWorker(const uint32_t worker_id) {
+  if (worker_id >= offsets_.size()) {
+    offsets_.resize(worker_id + 1);
+  }
+}
+
+void ReleaseSchedule::record(const uint32_t worker_id, const std::chrono::nanoseconds offset) {
+  ASSERT(worker_id < offsets_.size());
+  std::vector<std::chrono::nanoseconds>& offsets = offsets_[worker_id];
+  ASSERT(offsets.empty() || offsets.back() <= offset);
+  offsets.push_back(offset);
+}
+
+void ReleaseSchedule::unrecordLast(const uint32_t worker_id) {
+  ASSERT(worker_id < offsets_.size() && !offsets_[worker_id].empty());
+  offsets_[worker_id].pop_back();
+}
+
+const std::vector<std::chrono::nanoseconds>&
+ReleaseSchedule::offsets(const uint32_t worker_id) const {
+  ASSERT(worker_id < offsets_.size());
+  return offsets_[worker_id];
+}
+
+absl::Status ReleaseSchedule::writeToFile(const std::string& path) const {
+  std::string buffer(kMagic, sizeof(kMagic));
+  writeFixed32(buffer, kVersion);
+  writeFixed32(buffer, offsets_.size());
+  for (const std::vector<std::chrono::nanoseconds>& offsets : offsets_) {
+    writeVarint(buffer, offsets.size());
+    std::chrono::nanoseconds previous = std::chrono::nanoseconds::zero();
+    for (const std::chrono::nanoseconds offset : offsets) {
+      writeVarint(buffer, (offset - previous).count());
+      previous = offset;
+    }
+  }
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return absl::InvalidArgumentError(
+        fmt::format("Unable to open '{}' for writing the release schedule", path));
+  }
+  file.write(buffer.data(), buffer.size());
+  file.close();
+  if (file.fail()) {
+    return absl::InternalError(fmt::format("Failed writing the release schedule to '{}'", path));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<ReleaseSchedule>>
+ReleaseSchedule::readFromFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return absl::InvalidArgumentError(
+        fmt::format("Unable to open release schedule file '{}'", path));
+  }
+  const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  Reader reader(data);
+  uint32_t version;
+  uint32_t workers;
+  if (!reader.readMagic() || !reader.readFixed32(version) || !reader.readFixed32(workers)) {
+    return absl::InvalidArgumentError(
+        fmt::format("'{}' is not a release schedule file", path));
+  }
+  if (version != kVersion) {
+    return absl::InvalidArgumentError(
+        fmt::format("Unsupported release schedule file version {} in '{}'", version, path));
+  }
+  auto schedule = std::make_unique<ReleaseSchedule>();
+  for (uint32_t worker_id = 0; worker_id < workers; worker_id++) {
+    schedule->addWorker(worker_id);
+    uint64_t count;
+    if (!reader.readVarint(count)) {
+      return absl::InvalidArgumentError(fmt::format("Truncated release schedule file '{}'", path));
+    }
+    std::vector<std::chrono::nanoseconds>& offsets = schedule->offsets_[worker_id];
+    std::chrono::nanoseconds offset = std::chrono::nanoseconds::zero();
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t delta;
+      if (!reader.readVarint(delta)) {
+        return absl::InvalidArgumentError(
+            fmt::format("Truncated release schedule file '{}'", path));
+      }
+      offset += std::chrono::nanoseconds(delta);
+      offsets.push_back(offset);
+    }
+  }
+  if (!reader.atEnd()) {
+    return absl::InvalidArgumentError(
+        fmt::format("Unexpected trailing data in release schedule file '{}'", path));
+  }
+  return schedule;
+}
+
+} // namespace Nighthawk
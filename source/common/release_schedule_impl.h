@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+
+namespace Nighthawk {
+
+/**
+ * Holds the points in time at which requests were released, per worker. Each point in time is an
+ * offset relative to the first acquisition attempt of the worker's rate limiter. Used to record the
+ * release schedule of an execution, so that a later execution can replay it exactly.
+ *
+ * Workers must be added from a single thread before execution starts. After that, each worker may
+ * concurrently record to, or read from, its own entry.
+ *
+ * The file format is compact: a header consisting of a magic value, a version and the number of
+ * workers, followed by a section per worker. Each section holds the number of releases, followed by
+ * the deltas between consecutive offsets encoded as unsigned LEB128 varints. At high rates most
+ * deltas fit in two or three bytes.
+ */
+class ReleaseSchedule {
+public:
+  /**
+   * Makes sure an entry exists for the worker. Not thread safe: must be called before any worker
+   * records to, or reads from, the schedule.
+   * @param worker_id worker number.
+   */
+  void addWorker(const uint32_t worker_id);
+
+  /**
+   * Records a release. Offsets recorded for a worker must be non-decreasing.
+   * @param worker_id worker number, which must have been added before.
+   * @param offset offset of the release.
+   */
+  void record(const uint32_t worker_id, const std::chrono::nanoseconds offset);
+
+  /**
+   * Forgets the last release recorded for the worker, for when the release could not be used.
+   * @param worker_id worker number, which must have been added before.
+   */
+  void unrecordLast(const uint32_t worker_id);
+
+  /**
+   * @param worker_id worker number, which must have been added before.
+   * @return const std::vector<std::chrono::nanoseconds>& the offsets of the releases of the worker.
+   */
+  const std::vector<std::chrono::nanoseconds>& offsets(const uint32_t worker_id) const;
+
+  /**
+   * @return uint32_t the number of workers.
+   */
+  uint32_t workers() const { return offsets_.size(); }
+
+  /**
+   * Writes the schedule to a file.
+   * @param path path of the file.
+   * @return absl::Status indicating success or failure.
+   */
+  absl::Status writeToFile(const std::string& path) const;
+
+  /**
+   * Reads a schedule from a file written by writeToFile().
+   * @param path path of the file.
+   * @return absl::StatusOr<std::unique_ptr<ReleaseSchedule>> the schedule, or an error status when
+   * the file could not be read or is malformed.
+   */
+  static absl::StatusOr<std::unique_ptr<ReleaseSchedule>> readFromFile(const std::string& path);
+
+private:
+  std::vector<std::vector<std::chrono::nanoseconds>> offsets_;
+};
+
+using ReleaseScheduleSharedPtr = std::shared_ptr<ReleaseSchedule>;
+
+} // namespace Nighthawk
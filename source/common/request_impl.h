@@ -7,19 +7,33 @@
 
 #include "nighthawk/common/request.h"
 
+#include "source/common/slab_arena.h"
+
 namespace Nighthawk {
 
 class RequestImpl : public Request {
 public:
-  RequestImpl(HeaderMapPtr header, std::string json_body = "")
-      : header_(std::move(header)), json_body_(json_body) {}
+  RequestImpl(HeaderMapPtr header, BodyPtr body = nullptr, const uint32_t request_class = 0,
+              const absl::optional<ResponseExpectations> expectations = absl::nullopt)
+      : header_(std::move(header)), body_(std::move(body)), request_class_(request_class),
+        expectations_(expectations) {}
+
+  // Request sources that yield many requests may allocate them from a slab arena.
+  static void* operator new(size_t size) { return SlabArena::allocateFromHeap(size); }
+  static void* operator new(size_t size, SlabArena& arena) { return arena.allocate(size); }
+  static void operator delete(void* block) { SlabArena::release(block); }
+  static void operator delete(void* block, SlabArena&) { SlabArena::release(block); }
 
   HeaderMapPtr header() const override { return header_; }
-  const std::string& body() const override { return json_body_; }
+  BodyPtr body() const override { return body_; }
+  uint32_t requestClass() const override { return request_class_; }
+  absl::optional<ResponseExpectations> expectations() const override { return expectations_; }
 
 private:
   HeaderMapPtr header_;
-  std::string json_body_;
+  BodyPtr body_;
+  const uint32_t request_class_;
+  const absl::optional<ResponseExpectations> expectations_;
 };
 
 } // namespace Nighthawk
@@ -14,6 +14,9 @@ using namespace std::chrono_literals;
 
 namespace {
 using EnvoyException = Envoy::EnvoyException;
+
+// Interval at which the owner of a shared stream transfers received requests to it.
+constexpr std::chrono::milliseconds kSharedStreamTransferInterval = 1ms;
 } // namespace
 
 StaticRequestSourceImpl::StaticRequestSourceImpl(Envoy::Http::RequestHeaderMapPtr&& header,
@@ -25,7 +28,7 @@ StaticRequestSourceImpl::StaticRequestSourceImpl(Envoy::Http::RequestHeaderMapPt
 RequestGenerator StaticRequestSourceImpl::get() {
   return [this]() -> RequestPtr {
     while (yields_left_--) {
-      return std::make_unique<RequestImpl>(header_);
+      return RequestPtr(new (*request_arena_) RequestImpl(header_));
     }
     return nullptr;
   };
@@ -34,19 +37,25 @@ RequestGenerator StaticRequestSourceImpl::get() {
 RemoteRequestSourceImpl::RemoteRequestSourceImpl(
     const Envoy::Upstream::ClusterManagerPtr& cluster_manager, Envoy::Event::Dispatcher& dispatcher,
     Envoy::Stats::Scope& scope, absl::string_view service_cluster_name,
-    Envoy::Http::RequestHeaderMapPtr&& base_header, uint32_t header_buffer_length)
+    Envoy::Http::RequestHeaderMapPtr&& base_header, uint32_t header_buffer_length,
+    SharedRemoteRequestStreamSharedPtr shared_stream)
     : cluster_manager_(cluster_manager), dispatcher_(dispatcher), scope_(scope),
       service_cluster_name_(std::string(service_cluster_name)),
-      base_header_(std::move(base_header)), header_buffer_length_(header_buffer_length) {}
+      base_header_(std::move(base_header)), header_buffer_length_(header_buffer_length),
+      shared_stream_(std::move(shared_stream)) {
+  queue_depth_statistic_.setId("request_source.queued_request_count");
+  stall_statistic_.setId("request_source.stall");
+}
 
-void RemoteRequestSourceImpl::connectToRequestStreamGrpcService() {
-  Envoy::TimeSource& time_source = dispatcher_.timeSource();
+RequestStreamGrpcClientPtr
+RemoteRequestSourceImpl::createGrpcClient(const uint32_t header_buffer_length,
+                                          Statistic& queue_depth_statistic,
+                                          Statistic& stall_statistic) {
   const auto clusters = cluster_manager_->clusters();
   const bool have_cluster =
       clusters.active_clusters_.find(service_cluster_name_) != clusters.active_clusters_.end();
   RELEASE_ASSERT(have_cluster,
                  absl::StrCat("Failed to find service cluster ", service_cluster_name_));
-  const std::chrono::seconds STREAM_SETUP_TIMEOUT = 60s;
   envoy::config::core::v3::GrpcService grpc_service;
   grpc_service.mutable_envoy_grpc()->set_cluster_name(service_cluster_name_);
   absl::StatusOr<Envoy::Grpc::AsyncClientFactoryPtr> cluster_manager =
@@ -57,9 +66,21 @@ void RemoteRequestSourceImpl::connectToRequestStreamGrpcService() {
   absl::StatusOr<Envoy::Grpc::RawAsyncClientPtr> raw_async_client =
       (*cluster_manager)->createUncachedRawAsyncClient();
   THROW_IF_NOT_OK_REF(raw_async_client.status());
+  return std::make_unique<RequestStreamGrpcClientImpl>(*std::move(raw_async_client), dispatcher_,
+                                                       base_header_, header_buffer_length,
+                                                       queue_depth_statistic, stall_statistic);
+}
 
-  grpc_client_ = std::make_unique<RequestStreamGrpcClientImpl>(
-      *std::move(raw_async_client), dispatcher_, *base_header_, header_buffer_length_);
+void RemoteRequestSourceImpl::connectToRequestStreamGrpcService() {
+  Envoy::TimeSource& time_source = dispatcher_.timeSource();
+  const std::chrono::seconds STREAM_SETUP_TIMEOUT = 60s;
+  if (shared_stream_ == nullptr) {
+    grpc_client_ =
+        createGrpcClient(header_buffer_length_, queue_depth_statistic_, stall_statistic_);
+  } else {
+    grpc_client_ = createGrpcClient(static_cast<uint32_t>(shared_stream_->ring().capacity()),
+                                    owned_stream_statistic_, owned_stream_statistic_);
+  }
   grpc_client_->start();
   const Envoy::MonotonicTime start = time_source.monotonicTime();
   bool timeout = false;
@@ -71,15 +92,75 @@ void RemoteRequestSourceImpl::connectToRequestStreamGrpcService() {
   ENVOY_LOG(debug, "Finished remote request source stream setup, connected: {}", timeout);
 }
 
-void RemoteRequestSourceImpl::initOnThread() { connectToRequestStreamGrpcService(); }
+void RemoteRequestSourceImpl::initOnThread() {
+  if (shared_stream_ == nullptr) {
+    connectToRequestStreamGrpcService();
+  } else if (shared_stream_->claimStream()) {
+    connectToRequestStreamGrpcService();
+    transfer_timer_ = dispatcher_.createTimer([this]() {
+      transferToSharedStream();
+      transfer_timer_->enableTimer(kSharedStreamTransferInterval);
+    });
+    transfer_timer_->enableTimer(kSharedStreamTransferInterval);
+  }
+}
 
 void RemoteRequestSourceImpl::destroyOnThread() {
   // The RequestStreamGrpcClientImpl uses Envoy::Grpc::AsyncClient which demands
   // to be destroyed on the same thread it was constructed from.
+  transfer_timer_.reset();
   grpc_client_.reset();
 }
 
+void RemoteRequestSourceImpl::transferToSharedStream() {
+  MpmcRing<RequestPtr>& ring = shared_stream_->ring();
+  while (true) {
+    if (pending_request_ == nullptr) {
+      pending_request_ = grpc_client_->maybeDequeue();
+      if (pending_request_ == nullptr) {
+        return;
+      }
+    }
+    if (!ring.tryPush(std::move(pending_request_))) {
+      return;
+    }
+  }
+}
+
+RequestPtr RemoteRequestSourceImpl::dequeueFromSharedStream() {
+  if (grpc_client_ != nullptr) {
+    // We own the stream, top up the shared stream rather than waiting for the next transfer.
+    transferToSharedStream();
+  }
+  MpmcRing<RequestPtr>& ring = shared_stream_->ring();
+  queue_depth_statistic_.addValue(ring.size());
+  RequestPtr request;
+  if (!ring.tryPop(request)) {
+    if (!stall_start_.has_value()) {
+      stall_start_ = dispatcher_.timeSource().monotonicTime();
+    }
+    return nullptr;
+  }
+  if (stall_start_.has_value()) {
+    stall_statistic_.addValue(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  dispatcher_.timeSource().monotonicTime() - stall_start_.value())
+                                  .count());
+    stall_start_.reset();
+  }
+  return request;
+}
+
+StatisticPtrMap RemoteRequestSourceImpl::statistics() const {
+  StatisticPtrMap statistics;
+  statistics[queue_depth_statistic_.id()] = &queue_depth_statistic_;
+  statistics[stall_statistic_.id()] = &stall_statistic_;
+  return statistics;
+}
+
 RequestGenerator RemoteRequestSourceImpl::get() {
+  if (shared_stream_ != nullptr) {
+    return [this]() -> RequestPtr { return dequeueFromSharedStream(); };
+  }
   return [this]() -> RequestPtr { return grpc_client_->maybeDequeue(); };
 }
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+
+#include "envoy/event/timer.h"
 #include "envoy/http/header_map.h"
 
 #include "nighthawk/common/request.h"
@@ -7,7 +11,11 @@
 
 #include "external/envoy/source/common/common/logger.h"
 
+#include "source/common/mpmc_ring.h"
+#include "source/common/request_impl.h"
 #include "source/common/request_stream_grpc_client_impl.h"
+#include "source/common/slab_arena.h"
+#include "source/common/statistic_impl.h"
 
 namespace Nighthawk {
 
@@ -32,8 +40,44 @@ public:
 private:
   const HeaderMapPtr header_;
   uint64_t yields_left_;
+  // Yielded requests are allocated from here. Requests are yielded and released on the worker
+  // thread that uses the source.
+  SlabArenaPtr request_arena_{SlabArena::create(sizeof(RequestImpl))};
+};
+
+/**
+ * Requests fetched over a single stream to a remote request source service, on behalf of the remote
+ * request sources of all workers. The first source to be initialized owns the stream, and moves
+ * the requests it receives into a lock-free ring that all sources dequeue from. The service thus
+ * sees a single consumer, and requests are replayed in the order in which it yields them.
+ * Requests are transferred from the event loop of the owner, so the ring only gets refilled while
+ * the owner is executing.
+ */
+class SharedRemoteRequestStream {
+public:
+  /**
+   * @param capacity the number of requests to buffer.
+   */
+  explicit SharedRemoteRequestStream(const uint32_t capacity) : ring_(capacity) {}
+
+  /**
+   * Thread safe.
+   * @return bool true for the first caller only, which then owns the stream.
+   */
+  bool claimStream() { return !stream_claimed_.exchange(true); }
+
+  /**
+   * @return MpmcRing<RequestPtr>& the requests fetched, but not dequeued yet.
+   */
+  MpmcRing<RequestPtr>& ring() { return ring_; }
+
+private:
+  MpmcRing<RequestPtr> ring_;
+  std::atomic<bool> stream_claimed_{false};
 };
 
+using SharedRemoteRequestStreamSharedPtr = std::shared_ptr<SharedRemoteRequestStream>;
+
 /**
  * Remote request source implementation. Will connect to a gRPC service to pull request specifiers,
  * and yield results based on that.
@@ -48,18 +92,39 @@ public:
    * @param base_header Any headers in request specifiers yielded by the remote request
    * source service will override what is specified here.
    * @param header_buffer_length The number of messages to buffer.
+   * @param shared_stream When set, requests are dequeued from this stream, which is shared with
+   * the remote request sources of the other workers, instead of from a stream of our own.
    */
   RemoteRequestSourceImpl(const Envoy::Upstream::ClusterManagerPtr& cluster_manager,
                           Envoy::Event::Dispatcher& dispatcher, Envoy::Stats::Scope& scope,
                           absl::string_view service_cluster_name,
                           Envoy::Http::RequestHeaderMapPtr&& base_header,
-                          uint32_t header_buffer_length);
+                          uint32_t header_buffer_length,
+                          SharedRemoteRequestStreamSharedPtr shared_stream = nullptr);
   RequestGenerator get() override;
   void initOnThread() override;
   void destroyOnThread() override;
+  StatisticPtrMap statistics() const override;
+
+protected:
+  /**
+   * Creates the client for the stream to the remote request source service. Overridable for
+   * testing.
+   *
+   * @param header_buffer_length The number of messages the client should buffer.
+   * @param queue_depth_statistic Tracks the depth of the client's queue.
+   * @param stall_statistic Tracks the time spent waiting for the client's queue to fill.
+   * @return RequestStreamGrpcClientPtr The client, not started yet.
+   */
+  virtual RequestStreamGrpcClientPtr createGrpcClient(uint32_t header_buffer_length,
+                                                      Statistic& queue_depth_statistic,
+                                                      Statistic& stall_statistic);
 
 private:
   void connectToRequestStreamGrpcService();
+  // Moves the requests received by the stream we own into the shared stream, until it is full.
+  void transferToSharedStream();
+  RequestPtr dequeueFromSharedStream();
   const Envoy::Upstream::ClusterManagerPtr& cluster_manager_;
   Envoy::Event::Dispatcher& dispatcher_;
   Envoy::Stats::Scope& scope_;
@@ -67,6 +132,20 @@ private:
   RequestStreamGrpcClientPtr grpc_client_;
   const HeaderMapPtr base_header_;
   const uint32_t header_buffer_length_;
+  // Owned here rather than by the gRPC client, which is destroyed before statistics are collected.
+  HdrStatistic queue_depth_statistic_;
+  HdrStatistic stall_statistic_;
+  const SharedRemoteRequestStreamSharedPtr shared_stream_;
+  // Set when we own the shared stream. Periodically transfers received requests, so that other
+  // workers are served while this one is idle.
+  Envoy::Event::TimerPtr transfer_timer_;
+  // A received request that did not fit into the shared stream yet.
+  RequestPtr pending_request_;
+  // Set while requests are dequeued from an empty shared stream.
+  absl::optional<Envoy::MonotonicTime> stall_start_;
+  // The queue of the stream owned on behalf of all workers is not reported; the workers track
+  // their view of the shared stream instead.
+  NullStatistic owned_stream_statistic_;
 };
 
 } // namespace Nighthawk
@@ -1,5 +1,7 @@
 #include "source/common/request_stream_grpc_client_impl.h"
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 
 #include "envoy/api/v2/core/base.pb.h"
@@ -20,40 +22,67 @@ namespace Nighthawk {
 
 using ::nighthawk::request_source::RequestSpecifier;
 
+namespace {
+
+bool setsHeaders(const RequestSpecifier& request_specifier) {
+  return request_specifier.v3_headers().headers_size() > 0 ||
+         request_specifier.headers().headers_size() > 0 || request_specifier.has_content_length() ||
+         request_specifier.has_authority() || request_specifier.has_path() ||
+         request_specifier.has_method();
+}
+
+} // namespace
+
 const std::string RequestStreamGrpcClientImpl::METHOD_NAME =
     "nighthawk.request_source.NighthawkRequestSourceService.RequestStream";
 
 RequestStreamGrpcClientImpl::RequestStreamGrpcClientImpl(
-    Envoy::Grpc::RawAsyncClientPtr async_client, Envoy::Event::Dispatcher&,
-    const Envoy::Http::RequestHeaderMap& base_header, const uint32_t header_buffer_length)
+    Envoy::Grpc::RawAsyncClientPtr async_client, Envoy::Event::Dispatcher& dispatcher,
+    HeaderMapPtr base_header, const uint32_t header_buffer_length,
+    Statistic& queue_depth_statistic, Statistic& stall_statistic)
     : async_client_(std::move(async_client)),
       service_method_(
           *Envoy::Protobuf::DescriptorPool::generated_pool()->FindMethodByName(METHOD_NAME)),
-      base_header_(base_header), header_buffer_length_(header_buffer_length) {}
+      time_source_(dispatcher.timeSource()), base_header_(std::move(base_header)),
+      header_buffer_length_(header_buffer_length),
+      low_watermark_(std::max<uint32_t>(header_buffer_length / 2, 1)),
+      queue_depth_statistic_(queue_depth_statistic), stall_statistic_(stall_statistic) {}
 
 void RequestStreamGrpcClientImpl::start() {
   stream_ = async_client_->start(service_method_, *this, Envoy::Http::AsyncClient::StreamOptions());
   ENVOY_LOG(trace, "stream establishment status ok: {}", stream_ != nullptr);
-  trySendRequest();
+  trySendRequest(header_buffer_length_);
 }
 
-void RequestStreamGrpcClientImpl::trySendRequest() {
+void RequestStreamGrpcClientImpl::trySendRequest(const uint64_t quantity) {
   if (stream_ != nullptr) {
     nighthawk::request_source::RequestStreamRequest request;
-    request.set_quantity(header_buffer_length_);
+    request.set_quantity(quantity);
+    request.set_max_batch_size(kMaxBatchSize);
     stream_->sendMessage(request, false);
-    in_flight_headers_ = header_buffer_length_;
+    in_flight_headers_ += quantity;
     ENVOY_LOG(trace, "send request: {}", absl::StrCat(request));
   }
 }
 
+void RequestStreamGrpcClientImpl::maybeRefill() {
+  // Top up to the high watermark once we drop below the low watermark, so that the service has
+  // time to respond before the queue drains.
+  const uint64_t buffered = queued_requests_ + in_flight_headers_;
+  if (buffered < low_watermark_) {
+    trySendRequest(header_buffer_length_ - buffered);
+  }
+}
+
 void RequestStreamGrpcClientImpl::onCreateInitialMetadata(Envoy::Http::RequestHeaderMap&) {}
 
 void RequestStreamGrpcClientImpl::onReceiveInitialMetadata(Envoy::Http::ResponseHeaderMapPtr&&) {}
 
 void RequestStreamGrpcClientImpl::onReceiveMessage(
     std::unique_ptr<nighthawk::request_source::RequestStreamResponse>&& message) {
-  in_flight_headers_--;
+  const uint64_t requests = message->requests_size() > 0 ? message->requests_size() : 1;
+  in_flight_headers_ -= std::min(in_flight_headers_, requests);
+  queued_requests_ += requests;
   total_messages_received_++;
   emplaceMessage(std::move(message));
 }
@@ -75,70 +104,100 @@ void RequestStreamGrpcClientImpl::onRemoteClose(Envoy::Grpc::Status::GrpcStatus
 }
 
 RequestPtr ProtoRequestHelper::messageToRequest(
-    const Envoy::Http::RequestHeaderMap& base_header,
+    const HeaderMapPtr& base_header,
     const nighthawk::request_source::RequestStreamResponse& message) {
-  std::shared_ptr<Envoy::Http::RequestHeaderMapImpl> header(
-      Envoy::Http::RequestHeaderMapImpl::create().release());
-  header->copyFrom(*header, base_header);
-  RequestPtr request = std::make_unique<RequestImpl>(header);
-
-  if (message.has_request_specifier()) {
-    const RequestSpecifier& request_specifier = message.request_specifier();
-
-    if (request_specifier.has_v3_headers()) {
-      const envoy::config::core::v3::HeaderMap& message_request_headers =
-          request_specifier.v3_headers();
-      for (const envoy::config::core::v3::HeaderValue& message_header :
-           message_request_headers.headers()) {
-        Envoy::Http::LowerCaseString header_name(message_header.key());
-        header->remove(header_name);
-        header->addCopy(header_name, message_header.value());
-      }
-    } else if (request_specifier.has_headers()) {
-      const envoy::api::v2::core::HeaderMap& message_request_headers = request_specifier.headers();
-      for (const envoy::api::v2::core::HeaderValue& message_header :
-           message_request_headers.headers()) {
-        Envoy::Http::LowerCaseString header_name(message_header.key());
-        header->remove(header_name);
-        header->addCopy(header_name, message_header.value());
-      }
-    }
-
-    if (request_specifier.has_content_length()) {
-      std::string s_content_length = absl::StrCat("", request_specifier.content_length().value());
-      header->remove(Envoy::Http::Headers::get().ContentLength);
-      header->setContentLength(s_content_length);
+  absl::optional<ResponseExpectations> expectations;
+  if (message.has_expectations()) {
+    const nighthawk::request_source::Expectations& message_expectations = message.expectations();
+    expectations.emplace();
+    if (message_expectations.has_response_code()) {
+      expectations->response_code = message_expectations.response_code().value();
     }
-    if (request_specifier.has_authority()) {
-      header->remove(Envoy::Http::Headers::get().Host);
-      header->setHost(request_specifier.authority().value());
+    if (message_expectations.has_content_length()) {
+      expectations->content_length = message_expectations.content_length().value();
     }
-    if (request_specifier.has_path()) {
-      header->remove(Envoy::Http::Headers::get().Path);
-      header->setPath(request_specifier.path().value());
+  }
+  if (!message.has_request_specifier() || !setsHeaders(message.request_specifier())) {
+    // Nothing to override, so there is no need to copy the base header.
+    return std::make_unique<RequestImpl>(base_header, /*body=*/nullptr, /*request_class=*/0,
+                                         expectations);
+  }
+
+  std::shared_ptr<Envoy::Http::RequestHeaderMapImpl> header(
+      Envoy::Http::RequestHeaderMapImpl::create().release());
+  header->copyFrom(*header, *base_header);
+  const RequestSpecifier& request_specifier = message.request_specifier();
+
+  if (request_specifier.has_v3_headers()) {
+    const envoy::config::core::v3::HeaderMap& message_request_headers =
+        request_specifier.v3_headers();
+    for (const envoy::config::core::v3::HeaderValue& message_header :
+         message_request_headers.headers()) {
+      Envoy::Http::LowerCaseString header_name(message_header.key());
+      header->remove(header_name);
+      header->addCopy(header_name, message_header.value());
     }
-    if (request_specifier.has_method()) {
-      header->remove(Envoy::Http::Headers::get().Method);
-      header->setMethod(request_specifier.method().value());
+  } else if (request_specifier.has_headers()) {
+    const envoy::api::v2::core::HeaderMap& message_request_headers = request_specifier.headers();
+    for (const envoy::api::v2::core::HeaderValue& message_header :
+         message_request_headers.headers()) {
+      Envoy::Http::LowerCaseString header_name(message_header.key());
+      header->remove(header_name);
+      header->addCopy(header_name, message_header.value());
     }
   }
 
-  // TODO(oschaaf): associate the expectations from the proto to the request,
-  // and process those by verifying expectations on request completion.
-  return request;
+  if (request_specifier.has_content_length()) {
+    std::string s_content_length = absl::StrCat("", request_specifier.content_length().value());
+    header->remove(Envoy::Http::Headers::get().ContentLength);
+    header->setContentLength(s_content_length);
+  }
+  if (request_specifier.has_authority()) {
+    header->remove(Envoy::Http::Headers::get().Host);
+    header->setHost(request_specifier.authority().value());
+  }
+  if (request_specifier.has_path()) {
+    header->remove(Envoy::Http::Headers::get().Path);
+    header->setPath(request_specifier.path().value());
+  }
+  if (request_specifier.has_method()) {
+    header->remove(Envoy::Http::Headers::get().Method);
+    header->setMethod(request_specifier.method().value());
+  }
+  return std::make_unique<RequestImpl>(header, /*body=*/nullptr, /*request_class=*/0,
+                                       expectations);
 }
 
 RequestPtr RequestStreamGrpcClientImpl::maybeDequeue() {
-  RequestPtr request = nullptr;
-  if (!messages_.empty()) {
-    const auto& message = messages_.front();
-    request = ProtoRequestHelper::messageToRequest(base_header_, *message);
-    messages_.pop();
-    if (in_flight_headers_ == 0 && messages_.size() < header_buffer_length_) {
-      trySendRequest();
+  queue_depth_statistic_.addValue(queued_requests_);
+  if (messages_.empty()) {
+    if (stream_ != nullptr && !stall_start_.has_value()) {
+      stall_start_ = time_source_.monotonicTime();
     }
+    return nullptr;
+  }
+  if (stall_start_.has_value()) {
+    stall_statistic_.addValue(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  time_source_.monotonicTime() - stall_start_.value())
+                                  .count());
+    stall_start_.reset();
   }
 
+  const nighthawk::request_source::RequestStreamResponse& message = *messages_.front();
+  RequestPtr request;
+  if (message.requests_size() == 0) {
+    request = ProtoRequestHelper::messageToRequest(base_header_, message);
+    messages_.pop();
+  } else {
+    request = ProtoRequestHelper::messageToRequest(base_header_,
+                                                   message.requests(next_batch_entry_++));
+    if (next_batch_entry_ == message.requests_size()) {
+      next_batch_entry_ = 0;
+      messages_.pop();
+    }
+  }
+  queued_requests_--;
+  maybeRefill();
   return request;
 }
 
@@ -10,11 +10,14 @@
 
 #include "nighthawk/common/request.h"
 #include "nighthawk/common/request_stream_grpc_client.h"
+#include "nighthawk/common/statistic.h"
 
 #include "external/envoy/source/common/common/logger.h"
 #include "external/envoy/source/common/grpc/typed_async_client.h"
 #include "external/envoy/source/common/http/header_map_impl.h"
 
+#include "absl/types/optional.h"
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic warning "-Wunused-parameter"
@@ -29,30 +32,49 @@ namespace Nighthawk {
 
 class ProtoRequestHelper {
 public:
+  /**
+   * @param base_header Headers that the request specifier in the message may override. Shared by
+   * the returned request when the specifier does not set any header.
+   * @param message The message to translate.
+   * @return RequestPtr The request specified by the message.
+   */
   static RequestPtr
-  messageToRequest(const Envoy::Http::RequestHeaderMap& base_header,
+  messageToRequest(const HeaderMapPtr& base_header,
                    const nighthawk::request_source::RequestStreamResponse& message);
 };
 
 /**
  * gRPC client for communicating with a remote request-source service.
+ *
+ * Keeps between header_buffer_length / 2 (the low watermark) and header_buffer_length (the high
+ * watermark) requests either queued or requested from the service, so that the stream is refilled
+ * ahead of demand rather than after the queue has drained. Accepts batched responses carrying
+ * many request specifiers per message.
  */
 class RequestStreamGrpcClientImpl
     : public RequestStreamGrpcClient,
       Envoy::Grpc::AsyncStreamCallbacks<nighthawk::request_source::RequestStreamResponse>,
       Envoy::Logger::Loggable<Envoy::Logger::Id::upstream> {
 public:
+  /**
+   * The maximum number of requests the service is allowed to batch into a single message.
+   */
+  static constexpr uint32_t kMaxBatchSize = 128;
+
   /**
    * @param async_client Raw async client that we can use.
    * @param dispatcher Dispatcher that will be used.
    * @param base_header Any headers in request specifiers yielded by the remote request
    * source service will override what is specified here.
    * @param header_buffer_length The number of messages to buffer.
+   * @param queue_depth_statistic Receives the number of queued requests each time one is asked for.
+   * @param stall_statistic Receives how long requests were asked for while the queue was empty,
+   * in nanoseconds.
    */
   RequestStreamGrpcClientImpl(Envoy::Grpc::RawAsyncClientPtr async_client,
                               Envoy::Event::Dispatcher& dispatcher,
-                              const Envoy::Http::RequestHeaderMap& base_header,
-                              const uint32_t header_buffer_length);
+                              HeaderMapPtr base_header, const uint32_t header_buffer_length,
+                              Statistic& queue_depth_statistic, Statistic& stall_statistic);
 
   // Grpc::AsyncStreamCallbacks
   void onCreateInitialMetadata(Envoy::Http::RequestHeaderMap& metadata) override;
@@ -71,18 +93,30 @@ public:
 
 private:
   static const std::string METHOD_NAME;
-  void trySendRequest();
+  void trySendRequest(const uint64_t quantity);
+  void maybeRefill();
   Envoy::Grpc::AsyncClient<nighthawk::request_source::RequestStreamRequest,
                            nighthawk::request_source::RequestStreamResponse>
       async_client_;
   Envoy::Grpc::AsyncStream<nighthawk::request_source::RequestStreamRequest> stream_{};
   const Envoy::Protobuf::MethodDescriptor& service_method_;
+  Envoy::TimeSource& time_source_;
   std::queue<std::unique_ptr<nighthawk::request_source::RequestStreamResponse>> messages_;
   void emplaceMessage(std::unique_ptr<nighthawk::request_source::RequestStreamResponse>&& message);
-  uint32_t in_flight_headers_{0};
+  // Index of the next request to dequeue from the batch at the front of messages_.
+  int next_batch_entry_{0};
+  // Requests held by messages_.
+  uint64_t queued_requests_{0};
+  // Requests asked for, but not received yet.
+  uint64_t in_flight_headers_{0};
   uint32_t total_messages_received_{0};
-  const Envoy::Http::RequestHeaderMap& base_header_;
+  const HeaderMapPtr base_header_;
   const uint32_t header_buffer_length_;
+  const uint32_t low_watermark_;
+  Statistic& queue_depth_statistic_;
+  Statistic& stall_statistic_;
+  // Set while requests are asked for with an empty queue.
+  absl::optional<Envoy::MonotonicTime> stall_start_;
 };
 
 } // namespace Nighthawk
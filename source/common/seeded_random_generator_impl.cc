@@ -0,0 +1,26 @@
+#include "source/common/seeded_random_generator_impl.h"
+
+#include "fmt/format.h"
+
+namespace Nighthawk {
+
+std::string SeededRandomGeneratorImpl::uuid() {
+  const uint64_t high = generator_();
+  const uint64_t low = generator_();
+  // Set the version (4, random) and the variant (RFC 4122) bits.
+  const uint64_t versioned_high = (high & 0xffffffffffff0fffULL) | 0x0000000000004000ULL;
+  const uint64_t variant_low = (low & 0x3fffffffffffffffULL) | 0x8000000000000000ULL;
+  return fmt::format("{:08x}-{:04x}-{:04x}-{:04x}-{:012x}", versioned_high >> 32,
+                     (versioned_high >> 16) & 0xffff, versioned_high & 0xffff, variant_low >> 48,
+                     variant_low & 0xffffffffffffULL);
+}
+
+uint64_t SeededRandomGeneratorImpl::seedForWorker(const uint64_t seed, const uint32_t worker_id) {
+  // splitmix64 finalizer, so that seeds of adjacent workers are not correlated.
+  uint64_t value = seed + (static_cast<uint64_t>(worker_id) + 1) * 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+} // namespace Nighthawk
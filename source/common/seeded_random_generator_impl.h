@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "envoy/common/random_generator.h"
+
+namespace Nighthawk {
+
+/**
+ * Random generator which yields a deterministic sequence for a given seed, including the uuids
+ * it generates. Used instead of Envoy::Random::RandomGeneratorImpl when reproducible executions
+ * are requested. Not thread safe.
+ */
+class SeededRandomGeneratorImpl : public Envoy::Random::RandomGenerator {
+public:
+  /**
+   * @param seed seed for the underlying pseudo random number generator.
+   */
+  SeededRandomGeneratorImpl(const uint64_t seed) : generator_(seed) {}
+
+  uint64_t random() override { return generator_(); }
+
+  /**
+   * @return std::string a version 4 uuid, drawn from the seeded sequence.
+   */
+  std::string uuid() override;
+
+  /**
+   * Derives a seed for a worker from the seed that was configured for the execution, so that
+   * workers get distinct but reproducible random sequences.
+   * @param seed seed configured for the execution.
+   * @param worker_id worker number.
+   * @return uint64_t seed for the worker.
+   */
+  static uint64_t seedForWorker(const uint64_t seed, const uint32_t worker_id);
+
+private:
+  std::mt19937_64 generator_;
+};
+
+} // namespace Nighthawk
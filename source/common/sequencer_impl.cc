@@ -103,6 +103,7 @@ void SequencerImpl::run(bool from_periodic_timer) {
     return;
   }
 
+  const uint64_t targets_initiated_before = targets_initiated_;
   while (rate_limiter_->tryAcquireOne()) {
     // The rate limiter says it's OK to proceed and call the target. Let's see if the target is OK
     // with that as well.
@@ -155,6 +156,11 @@ void SequencerImpl::run(bool from_periodic_timer) {
       spin_timer_->enableHRTimer(0ms);
     } // .. else we poll, the periodic timer will be active
   }
+  // Refreshing the cached time here does not affect the consistency discussed above, as the pass
+  // is done by now.
+  dispatcher_.updateApproximateMonotonicTime();
+  (targets_initiated_ > targets_initiated_before ? pacing_duration_ : idle_duration_) +=
+      time_source_.monotonicTime() - now;
 }
 
 void SequencerImpl::waitForCompletion() {
@@ -170,6 +176,8 @@ StatisticPtrMap SequencerImpl::statistics() const {
   StatisticPtrMap statistics;
   statistics[latency_statistic_->id()] = latency_statistic_.get();
   statistics[blocked_statistic_->id()] = blocked_statistic_.get();
+  const StatisticPtrMap rate_limiter_statistics = rate_limiter_->statistics();
+  statistics.insert(rate_limiter_statistics.begin(), rate_limiter_statistics.end());
   return statistics;
 };
 
@@ -71,6 +71,10 @@ public:
     return usec == 0 ? 0 : ((targets_completed_ / usec) * 1000000);
   }
 
+  std::chrono::nanoseconds pacingDuration() const override { return pacing_duration_; }
+
+  std::chrono::nanoseconds idleDuration() const override { return idle_duration_; }
+
   StatisticPtrMap statistics() const override;
 
   const Statistic& blockedStatistic() const { return *blocked_statistic_; }
@@ -120,6 +124,8 @@ private:
   Envoy::Event::TimerPtr spin_timer_;
   uint64_t targets_initiated_{0};
   uint64_t targets_completed_{0};
+  std::chrono::nanoseconds pacing_duration_{0};
+  std::chrono::nanoseconds idle_duration_{0};
   bool running_{};
   bool blocked_{};
   Envoy::MonotonicTime blocked_start_;
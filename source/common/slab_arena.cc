@@ -0,0 +1,109 @@
+#include "source/common/slab_arena.h"
+
+#include <new>
+
+#include "external/envoy/source/common/common/assert.h"
+
+namespace Nighthawk {
+
+namespace {
+
+size_t roundUpToAlignment(const size_t size) {
+  constexpr size_t alignment = alignof(std::max_align_t);
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void SlabArenaDeleter::operator()(SlabArena* arena) const { arena->destroy(); }
+
+SlabArena::SlabArena(const size_t block_size, const size_t blocks_per_slab)
+    : block_size_(roundUpToAlignment(block_size)), blocks_per_slab_(blocks_per_slab),
+      stride_(sizeof(BlockHeader) + block_size_) {
+  ASSERT(blocks_per_slab_ > 0);
+}
+
+SlabArenaPtr SlabArena::create(const size_t block_size, const size_t blocks_per_slab) {
+  return SlabArenaPtr(new SlabArena(block_size, blocks_per_slab));
+}
+
+void* SlabArena::allocateFromHeap(const size_t size) {
+  auto* header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + size));
+  header->arena = nullptr;
+  header->next_free = nullptr;
+  return header + 1;
+}
+
+void SlabArena::release(void* block) {
+  if (block == nullptr) {
+    return;
+  }
+  BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+  if (header->arena == nullptr) {
+    ::operator delete(header);
+  } else {
+    header->arena->releaseBlock(header);
+  }
+}
+
+void* SlabArena::allocate(const size_t size) {
+  if (size > block_size_) {
+    heap_allocations_++;
+    return allocateFromHeap(size);
+  }
+  if (free_list_ == nullptr) {
+    addSlab();
+  }
+  BlockHeader* header = free_list_;
+  free_list_ = header->next_free;
+  header->next_free = nullptr;
+  blocks_in_use_++;
+  return header + 1;
+}
+
+void SlabArena::startEpoch() {
+  epoch_++;
+  if (blocks_in_use_ > 0 || slabs_.size() <= 1) {
+    return;
+  }
+  slabs_.resize(1);
+  // Rebuild the free list from the remaining slab.
+  free_list_ = nullptr;
+  unsigned char* slab = slabs_.front().get();
+  for (size_t i = blocks_per_slab_; i > 0; i--) {
+    auto* header = reinterpret_cast<BlockHeader*>(slab + (i - 1) * stride_);
+    header->next_free = free_list_;
+    free_list_ = header;
+  }
+}
+
+void SlabArena::addSlab() {
+  heap_allocations_++;
+  slabs_.push_back(std::make_unique<unsigned char[]>(stride_ * blocks_per_slab_));
+  unsigned char* slab = slabs_.back().get();
+  for (size_t i = blocks_per_slab_; i > 0; i--) {
+    auto* header = new (slab + (i - 1) * stride_) BlockHeader{this, free_list_};
+    free_list_ = header;
+  }
+}
+
+void SlabArena::releaseBlock(BlockHeader* header) {
+  ASSERT(header->arena == this);
+  ASSERT(blocks_in_use_ > 0);
+  header->next_free = free_list_;
+  free_list_ = header;
+  blocks_in_use_--;
+  if (owner_released_ && blocks_in_use_ == 0) {
+    delete this;
+  }
+}
+
+void SlabArena::destroy() {
+  if (blocks_in_use_ == 0) {
+    delete this;
+  } else {
+    owner_released_ = true;
+  }
+}
+
+} // namespace Nighthawk
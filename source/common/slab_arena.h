@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "external/envoy/source/common/common/non_copyable.h"
+
+namespace Nighthawk {
+
+class SlabArena;
+
+/**
+ * Owning pointer to a slab arena. Releasing it destroys the arena once the last of its blocks
+ * has been released.
+ */
+struct SlabArenaDeleter {
+  void operator()(SlabArena* arena) const;
+};
+using SlabArenaPtr = std::unique_ptr<SlabArena, SlabArenaDeleter>;
+
+/**
+ * Allocator for objects that live as long as a request, owned by a single worker. Hands out
+ * fixed-size blocks carved from slabs, and recycles released blocks via a free list. Once the
+ * arena has grown to the peak number of requests in flight, allocating and releasing blocks no
+ * longer touches the heap. Not thread safe: blocks must be allocated and released on the thread
+ * that owns the arena.
+ *
+ * Each block records the arena it came from, so that blocks can be released without a reference
+ * to the arena, for example from a class-specific operator delete. Blocks may outlive the owner
+ * of the arena, which is common for objects that are deleted in a deferred fashion; the arena
+ * stays alive until the last of them has been released.
+ *
+ * The arena counts epochs, which typically span an execution. Starting an epoch while no blocks
+ * are in use returns all slabs but the first one to the heap, so that a burst of requests in one
+ * execution does not pin memory for the lifetime of the worker.
+ */
+class SlabArena : public Envoy::NonCopyable {
+public:
+  /**
+   * @param block_size size of the objects allocated from the arena.
+   * @param blocks_per_slab number of blocks in each slab.
+   * @return SlabArenaPtr the arena.
+   */
+  static SlabArenaPtr create(const size_t block_size, const size_t blocks_per_slab = 256);
+
+  /**
+   * Allocates a block from the heap instead of an arena. The block can be released via release()
+   * like any other block, which allows classes to mix arena and heap allocation.
+   * @param size size of the block.
+   * @return void* the block.
+   */
+  static void* allocateFromHeap(const size_t size);
+
+  /**
+   * Releases a block allocated via allocate() or allocateFromHeap().
+   * @param block the block to release. May be nullptr.
+   */
+  static void release(void* block);
+
+  /**
+   * Allocates a block from the arena. Falls back to the heap when size exceeds the block size of
+   * the arena.
+   * @param size size of the object that will occupy the block.
+   * @return void* the block.
+   */
+  void* allocate(const size_t size);
+
+  /**
+   * Starts a new epoch. When no blocks are in use, all slabs but the first one are returned to
+   * the heap.
+   */
+  void startEpoch();
+
+  /**
+   * @return uint64_t the number of epochs started.
+   */
+  uint64_t epoch() const { return epoch_; }
+
+  /**
+   * @return size_t the maximum size of the objects the arena holds.
+   */
+  size_t blockSize() const { return block_size_; }
+
+  /**
+   * @return size_t the number of blocks currently in use.
+   */
+  size_t blocksInUse() const { return blocks_in_use_; }
+
+  /**
+   * @return size_t the number of slabs currently held.
+   */
+  size_t slabs() const { return slabs_.size(); }
+
+  /**
+   * @return uint64_t the number of times the arena had to allocate from the heap, either to add a
+   * slab or because an object did not fit into a block.
+   */
+  uint64_t heapAllocations() const { return heap_allocations_; }
+
+private:
+  friend struct SlabArenaDeleter;
+  // Precedes each block, and keeps the objects in the blocks aligned.
+  struct alignas(std::max_align_t) BlockHeader {
+    // nullptr for blocks allocated from the heap.
+    SlabArena* arena;
+    BlockHeader* next_free;
+  };
+
+  SlabArena(const size_t block_size, const size_t blocks_per_slab);
+  ~SlabArena() = default;
+  void addSlab();
+  void releaseBlock(BlockHeader* header);
+  // Destroys the arena when no blocks are in use, or marks it for destruction on the release of
+  // the last block in use otherwise.
+  void destroy();
+
+  const size_t block_size_;
+  const size_t blocks_per_slab_;
+  // Distance between the headers of consecutive blocks in a slab.
+  const size_t stride_;
+  std::vector<std::unique_ptr<unsigned char[]>> slabs_;
+  BlockHeader* free_list_{nullptr};
+  size_t blocks_in_use_{0};
+  uint64_t epoch_{0};
+  uint64_t heap_allocations_{0};
+  bool owner_released_{false};
+};
+
+} // namespace Nighthawk
@@ -234,6 +234,34 @@ StatisticPtr InMemoryStatistic::combine(const Statistic& statistic) const {
   return combined;
 }
 
+IntervalTrackingStatistic::IntervalTrackingStatistic(StatisticPtr&& statistic)
+    : statistic_(std::move(statistic)), interval_(statistic_->createNewInstanceOfSameType()) {}
+
+void IntervalTrackingStatistic::addValue(uint64_t sample_value) {
+  statistic_->addValue(sample_value);
+  interval_->addValue(sample_value);
+}
+
+StatisticPtr IntervalTrackingStatistic::createNewInstanceOfSameType() const {
+  return std::make_unique<IntervalTrackingStatistic>(statistic_->createNewInstanceOfSameType());
+}
+
+StatisticPtr IntervalTrackingStatistic::takeInterval() const {
+  StatisticPtr interval = std::move(interval_);
+  interval_ = interval->createNewInstanceOfSameType();
+  interval->setId(id());
+  return interval;
+}
+
+StatisticPtr IntervalTrackingStatistic::combine(const Statistic& statistic) const {
+  // Unwrap, as the wrapped statistics can only be combined with their own type.
+  const auto* tracking = dynamic_cast<const IntervalTrackingStatistic*>(&statistic);
+  StatisticPtr combined =
+      statistic_->combine(tracking != nullptr ? *tracking->statistic_ : statistic);
+  // Keep wrapping, so that combining the result with other instances keeps working.
+  return std::make_unique<IntervalTrackingStatistic>(std::move(combined));
+}
+
 const int HdrStatistic::SignificantDigits = 4;
 
 HdrStatistic::HdrStatistic() : histogram_(nullptr) {
@@ -186,6 +186,47 @@ private:
   histogram_t* histogram_;
 };
 
+/**
+ * Wraps a statistic, and additionally tracks the values added since the last call to
+ * takeInterval() in a separate instance of the same type. Everything else is delegated to the
+ * wrapped statistic, which keeps accumulating.
+ */
+class IntervalTrackingStatistic : public Statistic {
+public:
+  IntervalTrackingStatistic(StatisticPtr&& statistic);
+  void addValue(uint64_t sample_value) override;
+  uint64_t count() const override { return statistic_->count(); }
+  double mean() const override { return statistic_->mean(); }
+  double pvariance() const override { return statistic_->pvariance(); }
+  double pstdev() const override { return statistic_->pstdev(); }
+  uint64_t min() const override { return statistic_->min(); }
+  uint64_t max() const override { return statistic_->max(); }
+  StatisticPtr createNewInstanceOfSameType() const override;
+  uint64_t significantDigits() const override { return statistic_->significantDigits(); }
+  bool resistsCatastrophicCancellation() const override {
+    return statistic_->resistsCatastrophicCancellation();
+  }
+  StatisticPtr takeInterval() const override;
+  std::string toString() const override { return statistic_->toString(); }
+  nighthawk::client::Statistic toProto(SerializationDomain domain) const override {
+    return statistic_->toProto(domain);
+  }
+  StatisticPtr combine(const Statistic& statistic) const override;
+  std::string id() const override { return statistic_->id(); }
+  void setId(absl::string_view id) override { statistic_->setId(id); }
+  absl::StatusOr<std::unique_ptr<std::istream>> serializeNative() const override {
+    return statistic_->serializeNative();
+  }
+  absl::Status deserializeNative(std::istream& input_stream) override {
+    return statistic_->deserializeNative(input_stream);
+  }
+
+private:
+  StatisticPtr statistic_;
+  // Handing out the interval does not change what this statistic reports.
+  mutable StatisticPtr interval_;
+};
+
 /**
  * In order to be able to flush a histogram value to downstream Envoy stats Sinks, abstract class
  * SinkableStatistic takes the Scope reference in the constructor and wraps the
@@ -20,6 +20,11 @@ TerminationPredicate::Status DurationTerminationPredicateImpl::evaluate() {
                                                            : TerminationPredicate::Status::PROCEED;
 }
 
+TerminationPredicate::Status DeadlineTerminationPredicateImpl::evaluate() {
+  return time_source_.monotonicTime() >= deadline_.load() ? TerminationPredicate::Status::TERMINATE
+                                                          : TerminationPredicate::Status::PROCEED;
+}
+
 TerminationPredicate::Status StatsCounterAbsoluteThresholdTerminationPredicateImpl::evaluate() {
   return counter_.value() > counter_limit_ ? termination_status_
                                            : TerminationPredicate::Status::PROCEED;
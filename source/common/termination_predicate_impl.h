@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 
 #include "envoy/common/time.h"
@@ -49,6 +50,23 @@ private:
   std::chrono::microseconds duration_;
 };
 
+/**
+ * Predicate which indicates termination once the deadline it observes has been reached. The
+ * deadline may be moved by other threads at any time, Envoy::MonotonicTime::max() means there is
+ * none.
+ */
+class DeadlineTerminationPredicateImpl : public TerminationPredicateBaseImpl {
+public:
+  DeadlineTerminationPredicateImpl(Envoy::TimeSource& time_source,
+                                   const std::atomic<Envoy::MonotonicTime>& deadline)
+      : time_source_(time_source), deadline_(deadline) {}
+  TerminationPredicate::Status evaluate() override;
+
+private:
+  Envoy::TimeSource& time_source_;
+  const std::atomic<Envoy::MonotonicTime>& deadline_;
+};
+
 class StatsCounterAbsoluteThresholdTerminationPredicateImpl : public TerminationPredicateBaseImpl {
 public:
   StatsCounterAbsoluteThresholdTerminationPredicateImpl(
@@ -16,7 +16,12 @@ WorkerImpl::~WorkerImpl() { RELEASE_ASSERT(shutdown_, "Call shutdown() before de
 
 void WorkerImpl::shutdown() {
   shutdown_ = true;
-  signal_thread_to_exit_.set_value();
+  {
+    Envoy::Thread::LockGuard guard(rounds_lock_);
+    exit_requested_ = true;
+    rounds_changed_.notifyAll();
+  }
+  wakeUpIdleThread();
   thread_.join();
 }
 
@@ -24,16 +29,80 @@ void WorkerImpl::start() {
   RELEASE_ASSERT(!started_, "WorkerImpl::start() expected started_ to be false");
   started_ = true;
   shutdown_ = false;
+  {
+    Envoy::Thread::LockGuard guard(rounds_lock_);
+    rounds_requested_ = 1;
+  }
   thread_ = std::thread([this]() {
+    if (!cpu_affinity_.empty()) {
+      const absl::Status status = CpuTopology::setCurrentThreadAffinity(cpu_affinity_);
+      if (!status.ok()) {
+        ENVOY_LOG(warn, "Failed to pin worker thread: {}", status.message());
+      }
+    }
     dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
-    work();
-    complete_.set_value();
-    signal_thread_to_exit_.get_future().wait();
+    uint32_t round = 0;
+    while (true) {
+      {
+        Envoy::Thread::LockGuard guard(rounds_lock_);
+        while (rounds_requested_ == round && !exit_requested_ && !dispatch_while_idle_) {
+          rounds_changed_.wait(rounds_lock_);
+        }
+        if (rounds_requested_ == round && exit_requested_) {
+          break;
+        }
+        idle_ = rounds_requested_ == round;
+        round = rounds_requested_;
+      }
+      if (idle_) {
+        // Keep running the dispatcher in between rounds, so that connections and timers are
+        // serviced, until the next round or shutdown wakes us up.
+        dispatcher_->run(Envoy::Event::Dispatcher::RunType::RunUntilExit);
+        idle_ = false;
+        continue;
+      }
+      work();
+      Envoy::Thread::LockGuard guard(rounds_lock_);
+      rounds_completed_ = round;
+      dispatch_while_idle_ = false;
+      rounds_changed_.notifyAll();
+    }
     shutdownThread();
     tls_.shutdownThread();
   });
 }
 
-void WorkerImpl::waitForCompletion() { complete_.get_future().wait(); }
+void WorkerImpl::waitForCompletion() {
+  Envoy::Thread::LockGuard guard(rounds_lock_);
+  while (rounds_completed_ < rounds_requested_) {
+    rounds_changed_.wait(rounds_lock_);
+  }
+}
+
+void WorkerImpl::startNextRound() {
+  RELEASE_ASSERT(started_, "WorkerImpl::startNextRound() expected started_ to be true");
+  Envoy::Thread::LockGuard guard(rounds_lock_);
+  RELEASE_ASSERT(rounds_completed_ == rounds_requested_,
+                 "WorkerImpl::startNextRound() expected the previous round to be completed");
+  rounds_requested_++;
+  rounds_changed_.notifyAll();
+  wakeUpIdleThread();
+}
+
+void WorkerImpl::dispatchWhileIdle() {
+  Envoy::Thread::LockGuard guard(rounds_lock_);
+  dispatch_while_idle_ = true;
+  rounds_changed_.notifyAll();
+}
+
+void WorkerImpl::wakeUpIdleThread() {
+  // The worker may be busy with a round, in which case the dispatcher must not exit. It checks for
+  // a next round or shutdown before it goes idle again.
+  dispatcher_->post([this]() {
+    if (idle_) {
+      dispatcher_->exit();
+    }
+  });
+}
 
 } // namespace Nighthawk
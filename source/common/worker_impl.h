@@ -13,6 +13,8 @@
 #include "external/envoy/source/common/common/logger.h"
 #include "external/envoy/source/common/common/thread.h"
 
+#include "source/common/cpu_topology_impl.h"
+
 namespace Nighthawk {
 
 class WorkerImpl : virtual public Worker, public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
@@ -24,6 +26,32 @@ public:
   void waitForCompletion() override;
   void shutdown() override;
 
+  /**
+   * Restricts the worker thread to the given cpus. Must be called before start().
+   * @param cpus cpu set. An empty set leaves the thread unpinned.
+   */
+  void setCpuAffinity(const CpuSet& cpus) { cpu_affinity_ = cpus; }
+
+  /**
+   * @return const CpuSet& the cpus the worker thread will be restricted to, empty if unpinned.
+   */
+  const CpuSet& cpuAffinity() const { return cpu_affinity_; }
+
+  /**
+   * Runs work() once more on the worker thread. The thread, its dispatcher, and anything
+   * associated to those, like connections, stay alive in between, and the dispatcher keeps
+   * running. May only be called after the previous round of work completed, see
+   * waitForCompletion().
+   */
+  void startNextRound();
+
+  /**
+   * Lets the worker thread run its dispatcher once the current round of work completed, until the
+   * next round or shutdown. Events handled in the meantime may update what the round produced, so
+   * call this once its results have been collected. Applies to the current round only.
+   */
+  void dispatchWhileIdle();
+
 protected:
   /**
    * Perform the actual work on the associated thread initiated by start().
@@ -37,10 +65,26 @@ protected:
   Envoy::TimeSource& time_source_;
 
 private:
+  /**
+   * Makes the worker thread check for a next round or shutdown, when it is idle.
+   */
+  void wakeUpIdleThread();
+
   std::thread thread_;
+  CpuSet cpu_affinity_;
   bool started_{};
-  std::promise<void> complete_;
-  std::promise<void> signal_thread_to_exit_;
+  Envoy::Thread::MutexBasicLockable rounds_lock_;
+  Envoy::Thread::CondVar rounds_changed_;
+  // The worker thread calls work() for each requested round, and then waits for either another
+  // round to be requested, or for shutdown() to be called. It runs its dispatcher while it waits
+  // once dispatchWhileIdle() has been called.
+  uint32_t rounds_requested_ ABSL_GUARDED_BY(rounds_lock_){0};
+  uint32_t rounds_completed_ ABSL_GUARDED_BY(rounds_lock_){0};
+  bool exit_requested_ ABSL_GUARDED_BY(rounds_lock_){false};
+  bool dispatch_while_idle_ ABSL_GUARDED_BY(rounds_lock_){false};
+  // Set while the worker thread runs its dispatcher in between rounds. Only accessed on the worker
+  // thread.
+  bool idle_{false};
   bool shutdown_{true};
 };
 
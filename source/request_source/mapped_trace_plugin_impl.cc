@@ -0,0 +1,172 @@
+#include "source/request_source/mapped_trace_plugin_impl.h"
+
+#include <algorithm>
+
+#include "nighthawk/common/exception.h"
+
+#include "external/envoy/source/common/common/lock_guard.h"
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/source/common/protobuf/utility.h"
+
+#include "source/common/request_impl.h"
+
+#include "absl/strings/str_cat.h"
+#include "fmt/format.h"
+
+namespace Nighthawk {
+
+namespace {
+// Marks generators which found all requests to be claimed.
+constexpr uint64_t kReplayDone = UINT64_MAX;
+} // namespace
+
+std::string MappedTraceRequestSourceFactory::name() const {
+  return "nighthawk.mapped-trace-request-source-plugin";
+}
+
+Envoy::ProtobufTypes::MessagePtr MappedTraceRequestSourceFactory::createEmptyConfigProto() {
+  return std::make_unique<nighthawk::request_source::MappedTraceRequestSourceConfig>();
+}
+
+RequestSourcePtr MappedTraceRequestSourceFactory::createRequestSourcePlugin(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api&,
+    Envoy::Http::RequestHeaderMapPtr header) {
+  const auto* any = Envoy::Protobuf::DynamicCastToGenerated<const Envoy::Protobuf::Any>(&message);
+  nighthawk::request_source::MappedTraceRequestSourceConfig config;
+  THROW_IF_NOT_OK(Envoy::MessageUtil::unpackTo(*any, config));
+  absl::optional<double> time_scale;
+  if (config.replay_timing()) {
+    time_scale = config.has_time_scale() ? config.time_scale().value() : 1.0;
+    if (!(time_scale.value() > 0)) {
+      throw NighthawkException("time_scale must be greater than 0");
+    }
+  }
+  const std::string key =
+      absl::StrCat(config.num_requests(), ":", time_scale.value_or(0), ":", config.file_path());
+  SharedTraceReplaySharedPtr replay;
+  {
+    Envoy::Thread::LockGuard lock_guard(replays_lock_);
+    const auto it = replays_.find(key);
+    if (it != replays_.end()) {
+      replay = it->second.lock();
+    }
+    if (replay == nullptr) {
+      // Forget the replays that all sources are done with, so that the map does not grow with each
+      // execution that replays a different trace.
+      for (auto expired = replays_.begin(); expired != replays_.end();) {
+        if (expired->second.expired()) {
+          replays_.erase(expired++);
+        } else {
+          ++expired;
+        }
+      }
+      absl::StatusOr<MappedRequestTraceSharedPtr> trace =
+          MappedRequestTrace::open(config.file_path());
+      if (!trace.ok()) {
+        throw NighthawkException(std::string(trace.status().message()));
+      }
+      if (time_scale.has_value() && !trace.value()->hasTimes()) {
+        throw NighthawkException(fmt::format(
+            "Request trace file '{}' holds no timing, which replay_timing requires",
+            config.file_path()));
+      }
+      const uint64_t total_requests =
+          config.num_requests() == 0 ? trace.value()->records() : config.num_requests();
+      replay = std::make_shared<SharedTraceReplay>(std::move(trace.value()), total_requests,
+                                                   time_scale);
+      replays_[key] = replay;
+    }
+  }
+  return std::make_unique<MappedTraceRequestSource>(std::move(replay), std::move(header));
+}
+
+REGISTER_FACTORY(MappedTraceRequestSourceFactory, RequestSourcePluginConfigFactory);
+
+MappedTraceRequestSource::MappedTraceRequestSource(SharedTraceReplaySharedPtr replay,
+                                                   Envoy::Http::RequestHeaderMapPtr header)
+    : replay_(std::move(replay)), header_(std::move(header)) {}
+
+RequestGenerator MappedTraceRequestSource::get() {
+  if (replay_->time_scale.has_value()) {
+    return [this]() -> RequestPtr {
+      const absl::optional<uint64_t> index = claimTimedRequest();
+      if (!index.has_value()) {
+        return nullptr;
+      }
+      claimed_.reset();
+      return createRequest(index.value());
+    };
+  }
+  // The generator replays the slice [next, end), and claims a new slice once it is exhausted.
+  return [this, next = uint64_t(0), end = uint64_t(0)]() mutable -> RequestPtr {
+    if (next == end) {
+      if (end == kReplayDone) {
+        return nullptr;
+      }
+      next = replay_->next_slice.fetch_add(kSliceSize, std::memory_order_relaxed);
+      if (next >= replay_->total_requests) {
+        next = end = kReplayDone;
+        return nullptr;
+      }
+      end = std::min(next + kSliceSize, replay_->total_requests);
+    }
+    return createRequest(next++);
+  };
+}
+
+RequestPtr MappedTraceRequestSource::createRequest(const uint64_t index) const {
+  const MappedRequestTrace& trace = *replay_->trace;
+  RequestTraceRecord record;
+  if (trace.records() == 0 || !trace.read(index % trace.records(), record)) {
+    ENVOY_LOG_EVERY_POW_2(error, "Skipping malformed request {} in request trace",
+                          index % std::max<uint64_t>(trace.records(), 1));
+    return nullptr;
+  }
+  Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+  Envoy::Http::HeaderMapImpl::copyFrom(*header, *header_);
+  for (const auto& field : record.headers) {
+    header->setCopy(Envoy::Http::LowerCaseString(field.first), field.second);
+  }
+  if (!record.body.has_value()) {
+    return std::make_unique<RequestImpl>(std::move(header));
+  }
+  header->setContentLength(record.body->size());
+  return std::make_unique<RequestImpl>(std::move(header),
+                                       std::make_shared<const std::string>(record.body.value()));
+}
+
+void MappedTraceRequestSource::initOnThread() {}
+void MappedTraceRequestSource::destroyOnThread() {}
+
+RequestReleaseTiming* MappedTraceRequestSource::releaseTiming() {
+  return replay_->time_scale.has_value() ? this : nullptr;
+}
+
+absl::optional<uint64_t> MappedTraceRequestSource::claimTimedRequest() {
+  if (!claimed_.has_value() && !timed_replay_done_) {
+    const uint64_t next = replay_->next_slice.fetch_add(1, std::memory_order_relaxed);
+    if (next < replay_->total_requests) {
+      claimed_ = next;
+    } else {
+      timed_replay_done_ = true;
+    }
+  }
+  return claimed_;
+}
+
+absl::optional<std::chrono::nanoseconds> MappedTraceRequestSource::nextReleaseOffset() {
+  const absl::optional<uint64_t> index = claimTimedRequest();
+  const MappedRequestTrace& trace = *replay_->trace;
+  if (!index.has_value() || trace.records() == 0) {
+    return absl::nullopt;
+  }
+  // Each pass over the trace starts at the time of the last request of the previous pass.
+  const uint64_t pass = index.value() / trace.records();
+  const std::chrono::nanoseconds recorded =
+      trace.time(index.value() % trace.records()) + pass * trace.time(trace.records() - 1);
+  return std::chrono::nanoseconds(
+      static_cast<int64_t>(recorded.count() / replay_->time_scale.value()));
+}
+
+} // namespace Nighthawk
@@ -0,0 +1,114 @@
+#pragma once
+
+// Implementation of a RequestSourceConfigFactory that makes a MappedTraceRequestSource.
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "nighthawk/request_source/request_source_plugin_config_factory.h"
+
+#include "external/envoy/source/common/common/logger.h"
+#include "external/envoy/source/common/common/thread.h"
+
+#include "api/request_source/request_source_plugin.pb.h"
+
+#include "source/request_source/request_trace.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+
+namespace Nighthawk {
+
+// Replay state shared by the request sources of all workers: the mapped trace, and the position
+// of the next slice of it that has not been claimed by a worker yet.
+struct SharedTraceReplay {
+  SharedTraceReplay(MappedRequestTraceSharedPtr trace, const uint64_t total_requests,
+                    const absl::optional<double> time_scale)
+      : trace(std::move(trace)), total_requests(total_requests), time_scale(time_scale) {}
+  const MappedRequestTraceSharedPtr trace;
+  // The number of requests to replay in total across all workers.
+  const uint64_t total_requests;
+  // Set for timed replays, which send requests at their recorded times divided by this factor.
+  const absl::optional<double> time_scale;
+  std::atomic<uint64_t> next_slice{0};
+};
+using SharedTraceReplaySharedPtr = std::shared_ptr<SharedTraceReplay>;
+
+// Request source that replays a request trace file, mapped into memory. Workers claim disjoint
+// slices of the trace from the shared replay state, so that each request in the trace is replayed
+// by a single worker, and start-up takes constant time regardless of the size of the trace.
+// Headers of a request in the trace override those of the default header. Requests with a body
+// carry a matching content length.
+// For timed replays, workers claim a single request at a time, and the source provides the time
+// at which that request is due as its release timing.
+// The RequestGenerators produced by get() are not thread safe, but generators of different
+// request sources may be used concurrently.
+class MappedTraceRequestSource : public RequestSource,
+                                 public RequestReleaseTiming,
+                                 public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
+public:
+  // Number of consecutive requests claimed at once.
+  static constexpr uint64_t kSliceSize = 64;
+
+  MappedTraceRequestSource(SharedTraceReplaySharedPtr replay,
+                           Envoy::Http::RequestHeaderMapPtr header);
+
+  RequestGenerator get() override;
+
+  // default implementation
+  void initOnThread() override;
+  void destroyOnThread() override;
+
+  RequestReleaseTiming* releaseTiming() override;
+
+  // RequestReleaseTiming
+  absl::optional<std::chrono::nanoseconds> nextReleaseOffset() override;
+
+private:
+  RequestPtr createRequest(const uint64_t index) const;
+  // Claims the next request of a timed replay, unless one has been claimed and not sent yet.
+  absl::optional<uint64_t> claimTimedRequest();
+
+  const SharedTraceReplaySharedPtr replay_;
+  Envoy::Http::RequestHeaderMapPtr header_;
+  // The request of a timed replay that is due next.
+  absl::optional<uint64_t> claimed_;
+  bool timed_replay_done_{false};
+};
+
+// Factory that creates a MappedTraceRequestSource from a MappedTraceRequestSourceConfig proto.
+// Registered as an Envoy plugin. The request sources created for the same file and number of
+// requests while earlier ones are still alive share a single mapping and replay position, which is
+// how the workers of an execution divide the trace among themselves.
+// Usage: assume you are passed an appropriate Any type object called config, an Api
+// object called api, and a default header called header. auto& config_factory =
+//     Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+//         "nighthawk.mapped-trace-request-source-plugin");
+// RequestSourcePtr plugin =
+//     config_factory.createRequestSourcePlugin(config, std::move(api), std::move(header));
+class MappedTraceRequestSourceFactory : public virtual RequestSourcePluginConfigFactory {
+public:
+  std::string name() const override;
+
+  Envoy::ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  // This implementation is thread safe. This method will error if the trace can not be mapped, or
+  // is malformed.
+  RequestSourcePtr createRequestSourcePlugin(const Envoy::Protobuf::Message& message,
+                                             Envoy::Api::Api& api,
+                                             Envoy::Http::RequestHeaderMapPtr header) override;
+
+private:
+  Envoy::Thread::MutexBasicLockable replays_lock_;
+  absl::flat_hash_map<std::string, std::weak_ptr<SharedTraceReplay>>
+      replays_ ABSL_GUARDED_BY(replays_lock_);
+};
+
+// This factory will be activated through RequestSourceFactory in factories.h
+DECLARE_FACTORY(MappedTraceRequestSourceFactory);
+
+} // namespace Nighthawk
@@ -0,0 +1,226 @@
+#include "source/request_source/reloadable_plugin_impl.h"
+
+#include <algorithm>
+
+#include "nighthawk/common/exception.h"
+
+#include "external/envoy/source/common/common/assert.h"
+#include "external/envoy/source/common/common/lock_guard.h"
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/protobuf/message_validator_impl.h"
+#include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/source/common/protobuf/utility.h"
+
+#include "source/common/request_impl.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace Nighthawk {
+
+namespace {
+
+constexpr uint32_t kDefaultMaxFileSize = 1000000;
+constexpr uint64_t kDefaultPollIntervalMs = 1000;
+
+} // namespace
+
+std::string ReloadableOptionsListRequestSourceFactory::name() const {
+  return "nighthawk.reloadable-options-list-request-source-plugin";
+}
+
+Envoy::ProtobufTypes::MessagePtr
+ReloadableOptionsListRequestSourceFactory::createEmptyConfigProto() {
+  return std::make_unique<nighthawk::request_source::ReloadableOptionsListRequestSourceConfig>();
+}
+
+RequestSourcePtr ReloadableOptionsListRequestSourceFactory::createRequestSourcePlugin(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
+    Envoy::Http::RequestHeaderMapPtr header) {
+  return createRequestSourcePluginForWorker(message, api, std::move(header), 0);
+}
+
+RequestSourcePtr ReloadableOptionsListRequestSourceFactory::createRequestSourcePluginForWorker(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
+    Envoy::Http::RequestHeaderMapPtr header, const uint32_t worker_id) {
+  const auto* any = Envoy::Protobuf::DynamicCastToGenerated<const Envoy::Protobuf::Any>(&message);
+  nighthawk::request_source::ReloadableOptionsListRequestSourceConfig config;
+  THROW_IF_NOT_OK(Envoy::MessageUtil::unpackTo(*any, config));
+  const uint32_t max_file_size =
+      config.has_max_file_size() ? config.max_file_size().value() : kDefaultMaxFileSize;
+  const std::chrono::milliseconds poll_interval(
+      PROTOBUF_GET_MS_OR_DEFAULT(config, poll_interval, kDefaultPollIntervalMs));
+  ReloadableRequestTableSharedPtr table;
+  {
+    Envoy::Thread::LockGuard lock_guard(tables_lock_);
+    table = tables_[config.file_path()].lock();
+    if (table == nullptr) {
+      table = std::make_shared<ReloadableRequestTable>(api, config.file_path(), max_file_size,
+                                                       std::move(header));
+      table->startPolling(poll_interval);
+      tables_[config.file_path()] = table;
+    }
+  }
+  return std::make_unique<ReloadableOptionsListRequestSource>(
+      std::move(table), config.num_requests(),
+      SeededRandomGeneratorImpl::seedForWorker(config.seed(), worker_id));
+}
+
+REGISTER_FACTORY(ReloadableOptionsListRequestSourceFactory, RequestSourcePluginConfigFactory);
+
+CompiledRequestTable::CompiledRequestTable(
+    const nighthawk::client::RequestOptionsList& options_list,
+    const Envoy::Http::RequestHeaderMap& header, const uint32_t generation)
+    : sampler_(AliasMethodSampler::createForOptions(options_list)), generation_(generation) {
+  for (const nighthawk::client::RequestOptions& request_options : options_list.options()) {
+    Envoy::Http::RequestHeaderMapPtr entry_header = Envoy::Http::RequestHeaderMapImpl::create();
+    Envoy::Http::HeaderMapImpl::copyFrom(*entry_header, header);
+    applyRequestOptions(request_options, *entry_header);
+    entries_.push_back({std::move(entry_header), bodyFromRequestOptions(request_options)});
+  }
+  // Without options, requests are sent with the default header.
+  if (entries_.empty()) {
+    Envoy::Http::RequestHeaderMapPtr entry_header = Envoy::Http::RequestHeaderMapImpl::create();
+    Envoy::Http::HeaderMapImpl::copyFrom(*entry_header, header);
+    entries_.push_back({std::move(entry_header), nullptr});
+  }
+}
+
+RequestPtr CompiledRequestTable::createRequest(const uint64_t random, const uint64_t position,
+                                               const uint32_t request_class) const {
+  const Entry& entry =
+      entries_[sampler_ != nullptr ? sampler_->sample(random) : position % entries_.size()];
+  Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+  Envoy::Http::HeaderMapImpl::copyFrom(*header, *entry.header);
+  return std::make_unique<RequestImpl>(std::move(header), entry.body, request_class);
+}
+
+ReloadableRequestTable::ReloadableRequestTable(Envoy::Api::Api& api, std::string file_path,
+                                               const uint32_t max_file_size,
+                                               Envoy::Http::RequestHeaderMapPtr header)
+    : api_(api), file_path_(std::move(file_path)), max_file_size_(max_file_size),
+      header_(std::move(header)) {
+  const absl::Status status = reloadIfChanged();
+  if (!status.ok()) {
+    throw NighthawkException(std::string(status.message()));
+  }
+}
+
+ReloadableRequestTable::~ReloadableRequestTable() {
+  {
+    Envoy::Thread::LockGuard guard(lock_);
+    stop_requested_ = true;
+    stop_requested_changed_.notifyAll();
+  }
+  if (poller_.joinable()) {
+    poller_.join();
+  }
+}
+
+CompiledRequestTableSharedPtr ReloadableRequestTable::current() const {
+  Envoy::Thread::LockGuard guard(lock_);
+  return current_;
+}
+
+void ReloadableRequestTable::publish(const nighthawk::client::RequestOptionsList& options_list) {
+  Envoy::Thread::LockGuard guard(lock_);
+  publishLocked(options_list);
+}
+
+void ReloadableRequestTable::publishLocked(
+    const nighthawk::client::RequestOptionsList& options_list) {
+  const uint32_t generation = current_ == nullptr ? 0 : current_->generation() + 1;
+  // Compiling validates the options, and throws before anything is replaced.
+  current_ = std::make_shared<const CompiledRequestTable>(options_list, *header_, generation);
+  generation_.store(generation, std::memory_order_release);
+  ENVOY_LOG(info, "Publishing generation {} of the request options in {}", generation,
+            file_path_);
+}
+
+absl::Status ReloadableRequestTable::reloadIfChanged() {
+  if (api_.fileSystem().fileSize(file_path_) > max_file_size_) {
+    return absl::InvalidArgumentError("file size must be less than max_file_size");
+  }
+  absl::StatusOr<std::string> contents = api_.fileSystem().fileReadToEnd(file_path_);
+  if (!contents.ok()) {
+    return contents.status();
+  }
+  Envoy::Thread::LockGuard guard(lock_);
+  if (current_ != nullptr && contents.value() == file_contents_) {
+    return absl::OkStatus();
+  }
+  nighthawk::client::RequestOptionsList options_list;
+  try {
+    // Yaml is a superset of json, so that this loads either.
+    Envoy::MessageUtil::loadFromYaml(contents.value(), options_list,
+                                     Envoy::ProtobufMessage::getStrictValidationVisitor());
+  } catch (const Envoy::EnvoyException& exception) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Failed to load request options from ", file_path_, ": ", exception.what()));
+  }
+  try {
+    publishLocked(options_list);
+  } catch (const NighthawkException& exception) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid request options in ", file_path_, ": ", exception.what()));
+  }
+  file_contents_ = std::move(contents.value());
+  return absl::OkStatus();
+}
+
+void ReloadableRequestTable::startPolling(const std::chrono::milliseconds poll_interval) {
+  ASSERT(!poller_.joinable());
+  poller_ = std::thread([this, poll_interval]() {
+    while (true) {
+      {
+        Envoy::Thread::LockGuard guard(lock_);
+        if (!stop_requested_) {
+          stop_requested_changed_.waitFor(lock_, poll_interval);
+        }
+        if (stop_requested_) {
+          return;
+        }
+      }
+      const absl::Status status = reloadIfChanged();
+      if (!status.ok()) {
+        ENVOY_LOG_EVERY_POW_2(warn, "Keeping generation {} of the request options: {}",
+                              generation(), status.message());
+      }
+    }
+  });
+}
+
+ReloadableOptionsListRequestSource::ReloadableOptionsListRequestSource(
+    ReloadableRequestTableSharedPtr table, const uint32_t num_requests, const uint64_t seed)
+    : table_(std::move(table)), num_requests_(num_requests), random_generator_(seed) {}
+
+RequestGenerator ReloadableOptionsListRequestSource::get() {
+  // The generator loops over the options of the table it holds, and starts over with the current
+  // table when a new one was published. Holding the table keeps it alive until then.
+  return [this, table = table_->current(), position = uint64_t(0),
+          generated = uint32_t(0)]() mutable -> RequestPtr {
+    if (num_requests_ != 0 && generated >= num_requests_) {
+      return nullptr;
+    }
+    generated++;
+    if (table_->generation() != table->generation()) {
+      table = table_->current();
+      position = 0;
+    }
+    return table->createRequest(random_generator_.random(), position++,
+                                std::min(table->generation(), kLabelledGenerations - 1));
+  };
+}
+
+std::vector<std::string> ReloadableOptionsListRequestSource::requestClasses() const {
+  std::vector<std::string> request_classes;
+  for (uint32_t generation = 0; generation < kLabelledGenerations - 1; generation++) {
+    request_classes.push_back(absl::StrCat("generation_", generation));
+  }
+  request_classes.push_back("later_generations");
+  return request_classes;
+}
+
+void ReloadableOptionsListRequestSource::initOnThread() {}
+void ReloadableOptionsListRequestSource::destroyOnThread() {}
+
+} // namespace Nighthawk
@@ -0,0 +1,195 @@
+#pragma once
+
+// Implementation of a RequestSourceConfigFactory that makes a ReloadableOptionsListRequestSource.
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "envoy/api/api.h"
+#include "envoy/registry/registry.h"
+
+#include "nighthawk/request_source/request_source_plugin_config_factory.h"
+
+#include "external/envoy/source/common/common/logger.h"
+#include "external/envoy/source/common/common/thread.h"
+
+#include "api/client/options.pb.h"
+#include "api/request_source/request_source_plugin.pb.h"
+
+#include "source/common/seeded_random_generator_impl.h"
+#include "source/request_source/request_options_list_plugin_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+
+namespace Nighthawk {
+
+// A RequestOptionsList compiled for generating requests: the overrides of each of the options are
+// applied to the default header up front, so that creating a request only copies a header.
+// Immutable, so that it can be read by the request sources of all workers at once.
+class CompiledRequestTable {
+public:
+  // @param options_list the options to compile.
+  // @param header the default header, which the options override.
+  // @param generation the number of tables that were published before this one.
+  // @throw NighthawkException when the options are invalid, e.g. when a weight is not positive.
+  CompiledRequestTable(const nighthawk::client::RequestOptionsList& options_list,
+                       const Envoy::Http::RequestHeaderMap& header, const uint32_t generation);
+
+  // @param random random bits, used to sample weighted options.
+  // @param position the number of requests created from this table before, used to loop over
+  // options without weights.
+  // @param request_class the class to assign to the request.
+  // @return RequestPtr a request created from the sampled or next options.
+  RequestPtr createRequest(const uint64_t random, const uint64_t position,
+                           const uint32_t request_class) const;
+
+  uint32_t generation() const { return generation_; }
+
+private:
+  struct Entry {
+    Envoy::Http::RequestHeaderMapPtr header;
+    BodyPtr body;
+  };
+
+  std::vector<Entry> entries_;
+  // Set when the options are weighted.
+  std::unique_ptr<const AliasMethodSampler> sampler_;
+  const uint32_t generation_;
+};
+using CompiledRequestTableSharedPtr = std::shared_ptr<const CompiledRequestTable>;
+
+// Request table shared by the request sources of all workers, which is replaced whenever the file
+// it was loaded from changes. Readers hold on to the table they use, and check whether a newer one
+// was published through an atomic generation, without taking locks. Only picking up a new table
+// takes the lock, which is rare as reloads are. Tables are reference counted, so that a replaced
+// table is freed as soon as the last reader moved on from it.
+// A thread polls the file for changes while the table is alive.
+class ReloadableRequestTable : public Envoy::Logger::Loggable<Envoy::Logger::Id::main> {
+public:
+  // Loads the file, and publishes it as generation 0. Throws when the file can not be loaded.
+  // @param api api for reading the file.
+  // @param file_path path of a file holding a RequestOptionsList in json or yaml format.
+  // @param max_file_size the largest file that will be loaded, in bytes.
+  // @param header the default header, which the options override.
+  ReloadableRequestTable(Envoy::Api::Api& api, std::string file_path, const uint32_t max_file_size,
+                         Envoy::Http::RequestHeaderMapPtr header);
+  ~ReloadableRequestTable();
+
+  // Thread safe.
+  // @return CompiledRequestTableSharedPtr the most recently published table.
+  CompiledRequestTableSharedPtr current() const;
+
+  // Thread safe, and lock free.
+  // @return uint32_t the generation of the most recently published table.
+  uint32_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+  // Compiles options and publishes them as the next generation. Thread safe. Allows updates from
+  // sources other than the file.
+  // @param options_list the options to publish.
+  // @throw NighthawkException when the options are invalid, which leaves the current table in
+  // place.
+  void publish(const nighthawk::client::RequestOptionsList& options_list);
+
+  // Loads the file and publishes it when its contents changed since it was last loaded. Thread
+  // safe. A file that fails to load, or holds invalid options, leaves the current table in place.
+  // @return absl::Status whether the file could be loaded.
+  absl::Status reloadIfChanged();
+
+  // Starts a thread that calls reloadIfChanged() periodically until this object is destroyed.
+  // @param poll_interval time between the checks.
+  void startPolling(const std::chrono::milliseconds poll_interval);
+
+private:
+  // Compiles the options, and only publishes them when they are valid.
+  void publishLocked(const nighthawk::client::RequestOptionsList& options_list)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Envoy::Api::Api& api_;
+  const std::string file_path_;
+  const uint32_t max_file_size_;
+  const Envoy::Http::RequestHeaderMapPtr header_;
+  mutable Envoy::Thread::MutexBasicLockable lock_;
+  CompiledRequestTableSharedPtr current_ ABSL_GUARDED_BY(lock_);
+  // Generation of current_, which readers poll to learn about new tables.
+  std::atomic<uint32_t> generation_{0};
+  std::string file_contents_ ABSL_GUARDED_BY(lock_);
+  Envoy::Thread::CondVar stop_requested_changed_;
+  bool stop_requested_ ABSL_GUARDED_BY(lock_){false};
+  std::thread poller_;
+};
+using ReloadableRequestTableSharedPtr = std::shared_ptr<ReloadableRequestTable>;
+
+// Request source that generates requests from a ReloadableRequestTable, switching to a newly
+// published table at the next request. Requests are classified by the generation of the table
+// they were created from, so that their latencies are broken down per generation. Generations past
+// kLabelledGenerations - 2 share the last class.
+// The RequestGenerator produced by get() is not thread safe, but generators of different request
+// sources may be used concurrently.
+class ReloadableOptionsListRequestSource : public RequestSource {
+public:
+  // Number of generations that get a request class of their own, including the class shared by
+  // the generations past them.
+  static constexpr uint32_t kLabelledGenerations = 16;
+
+  // @param table the shared table.
+  // @param num_requests the number of requests to generate. 0 means it is unlimited.
+  // @param seed seed for sampling weighted options.
+  ReloadableOptionsListRequestSource(ReloadableRequestTableSharedPtr table,
+                                     const uint32_t num_requests, const uint64_t seed);
+
+  RequestGenerator get() override;
+  std::vector<std::string> requestClasses() const override;
+
+  // default implementation
+  void initOnThread() override;
+  void destroyOnThread() override;
+
+private:
+  const ReloadableRequestTableSharedPtr table_;
+  const uint32_t num_requests_;
+  SeededRandomGeneratorImpl random_generator_;
+};
+
+// Factory that creates a ReloadableOptionsListRequestSource from a
+// ReloadableOptionsListRequestSourceConfig proto. Registered as an Envoy plugin. The request
+// sources created for the same file while earlier ones are still alive share a single table, and
+// thereby see the same generations. The default header of the first of those request sources is
+// the one the options override.
+// Usage: assume you are passed an appropriate Any type object called config, an Api
+// object called api, and a default header called header. auto& config_factory =
+//     Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+//         "nighthawk.reloadable-options-list-request-source-plugin");
+// RequestSourcePtr plugin =
+//     config_factory.createRequestSourcePlugin(config, std::move(api), std::move(header));
+class ReloadableOptionsListRequestSourceFactory : public virtual RequestSourcePluginConfigFactory {
+public:
+  std::string name() const override;
+
+  Envoy::ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  // This implementation is thread safe. This method will error if the file can not be loaded.
+  RequestSourcePtr createRequestSourcePlugin(const Envoy::Protobuf::Message& message,
+                                             Envoy::Api::Api& api,
+                                             Envoy::Http::RequestHeaderMapPtr header) override;
+
+  // Seeds the sampling of weighted options from the seed in the config and |worker_id|.
+  RequestSourcePtr createRequestSourcePluginForWorker(const Envoy::Protobuf::Message& message,
+                                                      Envoy::Api::Api& api,
+                                                      Envoy::Http::RequestHeaderMapPtr header,
+                                                      const uint32_t worker_id) override;
+
+private:
+  Envoy::Thread::MutexBasicLockable tables_lock_;
+  absl::flat_hash_map<std::string, std::weak_ptr<ReloadableRequestTable>>
+      tables_ ABSL_GUARDED_BY(tables_lock_);
+};
+
+// This factory will be activated through RequestSourceFactory in factories.h
+DECLARE_FACTORY(ReloadableOptionsListRequestSourceFactory);
+
+} // namespace Nighthawk
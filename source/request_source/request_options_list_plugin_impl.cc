@@ -1,7 +1,13 @@
 #include "source/request_source/request_options_list_plugin_impl.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <numeric>
 
+#include "nighthawk/common/exception.h"
+
+#include "external/envoy/source/common/common/assert.h"
 #include "external/envoy/source/common/protobuf/message_validator_impl.h"
 #include "external/envoy/source/common/protobuf/protobuf.h"
 #include "external/envoy/source/common/protobuf/utility.h"
@@ -12,6 +18,9 @@
 #include "source/common/request_impl.h"
 #include "source/common/request_source_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+
 namespace Nighthawk {
 std::string FileBasedOptionsListRequestSourceFactory::name() const {
   return "nighthawk.file-based-request-source-plugin";
@@ -25,6 +34,12 @@ FileBasedOptionsListRequestSourceFactory::createEmptyConfigProto() {
 RequestSourcePtr FileBasedOptionsListRequestSourceFactory::createRequestSourcePlugin(
     const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
     Envoy::Http::RequestHeaderMapPtr header) {
+  return createRequestSourcePluginForWorker(message, api, std::move(header), 0);
+}
+
+RequestSourcePtr FileBasedOptionsListRequestSourceFactory::createRequestSourcePluginForWorker(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
+    Envoy::Http::RequestHeaderMapPtr header, const uint32_t worker_id) {
   const auto* any = Envoy::Protobuf::DynamicCastToGenerated<const Envoy::Protobuf::Any>(&message);
   nighthawk::request_source::FileBasedOptionsListRequestSourceConfig config;
   Envoy::MessageUtil util;
@@ -41,8 +56,9 @@ RequestSourcePtr FileBasedOptionsListRequestSourceFactory::createRequestSourcePl
                                       Envoy::ProtobufMessage::getStrictValidationVisitor(), api));
   }
   auto loaded_list_ptr = std::make_unique<const nighthawk::client::RequestOptionsList>(loaded_list);
-  return std::make_unique<OptionsListRequestSource>(config.num_requests(), std::move(header),
-                                                    std::move(loaded_list_ptr));
+  return std::make_unique<OptionsListRequestSource>(
+      config.num_requests(), std::move(header), std::move(loaded_list_ptr),
+      SeededRandomGeneratorImpl::seedForWorker(config.seed(), worker_id));
 }
 
 REGISTER_FACTORY(FileBasedOptionsListRequestSourceFactory, RequestSourcePluginConfigFactory);
@@ -56,29 +72,167 @@ Envoy::ProtobufTypes::MessagePtr InLineOptionsListRequestSourceFactory::createEm
 }
 
 RequestSourcePtr InLineOptionsListRequestSourceFactory::createRequestSourcePlugin(
-    const Envoy::Protobuf::Message& message, Envoy::Api::Api&,
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
     Envoy::Http::RequestHeaderMapPtr header) {
+  return createRequestSourcePluginForWorker(message, api, std::move(header), 0);
+}
+
+RequestSourcePtr InLineOptionsListRequestSourceFactory::createRequestSourcePluginForWorker(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api&,
+    Envoy::Http::RequestHeaderMapPtr header, const uint32_t worker_id) {
   const auto* any = Envoy::Protobuf::DynamicCastToGenerated<const Envoy::Protobuf::Any>(&message);
   nighthawk::request_source::InLineOptionsListRequestSourceConfig config;
   THROW_IF_NOT_OK(Envoy::MessageUtil::unpackTo(*any, config));
   auto loaded_list_ptr =
       std::make_unique<const nighthawk::client::RequestOptionsList>(config.options_list());
-  return std::make_unique<OptionsListRequestSource>(config.num_requests(), std::move(header),
-                                                    std::move(loaded_list_ptr));
+  return std::make_unique<OptionsListRequestSource>(
+      config.num_requests(), std::move(header), std::move(loaded_list_ptr),
+      SeededRandomGeneratorImpl::seedForWorker(config.seed(), worker_id));
 }
 
 REGISTER_FACTORY(InLineOptionsListRequestSourceFactory, RequestSourcePluginConfigFactory);
 
+AliasMethodSampler::AliasMethodSampler(const std::vector<double>& weights)
+    : thresholds_(weights.size()), aliases_(weights.size()) {
+  ASSERT(!weights.empty());
+  for (uint32_t i = 0; i < weights.size(); i++) {
+    if (!std::isfinite(weights[i]) || weights[i] <= 0) {
+      throw NighthawkException(
+          absl::StrCat("Weight ", i, " must be finite and positive, got: ", weights[i]));
+    }
+  }
+  const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+  if (!std::isfinite(total)) {
+    throw NighthawkException("The weights must add up to a finite total");
+  }
+  // Scale the weights so that they average to 1, and split the columns into those that hold less
+  // than their share and those that hold more.
+  std::vector<double> scaled(weights.size());
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i = 0; i < weights.size(); i++) {
+    scaled[i] = weights[i] * weights.size() / total;
+    aliases_[i] = i;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+  // Fill up each column that holds less than its share from one that holds more.
+  while (!small.empty() && !large.empty()) {
+    const uint32_t less = small.back();
+    small.pop_back();
+    const uint32_t more = large.back();
+    thresholds_[less] = static_cast<uint64_t>(scaled[less] * 4294967296.0);
+    aliases_[less] = more;
+    scaled[more] -= 1.0 - scaled[less];
+    if (scaled[more] < 1.0) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+  // What remains holds its share, up to rounding errors.
+  for (const uint32_t i : small) {
+    thresholds_[i] = uint64_t(1) << 32;
+  }
+  for (const uint32_t i : large) {
+    thresholds_[i] = uint64_t(1) << 32;
+  }
+}
+
+std::unique_ptr<const AliasMethodSampler>
+AliasMethodSampler::createForOptions(const nighthawk::client::RequestOptionsList& options_list) {
+  const bool weighted = std::any_of(
+      options_list.options().begin(), options_list.options().end(),
+      [](const nighthawk::client::RequestOptions& options) { return options.has_weight(); });
+  if (!weighted) {
+    return nullptr;
+  }
+  std::vector<double> weights;
+  weights.reserve(options_list.options_size());
+  for (int i = 0; i < options_list.options_size(); i++) {
+    const nighthawk::client::RequestOptions& options = options_list.options(i);
+    const double weight = options.has_weight() ? options.weight().value() : 1.0;
+    // Option lists are not always validated against the proto constraints, e.g. when reloaded
+    // from a file.
+    if (!std::isfinite(weight) || weight <= 0) {
+      throw NighthawkException(absl::StrCat("The weight of request options ", i,
+                                            " must be finite and positive, got: ", weight));
+    }
+    weights.push_back(weight);
+  }
+  return std::make_unique<const AliasMethodSampler>(weights);
+}
+
+uint32_t AliasMethodSampler::sample(const uint64_t random) const {
+  const uint32_t column = ((random >> 32) * thresholds_.size()) >> 32;
+  return (random & 0xffffffff) < thresholds_[column] ? column : aliases_[column];
+}
+
+void applyRequestOptions(const nighthawk::client::RequestOptions& request_options,
+                         Envoy::Http::RequestHeaderMap& header) {
+  header.setMethod(envoy::config::core::v3::RequestMethod_Name(request_options.request_method()));
+  uint32_t request_body_length = 0;
+  if (!request_options.json_body().empty()) {
+    request_body_length = request_options.json_body().size();
+  } else {
+    request_body_length = request_options.request_body_size().value();
+  }
+  const uint32_t content_length = request_body_length;
+
+  if (content_length > 0) {
+    header.setContentLength(
+        content_length); // Content length is used later in stream_decoder to populate the body
+  }
+  // If json_body is provided, we should set the ContentType as application/json.
+  if (!request_options.json_body().empty()) {
+    header.setContentType("application/json");
+  }
+  for (const envoy::config::core::v3::HeaderValueOption& option_header :
+       request_options.request_headers()) {
+    auto lower_case_key = Envoy::Http::LowerCaseString(std::string(option_header.header().key()));
+    header.setCopy(lower_case_key, std::string(option_header.header().value()));
+  }
+}
+
+BodyPtr bodyFromRequestOptions(const nighthawk::client::RequestOptions& request_options) {
+  if (request_options.json_body().empty()) {
+    return nullptr;
+  }
+  return std::make_shared<const std::string>(request_options.json_body());
+}
+
 OptionsListRequestSource::OptionsListRequestSource(
     const uint32_t total_requests, Envoy::Http::RequestHeaderMapPtr header,
-    std::unique_ptr<const nighthawk::client::RequestOptionsList> options_list)
+    std::unique_ptr<const nighthawk::client::RequestOptionsList> options_list,
+    const uint64_t seed)
     : header_(std::move(header)), options_list_(std::move(options_list)),
-      total_requests_(total_requests) {}
+      total_requests_(total_requests), seed_(seed) {
+  sampler_ = AliasMethodSampler::createForOptions(*options_list_);
+  for (const nighthawk::client::RequestOptions& request_options : options_list_->options()) {
+    option_bodies_.push_back(bodyFromRequestOptions(request_options));
+  }
+  if (options_list_->options_size() > 1) {
+    absl::flat_hash_map<std::string, uint32_t> classes_by_name;
+    for (int i = 0; i < options_list_->options_size(); i++) {
+      const std::string& name = options_list_->options(i).name();
+      auto it = classes_by_name
+                    .try_emplace(name.empty() ? absl::StrCat("options_", i) : name,
+                                 request_classes_.size())
+                    .first;
+      if (it->second == request_classes_.size()) {
+        request_classes_.push_back(it->first);
+      }
+      option_classes_.push_back(it->second);
+    }
+  }
+}
 
 RequestGenerator OptionsListRequestSource::get() {
   request_count_.push_back(0);
   uint32_t& lambda_counter = request_count_.back();
-  RequestGenerator request_generator = [this, lambda_counter]() mutable -> RequestPtr {
+  random_generators_.push_back(std::make_unique<SeededRandomGeneratorImpl>(
+      SeededRandomGeneratorImpl::seedForWorker(seed_, random_generators_.size())));
+  SeededRandomGeneratorImpl* random_generator = random_generators_.back().get();
+  RequestGenerator request_generator = [this, lambda_counter,
+                                        random_generator]() mutable -> RequestPtr {
     // Initialize the header with the values from the default header.
     Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
     Envoy::Http::HeaderMapImpl::copyFrom(*header, *header_);
@@ -92,35 +246,18 @@ RequestGenerator OptionsListRequestSource::get() {
       return std::make_unique<RequestImpl>(std::move(header));
     }
 
-    // Increment the counter and get the request_option from the list for the current iteration.
-    const uint32_t index = lambda_counter % options_list_->options_size();
-    nighthawk::client::RequestOptions request_option = options_list_->options().at(index);
+    // Increment the counter and get the request_option from the list for the current iteration,
+    // or sample it when the options are weighted.
+    const uint32_t index = sampler_ != nullptr
+                               ? sampler_->sample(random_generator->random())
+                               : lambda_counter % options_list_->options_size();
+    const nighthawk::client::RequestOptions& request_option = options_list_->options().at(index);
     ++lambda_counter;
 
     // Override the default values with the values from the request_option
-    header->setMethod(envoy::config::core::v3::RequestMethod_Name(request_option.request_method()));
-    uint32_t request_body_length = 0;
-    if (!request_option.json_body().empty()) {
-      request_body_length = request_option.json_body().size();
-    } else {
-      request_body_length = request_option.request_body_size().value();
-    }
-    const uint32_t content_length = request_body_length;
-
-    if (content_length > 0) {
-      header->setContentLength(
-          content_length); // Content length is used later in stream_decoder to populate the body
-    }
-    // If json_body is provided, we should set the ContentType as application/json.
-    if (!request_option.json_body().empty()) {
-      header->setContentType("application/json");
-    }
-    for (const envoy::config::core::v3::HeaderValueOption& option_header :
-         request_option.request_headers()) {
-      auto lower_case_key = Envoy::Http::LowerCaseString(std::string(option_header.header().key()));
-      header->setCopy(lower_case_key, std::string(option_header.header().value()));
-    }
-    return std::make_unique<RequestImpl>(std::move(header), request_option.json_body());
+    applyRequestOptions(request_option, *header);
+    return std::make_unique<RequestImpl>(std::move(header), option_bodies_[index],
+                                         option_classes_.empty() ? 0 : option_classes_[index]);
   };
   return request_generator;
 }
@@ -2,6 +2,10 @@
 
 // Implementations of RequestSourceConfigFactories that make a OptionsListRequestSource.
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "envoy/registry/registry.h"
 
 #include "nighthawk/request_source/request_source_plugin_config_factory.h"
@@ -12,10 +16,50 @@
 #include "api/client/options.pb.h"
 #include "api/request_source/request_source_plugin.pb.h"
 
+#include "source/common/seeded_random_generator_impl.h"
 #include "source/common/uri_impl.h"
 
 namespace Nighthawk {
 
+// Samples indices in proportion to their weights in constant time, using Vose's alias method.
+// Each index owns a column holding a threshold and an alias. A sample picks a column uniformly,
+// and yields its index when a second uniform draw falls below the threshold, or the alias
+// otherwise. Building the table takes linear time.
+class AliasMethodSampler {
+public:
+  // @param weights the relative weights of the indices to sample. Must be non-empty.
+  // @throw NighthawkException when a weight is not finite and positive, or the weights add up to
+  // infinity.
+  explicit AliasMethodSampler(const std::vector<double>& weights);
+
+  // @param options_list the options to sample. Options without a weight weigh 1.
+  // @return std::unique_ptr<const AliasMethodSampler> a sampler over the options, or nullptr when
+  // none of them carries a weight.
+  // @throw NighthawkException when a weight is not finite and positive.
+  static std::unique_ptr<const AliasMethodSampler>
+  createForOptions(const nighthawk::client::RequestOptionsList& options_list);
+
+  // @param random 64 uniformly distributed random bits. The high half picks the column, and the low
+  // half decides between its index and its alias.
+  // @return uint32_t the sampled index.
+  uint32_t sample(const uint64_t random) const;
+
+private:
+  // Probabilities of keeping the index of a column, scaled to 2^32.
+  std::vector<uint64_t> thresholds_;
+  std::vector<uint32_t> aliases_;
+};
+
+// Overrides the method, content length, content type and headers of a request header with those
+// of request options.
+void applyRequestOptions(const nighthawk::client::RequestOptions& request_options,
+                         Envoy::Http::RequestHeaderMap& header);
+
+// @param request_options the options to take the json body from.
+// @return BodyPtr a copy of the json body of the options, to be shared by the requests created
+// from them. nullptr when the options have no json body.
+BodyPtr bodyFromRequestOptions(const nighthawk::client::RequestOptions& request_options);
+
 // Sample Request Source for small RequestOptionsLists. Loads a copy of the RequestOptionsList in
 // memory and replays them.
 // @param total_requests The number of requests the requestGenerator produced by get() will
@@ -27,15 +71,23 @@ namespace Nighthawk {
 // overwrite values in the default header, and create new requests. if total_requests is greater
 // than the length of options_list, it will loop. If the options_list_ is empty, we just return the
 // default header. This is not thread safe.
+// When any of the options carries a weight, the RequestGenerator samples the options to use for
+// each request in proportion to their weights instead of looping over them in order.
+// @param seed seed for sampling weighted options. Each RequestGenerator produced by get() draws
+// from its own sequence derived from it.
+// When the list holds more than one option, requests are classified by the name of the options
+// they were created from, so that their latencies can be broken down per option.
 class OptionsListRequestSource : public RequestSource {
 public:
   OptionsListRequestSource(
       const uint32_t total_requests, Envoy::Http::RequestHeaderMapPtr header,
-      std::unique_ptr<const nighthawk::client::RequestOptionsList> options_list);
+      std::unique_ptr<const nighthawk::client::RequestOptionsList> options_list,
+      const uint64_t seed = 0);
 
   // This get function is not thread safe, because multiple threads calling get simultaneously will
   // result in a collision.
   RequestGenerator get() override;
+  std::vector<std::string> requestClasses() const override { return request_classes_; }
 
   // default implementation
   void initOnThread() override;
@@ -46,6 +98,15 @@ private:
   std::unique_ptr<const nighthawk::client::RequestOptionsList> options_list_;
   std::vector<uint32_t> request_count_;
   const uint32_t total_requests_;
+  const uint64_t seed_;
+  // Set when the options are weighted.
+  std::unique_ptr<const AliasMethodSampler> sampler_;
+  std::vector<std::unique_ptr<SeededRandomGeneratorImpl>> random_generators_;
+  std::vector<std::string> request_classes_;
+  // The request class of each option in the list.
+  std::vector<uint32_t> option_classes_;
+  // The body of each option in the list.
+  std::vector<BodyPtr> option_bodies_;
 };
 
 // Factory that creates a OptionsListRequestSource from a FileBasedOptionsListRequestSourceConfig
@@ -72,6 +133,12 @@ public:
                                              Envoy::Api::Api& api,
                                              Envoy::Http::RequestHeaderMapPtr header) override;
 
+  // Seeds the sampling of weighted options from the seed in the config and |worker_id|.
+  RequestSourcePtr createRequestSourcePluginForWorker(const Envoy::Protobuf::Message& message,
+                                                      Envoy::Api::Api& api,
+                                                      Envoy::Http::RequestHeaderMapPtr header,
+                                                      const uint32_t worker_id) override;
+
 private:
   Envoy::Thread::MutexBasicLockable file_lock_;
 };
@@ -101,6 +168,12 @@ public:
   RequestSourcePtr createRequestSourcePlugin(const Envoy::Protobuf::Message& message,
                                              Envoy::Api::Api& api,
                                              Envoy::Http::RequestHeaderMapPtr header) override;
+
+  // Seeds the sampling of weighted options from the seed in the config and |worker_id|.
+  RequestSourcePtr createRequestSourcePluginForWorker(const Envoy::Protobuf::Message& message,
+                                                      Envoy::Api::Api& api,
+                                                      Envoy::Http::RequestHeaderMapPtr header,
+                                                      const uint32_t worker_id) override;
 };
 
 // This factory will be activated through RequestSourceFactory in factories.h
@@ -0,0 +1,284 @@
+#include "source/request_source/request_template.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/optional.h"
+
+namespace Nighthawk {
+
+namespace {
+
+constexpr double kDefaultZipfianExponent = 0.99;
+
+// log1p(x) / x, accurate for x close to 0.
+double helper1(const double x) {
+  if (std::abs(x) > 1e-8) {
+    return std::log1p(x) / x;
+  }
+  return 1 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+// expm1(x) / x, accurate for x close to 0.
+double helper2(const double x) {
+  if (std::abs(x) > 1e-8) {
+    return std::expm1(x) / x;
+  }
+  return 1 + x * 0.5 * (1 + x / 3.0 * (1 + 0.25 * x));
+}
+
+// Parses a key bound, which is a non-negative integer, possibly in exponent notation.
+absl::optional<uint64_t> parseKey(absl::string_view text) {
+  uint64_t value;
+  if (absl::SimpleAtoi(text, &value)) {
+    return value;
+  }
+  double double_value;
+  if (absl::SimpleAtod(text, &double_value) && double_value >= 0 &&
+      double_value < 18446744073709551616.0 && std::floor(double_value) == double_value) {
+    return static_cast<uint64_t>(double_value);
+  }
+  return absl::nullopt;
+}
+
+void appendUuid(uint64_t high, uint64_t low, std::string& output) {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  // Version 4, and the variant of RFC 4122.
+  high = (high & 0xffffffffffff0fffULL) | 0x0000000000004000ULL;
+  low = (low & 0x3fffffffffffffffULL) | 0x8000000000000000ULL;
+  char uuid[36];
+  size_t position = 0;
+  for (int i = 0; i < 32; i++) {
+    if (i == 8 || i == 12 || i == 16 || i == 20) {
+      uuid[position++] = '-';
+    }
+    const uint64_t word = i < 16 ? high : low;
+    uuid[position++] = kHexDigits[(word >> (60 - 4 * (i % 16))) & 0xf];
+  }
+  output.append(uuid, sizeof(uuid));
+}
+
+} // namespace
+
+ZipfianDistribution::ZipfianDistribution(const uint64_t n, const double exponent)
+    : n_(n), exponent_(exponent), h_integral_x1_(hIntegral(1.5) - 1.0),
+      h_integral_n_(hIntegral(static_cast<double>(n) + 0.5)),
+      s_(2 - hIntegralInverse(hIntegral(2.5) - h(2))) {}
+
+uint64_t ZipfianDistribution::sample(Envoy::Random::RandomGenerator& random) const {
+  while (true) {
+    const double uniform = (random.random() >> 11) * 0x1.0p-53;
+    // Uniformly distributed over (h_integral_x1_, h_integral_n_].
+    const double u = h_integral_n_ + uniform * (h_integral_x1_ - h_integral_n_);
+    const double x = hIntegralInverse(u);
+    uint64_t k = x + 0.5 < 1 ? 1 : static_cast<uint64_t>(x + 0.5);
+    if (k > n_) {
+      k = n_;
+    }
+    if (k - x <= s_ || u >= hIntegral(k + 0.5) - h(k)) {
+      return k;
+    }
+  }
+}
+
+double ZipfianDistribution::h(const double x) const { return std::exp(-exponent_ * std::log(x)); }
+
+double ZipfianDistribution::hIntegral(const double x) const {
+  const double log_x = std::log(x);
+  return helper2((1 - exponent_) * log_x) * log_x;
+}
+
+double ZipfianDistribution::hIntegralInverse(const double x) const {
+  double t = x * (1 - exponent_);
+  if (t < -1) {
+    t = -1;
+  }
+  return std::exp(helper1(t) * x);
+}
+
+absl::StatusOr<RequestTemplateSharedPtr>
+RequestTemplate::compile(const std::vector<std::pair<std::string, std::string>>& fields) {
+  // Not via make_shared, the constructor is private.
+  std::shared_ptr<RequestTemplate> request_template(new RequestTemplate());
+  for (const auto& field : fields) {
+    const absl::Status status = request_template->compileField(field.first, field.second);
+    if (!status.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid template for ", field.first, ": ", status.message()));
+    }
+  }
+  return request_template;
+}
+
+absl::Status RequestTemplate::compileField(const std::string& name, absl::string_view text) {
+  Field field{Envoy::Http::LowerCaseString(name), static_cast<uint32_t>(segments_.size()), 0};
+  const auto append_literal = [this, &field](absl::string_view literal) {
+    if (segments_.size() > field.begin && segments_.back().op == Op::Literal) {
+      segments_.back().length += literal.size();
+    } else {
+      Segment segment{Op::Literal};
+      segment.offset = literals_.size();
+      segment.length = literal.size();
+      segments_.push_back(segment);
+    }
+    literals_.append(literal.data(), literal.size());
+  };
+  size_t i = 0;
+  while (i < text.size()) {
+    if (text[i] == '{' && i + 1 < text.size() && text[i + 1] == '{') {
+      append_literal("{");
+      i += 2;
+    } else if (text[i] == '}' && i + 1 < text.size() && text[i + 1] == '}') {
+      append_literal("}");
+      i += 2;
+    } else if (text[i] == '{') {
+      const size_t close = text.find('}', i + 1);
+      if (close == absl::string_view::npos) {
+        return absl::InvalidArgumentError(absl::StrCat("unterminated variable in '", text, "'"));
+      }
+      const absl::Status status = compileVariable(text.substr(i + 1, close - i - 1));
+      if (!status.ok()) {
+        return status;
+      }
+      i = close + 1;
+    } else if (text[i] == '}') {
+      return absl::InvalidArgumentError(absl::StrCat("unmatched '}' in '", text, "'"));
+    } else {
+      const size_t next = std::min(text.find_first_of("{}", i), text.size());
+      append_literal(text.substr(i, next - i));
+      i = next;
+    }
+  }
+  field.end = segments_.size();
+  fields_.push_back(std::move(field));
+  return absl::OkStatus();
+}
+
+absl::Status RequestTemplate::compileVariable(absl::string_view variable) {
+  const std::vector<absl::string_view> parts = absl::StrSplit(variable, ':');
+  const absl::string_view name = parts[0];
+  Segment segment{Op::Literal};
+  if (name == "uuid" || name == "counter" || name == "timestamp") {
+    if (parts.size() != 1) {
+      return absl::InvalidArgumentError(absl::StrCat("{", name, "} takes no arguments"));
+    }
+    segment.op = name == "uuid" ? Op::Uuid : name == "counter" ? Op::Counter : Op::Timestamp;
+    uses_uuid_ = uses_uuid_ || segment.op == Op::Uuid;
+    uses_timestamp_ = uses_timestamp_ || segment.op == Op::Timestamp;
+    segments_.push_back(segment);
+    return absl::OkStatus();
+  }
+  if (name != "rand" && name != "zipf" && name != "seq") {
+    return absl::InvalidArgumentError(absl::StrCat("unknown variable '", variable, "'"));
+  }
+  if (parts.size() != 2 && !(name == "zipf" && parts.size() == 3)) {
+    return absl::InvalidArgumentError(absl::StrCat("malformed variable '", variable, "'"));
+  }
+  const std::vector<absl::string_view> bounds = absl::StrSplit(parts[1], "..");
+  const absl::optional<uint64_t> min = bounds.size() == 2 ? parseKey(bounds[0]) : absl::nullopt;
+  const absl::optional<uint64_t> max = bounds.size() == 2 ? parseKey(bounds[1]) : absl::nullopt;
+  if (!min.has_value() || !max.has_value() || min.value() > max.value()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("expected a range of keys such as 1..1000 in '", variable, "'"));
+  }
+  segment.min = min.value();
+  segment.span = max.value() - min.value();
+  if (name == "rand") {
+    segment.op = Op::Uniform;
+  } else if (name == "seq") {
+    segment.op = Op::Sequential;
+    segment.index = sequences_++;
+  } else {
+    double exponent = kDefaultZipfianExponent;
+    if (parts.size() == 3 &&
+        (!absl::SimpleAtod(parts[2], &exponent) || !std::isfinite(exponent) || exponent <= 0)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("expected a positive exponent in '", variable, "'"));
+    }
+    segment.op = Op::Zipfian;
+    segment.index = zipfian_distributions_.size();
+    zipfian_distributions_.emplace_back(
+        segment.span == UINT64_MAX ? UINT64_MAX : segment.span + 1, exponent);
+  }
+  segments_.push_back(segment);
+  return absl::OkStatus();
+}
+
+RequestTemplateRenderer::RequestTemplateRenderer(RequestTemplateSharedPtr request_template,
+                                                 Envoy::Random::RandomGenerator& random,
+                                                 Envoy::TimeSource& time_source)
+    : template_(std::move(request_template)), random_(random), time_source_(time_source),
+      sequence_positions_(template_->sequences_) {
+  for (const RequestTemplate::Segment& segment : template_->segments_) {
+    if (segment.op == RequestTemplate::Op::Sequential) {
+      sequence_positions_[segment.index] = drawKey(segment.span);
+    }
+  }
+}
+
+uint64_t RequestTemplateRenderer::drawKey(const uint64_t span) {
+  if (span == UINT64_MAX) {
+    return random_.random();
+  }
+  // Scales a random 64 bit value to 0..span, which avoids the bias of a modulo.
+  return absl::Uint128High64(absl::uint128(random_.random()) * (span + 1));
+}
+
+void RequestTemplateRenderer::render(Envoy::Http::RequestHeaderMap& header) {
+  using Op = RequestTemplate::Op;
+  const uint64_t counter = counter_++;
+  uint64_t uuid_high = 0;
+  uint64_t uuid_low = 0;
+  if (template_->uses_uuid_) {
+    uuid_high = random_.random();
+    uuid_low = random_.random();
+  }
+  int64_t timestamp = 0;
+  if (template_->uses_timestamp_) {
+    timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    time_source_.systemTime().time_since_epoch())
+                    .count();
+  }
+  for (const RequestTemplate::Field& field : template_->fields_) {
+    buffer_.clear();
+    for (uint32_t i = field.begin; i < field.end; i++) {
+      const RequestTemplate::Segment& segment = template_->segments_[i];
+      switch (segment.op) {
+      case Op::Literal:
+        buffer_.append(template_->literals_.data() + segment.offset, segment.length);
+        break;
+      case Op::Uuid:
+        appendUuid(uuid_high, uuid_low, buffer_);
+        break;
+      case Op::Counter:
+        absl::StrAppend(&buffer_, counter);
+        break;
+      case Op::Timestamp:
+        absl::StrAppend(&buffer_, timestamp);
+        break;
+      case Op::Uniform:
+        absl::StrAppend(&buffer_, segment.min + drawKey(segment.span));
+        break;
+      case Op::Zipfian:
+        absl::StrAppend(&buffer_, segment.min - 1 +
+                                      template_->zipfian_distributions_[segment.index].sample(
+                                          random_));
+        break;
+      case Op::Sequential: {
+        uint64_t& position = sequence_positions_[segment.index];
+        absl::StrAppend(&buffer_, segment.min + position);
+        position = position == segment.span ? 0 : position + 1;
+        break;
+      }
+      }
+    }
+    header.setCopy(field.name, buffer_);
+  }
+}
+
+} // namespace Nighthawk
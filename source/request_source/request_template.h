@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/random_generator.h"
+#include "envoy/common/time.h"
+#include "envoy/http/header_map.h"
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace Nighthawk {
+
+/**
+ * Zipfian distribution over the ranks 1..n, where rank k is drawn with a probability proportional
+ * to 1 / k^exponent. Sampled via rejection-inversion (Hörmann and Derflinger, 1996), which takes
+ * constant time and memory regardless of n.
+ */
+class ZipfianDistribution {
+public:
+  /**
+   * @param n the number of ranks. Must be at least 1.
+   * @param exponent the exponent of the distribution. Must be greater than 0.
+   */
+  ZipfianDistribution(const uint64_t n, const double exponent);
+
+  /**
+   * @param random generator to draw from.
+   * @return uint64_t a rank in 1..n.
+   */
+  uint64_t sample(Envoy::Random::RandomGenerator& random) const;
+
+private:
+  double h(const double x) const;
+  double hIntegral(const double x) const;
+  double hIntegralInverse(const double x) const;
+
+  const uint64_t n_;
+  const double exponent_;
+  const double h_integral_x1_;
+  const double h_integral_n_;
+  const double s_;
+};
+
+/**
+ * Request headers with values that vary per request, compiled from templates such as
+ * "/item/{rand:1..1e6}". Compiling a template turns it into a sequence of segments, each of which
+ * either copies a literal or renders a variable, so that rendering a request is a single pass over
+ * the segments without any parsing. Immutable once compiled, so that it can be shared by the
+ * request sources of all workers, which render it via their own RequestTemplateRenderer.
+ *
+ * Templates hold literal text and variables enclosed in braces. "{{" and "}}" stand for literal
+ * braces. Supported variables:
+ * - {uuid}: a random version 4 uuid. The same for all fields of a request.
+ * - {counter}: the number of requests rendered before by the renderer, starting at 0.
+ * - {timestamp}: the wall clock time at which the request was rendered, in milliseconds since the
+ *   Unix epoch.
+ * - {rand:MIN..MAX}: a key drawn uniformly from MIN..MAX, inclusive.
+ * - {zipf:MIN..MAX} or {zipf:MIN..MAX:EXPONENT}: a key drawn from MIN..MAX with a zipfian
+ *   distribution, so that lower keys are hotter. The exponent defaults to 0.99.
+ * - {seq:MIN..MAX}: keys from MIN..MAX in order, wrapping around after MAX.
+ * Bounds are non-negative integers, and may use exponent notation such as 1e6.
+ */
+class RequestTemplate {
+public:
+  /**
+   * Compiles templates for the values of request headers.
+   * @param fields header names, which may include pseudo headers such as :path, and the templates
+   * of their values.
+   * @return absl::StatusOr<std::shared_ptr<const RequestTemplate>> the compiled template, or an
+   * error status describing the first malformed template.
+   */
+  static absl::StatusOr<std::shared_ptr<const RequestTemplate>>
+  compile(const std::vector<std::pair<std::string, std::string>>& fields);
+
+private:
+  friend class RequestTemplateRenderer;
+
+  enum class Op : uint8_t { Literal, Uuid, Counter, Timestamp, Uniform, Zipfian, Sequential };
+
+  struct Segment {
+    Op op;
+    // Literal: the range of the text in literals_.
+    uint32_t offset{0};
+    uint32_t length{0};
+    // Keys: the lowest key, and the number of keys above it.
+    uint64_t min{0};
+    uint64_t span{0};
+    // Zipfian: index into zipfian_distributions_. Sequential: index of the position of the
+    // renderer.
+    uint32_t index{0};
+  };
+
+  struct Field {
+    Envoy::Http::LowerCaseString name;
+    // The range of the segments of the value in segments_.
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  RequestTemplate() = default;
+  absl::Status compileField(const std::string& name, absl::string_view text);
+  absl::Status compileVariable(absl::string_view variable);
+
+  std::vector<Field> fields_;
+  std::vector<Segment> segments_;
+  std::string literals_;
+  std::vector<ZipfianDistribution> zipfian_distributions_;
+  uint32_t sequences_{0};
+  bool uses_uuid_{false};
+  bool uses_timestamp_{false};
+};
+
+using RequestTemplateSharedPtr = std::shared_ptr<const RequestTemplate>;
+
+/**
+ * Renders the fields of a RequestTemplate into request headers. Holds the state of the variables,
+ * and reuses a single buffer for rendering the values, so that rendering does not allocate beyond
+ * what setting the headers takes. Not thread safe.
+ */
+class RequestTemplateRenderer {
+public:
+  /**
+   * @param request_template the template to render.
+   * @param random generator the random variables are drawn from. Also determines where sequences
+   * start, so that renderers with differently seeded generators walk their keys out of step.
+   * @param time_source time source for rendering timestamps.
+   */
+  RequestTemplateRenderer(RequestTemplateSharedPtr request_template,
+                          Envoy::Random::RandomGenerator& random, Envoy::TimeSource& time_source);
+
+  /**
+   * Renders the next request, setting the fields of the template in the header. Any existing
+   * header with the name of a field is replaced.
+   * @param header the header to set the fields in.
+   */
+  void render(Envoy::Http::RequestHeaderMap& header);
+
+private:
+  uint64_t drawKey(const uint64_t span);
+
+  const RequestTemplateSharedPtr template_;
+  Envoy::Random::RandomGenerator& random_;
+  Envoy::TimeSource& time_source_;
+  uint64_t counter_{0};
+  std::vector<uint64_t> sequence_positions_;
+  std::string buffer_;
+};
+
+} // namespace Nighthawk
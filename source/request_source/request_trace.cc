@@ -0,0 +1,338 @@
+#include "source/request_source/request_trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+#include "external/envoy/source/common/common/assert.h"
+
+#include "absl/base/config.h"
+#include "fmt/format.h"
+
+#if !defined(ABSL_IS_LITTLE_ENDIAN)
+#error "Request traces are used in place once mapped, which requires a little endian host"
+#endif
+
+namespace Nighthawk {
+
+namespace {
+
+constexpr char kMagic[] = {'N', 'H', 'T', 'R'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kNoBody = UINT32_MAX;
+constexpr size_t kSectionAlignment = 8;
+
+struct FileHeader {
+  char magic[sizeof(kMagic)];
+  uint32_t version;
+  uint64_t record_count;
+  uint64_t string_count;
+  uint64_t body_count;
+  uint64_t string_offsets;
+  uint64_t string_data;
+  uint64_t body_offsets;
+  uint64_t body_data;
+  uint64_t record_offsets;
+  uint64_t header_fields;
+  uint64_t record_bodies;
+  // Zero when the trace does not hold timing.
+  uint64_t record_times;
+};
+static_assert(sizeof(FileHeader) == 96, "Unexpected padding in the request trace file header");
+
+// Columns larger than this are spilled to a temporary file.
+constexpr size_t kColumnSpillThreshold = 1 << 20;
+
+} // namespace
+
+RequestTraceWriter::Column::~Column() {
+  if (spill_ != nullptr) {
+    std::fclose(spill_);
+  }
+}
+
+void RequestTraceWriter::Column::append(const void* data, const size_t size) {
+  buffer_.append(static_cast<const char*>(data), size);
+  if (buffer_.size() < kColumnSpillThreshold || failed_) {
+    return;
+  }
+  if (spill_ == nullptr) {
+    spill_ = std::tmpfile();
+  }
+  if (spill_ == nullptr ||
+      std::fwrite(buffer_.data(), 1, buffer_.size(), spill_) != buffer_.size()) {
+    // Keep going in memory, and report the failure when the trace gets written.
+    failed_ = true;
+    return;
+  }
+  spilled_ += buffer_.size();
+  buffer_.clear();
+}
+
+absl::Status RequestTraceWriter::Column::copyTo(std::FILE* file) {
+  if (failed_) {
+    return absl::InternalError("Failed spilling the request trace to a temporary file");
+  }
+  if (spill_ != nullptr) {
+    std::rewind(spill_);
+    char chunk[64 * 1024];
+    uint64_t remaining = spilled_;
+    while (remaining > 0) {
+      const size_t size =
+          std::fread(chunk, 1, std::min<uint64_t>(sizeof(chunk), remaining), spill_);
+      if (size == 0 || std::fwrite(chunk, 1, size, file) != size) {
+        return absl::InternalError("Failed copying the request trace from a temporary file");
+      }
+      remaining -= size;
+    }
+  }
+  if (std::fwrite(buffer_.data(), 1, buffer_.size(), file) != buffer_.size()) {
+    return absl::InternalError("Failed writing the request trace");
+  }
+  return absl::OkStatus();
+}
+
+RequestTraceWriter::RequestTraceWriter(const uint64_t max_interned_bytes)
+    : max_interned_bytes_(max_interned_bytes) {
+  record_offsets_.append<uint64_t>(0);
+}
+
+uint32_t RequestTraceWriter::intern(absl::string_view value, Table& table) {
+  auto it = table.index.find(value);
+  if (it != table.index.end()) {
+    return it->second;
+  }
+  RELEASE_ASSERT(table.count < kNoBody, "Too many distinct entries in request trace");
+  const uint32_t id = table.count++;
+  table.data.append(value.data(), value.size());
+  table.offsets.append<uint64_t>(table.data.size());
+  // Past the limit, new values are still stored but no longer deduplicated.
+  if (table.interned_bytes + value.size() <= max_interned_bytes_) {
+    table.interned_bytes += value.size();
+    table.index.emplace(std::string(value), id);
+  }
+  return id;
+}
+
+void RequestTraceWriter::addRecord(const std::vector<std::pair<std::string, std::string>>& headers,
+                                   const absl::optional<std::string>& body,
+                                   const absl::optional<std::chrono::nanoseconds> time) {
+  for (const auto& header : headers) {
+    header_fields_.append<uint32_t>(intern(header.first, strings_));
+    header_fields_.append<uint32_t>(intern(header.second, strings_));
+  }
+  header_field_count_ += headers.size();
+  record_offsets_.append<uint64_t>(header_field_count_);
+  record_bodies_.append<uint32_t>(body.has_value() ? intern(body.value(), bodies_) : kNoBody);
+  all_records_timed_ = all_records_timed_ && time.has_value();
+  if (all_records_timed_) {
+    record_times_.append<uint64_t>(time->count());
+  }
+  records_++;
+}
+
+absl::Status RequestTraceWriter::writeToFile(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return absl::InvalidArgumentError(
+        fmt::format("Unable to open '{}' for writing the request trace", path));
+  }
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.record_count = records_;
+  header.string_count = strings_.count;
+  header.body_count = bodies_.count;
+  uint64_t position = sizeof(FileHeader);
+  // Appends a column to the file as a section, and sets its offset.
+  const auto append_section = [file, &position](Column& column,
+                                                uint64_t& offset) -> absl::Status {
+    const char padding[kSectionAlignment] = {};
+    const size_t padding_size = (kSectionAlignment - position % kSectionAlignment) %
+                                kSectionAlignment;
+    if (std::fwrite(padding, 1, padding_size, file) != padding_size) {
+      return absl::InternalError("Failed writing the request trace");
+    }
+    offset = position + padding_size;
+    position = offset + column.size();
+    return column.copyTo(file);
+  };
+  // The header is written last, once the section offsets are known.
+  absl::Status status = std::fseek(file, sizeof(FileHeader), SEEK_SET) == 0
+                            ? absl::OkStatus()
+                            : absl::InternalError("Failed writing the request trace");
+  for (const auto& [column, offset] : std::initializer_list<std::pair<Column*, uint64_t*>>{
+           {&strings_.offsets, &header.string_offsets},
+           {&strings_.data, &header.string_data},
+           {&bodies_.offsets, &header.body_offsets},
+           {&bodies_.data, &header.body_data},
+           {&record_offsets_, &header.record_offsets},
+           {&header_fields_, &header.header_fields},
+           {&record_bodies_, &header.record_bodies}}) {
+    if (status.ok()) {
+      status = append_section(*column, *offset);
+    }
+  }
+  if (status.ok() && all_records_timed_ && records_ > 0) {
+    status = append_section(record_times_, header.record_times);
+  }
+  if (status.ok() && (std::fseek(file, 0, SEEK_SET) != 0 ||
+                      std::fwrite(&header, sizeof(header), 1, file) != 1)) {
+    status = absl::InternalError("Failed writing the request trace");
+  }
+  if (std::fclose(file) != 0 && status.ok()) {
+    status = absl::InternalError("Failed writing the request trace");
+  }
+  if (!status.ok()) {
+    return absl::Status(status.code(), fmt::format("{} to '{}'", status.message(), path));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<MappedRequestTraceSharedPtr> MappedRequestTrace::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return absl::InvalidArgumentError(fmt::format("Unable to open request trace file '{}': {}",
+                                                  path, std::strerror(errno)));
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+    ::close(fd);
+    return absl::InvalidArgumentError(fmt::format("'{}' is not a request trace file", path));
+  }
+  const size_t size = file_stat.st_size;
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the descriptor has been closed.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return absl::InternalError(fmt::format("Unable to map request trace file '{}': {}", path,
+                                           std::strerror(errno)));
+  }
+  std::shared_ptr<MappedRequestTrace> trace(new MappedRequestTrace(data, size));
+  const absl::Status status = trace->parse();
+  if (!status.ok()) {
+    return absl::InvalidArgumentError(
+        fmt::format("Malformed request trace file '{}': {}", path, status.message()));
+  }
+  return trace;
+}
+
+MappedRequestTrace::~MappedRequestTrace() { ::munmap(const_cast<void*>(data_), size_); }
+
+absl::Status MappedRequestTrace::parse() {
+  FileHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return absl::InvalidArgumentError("bad magic value");
+  }
+  if (header.version != kVersion) {
+    return absl::InvalidArgumentError(fmt::format("unsupported version {}", header.version));
+  }
+  if (header.string_count >= kNoBody || header.body_count >= kNoBody) {
+    return absl::InvalidArgumentError("too many table entries");
+  }
+  const char* base = static_cast<const char*>(data_);
+  // Returns the start of a section of count elements, or nullptr when it does not fit the file.
+  const auto section = [this, base](const uint64_t offset, const uint64_t count,
+                                    const size_t element_size) -> const char* {
+    if (offset % kSectionAlignment != 0 || offset > size_ ||
+        count > (size_ - offset) / element_size) {
+      return nullptr;
+    }
+    return base + offset;
+  };
+  record_count_ = header.record_count;
+  string_count_ = header.string_count;
+  body_count_ = header.body_count;
+  string_offsets_ = reinterpret_cast<const uint64_t*>(
+      section(header.string_offsets, string_count_ + 1, sizeof(uint64_t)));
+  body_offsets_ = reinterpret_cast<const uint64_t*>(
+      section(header.body_offsets, body_count_ + 1, sizeof(uint64_t)));
+  record_offsets_ = reinterpret_cast<const uint64_t*>(
+      section(header.record_offsets, record_count_ + 1, sizeof(uint64_t)));
+  record_bodies_ = reinterpret_cast<const uint32_t*>(
+      section(header.record_bodies, record_count_, sizeof(uint32_t)));
+  if (string_offsets_ == nullptr || body_offsets_ == nullptr || record_offsets_ == nullptr ||
+      record_bodies_ == nullptr) {
+    return absl::InvalidArgumentError("truncated index sections");
+  }
+  string_data_size_ = string_offsets_[string_count_];
+  body_data_size_ = body_offsets_[body_count_];
+  header_field_count_ = record_offsets_[record_count_];
+  string_data_ = section(header.string_data, string_data_size_, 1);
+  body_data_ = section(header.body_data, body_data_size_, 1);
+  header_fields_ = reinterpret_cast<const uint32_t*>(
+      section(header.header_fields, header_field_count_, 2 * sizeof(uint32_t)));
+  if (string_data_ == nullptr || body_data_ == nullptr || header_fields_ == nullptr) {
+    return absl::InvalidArgumentError("truncated data sections");
+  }
+  if (header.record_times != 0) {
+    record_times_ = reinterpret_cast<const uint64_t*>(
+        section(header.record_times, record_count_, sizeof(uint64_t)));
+    if (record_times_ == nullptr) {
+      return absl::InvalidArgumentError("truncated timing section");
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::optional<absl::string_view>
+MappedRequestTrace::entry(const uint64_t* offsets, const uint64_t count, const char* data,
+                          const uint64_t data_size, const uint64_t index) const {
+  if (index >= count) {
+    return absl::nullopt;
+  }
+  const uint64_t begin = offsets[index];
+  const uint64_t end = offsets[index + 1];
+  if (begin > end || end > data_size) {
+    return absl::nullopt;
+  }
+  return absl::string_view(data + begin, end - begin);
+}
+
+bool MappedRequestTrace::read(const uint64_t index, RequestTraceRecord& record) const {
+  ASSERT(index < record_count_);
+  record.headers.clear();
+  record.body = absl::nullopt;
+  record.time = absl::nullopt;
+  const uint64_t begin = record_offsets_[index];
+  const uint64_t end = record_offsets_[index + 1];
+  if (begin > end || end > header_field_count_) {
+    return false;
+  }
+  for (uint64_t field = begin; field < end; field++) {
+    const absl::optional<absl::string_view> name = entry(
+        string_offsets_, string_count_, string_data_, string_data_size_, header_fields_[2 * field]);
+    const absl::optional<absl::string_view> value =
+        entry(string_offsets_, string_count_, string_data_, string_data_size_,
+              header_fields_[2 * field + 1]);
+    if (!name.has_value() || !value.has_value()) {
+      return false;
+    }
+    record.headers.emplace_back(name.value(), value.value());
+  }
+  if (record_bodies_[index] != kNoBody) {
+    record.body =
+        entry(body_offsets_, body_count_, body_data_, body_data_size_, record_bodies_[index]);
+    if (!record.body.has_value()) {
+      return false;
+    }
+  }
+  if (hasTimes()) {
+    record.time = time(index);
+  }
+  return true;
+}
+
+std::chrono::nanoseconds MappedRequestTrace::time(const uint64_t index) const {
+  ASSERT(index < record_count_ && hasTimes());
+  return std::chrono::nanoseconds(record_times_[index]);
+}
+
+} // namespace Nighthawk
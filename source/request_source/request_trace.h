@@ -0,0 +1,198 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "external/envoy/source/common/common/non_copyable.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Nighthawk {
+
+/**
+ * A single request of a trace, as viewed in a MappedRequestTrace. The views point into the mapping
+ * and are valid as long as the trace is.
+ */
+struct RequestTraceRecord {
+  absl::InlinedVector<std::pair<absl::string_view, absl::string_view>, 8> headers;
+  absl::optional<absl::string_view> body;
+  // When the request was sent, relative to the start of the trace, if the trace holds timing.
+  absl::optional<std::chrono::nanoseconds> time;
+};
+
+/**
+ * Builds a request trace file, for replay via MappedRequestTrace.
+ *
+ * The file format is columnar, so that it can be used in place once mapped into memory, regardless
+ * of the number of requests it holds. Header names and values are interned in a string table, and
+ * bodies are deduplicated into a body table. Each request is a range of (name, value) index pairs
+ * plus an optional body index. After a fixed size header holding a magic value, the version, the
+ * counts and the offsets of the sections, the file holds these sections, each 8 byte aligned:
+ * - string offsets: string count + 1 uint64 offsets into the string data.
+ * - string data.
+ * - body offsets: body count + 1 uint64 offsets into the body data.
+ * - body data.
+ * - record offsets: request count + 1 uint64 offsets into the header fields.
+ * - header fields: pairs of uint32 string indices.
+ * - record bodies: a uint32 body index per request, or UINT32_MAX for requests without a body.
+ * - record times: a uint64 per request with the time at which it was sent, in nanoseconds
+ *   relative to the start of the trace. Only present when every request in the trace has a time.
+ * Integers are stored in host byte order, which must be little endian.
+ *
+ * Building a trace takes bounded memory: the columns are spilled to anonymous temporary files as
+ * they grow, and values stop being interned once the intern tables reach their size limit. Values
+ * seen before that point are still deduplicated.
+ */
+class RequestTraceWriter {
+public:
+  /**
+   * @param max_interned_bytes limit on the combined size of the distinct values kept in memory
+   * for deduplication, per table.
+   */
+  RequestTraceWriter(const uint64_t max_interned_bytes = 64 << 20);
+
+  /**
+   * Appends a request to the trace.
+   * @param headers the headers of the request, including pseudo headers such as :path.
+   * @param body the body of the request, if any.
+   * @param time when the request was sent, relative to the start of the trace, if known.
+   */
+  void addRecord(const std::vector<std::pair<std::string, std::string>>& headers,
+                 const absl::optional<std::string>& body,
+                 const absl::optional<std::chrono::nanoseconds> time = absl::nullopt);
+
+  /**
+   * @return uint64_t the number of requests added so far.
+   */
+  uint64_t records() const { return records_; }
+
+  /**
+   * Writes the trace to a file. Must be called once, after all requests have been added.
+   * @param path path of the file.
+   * @return absl::Status indicating success or failure.
+   */
+  absl::Status writeToFile(const std::string& path);
+
+private:
+  // A section of the file under construction. Spills its contents to an anonymous temporary file
+  // once they grow beyond a threshold.
+  class Column {
+  public:
+    ~Column();
+    void append(const void* data, const size_t size);
+    template <class T> void append(const T value) { append(&value, sizeof(T)); }
+    uint64_t size() const { return spilled_ + buffer_.size(); }
+    absl::Status copyTo(std::FILE* file);
+
+  private:
+    std::string buffer_;
+    std::FILE* spill_{nullptr};
+    uint64_t spilled_{0};
+    bool failed_{false};
+  };
+
+  // A table of strings, with the distinct values seen so far mapped to their index.
+  struct Table {
+    Table() { offsets.append<uint64_t>(0); }
+    Column offsets;
+    Column data;
+    uint32_t count{0};
+    absl::flat_hash_map<std::string, uint32_t> index;
+    uint64_t interned_bytes{0};
+  };
+
+  uint32_t intern(absl::string_view value, Table& table);
+
+  const uint64_t max_interned_bytes_;
+  Table strings_;
+  Table bodies_;
+  Column record_offsets_;
+  Column header_fields_;
+  Column record_bodies_;
+  Column record_times_;
+  uint64_t records_{0};
+  uint64_t header_field_count_{0};
+  bool all_records_timed_{true};
+};
+
+class MappedRequestTrace;
+using MappedRequestTraceSharedPtr = std::shared_ptr<const MappedRequestTrace>;
+
+/**
+ * Read-only memory mapping of a request trace file written by RequestTraceWriter. Opening a trace
+ * only validates the layout of its sections, so that it takes constant time regardless of the
+ * size of the trace. Individual requests are validated when they are read. Thread safe.
+ */
+class MappedRequestTrace : public Envoy::NonCopyable {
+public:
+  /**
+   * Maps a trace file into memory.
+   * @param path path of the file.
+   * @return absl::StatusOr<MappedRequestTraceSharedPtr> the trace, or an error status when the
+   * file could not be mapped or is not a trace file.
+   */
+  static absl::StatusOr<MappedRequestTraceSharedPtr> open(const std::string& path);
+
+  ~MappedRequestTrace();
+
+  /**
+   * @return uint64_t the number of requests in the trace.
+   */
+  uint64_t records() const { return record_count_; }
+
+  /**
+   * Reads a request from the trace.
+   * @param index index of the request, which must be less than records().
+   * @param record receives the request.
+   * @return bool false when the request is malformed.
+   */
+  bool read(const uint64_t index, RequestTraceRecord& record) const;
+
+  /**
+   * @return bool whether the trace holds the times at which its requests were sent.
+   */
+  bool hasTimes() const { return record_times_ != nullptr; }
+
+  /**
+   * @param index index of the request, which must be less than records(). The trace must hold
+   * timing.
+   * @return std::chrono::nanoseconds when the request was sent, relative to the start of the trace.
+   */
+  std::chrono::nanoseconds time(const uint64_t index) const;
+
+private:
+  MappedRequestTrace(const void* data, const size_t size) : data_(data), size_(size) {}
+  absl::Status parse();
+  absl::optional<absl::string_view> entry(const uint64_t* offsets, const uint64_t count,
+                                          const char* data, const uint64_t data_size,
+                                          const uint64_t index) const;
+
+  const void* data_;
+  const size_t size_;
+  uint64_t record_count_{0};
+  uint64_t string_count_{0};
+  uint64_t body_count_{0};
+  const uint64_t* string_offsets_{nullptr};
+  const char* string_data_{nullptr};
+  uint64_t string_data_size_{0};
+  const uint64_t* body_offsets_{nullptr};
+  const char* body_data_{nullptr};
+  uint64_t body_data_size_{0};
+  const uint64_t* record_offsets_{nullptr};
+  const uint32_t* header_fields_{nullptr};
+  uint64_t header_field_count_{0};
+  const uint32_t* record_bodies_{nullptr};
+  const uint64_t* record_times_{nullptr};
+};
+
+} // namespace Nighthawk
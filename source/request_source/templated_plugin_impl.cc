@@ -0,0 +1,77 @@
+#include "source/request_source/templated_plugin_impl.h"
+
+#include <utility>
+#include <vector>
+
+#include "nighthawk/common/exception.h"
+
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/source/common/protobuf/utility.h"
+
+#include "source/common/request_impl.h"
+
+namespace Nighthawk {
+
+std::string TemplatedRequestSourceFactory::name() const {
+  return "nighthawk.templated-request-source-plugin";
+}
+
+Envoy::ProtobufTypes::MessagePtr TemplatedRequestSourceFactory::createEmptyConfigProto() {
+  return std::make_unique<nighthawk::request_source::TemplatedRequestSourceConfig>();
+}
+
+RequestSourcePtr TemplatedRequestSourceFactory::createRequestSourcePlugin(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
+    Envoy::Http::RequestHeaderMapPtr header) {
+  return createRequestSourcePluginForWorker(message, api, std::move(header), 0);
+}
+
+RequestSourcePtr TemplatedRequestSourceFactory::createRequestSourcePluginForWorker(
+    const Envoy::Protobuf::Message& message, Envoy::Api::Api& api,
+    Envoy::Http::RequestHeaderMapPtr header, const uint32_t worker_id) {
+  const auto* any = Envoy::Protobuf::DynamicCastToGenerated<const Envoy::Protobuf::Any>(&message);
+  nighthawk::request_source::TemplatedRequestSourceConfig config;
+  THROW_IF_NOT_OK(Envoy::MessageUtil::unpackTo(*any, config));
+  std::vector<std::pair<std::string, std::string>> fields;
+  for (const auto& field : config.fields()) {
+    fields.emplace_back(field.name(), field.value());
+  }
+  absl::StatusOr<RequestTemplateSharedPtr> request_template = RequestTemplate::compile(fields);
+  if (!request_template.ok()) {
+    throw NighthawkException(std::string(request_template.status().message()));
+  }
+  return std::make_unique<TemplatedRequestSource>(
+      std::move(request_template.value()), std::move(header), config.num_requests(),
+      SeededRandomGeneratorImpl::seedForWorker(config.seed(), worker_id),
+      api.timeSource());
+}
+
+REGISTER_FACTORY(TemplatedRequestSourceFactory, RequestSourcePluginConfigFactory);
+
+TemplatedRequestSource::TemplatedRequestSource(RequestTemplateSharedPtr request_template,
+                                               Envoy::Http::RequestHeaderMapPtr header,
+                                               const uint64_t num_requests, const uint64_t seed,
+                                               Envoy::TimeSource& time_source)
+    : header_(std::move(header)), num_requests_(num_requests), random_generator_(seed),
+      renderer_(std::move(request_template), random_generator_, time_source) {}
+
+RequestGenerator TemplatedRequestSource::get() {
+  return [this, remaining = num_requests_]() mutable -> RequestPtr {
+    if (num_requests_ != 0) {
+      if (remaining == 0) {
+        return nullptr;
+      }
+      remaining--;
+    }
+    Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+    Envoy::Http::HeaderMapImpl::copyFrom(*header, *header_);
+    renderer_.render(*header);
+    return std::make_unique<RequestImpl>(std::move(header));
+  };
+}
+
+void TemplatedRequestSource::initOnThread() {}
+void TemplatedRequestSource::destroyOnThread() {}
+
+} // namespace Nighthawk
@@ -0,0 +1,75 @@
+#pragma once
+
+// Implementation of a RequestSourceConfigFactory that makes a TemplatedRequestSource.
+
+#include <memory>
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "nighthawk/request_source/request_source_plugin_config_factory.h"
+
+#include "api/request_source/request_source_plugin.pb.h"
+
+#include "source/common/seeded_random_generator_impl.h"
+#include "source/request_source/request_template.h"
+
+namespace Nighthawk {
+
+// Request source that renders the fields of a compiled RequestTemplate into a copy of the default
+// header for each request, so that paths and headers can carry unique ids, counters, timestamps
+// and keys drawn from a keyspace. Random variables are drawn from a generator seeded for this
+// request source.
+// The RequestGenerator produced by get() is not thread safe, but generators of different request
+// sources may be used concurrently.
+class TemplatedRequestSource : public RequestSource {
+public:
+  TemplatedRequestSource(RequestTemplateSharedPtr request_template,
+                         Envoy::Http::RequestHeaderMapPtr header, const uint64_t num_requests,
+                         const uint64_t seed, Envoy::TimeSource& time_source);
+
+  RequestGenerator get() override;
+
+  // default implementation
+  void initOnThread() override;
+  void destroyOnThread() override;
+
+private:
+  Envoy::Http::RequestHeaderMapPtr header_;
+  const uint64_t num_requests_;
+  SeededRandomGeneratorImpl random_generator_;
+  RequestTemplateRenderer renderer_;
+};
+
+// Factory that creates a TemplatedRequestSource from a TemplatedRequestSourceConfig proto.
+// Registered as an Envoy plugin. The templates are compiled for each request source, and each
+// request source draws from its own seed, derived from the configured seed and the number of the
+// worker it is created for.
+// Usage: assume you are passed an appropriate Any type object called config, an Api
+// object called api, and a default header called header. auto& config_factory =
+//     Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+//         "nighthawk.templated-request-source-plugin");
+// RequestSourcePtr plugin =
+//     config_factory.createRequestSourcePlugin(config, std::move(api), std::move(header));
+class TemplatedRequestSourceFactory : public virtual RequestSourcePluginConfigFactory {
+public:
+  std::string name() const override;
+
+  Envoy::ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  // This implementation is thread safe. This method will error if a template is malformed.
+  RequestSourcePtr createRequestSourcePlugin(const Envoy::Protobuf::Message& message,
+                                             Envoy::Api::Api& api,
+                                             Envoy::Http::RequestHeaderMapPtr header) override;
+
+  // Seeds the request source from the seed in the config and |worker_id|.
+  RequestSourcePtr createRequestSourcePluginForWorker(const Envoy::Protobuf::Message& message,
+                                                      Envoy::Api::Api& api,
+                                                      Envoy::Http::RequestHeaderMapPtr header,
+                                                      const uint32_t worker_id) override;
+};
+
+// This factory will be activated through RequestSourceFactory in factories.h
+DECLARE_FACTORY(TemplatedRequestSourceFactory);
+
+} // namespace Nighthawk
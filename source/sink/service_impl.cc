@@ -2,6 +2,8 @@
 
 #include <grpc++/grpc++.h>
 
+#include <algorithm>
+
 #include "envoy/config/core/v3/base.pb.h"
 
 #include "external/envoy/source/common/common/assert.h"
@@ -106,15 +108,26 @@ mergeExecutionResponses(const std::string& requested_execution_id,
     return absl::Status(absl::StatusCode::kNotFound, "No results");
   }
 
+  // Intermediate responses stored along with final ones are covered by the final ones. As long as
+  // no final response was stored, the intermediate ones are all there is.
+  const bool has_final_response =
+      std::any_of(responses.begin(), responses.end(),
+                  [](const nighthawk::client::ExecutionResponse& response) {
+                    return !response.intermediate();
+                  });
   nighthawk::client::ExecutionResponse aggregated_response;
   nighthawk::client::Output aggregated_output;
   aggregated_response.set_execution_id(requested_execution_id);
+  aggregated_response.set_intermediate(!has_final_response);
   for (const nighthawk::client::ExecutionResponse& execution_response : responses) {
     if (execution_response.execution_id() != requested_execution_id) {
       return absl::Status(absl::StatusCode::kInternal,
                           fmt::format("Expected execution_id '{}' got '{}'", requested_execution_id,
                                       execution_response.execution_id()));
     }
+    if (has_final_response && execution_response.intermediate()) {
+      continue;
+    }
     // If any error exists, set an error code and message & append the details of each such
     // occurrence.
     if (execution_response.has_error_detail()) {
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "external/envoy/source/common/common/random_generator.h"
@@ -25,6 +26,8 @@
 #include "test/user_defined_output/fake_plugin/fake_user_defined_output.h"
 #include "test/user_defined_output/fake_plugin/fake_user_defined_output.pb.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "gtest/gtest.h"
 
 using namespace testing;
@@ -200,6 +203,19 @@ public:
         /*response_header_with_latency_input=*/"", std::move(user_defined_output_plugins_));
   }
 
+  // Expects the streams of the requests to be reset in the order in which they were started, and
+  // calls back their decoders.
+  // @param count the number of streams to expect to be reset.
+  // @param first index in decoders_ of the first of them.
+  void expectStreamResets(size_t count, size_t first = 0) {
+    EXPECT_CALL(stream_encoder_.stream_, resetStream(Envoy::Http::StreamResetReason::LocalReset))
+        .Times(count)
+        .WillRepeatedly([this, next = first](Envoy::Http::StreamResetReason reason) mutable {
+          dynamic_cast<Envoy::Http::StreamCallbacks*>(decoders_[next++])
+              ->onResetStream(reason, "");
+        });
+  }
+
   uint64_t getCounter(absl::string_view name) {
     return client_->scope().counterFromString(std::string(name)).value();
   }
@@ -288,6 +304,97 @@ TEST_F(BenchmarkClientHttpTest, EnableLatencyMeasurement) {
   EXPECT_EQ(10, client_->statistics()["benchmark_http_client.latency_2xx"]->count());
 }
 
+TEST_F(BenchmarkClientHttpTest, ResetStatisticsStartsFromScratch) {
+  response_code_ = "200";
+  RequestGenerator default_request_generator = getDefaultRequestGenerator();
+  auto client_setup_param = ClientSetupParameters(10, 1, 10, default_request_generator);
+  setupBenchmarkClient(default_request_generator);
+  client_->setShouldMeasureLatencies(true);
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  EXPECT_EQ(10, client_->statistics()["benchmark_http_client.latency_2xx"]->count());
+  client_->resetStatistics();
+  EXPECT_EQ(0, client_->statistics()["benchmark_http_client.latency_2xx"]->count());
+  EXPECT_EQ(0, client_->statistics()["benchmark_http_client.request_to_response"]->count());
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  EXPECT_EQ(10, client_->statistics()["benchmark_http_client.latency_2xx"]->count());
+  EXPECT_EQ(10, client_->statistics()["benchmark_http_client.request_to_response"]->count());
+  // Counters are not affected.
+  EXPECT_EQ(20, getCounter("http_2xx"));
+}
+
+TEST_F(BenchmarkClientHttpTest, RetireStatisticsHandsOutTheStatisticsSoFar) {
+  response_code_ = "200";
+  RequestGenerator default_request_generator = getDefaultRequestGenerator();
+  auto client_setup_param = ClientSetupParameters(10, 1, 10, default_request_generator);
+  setupBenchmarkClient(default_request_generator);
+  client_->setShouldMeasureLatencies(true);
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  StatisticPtrMap retired = client_->retireStatistics();
+  EXPECT_EQ(10, retired["benchmark_http_client.request_to_response"]->count());
+  EXPECT_EQ(0, client_->statistics()["benchmark_http_client.request_to_response"]->count());
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  EXPECT_EQ(10, client_->statistics()["benchmark_http_client.request_to_response"]->count());
+  // The retired statistics stay as they were.
+  EXPECT_EQ(10, retired["benchmark_http_client.request_to_response"]->count());
+}
+
+TEST_F(BenchmarkClientHttpTest, BreaksLatenciesDownByRequestClass) {
+  uint32_t requests = 0;
+  // Requests of the third class don't have a statistic.
+  RequestGenerator request_generator = [this, &requests]() {
+    return std::make_unique<RequestImpl>(default_header_map_, /*body=*/nullptr, requests++ % 3);
+  };
+  auto client_setup_param = ClientSetupParameters(9, 1, 9, request_generator);
+  setupBenchmarkClient(request_generator);
+  client_->setRequestClasses({"a", "b"});
+  client_->setShouldMeasureLatencies(true);
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  StatisticPtrMap statistics = client_->statistics();
+  EXPECT_EQ(9, statistics["benchmark_http_client.request_to_response"]->count());
+  EXPECT_EQ(3, statistics["benchmark_http_client.request_class.a"]->count());
+  EXPECT_EQ(3, statistics["benchmark_http_client.request_class.b"]->count());
+  EXPECT_EQ(statistics.count("benchmark_http_client.request_class.other"), 0);
+  client_->resetStatistics();
+  EXPECT_EQ(0, client_->statistics()["benchmark_http_client.request_class.a"]->count());
+}
+
+TEST_F(BenchmarkClientHttpTest, FoldsRequestClassesBeyondTheLimit) {
+  RequestGenerator request_generator = [this]() {
+    return std::make_unique<RequestImpl>(default_header_map_, /*body=*/nullptr,
+                                         /*request_class=*/19);
+  };
+  auto client_setup_param = ClientSetupParameters(1, 1, 1, request_generator);
+  setupBenchmarkClient(request_generator);
+  std::vector<std::string> request_classes;
+  for (int i = 0; i < 20; i++) {
+    request_classes.push_back(absl::StrCat("class_", i));
+  }
+  client_->setRequestClasses(request_classes);
+  client_->setShouldMeasureLatencies(true);
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  StatisticPtrMap statistics = client_->statistics();
+  const uint32_t request_class_statistics =
+      std::count_if(statistics.begin(), statistics.end(), [](const auto& statistic) {
+        return absl::StartsWith(statistic.first, "benchmark_http_client.request_class.");
+      });
+  EXPECT_EQ(Client::BenchmarkClientHttpImpl::kMaxRequestClasses, request_class_statistics);
+  EXPECT_EQ(statistics.count("benchmark_http_client.request_class.class_15"), 0);
+  EXPECT_EQ(statistics.count("benchmark_http_client.request_class.class_19"), 0);
+  EXPECT_EQ(1, statistics["benchmark_http_client.request_class.other"]->count());
+}
+
+TEST_F(BenchmarkClientHttpTest, CountsUnmetResponseExpectations) {
+  // Responses have a 200 status and a body of 97 bytes.
+  RequestGenerator request_generator = [this]() {
+    return std::make_unique<RequestImpl>(default_header_map_, /*body=*/nullptr, /*request_class=*/0,
+                                         ResponseExpectations{404, 97});
+  };
+  auto client_setup_param = ClientSetupParameters(4, 1, 4, request_generator);
+  verifyBenchmarkClientProcessesExpectedInflightRequests(client_setup_param);
+  EXPECT_EQ(4, getCounter("expectation_response_code_mismatch"));
+  EXPECT_EQ(0, getCounter("expectation_content_length_mismatch"));
+}
+
 TEST_F(BenchmarkClientHttpTest, ExportSuccessLatency) {
   RequestGenerator default_request_generator = getDefaultRequestGenerator();
   setupBenchmarkClient(default_request_generator);
@@ -461,6 +568,151 @@ TEST_F(BenchmarkClientHttpTest, DrainTimeoutFires) {
   EXPECT_EQ(0, getCounter("http_2xx"));
 }
 
+TEST_F(BenchmarkClientHttpTest, HardCutAbandonsInFlightRequests) {
+  setupBenchmarkClient(getDefaultRequestGenerator());
+  client_->setTerminationMode(nighthawk::client::TerminationMode::HARD_CUT, 1s);
+  client_->setMaxPendingRequests(10);
+  client_->setConnectionLimit(10);
+  EXPECT_CALL(cluster_info(), resourceManager(_))
+      .WillRepeatedly(
+          ReturnRef(cluster_info_->resourceManager(Envoy::Upstream::ResourcePriority::Default)));
+  EXPECT_CALL(pool_, newStream(_, _, _))
+      .WillRepeatedly([this](Envoy::Http::ResponseDecoder& decoder,
+                             Envoy::Http::ConnectionPool::Callbacks& callbacks,
+                             const Envoy::Http::ConnectionPool::Instance::StreamOptions&)
+                          -> Envoy::Http::ConnectionPool::Cancellable* {
+        decoders_.push_back(&decoder);
+        NiceMock<Envoy::StreamInfo::MockStreamInfo> stream_info;
+        callbacks.onPoolReady(stream_encoder_, Envoy::Upstream::HostDescriptionConstSharedPtr{},
+                              stream_info, {} /*absl::optional<Envoy::Http::Protocol> protocol*/);
+        return nullptr;
+      });
+  int completions = 0;
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(client_->tryStartRequest([&completions](bool, bool) { completions++; }));
+  }
+  // Hard cut should neither wait for the pool to become idle now, nor upon termination. It resets
+  // the streams of the in-flight requests instead.
+  EXPECT_CALL(pool_, addIdleCallback(_)).Times(0);
+  expectStreamResets(3);
+  client_->onExecutionEnded();
+  EXPECT_EQ(3, completions);
+  client_->terminate();
+  EXPECT_EQ(3, getCounter("requests_abandoned_at_termination"));
+  EXPECT_EQ(0, getCounter("stream_resets"));
+  EXPECT_FALSE(client_->shouldMeasureLatencies());
+  dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
+}
+
+TEST_F(BenchmarkClientHttpTest, BoundedDrainAlwaysReportsTheDrainedLatencies) {
+  setupBenchmarkClient(getDefaultRequestGenerator());
+  client_->setTerminationMode(nighthawk::client::TerminationMode::BOUNDED_DRAIN, 100ms);
+  client_->onExecutionEnded();
+  // Nothing was in flight, but the statistic is there so that it lines up with other workers.
+  ASSERT_EQ(1, client_->statistics().count("benchmark_http_client.drained_request_to_response"));
+  EXPECT_EQ(0,
+            client_->statistics()["benchmark_http_client.drained_request_to_response"]->count());
+}
+
+TEST_F(BenchmarkClientHttpTest, BoundedDrainReportsDrainedLatenciesSeparately) {
+  setupBenchmarkClient(getDefaultRequestGenerator());
+  client_->setTerminationMode(nighthawk::client::TerminationMode::BOUNDED_DRAIN, 100ms);
+  client_->setShouldMeasureLatencies(true);
+  client_->setMaxPendingRequests(10);
+  client_->setConnectionLimit(10);
+  EXPECT_CALL(cluster_info(), resourceManager(_))
+      .WillRepeatedly(
+          ReturnRef(cluster_info_->resourceManager(Envoy::Upstream::ResourcePriority::Default)));
+  EXPECT_CALL(pool_, newStream(_, _, _))
+      .WillRepeatedly([this](Envoy::Http::ResponseDecoder& decoder,
+                             Envoy::Http::ConnectionPool::Callbacks& callbacks,
+                             const Envoy::Http::ConnectionPool::Instance::StreamOptions&)
+                          -> Envoy::Http::ConnectionPool::Cancellable* {
+        decoders_.push_back(&decoder);
+        NiceMock<Envoy::StreamInfo::MockStreamInfo> stream_info;
+        callbacks.onPoolReady(stream_encoder_, Envoy::Upstream::HostDescriptionConstSharedPtr{},
+                              stream_info, {} /*absl::optional<Envoy::Http::Protocol> protocol*/);
+        return nullptr;
+      });
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(client_->tryStartRequest([](bool, bool) {}));
+  }
+  auto respond = [this](size_t index) {
+    decoders_[index]->decodeHeaders(
+        Envoy::Http::ResponseHeaderMapPtr{new Envoy::Http::TestResponseHeaderMapImpl{
+            {":status", "200"}}},
+        true);
+  };
+  // The first response arrives before execution ends, the second one while draining. The third
+  // one doesn't arrive in time.
+  respond(0);
+  // The drain waits for the requests, not for the pool to close its connections.
+  EXPECT_CALL(pool_, addIdleCallback(_)).Times(0);
+  dispatcher_->post([&respond]() { respond(1); });
+  // The third request is reset once the drain times out.
+  expectStreamResets(1, 2);
+  client_->onExecutionEnded();
+  EXPECT_EQ(1, client_->statistics()["benchmark_http_client.request_to_response"]->count());
+  EXPECT_EQ(1, client_->statistics()["benchmark_http_client.latency_2xx"]->count());
+  EXPECT_EQ(1,
+            client_->statistics()["benchmark_http_client.drained_request_to_response"]->count());
+  EXPECT_EQ(2, getCounter("http_2xx"));
+  EXPECT_EQ(1, getCounter("requests_abandoned_at_termination"));
+  // Termination shouldn't wait for the pool to drain a second time.
+  client_->terminate();
+  dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
+}
+
+TEST_F(BenchmarkClientHttpTest, BoundedDrainEndsOnceNothingIsInFlight) {
+  setupBenchmarkClient(getDefaultRequestGenerator());
+  // Long enough for the test to time out when the drain waits for it.
+  client_->setTerminationMode(nighthawk::client::TerminationMode::BOUNDED_DRAIN, 1h);
+  client_->setShouldMeasureLatencies(true);
+  client_->setMaxPendingRequests(10);
+  client_->setConnectionLimit(10);
+  EXPECT_CALL(cluster_info(), resourceManager(_))
+      .WillRepeatedly(
+          ReturnRef(cluster_info_->resourceManager(Envoy::Upstream::ResourcePriority::Default)));
+  EXPECT_CALL(pool_, newStream(_, _, _))
+      .WillRepeatedly([this](Envoy::Http::ResponseDecoder& decoder,
+                             Envoy::Http::ConnectionPool::Callbacks& callbacks,
+                             const Envoy::Http::ConnectionPool::Instance::StreamOptions&)
+                          -> Envoy::Http::ConnectionPool::Cancellable* {
+        decoders_.push_back(&decoder);
+        NiceMock<Envoy::StreamInfo::MockStreamInfo> stream_info;
+        callbacks.onPoolReady(stream_encoder_, Envoy::Upstream::HostDescriptionConstSharedPtr{},
+                              stream_info, {} /*absl::optional<Envoy::Http::Protocol> protocol*/);
+        return nullptr;
+      });
+  // Keep-alive connections keep the pool from becoming idle, so the drain must not wait for that.
+  EXPECT_CALL(pool_, addIdleCallback(_)).Times(0);
+  auto respond = [this](size_t index) {
+    decoders_[index]->decodeHeaders(
+        Envoy::Http::ResponseHeaderMapPtr{new Envoy::Http::TestResponseHeaderMapImpl{
+            {":status", "200"}}},
+        true);
+  };
+  // Two executions in a row, as with warm executions. Each drains its own in-flight requests.
+  for (size_t execution = 0; execution < 2; execution++) {
+    const size_t first = decoders_.size();
+    for (int i = 0; i < 2; i++) {
+      EXPECT_TRUE(client_->tryStartRequest([](bool, bool) {}));
+    }
+    dispatcher_->post([&respond, first]() { respond(first); });
+    dispatcher_->post([&respond, first]() { respond(first + 1); });
+    client_->onExecutionEnded();
+    EXPECT_EQ(2,
+              client_->statistics()["benchmark_http_client.drained_request_to_response"]->count());
+    EXPECT_EQ(0, client_->statistics()["benchmark_http_client.request_to_response"]->count());
+    EXPECT_EQ(2 * (execution + 1), getCounter("http_2xx"));
+    EXPECT_EQ(0, getCounter("requests_abandoned_at_termination"));
+    dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
+    client_->resetStatistics();
+    client_->setShouldMeasureLatencies(true);
+  }
+  client_->terminate();
+}
+
 UserDefinedOutputPluginPtr
 CreateTestUserDefinedOutputPlugin(const std::string& typed_config_textproto) {
   TypedExtensionConfig typed_config;
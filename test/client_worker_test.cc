@@ -56,11 +56,11 @@ public:
         .Times(1)
         .WillOnce(Return(ByMove(std::unique_ptr<BenchmarkClient>(benchmark_client_))));
 
-    EXPECT_CALL(sequencer_factory_, create(_, _, _, _, _, _))
+    EXPECT_CALL(sequencer_factory_, create(_, _, _, _, _, _, _))
         .Times(1)
         .WillOnce(Return(ByMove(std::unique_ptr<Sequencer>(sequencer_))));
 
-    EXPECT_CALL(request_generator_factory_, create(_, _, _, _))
+    EXPECT_CALL(request_generator_factory_, create(_, _, _, _, _))
         .Times(1)
         .WillOnce(Return(ByMove(std::unique_ptr<RequestSource>(request_generator_))));
     EXPECT_CALL(*request_generator_, initOnThread());
@@ -121,16 +121,18 @@ TEST_F(ClientWorkerTest, BasicTest) {
     EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(true));
     EXPECT_CALL(*sequencer_, start);
     EXPECT_CALL(*sequencer_, waitForCompletion);
+    EXPECT_CALL(*benchmark_client_, onExecutionEnded());
     EXPECT_CALL(*benchmark_client_, terminate());
   }
   int worker_number = 12345;
 
   std::vector<UserDefinedOutputNamePluginPair> user_defined_output_plugins;
 
+  WorkerStartBarrier start_barrier(time_system_, 1, 0ns, time_system_.monotonicTime());
   auto worker = std::make_unique<ClientWorkerImpl>(
       *api_, tls_, cluster_manager_ptr_, benchmark_client_factory_, termination_predicate_factory_,
-      sequencer_factory_, request_generator_factory_, store_, worker_number,
-      time_system_.monotonicTime(), tracer_, ClientWorkerImpl::HardCodedWarmupStyle::ON,
+      sequencer_factory_, request_generator_factory_, store_, worker_number, start_barrier, tracer_,
+      ClientWorkerImpl::HardCodedWarmupStyle::ON, absl::nullopt,
       std::move(user_defined_output_plugins));
 
   worker->start();
@@ -149,5 +151,162 @@ TEST_F(ClientWorkerTest, BasicTest) {
   worker->shutdown();
 }
 
+TEST_F(ClientWorkerTest, SwitchPhaseAddsPhase) {
+  MockSequencer* switched_sequencer = new MockSequencer();
+  ClientWorkerImpl* worker_ptr = nullptr;
+  nighthawk::client::LoadPhase load_phase;
+  load_phase.mutable_id()->set_value("switched");
+  load_phase.mutable_duration()->set_seconds(1);
+  load_phase.mutable_constant()->mutable_requests_per_second()->set_value(10);
+  const std::string latencies_id = "benchmark_http_client.request_to_response";
+  StreamingStatistic latencies_before_switch;
+  latencies_before_switch.addValue(1);
+  StreamingStatistic latencies_after_switch;
+  {
+    InSequence dummy;
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(false));
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(true));
+    EXPECT_CALL(*sequencer_, start);
+    // Request the switch while the first phase runs. The switch time lies in the past, so the
+    // first phase ends and the switched-to phase starts right away.
+    EXPECT_CALL(*sequencer_, waitForCompletion).WillOnce(Invoke([&worker_ptr, &load_phase]() {
+      worker_ptr->switchPhase(load_phase, Envoy::MonotonicTime());
+    }));
+    // Latencies observed before the switch stay with the first phase.
+    EXPECT_CALL(*benchmark_client_, retireStatistics())
+        .WillOnce(Return(StatisticPtrMap{{latencies_id, &latencies_before_switch}}));
+    EXPECT_CALL(termination_predicate_factory_, createForLoadPhase(_, _, _, _))
+        .WillOnce(Return(ByMove(createMockTerminationPredicate())));
+    EXPECT_CALL(sequencer_factory_, createForLoadPhase(_, _, _, _, _, _, Eq(absl::nullopt), _))
+        .WillOnce(Return(ByMove(std::unique_ptr<Sequencer>(switched_sequencer))));
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(true));
+    EXPECT_CALL(*switched_sequencer, start);
+    EXPECT_CALL(*switched_sequencer, waitForCompletion);
+    EXPECT_CALL(*benchmark_client_, onExecutionEnded());
+    EXPECT_CALL(*benchmark_client_, statistics())
+        .WillOnce(Return(StatisticPtrMap{{latencies_id, &latencies_after_switch}}));
+    EXPECT_CALL(*benchmark_client_, terminate());
+  }
+  EXPECT_CALL(*sequencer_, statistics()).WillRepeatedly(Return(StatisticPtrMap()));
+  EXPECT_CALL(*switched_sequencer, statistics()).WillRepeatedly(Return(StatisticPtrMap()));
+
+  WorkerStartBarrier start_barrier(time_system_, 1, 0ns, time_system_.monotonicTime());
+  auto worker = std::make_unique<ClientWorkerImpl>(
+      *api_, tls_, cluster_manager_ptr_, benchmark_client_factory_, termination_predicate_factory_,
+      sequencer_factory_, request_generator_factory_, store_, 0, start_barrier, tracer_,
+      ClientWorkerImpl::HardCodedWarmupStyle::OFF, absl::nullopt, {});
+  worker_ptr = worker.get();
+
+  worker->start();
+  worker->waitForCompletion();
+
+  ASSERT_EQ(worker->phases().size(), 2);
+  EXPECT_EQ(worker->phases()[1]->id(), "switched");
+  EXPECT_EQ(worker->phaseCounterValues().size(), 2);
+  ASSERT_EQ(worker->phaseClientStatistics().size(), 2);
+  EXPECT_EQ(worker->phaseClientStatistics()[0].at(latencies_id)->count(), 1);
+  EXPECT_EQ(worker->phaseClientStatistics()[1].at(latencies_id)->count(), 0);
+  worker->shutdown();
+}
+
+TEST_F(ClientWorkerTest, GivesEachLoadPhaseItsOwnClientStatistics) {
+  // Replace the sequencer and termination predicate the fixture expects with load phase ones.
+  Mock::VerifyAndClearExpectations(&sequencer_factory_);
+  Mock::VerifyAndClearExpectations(&termination_predicate_factory_);
+  nighthawk::client::LoadProfile load_profile;
+  for (const char* id : {"first", "second"}) {
+    nighthawk::client::LoadPhase* load_phase = load_profile.add_phases();
+    load_phase->mutable_id()->set_value(id);
+    load_phase->mutable_duration()->set_seconds(1);
+    load_phase->mutable_constant()->mutable_requests_per_second()->set_value(10);
+  }
+  const std::string latencies_id = "benchmark_http_client.request_to_response";
+  StreamingStatistic first_latencies;
+  first_latencies.addValue(1);
+  StreamingStatistic second_latencies;
+  second_latencies.addValue(2);
+  second_latencies.addValue(3);
+  MockSequencer* first_sequencer = new MockSequencer();
+  MockSequencer* second_sequencer = new MockSequencer();
+  EXPECT_CALL(termination_predicate_factory_, createForLoadPhase(_, _, _, _))
+      .WillOnce(Return(ByMove(createMockTerminationPredicate())))
+      .WillOnce(Return(ByMove(createMockTerminationPredicate())));
+  {
+    InSequence dummy;
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(false));
+    EXPECT_CALL(sequencer_factory_, createForLoadPhase(_, _, _, _, _, _, _, _))
+        .WillOnce(Return(ByMove(std::unique_ptr<Sequencer>(first_sequencer))));
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(true));
+    EXPECT_CALL(*first_sequencer, start);
+    EXPECT_CALL(*first_sequencer, waitForCompletion);
+    EXPECT_CALL(*benchmark_client_, retireStatistics())
+        .WillOnce(Return(StatisticPtrMap{{latencies_id, &first_latencies}}));
+    EXPECT_CALL(sequencer_factory_, createForLoadPhase(_, _, _, _, _, _, _, _))
+        .WillOnce(Return(ByMove(std::unique_ptr<Sequencer>(second_sequencer))));
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(true));
+    EXPECT_CALL(*second_sequencer, start);
+    EXPECT_CALL(*second_sequencer, waitForCompletion);
+    EXPECT_CALL(*benchmark_client_, onExecutionEnded());
+    EXPECT_CALL(*benchmark_client_, statistics())
+        .WillOnce(Return(StatisticPtrMap{{latencies_id, &second_latencies}}));
+    EXPECT_CALL(*benchmark_client_, terminate());
+  }
+  EXPECT_CALL(*first_sequencer, statistics()).WillRepeatedly(Return(StatisticPtrMap()));
+  EXPECT_CALL(*second_sequencer, statistics()).WillRepeatedly(Return(StatisticPtrMap()));
+
+  WorkerStartBarrier start_barrier(time_system_, 1, 0ns, time_system_.monotonicTime());
+  auto worker = std::make_unique<ClientWorkerImpl>(
+      *api_, tls_, cluster_manager_ptr_, benchmark_client_factory_, termination_predicate_factory_,
+      sequencer_factory_, request_generator_factory_, store_, 0, start_barrier, tracer_,
+      ClientWorkerImpl::HardCodedWarmupStyle::OFF, load_profile, {});
+
+  worker->start();
+  worker->waitForCompletion();
+
+  ASSERT_EQ(worker->phases().size(), 2);
+  ASSERT_EQ(worker->phaseClientStatistics().size(), 2);
+  EXPECT_EQ(worker->phaseClientStatistics()[0].at(latencies_id)->count(), 1);
+  EXPECT_EQ(worker->phaseClientStatistics()[1].at(latencies_id)->count(), 2);
+  // The results of the whole execution span both phases.
+  EXPECT_EQ(worker->statistics().at(latencies_id)->count(), 3);
+  worker->shutdown();
+}
+
+TEST_F(ClientWorkerTest, ReplaysReleaseTimingFromTheCommonStartTime) {
+  // Replace the sequencer the fixture expects with one that replays the release timing.
+  Mock::VerifyAndClearExpectations(&sequencer_factory_);
+  MockSequencer* release_timing_sequencer = new MockSequencer();
+  class NoRequestsLeft : public RequestReleaseTiming {
+  public:
+    absl::optional<std::chrono::nanoseconds> nextReleaseOffset() override { return absl::nullopt; }
+  } release_timing;
+  const Envoy::MonotonicTime common_start = time_system_.monotonicTime() + 10s;
+  EXPECT_CALL(*request_generator_, releaseTiming()).WillRepeatedly(Return(&release_timing));
+  // Trace entries are claimed by the workers in a single order, so the second worker must not
+  // replay them offset by its stagger.
+  EXPECT_CALL(sequencer_factory_,
+              createForReleaseTiming(_, _, _, _, _, _, Eq(common_start), Eq(1)))
+      .WillOnce(Return(ByMove(std::unique_ptr<Sequencer>(release_timing_sequencer))));
+  {
+    InSequence dummy;
+    EXPECT_CALL(*benchmark_client_, setShouldMeasureLatencies(true));
+    EXPECT_CALL(*release_timing_sequencer, start);
+    EXPECT_CALL(*release_timing_sequencer, waitForCompletion);
+    EXPECT_CALL(*benchmark_client_, onExecutionEnded());
+    EXPECT_CALL(*benchmark_client_, terminate());
+  }
+  EXPECT_CALL(*release_timing_sequencer, statistics()).WillRepeatedly(Return(StatisticPtrMap()));
+
+  WorkerStartBarrier start_barrier(time_system_, 1, 1s, common_start);
+  auto worker = std::make_unique<ClientWorkerImpl>(
+      *api_, tls_, cluster_manager_ptr_, benchmark_client_factory_, termination_predicate_factory_,
+      sequencer_factory_, request_generator_factory_, store_, 1, start_barrier, tracer_,
+      ClientWorkerImpl::HardCodedWarmupStyle::OFF, absl::nullopt, {});
+
+  worker->start();
+  worker->waitForCompletion();
+  worker->shutdown();
+}
+
 } // namespace Client
 } // namespace Nighthawk
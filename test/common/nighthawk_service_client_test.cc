@@ -85,6 +85,35 @@ TEST(PerformNighthawkBenchmark, ReturnsNighthawkResponseSuccessfully) {
   EXPECT_THAT(actual_response, EqualsProto(expected_response));
 }
 
+TEST(PerformNighthawkBenchmark, SkipsIntermediateResponses) {
+  ExecutionResponse intermediate_response;
+  intermediate_response.set_intermediate(true);
+  intermediate_response.set_execution_id("intermediate");
+  ExecutionResponse expected_response;
+  expected_response.set_execution_id("final");
+  nighthawk::client::MockNighthawkServiceStub mock_nighthawk_service_stub;
+  EXPECT_CALL(mock_nighthawk_service_stub, ExecutionStreamRaw)
+      .WillOnce([&intermediate_response, &expected_response](grpc::ClientContext*) {
+        auto* mock_reader_writer =
+            new MockClientReaderWriter<ExecutionRequest, ExecutionResponse>();
+        EXPECT_CALL(*mock_reader_writer, Read(_))
+            .WillOnce(DoAll(SetArgPointee<0>(intermediate_response), Return(true)))
+            .WillOnce(DoAll(SetArgPointee<0>(expected_response), Return(true)))
+            .WillOnce(DoAll(SetArgPointee<0>(intermediate_response), Return(true)))
+            .WillOnce(Return(false));
+        EXPECT_CALL(*mock_reader_writer, Write(_, _)).WillOnce(Return(true));
+        EXPECT_CALL(*mock_reader_writer, WritesDone()).WillOnce(Return(true));
+        EXPECT_CALL(*mock_reader_writer, Finish()).WillOnce(Return(grpc::Status::OK));
+        return mock_reader_writer;
+      });
+
+  NighthawkServiceClientImpl client;
+  absl::StatusOr<ExecutionResponse> response_or =
+      client.PerformNighthawkBenchmark(&mock_nighthawk_service_stub, CommandLineOptions());
+  ASSERT_TRUE(response_or.ok());
+  EXPECT_THAT(response_or.value(), EqualsProto(expected_response));
+}
+
 TEST(PerformNighthawkBenchmark, ReturnsErrorIfNighthawkServiceDoesNotSendResponse) {
   nighthawk::client::MockNighthawkServiceStub mock_nighthawk_service_stub;
   // Configure the mock Nighthawk Service stub to return an inner mock channel when the code under
@@ -0,0 +1,109 @@
+#include <string>
+#include <vector>
+
+#include "external/envoy/test/test_common/status_utility.h"
+
+#include "source/common/cpu_topology_impl.h"
+
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace Nighthawk {
+namespace {
+
+using ::Envoy::StatusHelpers::StatusIs;
+
+class CpuTopologyTest : public Test {};
+
+TEST_F(CpuTopologyTest, ParseCpuList) {
+  absl::StatusOr<CpuSet> cpus = CpuTopology::parseCpuList("0-3,8, 10-11\n");
+  ASSERT_TRUE(cpus.ok());
+  EXPECT_THAT(*cpus, ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  cpus = CpuTopology::parseCpuList("5,1-2,2");
+  ASSERT_TRUE(cpus.ok());
+  EXPECT_THAT(*cpus, ElementsAre(1, 2, 5));
+}
+
+TEST_F(CpuTopologyTest, ParseBadCpuList) {
+  for (const std::string& cpu_list : {"", "\n", "a", "3-1", "1-", "-1", "0-100000", "1,,x"}) {
+    EXPECT_THAT(CpuTopology::parseCpuList(cpu_list),
+                StatusIs(absl::StatusCode::kInvalidArgument))
+        << cpu_list;
+  }
+}
+
+TEST_F(CpuTopologyTest, ToCpuList) {
+  EXPECT_EQ(CpuTopology::toCpuList({}), "");
+  EXPECT_EQ(CpuTopology::toCpuList({4}), "4");
+  EXPECT_EQ(CpuTopology::toCpuList({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+}
+
+TEST_F(CpuTopologyTest, NodeOf) {
+  const CpuTopology topology({{0, {0, 1, 2, 3}}, {1, {4, 5, 6, 7}}});
+  EXPECT_EQ(topology.nodeOf({1}), 0);
+  EXPECT_EQ(topology.nodeOf({4, 7}), 1);
+  EXPECT_EQ(topology.nodeOf({3, 4}), absl::nullopt);
+  EXPECT_EQ(topology.nodeOf({9}), absl::nullopt);
+  EXPECT_EQ(topology.nodeOf({}), absl::nullopt);
+}
+
+TEST_F(CpuTopologyTest, CompactLayoutFillsNodesInOrder) {
+  const CpuTopology topology({{0, {0, 2, 4, 6}}, {1, {1, 3, 5, 7}}});
+  std::vector<CpuSet> layout = topology.compactLayout({0, 1, 2, 3, 4, 5, 6, 7}, 6);
+  EXPECT_THAT(layout, ElementsAre(ElementsAre(0), ElementsAre(2), ElementsAre(4), ElementsAre(6),
+                                  ElementsAre(1), ElementsAre(3)));
+  // Only allowed cpus are used, and cpus are handed out again when there are more workers.
+  layout = topology.compactLayout({2, 3}, 3);
+  EXPECT_THAT(layout, ElementsAre(ElementsAre(2), ElementsAre(3), ElementsAre(2)));
+  // Allowed cpus that are not part of any known node go last.
+  layout = topology.compactLayout({5, 9}, 2);
+  EXPECT_THAT(layout, ElementsAre(ElementsAre(5), ElementsAre(9)));
+  EXPECT_THAT(topology.compactLayout({}, 2), IsEmpty());
+}
+
+TEST_F(CpuTopologyTest, FromSysfs) {
+  TestEnvironment::createPath(TestEnvironment::temporaryPath("cpu_topology/node0"));
+  TestEnvironment::createPath(TestEnvironment::temporaryPath("cpu_topology/node2"));
+  TestEnvironment::createPath(TestEnvironment::temporaryPath("cpu_topology/node3"));
+  TestEnvironment::writeStringToFileForTest("cpu_topology/node0/cpulist", "0-1\n");
+  TestEnvironment::writeStringToFileForTest("cpu_topology/node2/cpulist", "2,3\n");
+  // Memory-only nodes have no cpus, and are skipped.
+  TestEnvironment::writeStringToFileForTest("cpu_topology/node3/cpulist", "\n");
+  const CpuTopology topology =
+      CpuTopology::fromSystem(TestEnvironment::temporaryPath("cpu_topology"));
+  ASSERT_EQ(topology.nodes().size(), 2);
+  EXPECT_EQ(topology.nodes()[0].id, 0);
+  EXPECT_THAT(topology.nodes()[0].cpus, ElementsAre(0, 1));
+  EXPECT_EQ(topology.nodes()[1].id, 2);
+  EXPECT_THAT(topology.nodes()[1].cpus, ElementsAre(2, 3));
+}
+
+TEST_F(CpuTopologyTest, FromSysfsFallsBackToSingleNode) {
+  const CpuTopology topology =
+      CpuTopology::fromSystem(TestEnvironment::temporaryPath("cpu_topology_does_not_exist"));
+  ASSERT_EQ(topology.nodes().size(), 1);
+  EXPECT_EQ(topology.nodes()[0].id, 0);
+}
+
+#ifdef __linux__
+TEST_F(CpuTopologyTest, PinCurrentThread) {
+  absl::StatusOr<CpuSet> original = CpuTopology::currentThreadAffinity();
+  ASSERT_TRUE(original.ok());
+  ASSERT_FALSE(original->empty());
+  const CpuSet first = {original->front()};
+  EXPECT_TRUE(CpuTopology::setCurrentThreadAffinity(first).ok());
+  absl::StatusOr<CpuSet> pinned = CpuTopology::currentThreadAffinity();
+  ASSERT_TRUE(pinned.ok());
+  EXPECT_EQ(*pinned, first);
+  EXPECT_TRUE(CpuTopology::setCurrentThreadAffinity(*original).ok());
+  EXPECT_THAT(CpuTopology::setCurrentThreadAffinity({}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+#endif
+
+} // namespace
+} // namespace Nighthawk
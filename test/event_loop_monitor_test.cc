@@ -0,0 +1,86 @@
+#include <chrono>
+
+#include "external/envoy/source/common/api/api_impl.h"
+#include "external/envoy/test/mocks/event/mocks.h"
+#include "external/envoy/test/test_common/utility.h"
+
+#include "source/client/event_loop_monitor.h"
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+namespace Nighthawk {
+namespace Client {
+namespace {
+
+class EventLoopMonitorTest : public testing::Test {
+public:
+  EventLoopMonitorTest()
+      : api_(Envoy::Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test")) {}
+
+  // Runs the event loop until a few timers have fired one after the other.
+  void runTimers() {
+    int fired = 0;
+    Envoy::Event::TimerPtr timer;
+    timer = dispatcher_->createTimer([this, &fired, &timer]() {
+      if (++fired == 3) {
+        dispatcher_->exit();
+      } else {
+        timer->enableTimer(1ms);
+      }
+    });
+    timer->enableTimer(1ms);
+    dispatcher_->run(Envoy::Event::Dispatcher::RunType::Block);
+  }
+
+  Envoy::Api::ApiPtr api_;
+  Envoy::Event::DispatcherPtr dispatcher_;
+};
+
+TEST_F(EventLoopMonitorTest, ObservesIterations) {
+  EventLoopMonitor monitor(*dispatcher_, dispatcher_->timeSource());
+  monitor.start();
+  runTimers();
+  monitor.stop();
+  EXPECT_GE(monitor.iterations(), 3);
+  EXPECT_GE(monitor.busyStatistic().count(), 3);
+  EXPECT_EQ(monitor.busyStatistic().count(), monitor.callbacksStatistic().count());
+  EXPECT_GE(monitor.callbacksStatistic().max(), 1);
+  EXPECT_EQ(monitor.busyStatistic().id(), "event_loop.busy");
+  EXPECT_EQ(monitor.callbacksStatistic().id(), "event_loop.callback_count");
+  // Nothing is observed after stopping, and starting again starts from scratch.
+  const uint64_t iterations = monitor.iterations();
+  runTimers();
+  EXPECT_EQ(monitor.iterations(), iterations);
+  monitor.start();
+  EXPECT_EQ(monitor.iterations(), 0);
+  EXPECT_EQ(monitor.busyDuration(), 0ns);
+}
+
+TEST_F(EventLoopMonitorTest, ObservesNothingWithoutLibevent) {
+  testing::NiceMock<Envoy::Event::MockDispatcher> dispatcher;
+  EventLoopMonitor monitor(dispatcher, dispatcher_->timeSource());
+  monitor.start();
+  monitor.stop();
+  EXPECT_EQ(monitor.iterations(), 0);
+}
+
+#ifdef __linux__
+TEST(ThreadCpuUsageTest, CurrentThread) {
+  const absl::StatusOr<ThreadCpuUsage> before = ThreadCpuUsage::currentThread();
+  ASSERT_TRUE(before.ok());
+  volatile uint64_t sum = 0;
+  for (uint64_t i = 0; i < 10000000; i++) {
+    sum += i;
+  }
+  const absl::StatusOr<ThreadCpuUsage> after = ThreadCpuUsage::currentThread();
+  ASSERT_TRUE(after.ok());
+  EXPECT_GE(after->user_time + after->system_time, before->user_time + before->system_time);
+  EXPECT_GE(after->voluntary_context_switches, before->voluntary_context_switches);
+}
+#endif
+
+} // namespace
+} // namespace Client
+} // namespace Nighthawk
@@ -54,6 +54,27 @@ TEST_F(FactoriesTest, CreateBenchmarkClient) {
   EXPECT_NE(nullptr, benchmark_client.get());
 }
 
+TEST_F(FactoriesTest, TerminationPredicatesRelativeToCurrentCounterValues) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  EXPECT_CALL(options_, noDuration()).WillRepeatedly(Return(true));
+  EXPECT_CALL(options_, failurePredicates())
+      .WillRepeatedly(Return(TerminationPredicateMap{{"benchmark.http_5xx", 0}}));
+  EXPECT_CALL(options_, terminationPredicates()).WillRepeatedly(Return(TerminationPredicateMap{}));
+  Envoy::Stats::Counter& http_5xx = stats_scope_.counterFromString("benchmark.http_5xx");
+  http_5xx.inc();
+  TerminationPredicateFactoryImpl absolute_factory(options_);
+  TerminationPredicateFactoryImpl relative_factory(options_,
+                                                   /*relative_to_current_counter_values=*/true);
+  TerminationPredicatePtr absolute_predicate =
+      absolute_factory.create(time_system, stats_scope_, time_system.monotonicTime());
+  TerminationPredicatePtr relative_predicate =
+      relative_factory.create(time_system, stats_scope_, time_system.monotonicTime());
+  EXPECT_EQ(absolute_predicate->evaluateChain(), TerminationPredicate::Status::FAIL);
+  EXPECT_EQ(relative_predicate->evaluateChain(), TerminationPredicate::Status::PROCEED);
+  http_5xx.inc();
+  EXPECT_EQ(relative_predicate->evaluateChain(), TerminationPredicate::Status::FAIL);
+}
+
 TEST_F(FactoriesTest, CreateRequestSourcePluginWithWorkingJsonReturnsWorkingRequestSource) {
   absl::optional<envoy::config::core::v3::TypedExtensionConfig> request_source_plugin_config;
   std::string request_source_plugin_config_json =
@@ -88,7 +109,8 @@ TEST_F(FactoriesTest, CreateRequestSourcePluginWithWorkingJsonReturnsWorkingRequ
   RequestSourceFactoryImpl factory(options_, *api_);
   Envoy::Upstream::ClusterManagerPtr cluster_manager;
   Nighthawk::RequestSourcePtr request_source = factory.create(
-      cluster_manager, dispatcher_, *stats_scope_.createScope("foo."), "requestsource");
+      cluster_manager, dispatcher_, *stats_scope_.createScope("foo."), "requestsource",
+      /*worker_id=*/0);
   EXPECT_NE(nullptr, request_source.get());
   Nighthawk::RequestGenerator generator = request_source->get();
   Nighthawk::RequestPtr request = generator();
@@ -129,7 +151,7 @@ TEST_F(FactoriesTest, CreateRequestSourcePluginWithNonWorkingJsonThrowsError) {
   Envoy::Upstream::ClusterManagerPtr cluster_manager;
   EXPECT_THROW_WITH_REGEX(
       factory.create(cluster_manager, dispatcher_, *stats_scope_.createScope("foo."),
-                     "requestsource"),
+                     "requestsource", /*worker_id=*/0),
       NighthawkException,
       "Request Source plugin loading error should have been caught during input validation");
 }
@@ -152,7 +174,8 @@ TEST_F(FactoriesTest, CreateRequestSource) {
   RequestSourceFactoryImpl factory(options_, *api_);
   Envoy::Upstream::ClusterManagerPtr cluster_manager;
   RequestSourcePtr request_generator = factory.create(
-      cluster_manager, dispatcher_, *stats_scope_.createScope("foo."), "requestsource");
+      cluster_manager, dispatcher_, *stats_scope_.createScope("foo."), "requestsource",
+      /*worker_id=*/0);
   EXPECT_NE(nullptr, request_generator.get());
 }
 
@@ -172,10 +195,34 @@ TEST_F(FactoriesTest, CreateRemoteRequestSource) {
   RequestSourceFactoryImpl factory(options_, *api_);
   Envoy::Upstream::ClusterManagerPtr cluster_manager;
   RequestSourcePtr request_generator = factory.create(
-      cluster_manager, dispatcher_, *stats_scope_.createScope("foo."), "requestsource");
+      cluster_manager, dispatcher_, *stats_scope_.createScope("foo."), "requestsource",
+      /*worker_id=*/0);
   EXPECT_NE(nullptr, request_generator.get());
 }
 
+TEST_F(FactoriesTest, CreateSharedRemoteRequestSources) {
+  EXPECT_CALL(options_, requestSourceSharedStream()).WillOnce(Return(true));
+  EXPECT_CALL(options_, requestMethod()).Times(2);
+  EXPECT_CALL(options_, requestBodySize()).Times(2);
+  EXPECT_CALL(options_, uri()).Times(4).WillRepeatedly(Return("http://foo/"));
+  EXPECT_CALL(options_, requestSource()).Times(2).WillRepeatedly(Return("http://bar/"));
+  EXPECT_CALL(options_, requestsPerSecond()).Times(3).WillRepeatedly(Return(5));
+  EXPECT_CALL(options_, toCommandLineOptions()).Times(2).WillRepeatedly([]() {
+    return std::make_unique<nighthawk::client::CommandLineOptions>();
+  });
+  RequestSourceFactoryImpl factory(options_, *api_, /*workers=*/2);
+  Envoy::Upstream::ClusterManagerPtr cluster_manager;
+  for (int i = 0; i < 2; i++) {
+    RequestSourcePtr request_source =
+        factory.create(cluster_manager, dispatcher_, *stats_scope_.createScope("foo."),
+                       "requestsource", /*worker_id=*/i);
+    ASSERT_NE(nullptr, request_source.get());
+    StatisticPtrMap statistics = request_source->statistics();
+    EXPECT_EQ(statistics.count("request_source.queued_request_count"), 1);
+    EXPECT_EQ(statistics.count("request_source.stall"), 1);
+  }
+}
+
 TEST_F(FactoriesTest, CreateSequencer) {}
 class SequencerFactoryTest
     : public FactoriesTest,
@@ -199,7 +246,7 @@ public:
     };
     auto sequencer = factory.create(api_->timeSource(), dispatcher_, dummy_sequencer_target,
                                     std::make_unique<MockTerminationPredicate>(), stats_scope_,
-                                    time_system.monotonicTime() + 10ms);
+                                    time_system.monotonicTime() + 10ms, 0);
     EXPECT_NE(nullptr, sequencer.get());
   }
 };
@@ -211,11 +258,90 @@ INSTANTIATE_TEST_SUITE_P(SequencerIdleStrategies, SequencerFactoryTest,
                                    nighthawk::client::SequencerIdleStrategy::SLEEP,
                                    nighthawk::client::SequencerIdleStrategy::SPIN}));
 
+TEST_F(FactoriesTest, CreateRecordingSequencer) {
+  EXPECT_CALL(options_, recordSchedule()).WillRepeatedly(Return("schedule.bin"));
+  SequencerFactoryImpl factory(options_);
+  ASSERT_NE(nullptr, factory.recordedSchedule());
+  EXPECT_EQ(0, factory.recordedSchedule()->workers());
+  // The entries of all workers are added up front, before any of them records.
+  factory.setWorkers(2);
+  EXPECT_EQ(2, factory.recordedSchedule()->workers());
+  EXPECT_CALL(options_, requestsPerSecond()).WillOnce(Return(1));
+  EXPECT_CALL(options_, sequencerIdleStrategy())
+      .WillOnce(Return(nighthawk::client::SequencerIdleStrategy::SPIN));
+  EXPECT_CALL(dispatcher_, createTimer_(_)).Times(2);
+  Envoy::Event::SimulatedTimeSystem time_system;
+  const SequencerTarget dummy_sequencer_target = [](const CompletionCallback&) -> bool {
+    return true;
+  };
+  auto sequencer = factory.create(api_->timeSource(), dispatcher_, dummy_sequencer_target,
+                                  std::make_unique<MockTerminationPredicate>(), stats_scope_,
+                                  time_system.monotonicTime() + 10ms, 1);
+  EXPECT_NE(nullptr, sequencer.get());
+  EXPECT_EQ(2, factory.recordedSchedule()->workers());
+}
+
+TEST_F(FactoriesTest, CreateClosedLoopSequencer) {
+  SequencerFactoryImpl factory(options_);
+  EXPECT_CALL(options_, virtualUsers()).WillRepeatedly(Return(10));
+  EXPECT_CALL(options_, thinkTime()).WillOnce(Return(1ms));
+  EXPECT_CALL(options_, thinkTimeDistribution())
+      .WillOnce(Return(nighthawk::client::ThinkTimeDistribution::EXPONENTIAL));
+  EXPECT_CALL(options_, sequencerIdleStrategy())
+      .WillOnce(Return(nighthawk::client::SequencerIdleStrategy::SPIN));
+  // Closed-loop execution is not paced by a frequency, and doesn't wrap the rate limiter.
+  EXPECT_CALL(options_, requestsPerSecond()).Times(0);
+  EXPECT_CALL(options_, burstSize()).Times(0);
+  EXPECT_CALL(options_, jitterUniform()).Times(0);
+  EXPECT_CALL(dispatcher_, createTimer_(_)).Times(2);
+  Envoy::Event::SimulatedTimeSystem time_system;
+  const SequencerTarget dummy_sequencer_target = [](const CompletionCallback&) -> bool {
+    return true;
+  };
+  auto sequencer = factory.create(api_->timeSource(), dispatcher_, dummy_sequencer_target,
+                                  std::make_unique<MockTerminationPredicate>(), stats_scope_,
+                                  time_system.monotonicTime() + 10ms, 0);
+  EXPECT_NE(nullptr, sequencer.get());
+}
+
+TEST_F(FactoriesTest, CreateReleaseTimingSequencer) {
+  class NoReleaseTiming : public RequestReleaseTiming {
+  public:
+    absl::optional<std::chrono::nanoseconds> nextReleaseOffset() override { return absl::nullopt; }
+  };
+  NoReleaseTiming timing;
+  SequencerFactoryImpl factory(options_);
+  EXPECT_CALL(options_, sequencerIdleStrategy())
+      .WillOnce(Return(nighthawk::client::SequencerIdleStrategy::SPIN));
+  // The request times take the place of the rate, and are not skewed by bursts or jitter.
+  EXPECT_CALL(options_, requestsPerSecond()).Times(0);
+  EXPECT_CALL(options_, burstSize()).Times(0);
+  EXPECT_CALL(options_, jitterUniform()).Times(0);
+  EXPECT_CALL(dispatcher_, createTimer_(_)).Times(2);
+  Envoy::Event::SimulatedTimeSystem time_system;
+  const SequencerTarget dummy_sequencer_target = [](const CompletionCallback&) -> bool {
+    return true;
+  };
+  auto sequencer = factory.createForReleaseTiming(
+      api_->timeSource(), dispatcher_, dummy_sequencer_target,
+      std::make_unique<MockTerminationPredicate>(), stats_scope_, timing,
+      time_system.monotonicTime() + 10ms, 0);
+  ASSERT_NE(nullptr, sequencer.get());
+  EXPECT_EQ(sequencer->statistics().count("sequencer.schedule_deviation"), 1);
+}
+
 TEST_F(FactoriesTest, CreateStatistic) {
   StatisticFactoryImpl factory(options_);
   EXPECT_NE(nullptr, factory.create().get());
 }
 
+TEST_F(FactoriesTest, CreateStatisticTrackingIntervals) {
+  StatisticFactoryImpl factory(options_);
+  EXPECT_CALL(options_, reportInterval()).WillOnce(Return(0s)).WillOnce(Return(1s));
+  EXPECT_EQ(nullptr, factory.create()->takeInterval());
+  EXPECT_NE(nullptr, factory.create()->takeInterval());
+}
+
 class OutputFormatterFactoryTest
     : public FactoriesTest,
       public WithParamInterface<nighthawk::client::OutputFormat::OutputFormatOptions> {
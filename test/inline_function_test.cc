@@ -0,0 +1,78 @@
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "nighthawk/common/inline_function.h"
+
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace Nighthawk {
+namespace {
+
+using TestFunction = InlineFunction<int(int), 32>;
+
+TEST(InlineFunctionTest, EmptyFunction) {
+  TestFunction f;
+  EXPECT_FALSE(f);
+  EXPECT_TRUE(f == nullptr);
+  TestFunction g = nullptr;
+  EXPECT_FALSE(g);
+}
+
+TEST(InlineFunctionTest, InvokesSmallCallableInPlace) {
+  int offset = 10;
+  auto lambda = [offset](int value) { return value + offset; };
+  static_assert(TestFunction::storesInline<decltype(lambda)>(), "Expected in place storage");
+  TestFunction f = lambda;
+  EXPECT_TRUE(f != nullptr);
+  EXPECT_EQ(f(1), 11);
+}
+
+TEST(InlineFunctionTest, StoresLargeCallableOnTheHeap) {
+  std::array<int, 16> values{};
+  values[3] = 4;
+  auto lambda = [values](int index) { return values[index]; };
+  static_assert(!TestFunction::storesInline<decltype(lambda)>(), "Expected heap storage");
+  TestFunction f = lambda;
+  TestFunction copy = f;
+  TestFunction moved = std::move(f);
+  EXPECT_FALSE(f);
+  EXPECT_EQ(copy(3), 4);
+  EXPECT_EQ(moved(3), 4);
+}
+
+TEST(InlineFunctionTest, CopiesAndMovesCaptures) {
+  auto counter = std::make_shared<int>(0);
+  {
+    TestFunction f = [counter](int value) { return *counter += value; };
+    EXPECT_EQ(counter.use_count(), 2);
+    TestFunction copy = f;
+    EXPECT_EQ(counter.use_count(), 3);
+    TestFunction moved = std::move(copy);
+    EXPECT_EQ(counter.use_count(), 3);
+    EXPECT_EQ(f(1), 1);
+    EXPECT_EQ(moved(2), 3);
+    f = nullptr;
+    EXPECT_EQ(counter.use_count(), 2);
+    f = moved;
+    EXPECT_EQ(counter.use_count(), 3);
+  }
+  // All captures are destroyed along with the functions.
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(InlineFunctionTest, WrapsOtherCallables) {
+  std::function<int(int)> std_function = [](int value) { return value * 2; };
+  TestFunction f = std_function;
+  EXPECT_EQ(f(21), 42);
+  InlineFunction<void(std::string&)> appender = [](std::string& s) { s += "!"; };
+  std::string s = "hi";
+  appender(s);
+  EXPECT_EQ(s, "hi!");
+}
+
+} // namespace
+} // namespace Nighthawk
@@ -339,6 +339,20 @@ def test_http_concurrency(http_test_server_fixture):
   asserts.assertCounterGreaterEqual(counters, "upstream_cx_http1_total", 4)
 
 
+def test_http_adaptive_concurrency(http_test_server_fixture):
+  """Test that adaptive concurrency calibrates, and reports the calibration in the output."""
+  parsed_json, _ = http_test_server_fixture.runNighthawkClient([
+      "--concurrency adaptive --rps 100", "--duration", "2",
+      http_test_server_fixture.getTestServerRootUri()
+  ])
+  calibration = parsed_json["concurrency_calibration"]
+  asserts.assertGreaterEqual(int(calibration["workers"]), 1)
+  asserts.assertGreater(float(calibration["sustainable_requests_per_second"]), 0)
+  asserts.assertEqual(int(calibration["requested_requests_per_second"]), 100)
+  counters = http_test_server_fixture.getNighthawkCounterMapFromJson(parsed_json)
+  asserts.assertCounterGreaterEqual(counters, "benchmark.http_2xx", 100)
+
+
 @pytest.mark.parametrize('server_config',
                          ["nighthawk/test/integration/configurations/nighthawk_https_origin.yaml"])
 def test_https_h1(https_test_server_fixture):
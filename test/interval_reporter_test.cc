@@ -0,0 +1,108 @@
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "external/envoy/test/test_common/simulated_time_system.h"
+
+#include "source/client/interval_reporter.h"
+#include "source/client/options_impl.h"
+#include "source/common/statistic_impl.h"
+
+#include "test/client/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace Nighthawk {
+namespace Client {
+namespace {
+
+class IntervalReporterTest : public Test, public Envoy::Event::TestUsingSimulatedTime {
+public:
+  IntervalReporterTest()
+      : options_(TestUtility::createOptionsImpl("foo --report-interval 1s https://foo/")),
+        reporter_(simTime(), *options_, 2,
+                  [this](const nighthawk::client::Output& output) { outputs_.push_back(output); }) {
+  }
+
+  IntervalReportPtr makeReport(const uint64_t latency, const uint64_t requests,
+                               const std::chrono::nanoseconds duration) {
+    auto report = std::make_unique<IntervalReport>();
+    auto statistic = std::make_unique<HdrStatistic>();
+    statistic->addValue(latency);
+    statistic->setId("latency");
+    report->statistics["latency"] = std::move(statistic);
+    report->counters["upstream_rq_total"] = requests;
+    report->duration = duration;
+    return report;
+  }
+
+  std::unique_ptr<OptionsImpl> options_;
+  std::vector<nighthawk::client::Output> outputs_;
+  IntervalReporter reporter_;
+};
+
+TEST_F(IntervalReporterTest, EmitsOnceAllWorkersReported) {
+  reporter_.onReport(0, makeReport(10, 1, 1s));
+  reporter_.onReport(0, makeReport(20, 2, 1s));
+  reporter_.onReport(1, makeReport(30, 3, 3s));
+  // Reports are only queued on the reporting threads.
+  EXPECT_TRUE(outputs_.empty());
+  reporter_.onReport(0, nullptr);
+  reporter_.onReport(1, nullptr);
+  reporter_.emitUntilDone();
+  ASSERT_EQ(outputs_.size(), 2);
+  const nighthawk::client::Result& result = outputs_[0].results(0);
+  EXPECT_EQ(result.name(), "global");
+  EXPECT_EQ(result.execution_duration().seconds(), 2);
+  ASSERT_EQ(result.statistics_size(), 1);
+  EXPECT_EQ(result.statistics(0).id(), "latency");
+  EXPECT_EQ(result.statistics(0).count(), 2);
+  ASSERT_EQ(result.counters_size(), 1);
+  EXPECT_EQ(result.counters(0).name(), "upstream_rq_total");
+  EXPECT_EQ(result.counters(0).value(), 4);
+  EXPECT_EQ(outputs_[0].options().report_interval().seconds(), 1);
+  EXPECT_EQ(reporter_.emitted(), 2);
+}
+
+TEST_F(IntervalReporterTest, DoesNotWaitForWorkersThatAreDone) {
+  reporter_.onReport(0, makeReport(10, 1, 1s));
+  reporter_.onReport(0, makeReport(20, 2, 1s));
+  reporter_.onReport(1, nullptr);
+  reporter_.onReport(0, nullptr);
+  reporter_.emitUntilDone();
+  ASSERT_EQ(outputs_.size(), 2);
+  EXPECT_EQ(outputs_[1].results(0).counters(0).value(), 2);
+  EXPECT_EQ(reporter_.emitted(), 2);
+}
+
+TEST_F(IntervalReporterTest, EmitsOnTheWaitingThreadWhileWorkersReport) {
+  const std::thread::id emitting_thread = std::this_thread::get_id();
+  std::vector<std::thread::id> output_threads;
+  IntervalReporter reporter(simTime(), *options_, 2,
+                            [&output_threads](const nighthawk::client::Output&) {
+                              output_threads.push_back(std::this_thread::get_id());
+                            });
+  std::vector<std::thread> workers;
+  for (uint32_t worker_number = 0; worker_number < 2; worker_number++) {
+    workers.emplace_back([this, &reporter, worker_number]() {
+      for (int i = 0; i < 10; i++) {
+        reporter.onReport(worker_number, makeReport(10, 1, 1s));
+      }
+      reporter.onReport(worker_number, nullptr);
+    });
+  }
+  reporter.emitUntilDone();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  EXPECT_EQ(reporter.emitted(), 10);
+  EXPECT_THAT(output_threads, Each(emitting_thread));
+}
+
+} // namespace
+} // namespace Client
+} // namespace Nighthawk
@@ -12,7 +12,10 @@ public:
   MockBenchmarkClient();
 
   MOCK_METHOD(void, terminate, (), (override));
+  MOCK_METHOD(void, onExecutionEnded, (), (override));
   MOCK_METHOD(void, setShouldMeasureLatencies, (bool), (override));
+  MOCK_METHOD(void, resetStatistics, (), (override));
+  MOCK_METHOD(StatisticPtrMap, retireStatistics, (), (override));
   MOCK_METHOD(StatisticPtrMap, statistics, (), (const, override));
   MOCK_METHOD(bool, tryStartRequest, (Client::CompletionCallback), (override));
   MOCK_METHOD(Envoy::Stats::Scope&, scope, (), (const, override));
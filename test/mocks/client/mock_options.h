@@ -86,6 +86,30 @@ public:
   MOCK_METHOD(absl::optional<std::string>, executionId, (), (const, override));
   MOCK_METHOD(const std::vector<envoy::config::core::v3::TypedExtensionConfig>&,
               userDefinedOutputPluginConfigs, (), (const, override));
+  MOCK_METHOD(const absl::optional<nighthawk::client::LoadProfile>&, loadProfile, (),
+              (const, override));
+  MOCK_METHOD(bool, globalRateCoordination, (), (const, override));
+  MOCK_METHOD(uint32_t, virtualUsers, (), (const, override));
+  MOCK_METHOD(std::chrono::nanoseconds, thinkTime, (), (const, override));
+  MOCK_METHOD(nighthawk::client::ThinkTimeDistribution::ThinkTimeDistributionOptions,
+              thinkTimeDistribution, (), (const, override));
+  MOCK_METHOD(absl::optional<uint64_t>, seed, (), (const, override));
+  MOCK_METHOD(std::string, recordSchedule, (), (const, override));
+  MOCK_METHOD(std::string, replaySchedule, (), (const, override));
+  MOCK_METHOD(nighthawk::client::TerminationMode::TerminationModeOptions, terminationMode, (),
+              (const, override));
+  MOCK_METHOD(std::chrono::nanoseconds, drainTimeout, (), (const, override));
+  MOCK_METHOD(nighthawk::client::CpuPinning::CpuPinningOptions, cpuPinning, (),
+              (const, override));
+  MOCK_METHOD(std::vector<std::string>, workerCpuSets, (), (const, override));
+  MOCK_METHOD(std::string, flushWorkerCpuSet, (), (const, override));
+  MOCK_METHOD(std::vector<std::string>, workerSourceAddresses, (), (const, override));
+  MOCK_METHOD(uint32_t, workerSourcePortBase, (), (const, override));
+  MOCK_METHOD(uint32_t, busyPollUs, (), (const, override));
+  MOCK_METHOD(bool, incomingCpuAffinity, (), (const, override));
+  MOCK_METHOD(std::chrono::nanoseconds, reportInterval, (), (const, override));
+  MOCK_METHOD(uint32_t, eventLoopUtilizationThreshold, (), (const, override));
+  MOCK_METHOD(bool, requestSourceSharedStream, (), (const, override));
 };
 
 } // namespace Client
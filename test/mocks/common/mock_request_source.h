@@ -12,6 +12,7 @@ public:
   MOCK_METHOD(RequestGenerator, get, (), (override));
   MOCK_METHOD(void, initOnThread, (), (override));
   MOCK_METHOD(void, destroyOnThread, (), (override));
+  MOCK_METHOD(RequestReleaseTiming*, releaseTiming, (), (override));
 };
 
 } // namespace Nighthawk
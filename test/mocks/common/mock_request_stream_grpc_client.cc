@@ -0,0 +1,7 @@
+#include "test/mocks/common/mock_request_stream_grpc_client.h"
+
+namespace Nighthawk {
+
+MockRequestStreamGrpcClient::MockRequestStreamGrpcClient() = default;
+
+} // namespace Nighthawk
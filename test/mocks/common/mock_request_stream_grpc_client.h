@@ -0,0 +1,17 @@
+#pragma once
+
+#include "nighthawk/common/request_stream_grpc_client.h"
+
+#include "gmock/gmock.h"
+
+namespace Nighthawk {
+
+class MockRequestStreamGrpcClient : public RequestStreamGrpcClient {
+public:
+  MockRequestStreamGrpcClient();
+  MOCK_METHOD(void, start, (), (override));
+  MOCK_METHOD(RequestPtr, maybeDequeue, (), (override));
+  MOCK_METHOD(bool, streamStatusKnown, (), (const, override));
+};
+
+} // namespace Nighthawk
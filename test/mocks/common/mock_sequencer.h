@@ -15,6 +15,8 @@ public:
   MOCK_METHOD(void, waitForCompletion, (), (override));
   MOCK_METHOD(double, completionsPerSecond, (), (const, override));
   MOCK_METHOD(std::chrono::nanoseconds, executionDuration, (), (const, override));
+  MOCK_METHOD(std::chrono::nanoseconds, pacingDuration, (), (const, override));
+  MOCK_METHOD(std::chrono::nanoseconds, idleDuration, (), (const, override));
   MOCK_METHOD(StatisticPtrMap, statistics, (), (const, override));
   MOCK_METHOD(void, cancel, ());
   MOCK_METHOD(RateLimiter&, rate_limiter, (), (const, override));
@@ -13,7 +13,22 @@ public:
               (Envoy::TimeSource & time_source, Envoy::Event::Dispatcher& dispatcher,
                const SequencerTarget& sequencer_target,
                TerminationPredicatePtr&& termination_predicate, Envoy::Stats::Scope& scope,
-               const Envoy::MonotonicTime scheduled_starting_time),
+               const Envoy::MonotonicTime scheduled_starting_time, const int worker_id),
+              (const, override));
+  MOCK_METHOD(SequencerPtr, createForLoadPhase,
+              (Envoy::TimeSource & time_source, Envoy::Event::Dispatcher& dispatcher,
+               const SequencerTarget& sequencer_target,
+               TerminationPredicatePtr&& termination_predicate, Envoy::Stats::Scope& scope,
+               const nighthawk::client::LoadPhase& load_phase,
+               const absl::optional<Envoy::MonotonicTime> scheduled_starting_time,
+               const int worker_id),
+              (const, override));
+  MOCK_METHOD(SequencerPtr, createForReleaseTiming,
+              (Envoy::TimeSource & time_source, Envoy::Event::Dispatcher& dispatcher,
+               const SequencerTarget& sequencer_target,
+               TerminationPredicatePtr&& termination_predicate, Envoy::Stats::Scope& scope,
+               RequestReleaseTiming& timing, const Envoy::MonotonicTime scheduled_starting_time,
+               const int worker_id),
               (const, override));
 };
 
@@ -13,6 +13,11 @@ public:
               (Envoy::TimeSource & time_source, Envoy::Stats::Scope& scope,
                const Envoy::MonotonicTime scheduled_starting_time),
               (const, override));
+  MOCK_METHOD(TerminationPredicatePtr, createForLoadPhase,
+              (Envoy::TimeSource & time_source, Envoy::Stats::Scope& scope,
+               const nighthawk::client::LoadPhase& load_phase,
+               const Envoy::MonotonicTime starting_time),
+              (const, override));
 };
 
 } // namespace Nighthawk
\ No newline at end of file
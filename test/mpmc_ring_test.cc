@@ -0,0 +1,103 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "source/common/mpmc_ring.h"
+
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace Nighthawk {
+namespace {
+
+TEST(MpmcRingTest, RoundsCapacityUpToAPowerOfTwo) {
+  EXPECT_EQ(MpmcRing<int>(0).capacity(), 2);
+  EXPECT_EQ(MpmcRing<int>(2).capacity(), 2);
+  EXPECT_EQ(MpmcRing<int>(5).capacity(), 8);
+  EXPECT_EQ(MpmcRing<int>(1024).capacity(), 1024);
+}
+
+TEST(MpmcRingTest, PopsInPushOrder) {
+  MpmcRing<int> ring(4);
+  int value = 0;
+  EXPECT_FALSE(ring.tryPop(value));
+  // Wrap around a couple of times.
+  for (int lap = 0; lap < 3; lap++) {
+    for (int i = 0; i < 4; i++) {
+      EXPECT_TRUE(ring.tryPush(lap * 4 + i));
+    }
+    EXPECT_EQ(ring.size(), 4);
+    EXPECT_FALSE(ring.tryPush(-1));
+    for (int i = 0; i < 4; i++) {
+      ASSERT_TRUE(ring.tryPop(value));
+      EXPECT_EQ(value, lap * 4 + i);
+    }
+    EXPECT_EQ(ring.size(), 0);
+    EXPECT_FALSE(ring.tryPop(value));
+  }
+}
+
+TEST(MpmcRingTest, DoesNotMoveFromValuesThatCouldNotBePushed) {
+  MpmcRing<std::unique_ptr<int>> ring(2);
+  EXPECT_TRUE(ring.tryPush(std::make_unique<int>(1)));
+  EXPECT_TRUE(ring.tryPush(std::make_unique<int>(2)));
+  auto value = std::make_unique<int>(3);
+  EXPECT_FALSE(ring.tryPush(std::move(value)));
+  ASSERT_NE(value, nullptr);
+  std::unique_ptr<int> popped;
+  ASSERT_TRUE(ring.tryPop(popped));
+  EXPECT_EQ(*popped, 1);
+  EXPECT_TRUE(ring.tryPush(std::move(value)));
+  EXPECT_EQ(value, nullptr);
+}
+
+TEST(MpmcRingTest, DeliversEachValueOnceAcrossThreads) {
+  constexpr int kThreads = 4;
+  constexpr int kValuesPerProducer = 10000;
+  MpmcRing<int> ring(64);
+  std::vector<std::vector<int>> popped(kThreads);
+  std::atomic<int> popped_count{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&ring, t]() {
+      for (int i = 0; i < kValuesPerProducer; i++) {
+        while (!ring.tryPush(t * kValuesPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&ring, &popped, &popped_count, t]() {
+      int value;
+      while (popped_count.load() < kThreads * kValuesPerProducer) {
+        if (ring.tryPop(value)) {
+          popped[t].push_back(value);
+          popped_count++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  std::vector<int> seen(kThreads * kValuesPerProducer, 0);
+  for (const std::vector<int>& values : popped) {
+    // The values of each producer are popped in the order in which it pushed them.
+    std::vector<int> last_of_producer(kThreads, -1);
+    for (const int value : values) {
+      seen[value]++;
+      const int producer = value / kValuesPerProducer;
+      EXPECT_GT(value, last_of_producer[producer]);
+      last_of_producer[producer] = value;
+    }
+  }
+  for (const int count : seen) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+} // namespace
+} // namespace Nighthawk
@@ -209,7 +209,11 @@ TEST_F(OptionsImplTest, AlmostAll) {
       "--max-concurrent-streams 42 "
       "--experimental-h1-connection-reuse-strategy lru --label label1 --label label2 {} "
       "--simple-warmup --stats-sinks {} --stats-sinks {} --stats-flush-interval 10 "
-      "--latency-response-header-name zz --user-defined-plugin-config {}",
+      "--latency-response-header-name zz --user-defined-plugin-config {} "
+      "--global-rate-coordination --termination-mode bounded-drain --drain-timeout 0.25s "
+      "--worker-cpu-set 0-1 --worker-cpu-set 2 --flush-worker-cpu-set 3 "
+      "--worker-source-address 127.0.0.2 --worker-source-address ::1 --busy-poll-us 20 "
+      "--incoming-cpu-affinity",
       client_name_, "{source_address:{address:\"127.0.0.1\",port_value:0}}",
       "{name:\"envoy.transport_sockets.tls\","
       "typed_config:{\"@type\":\"type.googleapis.com/"
@@ -226,6 +230,13 @@ TEST_F(OptionsImplTest, AlmostAll) {
   EXPECT_EQ("8", options->concurrency());
   EXPECT_EQ(nighthawk::client::Verbosity::ERROR, options->verbosity());
   EXPECT_EQ(nighthawk::client::OutputFormat::YAML, options->outputFormat());
+  EXPECT_EQ(nighthawk::client::TerminationMode::BOUNDED_DRAIN, options->terminationMode());
+  EXPECT_EQ(250ms, options->drainTimeout());
+  EXPECT_THAT(options->workerCpuSets(), ElementsAre("0-1", "2"));
+  EXPECT_EQ("3", options->flushWorkerCpuSet());
+  EXPECT_THAT(options->workerSourceAddresses(), ElementsAre("127.0.0.2", "::1"));
+  EXPECT_EQ(20, options->busyPollUs());
+  EXPECT_TRUE(options->incomingCpuAffinity());
   EXPECT_EQ(true, options->prefetchConnections());
   EXPECT_EQ(13, options->burstSize());
   EXPECT_EQ(nighthawk::client::AddressFamily::V6, options->addressFamily());
@@ -268,6 +279,7 @@ TEST_F(OptionsImplTest, AlmostAll) {
   const std::vector<std::string> expected_labels{"label1", "label2"};
   EXPECT_EQ(expected_labels, options->labels());
   EXPECT_TRUE(options->simpleWarmup());
+  EXPECT_TRUE(options->globalRateCoordination());
   EXPECT_EQ(10, options->statsFlushInterval());
   ASSERT_EQ(2, options->statsSinks().size());
   envoy::config::metrics::v3::StatsSink expected_stats_sink1;
@@ -355,6 +367,16 @@ TEST_F(OptionsImplTest, AlmostAll) {
             options->h1ConnectionReuseStrategy());
   EXPECT_THAT(cmd->labels(), ElementsAreArray(expected_labels));
   EXPECT_EQ(cmd->simple_warmup().value(), options->simpleWarmup());
+  EXPECT_EQ(cmd->global_rate_coordination().value(), options->globalRateCoordination());
+  EXPECT_EQ(cmd->termination_mode().value(), options->terminationMode());
+  EXPECT_EQ(Envoy::Protobuf::util::TimeUtil::DurationToNanoseconds(cmd->drain_timeout()),
+            options->drainTimeout().count());
+  EXPECT_EQ(cmd->cpu_pinning().value(), options->cpuPinning());
+  EXPECT_THAT(cmd->worker_cpu_sets(), ElementsAreArray(options->workerCpuSets()));
+  EXPECT_EQ(cmd->flush_worker_cpu_set().value(), options->flushWorkerCpuSet());
+  EXPECT_THAT(cmd->worker_source_addresses(), ElementsAreArray(options->workerSourceAddresses()));
+  EXPECT_EQ(cmd->busy_poll_us().value(), options->busyPollUs());
+  EXPECT_EQ(cmd->incoming_cpu_affinity().value(), options->incomingCpuAffinity());
   EXPECT_EQ(10, cmd->stats_flush_interval().value());
   ASSERT_EQ(cmd->stats_sinks_size(), options->statsSinks().size());
   EXPECT_TRUE(util(cmd->stats_sinks(0), options->statsSinks()[0]));
@@ -907,6 +929,21 @@ TEST_F(OptionsImplTest, AutoConcurrencyValueParsedOK) {
   EXPECT_EQ("auto", options->concurrency());
 }
 
+// Test we accept --concurrency adaptive, but only when the requested rate is a single number.
+TEST_F(OptionsImplTest, AdaptiveConcurrency) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --concurrency adaptive --rps 1000 {} ", client_name_, good_test_uri_));
+  EXPECT_EQ("adaptive", options->concurrency());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_EQ(cmd->concurrency().value(), "adaptive");
+  for (const std::string& flags : {"--virtual-users 5", "--global-rate-coordination"}) {
+    EXPECT_THROW_WITH_REGEX(
+        TestUtility::createOptionsImpl(fmt::format("{} --concurrency adaptive {} {}", client_name_,
+                                                   flags, good_test_uri_)),
+        MalformedArgvException, "--concurrency adaptive is not supported");
+  }
+}
+
 TEST_F(OptionsImplTest, NoDefaultFailurePredicates) {
   std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
       fmt::format("{} --no-default-failure-predicates {}", client_name_, good_test_uri_));
@@ -1296,5 +1333,339 @@ TEST_F(OptionsImplTest, TunnelModeMissingParams) {
       MalformedArgvException, "--tunnel-tls-context is required to use --tunnel-protocol http3");
 }
 
+TEST_F(OptionsImplTest, LoadProfile) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(fmt::format(
+      "{} --load-profile {} {}", client_name_,
+      "{phases:[{id:\"warmup\",duration:\"2s\",linear_ramp:{start_requests_per_second:1,"
+      "end_requests_per_second:10}},{duration:\"3s\",constant:{requests_per_second:10}},"
+      "{duration:\"4s\",sine:{base_requests_per_second:10,amplitude_requests_per_second:5,"
+      "period:\"1s\"}}]}",
+      good_test_uri_));
+  ASSERT_TRUE(options->loadProfile().has_value());
+  const nighthawk::client::LoadProfile& profile = options->loadProfile().value();
+  ASSERT_EQ(3, profile.phases_size());
+  EXPECT_EQ("warmup", profile.phases(0).id().value());
+  EXPECT_TRUE(profile.phases(0).has_linear_ramp());
+  EXPECT_FALSE(profile.phases(1).has_id());
+  EXPECT_EQ(10, profile.phases(1).constant().requests_per_second().value());
+  EXPECT_EQ(5, profile.phases(2).sine().amplitude_requests_per_second().value());
+
+  // Check that the load profile survives a round trip through the proto representation.
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_THAT(cmd->load_profile(), EqualsProto(profile));
+  OptionsImpl options_from_proto(*cmd);
+  EXPECT_THAT(options_from_proto.toCommandLineOptions()->load_profile(), EqualsProto(profile));
+}
+
+TEST_F(OptionsImplTest, LoadProfileRpsCurveFileIsInlined) {
+  const std::string curve_path = TestEnvironment::writeStringToFileForTest(
+      "rps_curve.csv", "# offset seconds, requests per second\n0,1\n\n0.5, 20\n2,5\n");
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --load-profile {{phases:[{{duration:\"3s\",rps_curve:{{file:\"{}\"}}}}]}} {}",
+                  client_name_, curve_path, good_test_uri_));
+  const nighthawk::client::LoadPhase::RpsCurve& curve =
+      options->loadProfile().value().phases(0).rps_curve();
+  EXPECT_TRUE(curve.file().empty());
+  ASSERT_EQ(3, curve.points_size());
+  EXPECT_EQ(500, Envoy::Protobuf::util::TimeUtil::DurationToMilliseconds(curve.points(1).offset()));
+  EXPECT_DOUBLE_EQ(20, curve.points(1).requests_per_second());
+  EXPECT_DOUBLE_EQ(5, curve.points(2).requests_per_second());
+}
+
+TEST_F(OptionsImplTest, VirtualUsers) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(fmt::format(
+      "{} --virtual-users 100 --think-time 0.25s --think-time-distribution exponential {}",
+      client_name_, good_test_uri_));
+  EXPECT_EQ(100, options->virtualUsers());
+  EXPECT_EQ(250ms, options->thinkTime());
+  EXPECT_EQ(nighthawk::client::ThinkTimeDistribution::EXPONENTIAL,
+            options->thinkTimeDistribution());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_EQ(100, cmd->virtual_users().value());
+  EXPECT_EQ(250, Envoy::Protobuf::util::TimeUtil::DurationToMilliseconds(cmd->think_time()));
+  EXPECT_EQ(nighthawk::client::ThinkTimeDistribution::EXPONENTIAL,
+            cmd->think_time_distribution().value());
+  OptionsImpl options_from_proto(*cmd);
+  EXPECT_TRUE(Envoy::MessageUtil()(*(options_from_proto.toCommandLineOptions()), *cmd));
+}
+
+TEST_F(OptionsImplTest, ReportInterval) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --report-interval 2.5s {}", client_name_, good_test_uri_));
+  EXPECT_EQ(2500ms, options->reportInterval());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_EQ(2500, Envoy::Protobuf::util::TimeUtil::DurationToMilliseconds(cmd->report_interval()));
+  OptionsImpl options_from_proto(*cmd);
+  EXPECT_TRUE(Envoy::MessageUtil()(*(options_from_proto.toCommandLineOptions()), *cmd));
+  EXPECT_EQ(0ns, TestUtility::createOptionsImpl(fmt::format("{} {}", client_name_, good_test_uri_))
+                     ->reportInterval());
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --report-interval foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Invalid value for --report-interval");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --report-interval -1s {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "--report-interval is out of range");
+}
+
+TEST_F(OptionsImplTest, EventLoopUtilizationThreshold) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --event-loop-utilization-threshold 80 {}", client_name_, good_test_uri_));
+  EXPECT_EQ(80, options->eventLoopUtilizationThreshold());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_EQ(80, cmd->event_loop_utilization_threshold().value());
+  OptionsImpl options_from_proto(*cmd);
+  EXPECT_TRUE(Envoy::MessageUtil()(*(options_from_proto.toCommandLineOptions()), *cmd));
+  EXPECT_EQ(0, TestUtility::createOptionsImpl(fmt::format("{} {}", client_name_, good_test_uri_))
+                   ->eventLoopUtilizationThreshold());
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --event-loop-utilization-threshold 101 {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "CommandLineOptionsValidationError.EventLoopUtilizationThreshold");
+}
+
+TEST_F(OptionsImplTest, RequestSourceSharedStream) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --request-source 127.9.9.4:32323 --request-source-shared-stream {}",
+                  client_name_, good_test_uri_));
+  EXPECT_TRUE(options->requestSourceSharedStream());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_TRUE(cmd->request_source_shared_stream().value());
+  OptionsImpl options_from_proto(*cmd);
+  EXPECT_TRUE(Envoy::MessageUtil()(*(options_from_proto.toCommandLineOptions()), *cmd));
+  EXPECT_FALSE(TestUtility::createOptionsImpl(fmt::format("{} {}", client_name_, good_test_uri_))
+                   ->requestSourceSharedStream());
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --request-source-shared-stream {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "--request-source-shared-stream requires --request-source");
+}
+
+TEST_F(OptionsImplTest, VirtualUsersDisabledByDefault) {
+  std::unique_ptr<OptionsImpl> options =
+      TestUtility::createOptionsImpl(fmt::format("{} {}", client_name_, good_test_uri_));
+  EXPECT_EQ(0, options->virtualUsers());
+  EXPECT_EQ(0ns, options->thinkTime());
+  EXPECT_EQ(nighthawk::client::ThinkTimeDistribution::CONSTANT, options->thinkTimeDistribution());
+  EXPECT_FALSE(options->toCommandLineOptions()->has_virtual_users());
+}
+
+TEST_F(OptionsImplTest, BadVirtualUsersSpecification) {
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --virtual-users 1 --think-time foo {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "Invalid value for --think-time");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --virtual-users 1 --think-time -1s {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "--think-time is out of range");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --virtual-users 1 --think-time-distribution foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Value 'foo' does not meet constraint");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --virtual-users 1 --burst-size 2 {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "--virtual-users is not supported in combination with --burst-size");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --virtual-users 1 --global-rate-coordination {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "--virtual-users is not supported in combination with --load");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --virtual-users 1000001 {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Proto constraint validation failed");
+}
+
+TEST_F(OptionsImplTest, SeedAndScheduleRecording) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --seed 18446744073709551615 --record-schedule /tmp/schedule.bin {}",
+                  client_name_, good_test_uri_));
+  EXPECT_EQ(18446744073709551615ULL, options->seed().value());
+  EXPECT_EQ("/tmp/schedule.bin", options->recordSchedule());
+  EXPECT_EQ("", options->replaySchedule());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_EQ(18446744073709551615ULL, cmd->seed().value());
+  EXPECT_EQ("/tmp/schedule.bin", cmd->record_schedule().value());
+  EXPECT_FALSE(cmd->has_replay_schedule());
+  OptionsImpl options_from_proto(*cmd);
+  EXPECT_TRUE(Envoy::MessageUtil()(*(options_from_proto.toCommandLineOptions()), *cmd));
+}
+
+TEST_F(OptionsImplTest, ScheduleReplay) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(
+      fmt::format("{} --replay-schedule /tmp/schedule.bin {}", client_name_, good_test_uri_));
+  EXPECT_FALSE(options->seed().has_value());
+  EXPECT_EQ("/tmp/schedule.bin", options->replaySchedule());
+  CommandLineOptionsPtr cmd = options->toCommandLineOptions();
+  EXPECT_FALSE(cmd->has_seed());
+  EXPECT_EQ("/tmp/schedule.bin", cmd->replay_schedule().value());
+}
+
+TEST_F(OptionsImplTest, BadScheduleReplaySpecification) {
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --replay-schedule a --record-schedule b {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "--replay-schedule and --record-schedule are mutually exclusive");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --replay-schedule a --burst-size 2 {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "--replay-schedule is not supported in combination");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --replay-schedule a --virtual-users 2 {}",
+                                                 client_name_, good_test_uri_)),
+      MalformedArgvException, "--replay-schedule is not supported in combination");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --record-schedule a --load-profile {} {}", client_name_,
+          "{phases:[{duration:\"1s\",constant:{requests_per_second:1}}]}", good_test_uri_)),
+      MalformedArgvException, "--record-schedule is not supported in combination");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --seed foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Couldn't read argument value");
+}
+
+TEST_F(OptionsImplTest, TerminationModeDefaults) {
+  std::unique_ptr<OptionsImpl> options =
+      TestUtility::createOptionsImpl(fmt::format("{} {}", client_name_, good_test_uri_));
+  EXPECT_EQ(nighthawk::client::TerminationMode::DRAIN, options->terminationMode());
+  EXPECT_EQ(1s, options->drainTimeout());
+  options = TestUtility::createOptionsImpl(
+      fmt::format("{} --termination-mode hard-cut {}", client_name_, good_test_uri_));
+  EXPECT_EQ(nighthawk::client::TerminationMode::HARD_CUT, options->terminationMode());
+}
+
+TEST_F(OptionsImplTest, BadTerminationModeSpecification) {
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --termination-mode foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Value 'foo' does not meet constraint");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --drain-timeout foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Invalid value for --drain-timeout");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --drain-timeout -1s {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "--drain-timeout is out of range");
+}
+
+TEST_F(OptionsImplTest, CpuPinning) {
+  std::unique_ptr<OptionsImpl> options =
+      TestUtility::createOptionsImpl(fmt::format("{} {}", client_name_, good_test_uri_));
+  EXPECT_EQ(nighthawk::client::CpuPinning::NONE, options->cpuPinning());
+  EXPECT_THAT(options->workerCpuSets(), IsEmpty());
+  EXPECT_EQ("", options->flushWorkerCpuSet());
+  options = TestUtility::createOptionsImpl(
+      fmt::format("{} --cpu-pinning numa-compact {}", client_name_, good_test_uri_));
+  EXPECT_EQ(nighthawk::client::CpuPinning::NUMA_COMPACT, options->cpuPinning());
+}
+
+TEST_F(OptionsImplTest, BadCpuPinningSpecification) {
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --cpu-pinning foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Value 'foo' does not meet constraint");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --cpu-pinning numa-compact --worker-cpu-set 0 {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "cannot both be specified");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --worker-cpu-set 3-1 {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Invalid value for --worker-cpu-set");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --flush-worker-cpu-set x {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Invalid value for --flush-worker-cpu-set");
+}
+
+TEST_F(OptionsImplTest, WorkerSourceBinding) {
+  std::unique_ptr<OptionsImpl> options = TestUtility::createOptionsImpl(fmt::format(
+      "{} --worker-source-port-base 4000 --connections 1 {}", client_name_, good_test_uri_));
+  EXPECT_EQ(4000, options->workerSourcePortBase());
+  EXPECT_EQ(4000, options->toCommandLineOptions()->worker_source_port_base().value());
+}
+
+TEST_F(OptionsImplTest, BadWorkerSourceBindingSpecification) {
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --worker-source-address foo {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "Invalid value for --worker-source-address");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --worker-source-port-base 4000 {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "--worker-source-port-base requires --connections 1");
+  EXPECT_THROW_WITH_REGEX(TestUtility::createOptionsImpl(fmt::format(
+                              "{} --worker-source-port-base 70000 --connections 1 {}",
+                              client_name_, good_test_uri_)),
+                          MalformedArgvException,
+                          "CommandLineOptionsValidationError.WorkerSourcePortBase");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --incoming-cpu-affinity {}", client_name_, good_test_uri_)),
+      MalformedArgvException, "--incoming-cpu-affinity requires");
+}
+
+TEST_F(OptionsImplTest, GlobalRateCoordinationAndLoadProfileAreMutuallyExclusive) {
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --global-rate-coordination --load-profile {} {}", client_name_,
+          "{phases:[{duration:\"1s\",constant:{requests_per_second:1}}]}", good_test_uri_)),
+      MalformedArgvException, "--global-rate-coordination is not supported in combination");
+}
+
+TEST_F(OptionsImplTest, BadLoadProfileSpecification) {
+  // Bad JSON.
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --load-profile {} http://foo/", client_name_, "{broken_json:")),
+      MalformedArgvException, "Unable to parse JSON as proto");
+  // No phases.
+  EXPECT_THROW_WITH_REGEX(TestUtility::createOptionsImpl(fmt::format(
+                              "{} --load-profile {} http://foo/", client_name_, "{phases:[]}")),
+                          MalformedArgvException, "Proto constraint validation failed");
+  // A phase without a rate shape.
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --load-profile {} http://foo/", client_name_,
+                                                 "{phases:[{duration:\"1s\"}]}")),
+      MalformedArgvException, "Proto constraint validation failed");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --load-profile {} http://foo/", client_name_,
+          "{phases:[{id:\"a\",duration:\"1s\",constant:{requests_per_second:1}},"
+          "{id:\"a\",duration:\"1s\",constant:{requests_per_second:1}}]}")),
+      MalformedArgvException, "Duplicate load profile phase id");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --load-profile {} http://foo/", client_name_,
+          "{phases:[{duration:\"1s\",sine:{base_requests_per_second:1,"
+          "amplitude_requests_per_second:2,period:\"1s\"}}]}")),
+      MalformedArgvException, "sine amplitude may not exceed the base frequency");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format("{} --load-profile {} http://foo/", client_name_,
+                                                 "{phases:[{duration:\"1s\",rps_curve:{}}]}")),
+      MalformedArgvException, "rps_curve requires at least one point");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --load-profile {} http://foo/", client_name_,
+          "{phases:[{duration:\"1s\",rps_curve:{points:[{offset:\"1s\",requests_per_second:1},"
+          "{offset:\"1s\",requests_per_second:2}]}}]}")),
+      MalformedArgvException, "rps_curve offsets must be strictly increasing");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(
+          fmt::format("{} --load-profile {} http://foo/", client_name_,
+                      "{phases:[{duration:\"1s\",rps_curve:{file:\"/does/not/exist.csv\"}}]}")),
+      MalformedArgvException, "Unable to open rps_curve file");
+  const std::string curve_path =
+      TestEnvironment::writeStringToFileForTest("bad_rps_curve.csv", "0,1\nnot a number,2\n");
+  EXPECT_THROW_WITH_REGEX(
+      TestUtility::createOptionsImpl(fmt::format(
+          "{} --load-profile {{phases:[{{duration:\"1s\",rps_curve:{{file:\"{}\"}}}}]}} {}",
+          client_name_, curve_path, good_test_uri_)),
+      MalformedArgvException, "Malformed line 2 in rps_curve file");
+}
+
 } // namespace Client
 } // namespace Nighthawk
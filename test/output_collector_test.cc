@@ -80,6 +80,24 @@ TEST_F(OutputCollectorTest, AddResultWorksWithNoUserDefinedOutputs) {
   EXPECT_EQ(full_output.results(0).user_defined_outputs_size(), 0);
 }
 
+TEST_F(OutputCollectorTest, AddWorkerPlacement) {
+  std::unique_ptr<OptionsImpl> options =
+      TestUtility::createOptionsImpl("foo https://unresolved.host/");
+  OutputCollectorImpl collector(simTime(), *options);
+
+  collector.addWorkerPlacement("worker_0", {2, 3}, 1);
+  collector.addWorkerPlacement("flush_worker", {0, 4}, absl::nullopt);
+
+  nighthawk::client::Output full_output = collector.toProto();
+  ASSERT_EQ(full_output.worker_placements_size(), 2);
+  EXPECT_EQ(full_output.worker_placements(0).name(), "worker_0");
+  EXPECT_THAT(full_output.worker_placements(0).cpus(), ElementsAre(2, 3));
+  EXPECT_EQ(full_output.worker_placements(0).numa_node().value(), 1);
+  EXPECT_EQ(full_output.worker_placements(1).name(), "flush_worker");
+  EXPECT_THAT(full_output.worker_placements(1).cpus(), ElementsAre(0, 4));
+  EXPECT_FALSE(full_output.worker_placements(1).has_numa_node());
+}
+
 } // namespace
 } // namespace Client
 } // namespace Nighthawk
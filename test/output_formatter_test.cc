@@ -282,10 +282,15 @@ TEST_F(StatidToNameTest, TestTranslations) {
                                         "benchmark_http_client.response_body_size",
                                         "benchmark_http_client.response_header_size",
                                         "sequencer.callback",
-                                        "sequencer.blocking"};
+                                        "sequencer.blocking",
+                                        "request_source.stall",
+                                        "request_source.queued_request_count"};
   for (const std::string& id : ids) {
     EXPECT_NE(ConsoleOutputFormatterImpl::statIdtoFriendlyStatName(id), id);
   }
+  EXPECT_EQ(ConsoleOutputFormatterImpl::statIdtoFriendlyStatName(
+                "benchmark_http_client.request_class.checkout"),
+            "Request start to response end, checkout");
 }
 
 TEST_F(MediumOutputCollectorTest, FortioPedanticFormatter) {
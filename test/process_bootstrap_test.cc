@@ -1,6 +1,8 @@
 #include <string>
 #include <vector>
 
+#include "envoy/common/platform.h"
+
 #include "nighthawk/common/uri.h"
 
 #include "external/envoy/source/common/common/statusor.h"
@@ -1848,6 +1850,101 @@ TEST_F(CreateBootstrapConfigurationTest, CreatesBootstrapWithCustomUpstreamBindC
   Envoy::MessageUtil::validate(*bootstrap, Envoy::ProtobufMessage::getStrictValidationVisitor());
 }
 
+TEST_F(CreateBootstrapConfigurationTest, CreatesBootstrapWithPerWorkerSourceBinding) {
+  setupUriResolutionExpectations();
+
+  std::unique_ptr<Client::OptionsImpl> options = Client::TestUtility::createOptionsImpl(
+      "nighthawk_client --worker-source-address 127.0.0.2 --worker-source-address 127.0.0.3 "
+      "--worker-source-port-base 4000 --connections 1 http://www.example.org");
+
+  NiceMock<Envoy::Api::MockApi> api;
+  absl::StatusOr<Bootstrap> bootstrap = createBootstrapConfiguration(
+      mock_dispatcher_, api, *options, mock_dns_resolver_factory_, typed_dns_resolver_config_,
+      /*number_of_workers=*/3);
+  ASSERT_THAT(bootstrap, StatusIs(absl::StatusCode::kOk));
+  ASSERT_EQ(bootstrap->static_resources().clusters_size(), 3);
+  const std::vector<std::string> expected_addresses = {"127.0.0.2", "127.0.0.3", "127.0.0.2"};
+  for (int i = 0; i < 3; i++) {
+    const envoy::config::core::v3::BindConfig& bind_config =
+        bootstrap->static_resources().clusters(i).upstream_bind_config();
+    EXPECT_EQ(bind_config.source_address().address(), expected_addresses[i]);
+    EXPECT_EQ(bind_config.source_address().port_value(), 4000 + i);
+    ASSERT_EQ(bind_config.socket_options_size(), 1);
+    EXPECT_EQ(bind_config.socket_options(0).level(), SOL_SOCKET);
+    EXPECT_EQ(bind_config.socket_options(0).name(), SO_REUSEADDR);
+    EXPECT_EQ(bind_config.socket_options(0).int_value(), 1);
+  }
+  EXPECT_FALSE(bootstrap->cluster_manager().has_upstream_bind_config());
+
+  // Ensure the generated bootstrap is valid.
+  Envoy::MessageUtil::validate(*bootstrap, Envoy::ProtobufMessage::getStrictValidationVisitor());
+}
+
+TEST_F(CreateBootstrapConfigurationTest, PerWorkerSourcePortDefaultsToWildcardAddress) {
+  setupUriResolutionExpectations();
+
+  std::unique_ptr<Client::OptionsImpl> options = Client::TestUtility::createOptionsImpl(
+      "nighthawk_client --worker-source-port-base 4000 --connections 1 http://www.example.org");
+
+  NiceMock<Envoy::Api::MockApi> api;
+  absl::StatusOr<Bootstrap> bootstrap =
+      createBootstrapConfiguration(mock_dispatcher_, api, *options, mock_dns_resolver_factory_,
+                                   typed_dns_resolver_config_, number_of_workers_);
+  ASSERT_THAT(bootstrap, StatusIs(absl::StatusCode::kOk));
+  const envoy::config::core::v3::BindConfig& bind_config =
+      bootstrap->static_resources().clusters(0).upstream_bind_config();
+  EXPECT_EQ(bind_config.source_address().address(), "0.0.0.0");
+  EXPECT_EQ(bind_config.source_address().port_value(), 4000);
+}
+
+TEST_F(CreateBootstrapConfigurationTest, FailsWhenSourcePortsRunOut) {
+  setupUriResolutionExpectations();
+
+  std::unique_ptr<Client::OptionsImpl> options = Client::TestUtility::createOptionsImpl(
+      "nighthawk_client --worker-source-port-base 65535 --connections 1 http://www.example.org");
+
+  NiceMock<Envoy::Api::MockApi> api;
+  EXPECT_THAT(createBootstrapConfiguration(mock_dispatcher_, api, *options,
+                                           mock_dns_resolver_factory_, typed_dns_resolver_config_,
+                                           /*number_of_workers=*/2),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+#if defined(SO_BUSY_POLL) && defined(SO_INCOMING_CPU)
+TEST_F(CreateBootstrapConfigurationTest, CreatesBootstrapWithBusyPollAndIncomingCpu) {
+  setupUriResolutionExpectations();
+
+  std::unique_ptr<Client::OptionsImpl> options = Client::TestUtility::createOptionsImpl(
+      "nighthawk_client --busy-poll-us 50 --incoming-cpu-affinity --worker-cpu-set 2 "
+      "--worker-cpu-set 5-6 --upstream-bind-config {source_address:{address:\"127.0.0.1\","
+      "port_value:0}} http://www.example.org");
+
+  NiceMock<Envoy::Api::MockApi> api;
+  absl::StatusOr<Bootstrap> bootstrap = createBootstrapConfiguration(
+      mock_dispatcher_, api, *options, mock_dns_resolver_factory_, typed_dns_resolver_config_,
+      /*number_of_workers=*/2, /*worker_cpu_sets=*/{{2}, {5, 6}});
+  ASSERT_THAT(bootstrap, StatusIs(absl::StatusCode::kOk));
+  const std::vector<uint32_t> expected_cpus = {2, 5};
+  for (int i = 0; i < 2; i++) {
+    const envoy::config::core::v3::BindConfig& bind_config =
+        bootstrap->static_resources().clusters(i).upstream_bind_config();
+    // The source address of the global bind config is retained.
+    EXPECT_EQ(bind_config.source_address().address(), "127.0.0.1");
+    ASSERT_EQ(bind_config.socket_options_size(), 2);
+    EXPECT_EQ(bind_config.socket_options(0).name(), SO_BUSY_POLL);
+    EXPECT_EQ(bind_config.socket_options(0).int_value(), 50);
+    EXPECT_EQ(bind_config.socket_options(1).name(), SO_INCOMING_CPU);
+    EXPECT_EQ(bind_config.socket_options(1).int_value(), expected_cpus[i]);
+  }
+
+  // Without pinned workers, there is no cpu to steer to.
+  EXPECT_THAT(createBootstrapConfiguration(mock_dispatcher_, api, *options,
+                                           mock_dns_resolver_factory_, typed_dns_resolver_config_,
+                                           /*number_of_workers=*/2),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+#endif
+
 TEST_F(CreateBootstrapConfigurationTest, DeterminesSniFromRequestHeader) {
   setupUriResolutionExpectations();
 
@@ -24,6 +24,7 @@
 #include "test/test_common/proto_matchers.h"
 #include "test/user_defined_output/fake_plugin/fake_user_defined_output.h"
 
+#include "absl/strings/match.h"
 #include "gtest/gtest.h"
 
 namespace Nighthawk {
@@ -168,6 +169,32 @@ TEST_P(ProcessTest, FailsToCreateProcessOnUnresolvableHost) {
   EXPECT_FALSE(runProcess(RunExpectation::EXPECT_FAILURE).ok());
 }
 
+TEST_P(ProcessTest, FailsToCreateProcessWhenConcurrencyCalibrationFails) {
+  // There is no backend to calibrate against.
+  options_ = TestUtility::createOptionsImpl(fmt::format(
+      "foo --concurrency adaptive --duration 1 --rps 10 https://{}/", loopback_address_));
+  const absl::Status status = runProcess(RunExpectation::EXPECT_FAILURE);
+  EXPECT_EQ(status.code(), absl::StatusCode::kUnavailable);
+}
+
+TEST(AdaptiveConcurrencyTest, LoadsWorkersToTheTargetUtilization) {
+  // A worker sustains 1000 requests per second, and gets loaded to 700 of them.
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(1000, 1300, /*cpu_count=*/64), 2);
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(1000, 1500, /*cpu_count=*/64), 3);
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(1000, 10, /*cpu_count=*/64), 1);
+}
+
+TEST(AdaptiveConcurrencyTest, UsesNoMoreWorkersThanRequestsPerSecond) {
+  // Sustaining 10 requests per second would take 29 workers at this rate.
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(0.5, 10, /*cpu_count=*/64), 10);
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(0, 10, /*cpu_count=*/64), 10);
+}
+
+TEST(AdaptiveConcurrencyTest, UsesNoMoreWorkersThanCpus) {
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(100, 10000, /*cpu_count=*/8), 8);
+  EXPECT_EQ(ProcessImpl::adaptiveConcurrency(100, 10000, /*cpu_count=*/1000), 143);
+}
+
 TEST_P(ProcessTest, TwoProcessInSequence) {
   ASSERT_TRUE(runProcess(RunExpectation::EXPECT_FAILURE).ok());
   options_ = TestUtility::createOptionsImpl(
@@ -372,6 +399,32 @@ TEST_P(ProcessTest, TestWithEncapsulation) {
                   loopback_address_, loopback_address_));
   EXPECT_TRUE(runProcess(RunExpectation::EXPECT_FAILURE).ok());
 }
+
+TEST_P(ProcessTest, ReportsClientStatisticsPerLoadPhase) {
+  options_ = TestUtility::createOptionsImpl(fmt::format(
+      "foo --concurrency 2 --failure-predicate foo:0 --load-profile "
+      "{{phases:[{{id:\"first\",duration:\"1s\",constant:{{requests_per_second:10}}}},"
+      "{{id:\"second\",duration:\"1s\",constant:{{requests_per_second:10}}}}]}} https://{}/",
+      loopback_address_));
+  EXPECT_TRUE(runProcess(RunExpectation::EXPECT_SUCCESS).ok());
+
+  std::vector<std::string> phase_results;
+  for (const nighthawk::client::Result& result : output_proto_.results()) {
+    if (!absl::StrContains(result.name(), ".")) {
+      continue;
+    }
+    phase_results.push_back(result.name());
+    bool has_latencies = false;
+    for (const nighthawk::client::Statistic& statistic : result.statistics()) {
+      has_latencies |= statistic.id() == "benchmark_http_client.request_to_response";
+    }
+    EXPECT_TRUE(has_latencies) << result.name();
+  }
+  EXPECT_THAT(phase_results,
+              ::testing::UnorderedElementsAre("global.first", "global.second", "worker_0.first",
+                                              "worker_0.second", "worker_1.first",
+                                              "worker_1.second"));
+}
 /**
  * Fixture for executing the Nighthawk process with simulated time.
  */
@@ -1,4 +1,6 @@
+#include <atomic>
 #include <chrono>
+#include <thread>
 #include <vector>
 
 #include "nighthawk/common/exception.h"
@@ -7,6 +9,7 @@
 
 #include "source/common/frequency.h"
 #include "source/common/rate_limiter_impl.h"
+#include "source/common/statistic_impl.h"
 
 #include "test/mocks/common/mock_rate_limiter.h"
 
@@ -406,6 +409,235 @@ TEST_F(LinearRampingRateLimiterImplTest, TimingVerificationTest) {
   checkAcquisitionTimings(40000_Hz, 7s);
 }
 
+class ShapedRateLimiterTest : public Test {
+public:
+  /**
+   * Advances time in 1 ms steps until the specified point in time, acquiring greedily.
+   * @param rate_limiter the rate limiter to acquire from.
+   * @param until the point in time (relative to the start of the test) to advance to.
+   * @return uint64_t total number of successful acquisitions since the start of the test.
+   */
+  uint64_t acquireUntil(RateLimiter& rate_limiter, const std::chrono::milliseconds until) {
+    while (elapsed_ < until) {
+      time_system_.advanceTimeWait(1ms);
+      elapsed_ += 1ms;
+      while (rate_limiter.tryAcquireOne()) {
+        acquisitions_++;
+      }
+    }
+    return acquisitions_;
+  }
+
+  Envoy::Event::SimulatedTimeSystem time_system_;
+  std::chrono::milliseconds elapsed_{0ms};
+  uint64_t acquisitions_{0};
+};
+
+TEST_F(ShapedRateLimiterTest, PiecewiseLinearSinglePointIsConstant) {
+  PiecewiseLinearRateLimiterImpl rate_limiter(time_system_, {{0ns, 10}});
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  // Like LinearRateLimiter, acquisitions are shifted by half an interval.
+  EXPECT_EQ(acquireUntil(rate_limiter, 49ms), 0);
+  EXPECT_EQ(acquireUntil(rate_limiter, 50ms), 1);
+  EXPECT_EQ(acquireUntil(rate_limiter, 1050ms), 11);
+}
+
+TEST_F(ShapedRateLimiterTest, PiecewiseLinearRampAndHold) {
+  // Ramp from 0 to 10 Hz over 2 seconds, after which 10 Hz is held.
+  PiecewiseLinearRateLimiterImpl rate_limiter(time_system_, {{0ns, 0}, {2s, 10}});
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  // ½ * 5 Hz/s * 1s² = 2.5
+  EXPECT_EQ(acquireUntil(rate_limiter, 1s), 3);
+  EXPECT_EQ(acquireUntil(rate_limiter, 2s), 10);
+  EXPECT_EQ(acquireUntil(rate_limiter, 3s), 20);
+}
+
+TEST_F(ShapedRateLimiterTest, PiecewiseLinearStep) {
+  // 10 Hz for the first second, then step up to 100 Hz.
+  PiecewiseLinearRateLimiterImpl rate_limiter(
+      time_system_, {{0ns, 10}, {999999999ns, 10}, {1s, 100}, {2s, 100}});
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  EXPECT_EQ(acquireUntil(rate_limiter, 1s), 10);
+  EXPECT_EQ(acquireUntil(rate_limiter, 2s), 110);
+}
+
+TEST_F(ShapedRateLimiterTest, PiecewiseLinearReleaseOne) {
+  PiecewiseLinearRateLimiterImpl rate_limiter(time_system_, {{0ns, 10}});
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system_.advanceTimeWait(1s);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  rate_limiter.releaseOne();
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  }
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+}
+
+TEST_F(RateLimiterTest, PiecewiseLinearRateLimiterInvalidArgumentTest) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  // No points.
+  EXPECT_THROW(PiecewiseLinearRateLimiterImpl rate_limiter(time_system, {}), NighthawkException);
+  // Negative offset.
+  EXPECT_THROW(PiecewiseLinearRateLimiterImpl rate_limiter(time_system, {{-1s, 1}}),
+               NighthawkException);
+  // Negative frequency.
+  EXPECT_THROW(PiecewiseLinearRateLimiterImpl rate_limiter(time_system, {{0s, 1}, {1s, -1}}),
+               NighthawkException);
+  // Offsets not strictly increasing.
+  EXPECT_THROW(PiecewiseLinearRateLimiterImpl rate_limiter(time_system, {{1s, 1}, {1s, 2}}),
+               NighthawkException);
+  EXPECT_THROW(PiecewiseLinearRateLimiterImpl rate_limiter(time_system, {{2s, 1}, {1s, 2}}),
+               NighthawkException);
+}
+
+TEST_F(ShapedRateLimiterTest, SineTimingTest) {
+  SineRateLimiterImpl rate_limiter(time_system_, 10_Hz, 10, 2s);
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  // 10 * 1 + 10 * 2 / (2 * pi) * (1 - cos(pi)) ~= 16.37
+  EXPECT_EQ(acquireUntil(rate_limiter, 1s), 16);
+  // A full period averages out at the base frequency.
+  EXPECT_EQ(acquireUntil(rate_limiter, 2s), 20);
+  EXPECT_EQ(acquireUntil(rate_limiter, 20s), 200);
+}
+
+TEST_F(RateLimiterTest, SineRateLimiterInvalidArgumentTest) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  EXPECT_THROW(SineRateLimiterImpl rate_limiter(time_system, 0_Hz, 0, 1s), NighthawkException);
+  EXPECT_THROW(SineRateLimiterImpl rate_limiter(time_system, 10_Hz, 11, 1s), NighthawkException);
+  EXPECT_THROW(SineRateLimiterImpl rate_limiter(time_system, 10_Hz, -1, 1s), NighthawkException);
+  EXPECT_THROW(SineRateLimiterImpl rate_limiter(time_system, 10_Hz, 5, 0s), NighthawkException);
+}
+
+TEST_F(RateLimiterTest, SharedLinearRateLimiterPicksUpLaggingParticipant) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  SharedRateLimiterStateSharedPtr state = std::make_shared<SharedRateLimiterState>(10_Hz);
+  state->setParticipants(2);
+  SharedLinearRateLimiterImpl rate_limiter_a(time_system, state);
+  SharedLinearRateLimiterImpl rate_limiter_b(time_system, state);
+
+  EXPECT_FALSE(rate_limiter_a.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter_b.tryAcquireOne());
+  // Two participants at 10Hz each yield 20 acquisitions per second in total. Even though only
+  // rate_limiter_a attempts to acquire, it should be able to claim all of them.
+  time_system.advanceTimeWait(1s);
+  for (int i = 0; i < 20; i++) {
+    EXPECT_TRUE(rate_limiter_a.tryAcquireOne());
+  }
+  EXPECT_FALSE(rate_limiter_a.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter_b.tryAcquireOne());
+
+  time_system.advanceTimeWait(1s);
+  for (int i = 0; i < 20; i++) {
+    EXPECT_TRUE(rate_limiter_b.tryAcquireOne());
+  }
+  EXPECT_FALSE(rate_limiter_b.tryAcquireOne());
+  // An acquisition returned by one participant may be claimed by another one.
+  rate_limiter_b.releaseOne();
+  EXPECT_TRUE(rate_limiter_a.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter_a.tryAcquireOne());
+}
+
+TEST_F(RateLimiterTest, SharedLinearRateLimiterConcurrentAcquisitions) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  SharedRateLimiterStateSharedPtr state = std::make_shared<SharedRateLimiterState>(25_Hz);
+  state->setParticipants(4);
+  std::vector<std::unique_ptr<SharedLinearRateLimiterImpl>> rate_limiters;
+  for (int i = 0; i < 4; i++) {
+    rate_limiters.push_back(std::make_unique<SharedLinearRateLimiterImpl>(time_system, state));
+  }
+  // Start the shared budget, and move to the point where it allows 1000 acquisitions in total.
+  EXPECT_FALSE(rate_limiters[0]->tryAcquireOne());
+  time_system.advanceTimeWait(10s);
+  std::atomic<uint64_t> acquisitions{0};
+  std::vector<std::thread> threads;
+  for (const auto& rate_limiter : rate_limiters) {
+    threads.emplace_back([&acquisitions, &rate_limiter]() {
+      while (rate_limiter->tryAcquireOne()) {
+        acquisitions++;
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1000, acquisitions.load());
+}
+
+TEST_F(RateLimiterTest, SharedRateLimiterStateInvalidArgumentTest) {
+  EXPECT_THROW(SharedRateLimiterState state(0_Hz), NighthawkException);
+}
+
+TEST_F(RateLimiterTest, ClosedLoopRateLimiterConstantThinkTime) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  auto schedule = std::make_shared<VirtualUserSchedule>(
+      time_system, 2, 100ms, VirtualUserSchedule::ThinkTimeDistribution::CONSTANT);
+  ClosedLoopRateLimiterImpl rate_limiter(time_system, schedule);
+
+  // Both virtual users are ready right away.
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  // A virtual user that could not issue its request is ready again right away.
+  rate_limiter.releaseOne();
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+
+  // Completions put the virtual users to think.
+  schedule->completeUser();
+  time_system.advanceTimeWait(50ms);
+  schedule->completeUser();
+  EXPECT_EQ(2, schedule->thinkingUsers());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(50ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(50ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  EXPECT_EQ(0, schedule->thinkingUsers());
+}
+
+TEST_F(RateLimiterTest, ClosedLoopRateLimiterZeroThinkTime) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  auto schedule = std::make_shared<VirtualUserSchedule>(
+      time_system, 1, 0s, VirtualUserSchedule::ThinkTimeDistribution::EXPONENTIAL);
+  ClosedLoopRateLimiterImpl rate_limiter(time_system, schedule);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  schedule->completeUser();
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+}
+
+TEST_F(RateLimiterTest, ClosedLoopRateLimiterExponentialThinkTime) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  constexpr uint32_t kVirtualUsers = 10000;
+  auto schedule = std::make_shared<VirtualUserSchedule>(
+      time_system, kVirtualUsers, 1s, VirtualUserSchedule::ThinkTimeDistribution::EXPONENTIAL);
+  ClosedLoopRateLimiterImpl rate_limiter(time_system, schedule);
+  for (uint32_t i = 0; i < kVirtualUsers; i++) {
+    EXPECT_TRUE(rate_limiter.tryAcquireOne());
+    schedule->completeUser();
+  }
+  // With a mean think time of 1s, about 1 - e^-1 (63.2%) of the virtual users should be done
+  // thinking after a second.
+  time_system.advanceTimeWait(1s);
+  uint32_t ready = 0;
+  while (rate_limiter.tryAcquireOne()) {
+    ready++;
+  }
+  EXPECT_NEAR(ready, 6321, 300);
+}
+
+TEST_F(RateLimiterTest, VirtualUserScheduleInvalidArgumentTest) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  EXPECT_THROW(VirtualUserSchedule schedule(time_system, 0, 0s,
+                                            VirtualUserSchedule::ThinkTimeDistribution::CONSTANT),
+               NighthawkException);
+  EXPECT_THROW(VirtualUserSchedule schedule(time_system, 1, -1s,
+                                            VirtualUserSchedule::ThinkTimeDistribution::CONSTANT),
+               NighthawkException);
+}
+
 TEST_F(RateLimiterTest, GraduallyOpeningRateLimiterFilterInvalidArgumentTest) {
   // Negative ramp throws.
   EXPECT_THROW(GraduallyOpeningRateLimiterFilter gorl(
@@ -543,4 +775,127 @@ TEST_F(ZipfRateLimiterImplTest, BadArgumentsTest) {
   }
 }
 
+TEST_F(RateLimiterTest, RecordingRateLimiterRecordsReleases) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  auto schedule = std::make_shared<ReleaseSchedule>();
+  schedule->addWorker(0);
+  RecordingRateLimiterImpl rate_limiter(std::make_unique<LinearRateLimiter>(time_system, 10_Hz),
+                                        schedule, 0);
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(100ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(150ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  // A release that could not be used should not end up in the recording.
+  rate_limiter.releaseOne();
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  EXPECT_THAT(schedule->offsets(0), ElementsAre(100ms, 250ms));
+}
+
+TEST_F(RateLimiterTest, ReplayRateLimiterReplaysReleases) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  auto schedule = std::make_shared<ReleaseSchedule>();
+  schedule->addWorker(0);
+  schedule->addWorker(1);
+  schedule->record(1, 10ms);
+  schedule->record(1, 10ms);
+  schedule->record(1, 35ms);
+  ReplayRateLimiterImpl rate_limiter(time_system, schedule, 1);
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(10ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  rate_limiter.releaseOne();
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(25ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  // The schedule is exhausted.
+  time_system.advanceTimeWait(1s);
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+
+  ReplayRateLimiterImpl idle_rate_limiter(time_system, schedule, 0);
+  EXPECT_FALSE(idle_rate_limiter.tryAcquireOne());
+}
+
+// Release timing which yields a fixed list of offsets, one per generated request.
+class FixedReleaseTiming : public RequestReleaseTiming {
+public:
+  FixedReleaseTiming(std::vector<std::chrono::nanoseconds> offsets)
+      : offsets_(std::move(offsets)) {}
+  absl::optional<std::chrono::nanoseconds> nextReleaseOffset() override {
+    if (next_ >= offsets_.size()) {
+      return absl::nullopt;
+    }
+    return offsets_[next_];
+  }
+  void generate() { next_++; }
+
+private:
+  const std::vector<std::chrono::nanoseconds> offsets_;
+  size_t next_{0};
+};
+
+TEST_F(RateLimiterTest, ReleaseTimingRateLimiterReleasesAtOffsets) {
+  Envoy::Event::SimulatedTimeSystem time_system;
+  FixedReleaseTiming timing({10ms, 10ms, 30ms});
+  ReleaseTimingRateLimiterImpl rate_limiter(time_system, timing,
+                                            std::make_unique<StreamingStatistic>());
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(10ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  timing.generate();
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  // The request could not be sent, so its release is retried.
+  rate_limiter.releaseOne();
+  time_system.advanceTimeWait(5ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  timing.generate();
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+  time_system.advanceTimeWait(20ms);
+  EXPECT_TRUE(rate_limiter.tryAcquireOne());
+  timing.generate();
+  // The timing is exhausted.
+  time_system.advanceTimeWait(1s);
+  EXPECT_FALSE(rate_limiter.tryAcquireOne());
+
+  // The retried release is only tracked once, and the last one was 5ms late.
+  const StatisticPtrMap statistics = rate_limiter.statistics();
+  ASSERT_EQ(statistics.size(), 1);
+  const Statistic* deviation = statistics.at("sequencer.schedule_deviation");
+  EXPECT_EQ(deviation->count(), 3);
+  EXPECT_EQ(deviation->max(), std::chrono::nanoseconds(5ms).count());
+}
+
+TEST_F(RateLimiterTest, SeededRateLimitersAreDeterministic) {
+  UniformRandomDistributionSamplerImpl sampler_1(1000000, 42);
+  UniformRandomDistributionSamplerImpl sampler_2(1000000, 42);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(sampler_1.getValue(), sampler_2.getValue());
+  }
+
+  Envoy::Event::SimulatedTimeSystem time_system;
+  VirtualUserSchedule schedule_1(time_system, 1, 10ms,
+                                 VirtualUserSchedule::ThinkTimeDistribution::EXPONENTIAL, 42);
+  VirtualUserSchedule schedule_2(time_system, 1, 10ms,
+                                 VirtualUserSchedule::ThinkTimeDistribution::EXPONENTIAL, 42);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(schedule_1.tryClaimReadyUser());
+    ASSERT_TRUE(schedule_2.tryClaimReadyUser());
+    schedule_1.completeUser();
+    schedule_2.completeUser();
+    int steps = 0;
+    while (!schedule_1.tryClaimReadyUser()) {
+      EXPECT_FALSE(schedule_2.tryClaimReadyUser());
+      time_system.advanceTimeWait(1ms);
+      steps++;
+    }
+    // Both schedules should hand out the virtual user after the same think time.
+    EXPECT_TRUE(schedule_2.tryClaimReadyUser()) << "after " << steps << "ms";
+    schedule_1.returnUser();
+    schedule_2.returnUser();
+  }
+}
+
 } // namespace Nighthawk
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "external/envoy/test/test_common/status_utility.h"
+
+#include "source/common/release_schedule_impl.h"
+#include "source/common/seeded_random_generator_impl.h"
+
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace Nighthawk {
+namespace {
+
+using ::Envoy::StatusHelpers::StatusIs;
+
+class ReleaseScheduleTest : public Test {};
+
+TEST_F(ReleaseScheduleTest, WriteAndReadRoundTrip) {
+  ReleaseSchedule schedule;
+  schedule.addWorker(2);
+  EXPECT_EQ(schedule.workers(), 3);
+  schedule.record(0, 0ns);
+  schedule.record(0, 1ms);
+  schedule.record(0, 1ms);
+  schedule.record(0, 1h);
+  schedule.record(2, 123456789ns);
+  const std::string path = TestEnvironment::writeStringToFileForTest("release_schedule.bin", "");
+  ASSERT_TRUE(schedule.writeToFile(path).ok());
+
+  absl::StatusOr<std::unique_ptr<ReleaseSchedule>> read = ReleaseSchedule::readFromFile(path);
+  ASSERT_TRUE(read.ok()) << read.status();
+  ASSERT_EQ((*read)->workers(), 3);
+  EXPECT_THAT((*read)->offsets(0), ElementsAre(0ns, 1ms, 1ms, 1h));
+  EXPECT_THAT((*read)->offsets(1), IsEmpty());
+  EXPECT_THAT((*read)->offsets(2), ElementsAre(123456789ns));
+}
+
+TEST_F(ReleaseScheduleTest, UnrecordLast) {
+  ReleaseSchedule schedule;
+  schedule.addWorker(0);
+  schedule.record(0, 1ms);
+  schedule.record(0, 2ms);
+  schedule.unrecordLast(0);
+  EXPECT_THAT(schedule.offsets(0), ElementsAre(1ms));
+}
+
+TEST_F(ReleaseScheduleTest, ReadNonExistingFile) {
+  EXPECT_THAT(ReleaseSchedule::readFromFile("/does/not/exist").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(ReleaseScheduleTest, ReadMalformedFiles) {
+  ReleaseSchedule schedule;
+  schedule.addWorker(0);
+  schedule.record(0, 1s);
+  const std::string path =
+      TestEnvironment::writeStringToFileForTest("release_schedule_source.bin", "");
+  ASSERT_TRUE(schedule.writeToFile(path).ok());
+  std::ifstream file(path, std::ios::binary);
+  const std::string contents((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+
+  const std::string not_a_schedule =
+      TestEnvironment::writeStringToFileForTest("not_a_schedule.bin", "0,1\n");
+  EXPECT_THAT(ReleaseSchedule::readFromFile(not_a_schedule).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  const std::string truncated = TestEnvironment::writeStringToFileForTest(
+      "truncated_schedule.bin", contents.substr(0, contents.size() - 1));
+  EXPECT_THAT(ReleaseSchedule::readFromFile(truncated).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  const std::string trailing =
+      TestEnvironment::writeStringToFileForTest("trailing_schedule.bin", contents + "x");
+  EXPECT_THAT(ReleaseSchedule::readFromFile(trailing).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  std::string future_version = contents;
+  future_version[4] = 2;
+  const std::string unsupported =
+      TestEnvironment::writeStringToFileForTest("future_schedule.bin", future_version);
+  EXPECT_THAT(ReleaseSchedule::readFromFile(unsupported).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(ReleaseScheduleTest, SeededRandomGeneratorIsDeterministic) {
+  SeededRandomGeneratorImpl generator_1(SeededRandomGeneratorImpl::seedForWorker(42, 0));
+  SeededRandomGeneratorImpl generator_2(SeededRandomGeneratorImpl::seedForWorker(42, 0));
+  SeededRandomGeneratorImpl generator_3(SeededRandomGeneratorImpl::seedForWorker(42, 1));
+  EXPECT_EQ(generator_1.random(), generator_2.random());
+  const std::string uuid = generator_1.uuid();
+  EXPECT_EQ(uuid, generator_2.uuid());
+  EXPECT_NE(uuid, generator_3.uuid());
+  // Version 4, RFC 4122 variant.
+  EXPECT_THAT(uuid, MatchesRegex("[0-9a-f]{8}-[0-9a-f]{4}-4[0-9a-f]{3}-[89ab][0-9a-f]{3}-"
+                                 "[0-9a-f]{12}"));
+}
+
+} // namespace
+} // namespace Nighthawk
@@ -1,14 +1,26 @@
 #include <chrono>
+#include <deque>
 
+#include "external/envoy/source/common/stats/isolated_store_impl.h"
+#include "external/envoy/test/mocks/event/mocks.h"
+#include "external/envoy/test/test_common/simulated_time_system.h"
 #include "external/envoy/test/test_common/utility.h"
 
 #include "source/common/request_source_impl.h"
 
+#include "test/mocks/common/mock_request_stream_grpc_client.h"
+
 #include "gtest/gtest.h"
 
 namespace Nighthawk {
 namespace Client {
 
+using namespace std::chrono_literals;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
 class RequestSourceTest : public testing::Test {};
 
 TEST_F(RequestSourceTest, StaticRequestSourceImpl) {
@@ -23,5 +35,158 @@ TEST_F(RequestSourceTest, StaticRequestSourceImpl) {
   ASSERT_EQ(generator(), nullptr);
 }
 
+// Replaces the gRPC client of the remote request source with a mock, which yields the requests
+// queued in `received`.
+class TestRemoteRequestSourceImpl : public RemoteRequestSourceImpl {
+public:
+  TestRemoteRequestSourceImpl(const Envoy::Upstream::ClusterManagerPtr& cluster_manager,
+                              Envoy::Event::Dispatcher& dispatcher, Envoy::Stats::Scope& scope,
+                              SharedRemoteRequestStreamSharedPtr shared_stream,
+                              std::deque<RequestPtr>& received, uint32_t& dequeue_calls)
+      : RemoteRequestSourceImpl(cluster_manager, dispatcher, scope, "service_cluster",
+                                Envoy::Http::RequestHeaderMapImpl::create(),
+                                /*header_buffer_length=*/1, std::move(shared_stream)),
+        received_(received), dequeue_calls_(dequeue_calls) {}
+
+  uint32_t grpcClientsCreated() const { return grpc_clients_created_; }
+
+protected:
+  RequestStreamGrpcClientPtr createGrpcClient(uint32_t, Statistic&, Statistic&) override {
+    grpc_clients_created_++;
+    auto grpc_client = std::make_unique<NiceMock<MockRequestStreamGrpcClient>>();
+    ON_CALL(*grpc_client, streamStatusKnown()).WillByDefault(Return(true));
+    ON_CALL(*grpc_client, maybeDequeue()).WillByDefault(Invoke([this]() -> RequestPtr {
+      dequeue_calls_++;
+      if (received_.empty()) {
+        return nullptr;
+      }
+      RequestPtr request = std::move(received_.front());
+      received_.pop_front();
+      return request;
+    }));
+    return grpc_client;
+  }
+
+private:
+  std::deque<RequestPtr>& received_;
+  uint32_t& dequeue_calls_;
+  uint32_t grpc_clients_created_{0};
+};
+
+class SharedRemoteRequestSourceTest : public testing::Test {
+public:
+  SharedRemoteRequestSourceTest()
+      : shared_stream_(std::make_shared<SharedRemoteRequestStream>(/*capacity=*/2)),
+        transfer_timer_(new NiceMock<Envoy::Event::MockTimer>()) {
+    // Only the owner of the shared stream creates a transfer timer.
+    EXPECT_CALL(dispatcher_, createTimer_(_)).WillOnce(Invoke([this](Envoy::Event::TimerCb cb) {
+      transfer_timer_cb_ = std::move(cb);
+      return transfer_timer_;
+    }));
+    owner_ = createSource();
+    other_ = createSource();
+    owner_->initOnThread();
+    other_->initOnThread();
+  }
+
+  ~SharedRemoteRequestSourceTest() override {
+    owner_->destroyOnThread();
+    other_->destroyOnThread();
+  }
+
+  std::unique_ptr<TestRemoteRequestSourceImpl> createSource() {
+    return std::make_unique<TestRemoteRequestSourceImpl>(
+        cluster_manager_, dispatcher_, *store_.rootScope(), shared_stream_, received_,
+        dequeue_calls_);
+  }
+
+  void receive(absl::string_view path) {
+    auto header = std::make_shared<Envoy::Http::TestRequestHeaderMapImpl>();
+    header->setPath(path);
+    received_.push_back(std::make_unique<RequestImpl>(std::move(header)));
+  }
+
+  static std::string pathOf(const RequestPtr& request) {
+    return request == nullptr ? "" : std::string(request->header()->getPathValue());
+  }
+
+  static const Statistic& statistic(const RequestSource& source, absl::string_view id) {
+    return *source.statistics().at(std::string(id));
+  }
+
+  // Picked up by the time source of the mock dispatcher.
+  Envoy::Event::SimulatedTimeSystem time_system_;
+  NiceMock<Envoy::Event::MockDispatcher> dispatcher_;
+  // Unused, as the gRPC client is mocked.
+  const Envoy::Upstream::ClusterManagerPtr cluster_manager_;
+  Envoy::Stats::IsolatedStoreImpl store_;
+  SharedRemoteRequestStreamSharedPtr shared_stream_;
+  std::deque<RequestPtr> received_;
+  uint32_t dequeue_calls_{0};
+  NiceMock<Envoy::Event::MockTimer>* transfer_timer_; // not owned
+  Envoy::Event::TimerCb transfer_timer_cb_;
+  std::unique_ptr<TestRemoteRequestSourceImpl> owner_;
+  std::unique_ptr<TestRemoteRequestSourceImpl> other_;
+};
+
+TEST_F(SharedRemoteRequestSourceTest, OnlyTheFirstSourceToInitializeOwnsTheStream) {
+  EXPECT_EQ(owner_->grpcClientsCreated(), 1U);
+  EXPECT_EQ(other_->grpcClientsCreated(), 0U);
+  EXPECT_TRUE(transfer_timer_cb_ != nullptr);
+}
+
+TEST_F(SharedRemoteRequestSourceTest, OwnerFillsTheStreamAndHoldsWhatDoesNotFit) {
+  receive("/1");
+  receive("/2");
+  receive("/3");
+  RequestGenerator owner_generator = owner_->get();
+  RequestGenerator other_generator = other_->get();
+
+  // The ring holds two requests, so the third one is held back and nothing more is dequeued.
+  EXPECT_EQ(pathOf(owner_generator()), "/1");
+  EXPECT_EQ(dequeue_calls_, 3U);
+  EXPECT_EQ(shared_stream_->ring().size(), 1U);
+
+  // Other workers only dequeue from the ring.
+  EXPECT_EQ(pathOf(other_generator()), "/2");
+  EXPECT_EQ(other_generator(), nullptr);
+  EXPECT_EQ(dequeue_calls_, 3U);
+
+  // The held request goes first once there is room again.
+  receive("/4");
+  transfer_timer_cb_();
+  EXPECT_EQ(dequeue_calls_, 5U);
+  EXPECT_EQ(pathOf(other_generator()), "/3");
+  EXPECT_EQ(pathOf(other_generator()), "/4");
+  EXPECT_EQ(owner_generator(), nullptr);
+}
+
+TEST_F(SharedRemoteRequestSourceTest, OtherSourcesTrackTheirStallsAndQueueDepth) {
+  RequestGenerator other_generator = other_->get();
+  EXPECT_EQ(other_generator(), nullptr);
+  time_system_.setMonotonicTime(time_system_.monotonicTime() + 10ms);
+  EXPECT_EQ(other_generator(), nullptr);
+
+  receive("/1");
+  receive("/2");
+  transfer_timer_cb_();
+  time_system_.setMonotonicTime(time_system_.monotonicTime() + 5ms);
+  EXPECT_EQ(pathOf(other_generator()), "/1");
+  EXPECT_EQ(pathOf(other_generator()), "/2");
+
+  const Statistic& queue_depth = statistic(*other_, "request_source.queued_request_count");
+  EXPECT_EQ(queue_depth.count(), 4U);
+  EXPECT_EQ(queue_depth.min(), 0U);
+  EXPECT_EQ(queue_depth.max(), 2U);
+  // The stall lasted from the first failed dequeue until the first successful one.
+  const Statistic& stall = statistic(*other_, "request_source.stall");
+  ASSERT_EQ(stall.count(), 1U);
+  EXPECT_NEAR(stall.mean(), std::chrono::nanoseconds(15ms).count(),
+              std::chrono::nanoseconds(100us).count());
+  // The owner did not dequeue, so it did not stall.
+  EXPECT_EQ(statistic(*owner_, "request_source.stall").count(), 0U);
+  EXPECT_EQ(statistic(*owner_, "request_source.queued_request_count").count(), 0U);
+}
+
 } // namespace Client
 } // namespace Nighthawk
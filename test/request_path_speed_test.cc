@@ -0,0 +1,278 @@
+// Measures the cost of the request path of a worker, in time and heap allocations. Run with:
+// bazel run -c opt //test:request_path_speed_test
+// Steady state, the benchmarks below are expected to report zero allocations per request, except
+// for the std::function baseline and the stream decoder, which sets up an Envoy stream info for
+// each request. Allocations are counted by replacing the global operator new, which is not
+// possible when building with tcmalloc; the counters are omitted in that case.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "nighthawk/common/operation_callback.h"
+#include "nighthawk/common/sequencer.h"
+
+#include "external/envoy/source/common/api/api_impl.h"
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/stats/isolated_store_impl.h"
+#include "external/envoy/test/test_common/utility.h"
+
+#include "source/client/stream_decoder.h"
+#include "source/common/platform_util_impl.h"
+#include "source/common/rate_limiter_impl.h"
+#include "source/common/request_impl.h"
+#include "source/common/request_source_impl.h"
+#include "source/common/sequencer_impl.h"
+#include "source/common/slab_arena.h"
+#include "source/common/statistic_impl.h"
+#include "source/common/termination_predicate_impl.h"
+
+#include "benchmark/benchmark.h"
+
+#if !defined(TCMALLOC) && !defined(GPERFTOOLS_TCMALLOC)
+#define NIGHTHAWK_COUNT_ALLOCATIONS
+namespace {
+std::atomic<uint64_t> allocations{0};
+} // namespace
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+#endif
+
+namespace Nighthawk {
+namespace {
+
+constexpr uint64_t kIncrement = 1;
+
+uint64_t currentAllocations() {
+#ifdef NIGHTHAWK_COUNT_ALLOCATIONS
+  return allocations.load();
+#else
+  return 0;
+#endif
+}
+
+class AllocationCounter {
+public:
+  AllocationCounter() : start_(currentAllocations()) {}
+  // Reports the allocations made since construction, per iteration of the benchmark.
+  void report(benchmark::State& state) const {
+#ifdef NIGHTHAWK_COUNT_ALLOCATIONS
+    state.counters["allocations_per_request"] = benchmark::Counter(
+        static_cast<double>(currentAllocations() - start_), benchmark::Counter::kAvgIterations);
+#else
+    state.SetLabel("allocations are not counted when building with tcmalloc");
+#endif
+  }
+
+private:
+  const uint64_t start_;
+};
+
+// Mirrors the completion callback that SequencerImpl hands to its target for each request, and
+// the way the benchmark client passes it on to the stream decoder. Instantiated with
+// std::function as well, to compare against.
+template <class Callback> void operationCallback(benchmark::State& state) {
+  uint64_t completed = 0;
+  uint64_t latency_sum = 0;
+  const Envoy::MonotonicTime start_time = Envoy::MonotonicTime(std::chrono::seconds(42));
+  const uint64_t* increment = &kIncrement;
+  AllocationCounter counter;
+  for (auto _ : state) { // NOLINT
+    Callback callback = [&completed, &latency_sum, start_time, increment](bool, bool) {
+      completed += *increment;
+      latency_sum += start_time.time_since_epoch().count();
+    };
+    Callback decoder_callback = std::move(callback);
+    decoder_callback(true, true);
+  }
+  counter.report(state);
+  benchmark::DoNotOptimize(completed);
+  benchmark::DoNotOptimize(latency_sum);
+}
+BENCHMARK_TEMPLATE(operationCallback, OperationCallback);
+BENCHMARK_TEMPLATE(operationCallback, std::function<void(bool, bool)>);
+
+void staticRequestSource(benchmark::State& state) {
+  StaticRequestSourceImpl request_source(Envoy::Http::RequestHeaderMapImpl::create());
+  RequestGenerator generator = request_source.get();
+  // Warm up, so that the request arena grows to size before counting starts.
+  generator();
+  AllocationCounter counter;
+  for (auto _ : state) { // NOLINT
+    RequestPtr request = generator();
+    benchmark::DoNotOptimize(request->header());
+  }
+  counter.report(state);
+}
+BENCHMARK(staticRequestSource);
+
+struct DecoderSizedObject {
+  static void* operator new(size_t size, SlabArena& arena) { return arena.allocate(size); }
+  static void operator delete(void* block) { SlabArena::release(block); }
+  static void operator delete(void* block, SlabArena&) { SlabArena::release(block); }
+  char payload[512];
+};
+
+// Keeps a configurable number of objects in flight, like the benchmark client does with stream
+// decoders.
+void slabArena(benchmark::State& state) {
+  const size_t in_flight = state.range(0);
+  SlabArenaPtr arena = SlabArena::create(sizeof(DecoderSizedObject));
+  std::vector<DecoderSizedObject*> objects(in_flight);
+  for (auto& object : objects) {
+    object = new (*arena) DecoderSizedObject();
+  }
+  size_t i = 0;
+  AllocationCounter counter;
+  for (auto _ : state) { // NOLINT
+    delete objects[i];
+    objects[i] = new (*arena) DecoderSizedObject();
+    i = (i + 1) % in_flight;
+  }
+  counter.report(state);
+  for (auto& object : objects) {
+    delete object;
+  }
+}
+BENCHMARK(slabArena)->Arg(1)->Arg(100)->Arg(10000);
+
+class NullDecoderCompletionCallback : public Client::StreamDecoderCompletionCallback {
+public:
+  void onComplete(bool, const Envoy::Http::ResponseHeaderMap&) override {}
+  void onPoolFailure(Envoy::Http::ConnectionPool::PoolFailureReason) override {}
+  void exportLatency(const uint32_t, const uint64_t) override {}
+  void handleResponseData(const Envoy::Buffer::Instance&) override {}
+  void onExpectationMismatch(const Client::ExpectationMismatch) override {}
+};
+
+// Starts and completes a request with a json body the way the benchmark client does: the stream
+// decoder comes from the slab arena, gets the header and body of the request, and is tracked
+// while in flight. The pool fails the request right away, so that no connection is involved.
+void streamDecoder(benchmark::State& state) {
+  Envoy::Api::ApiPtr api = Envoy::Api::createApiForTest();
+  Envoy::Event::DispatcherPtr dispatcher = api->allocateDispatcher("decoder");
+  SlabArenaPtr arena = SlabArena::create(sizeof(Client::StreamDecoder));
+  StreamingStatistic connect_statistic;
+  StreamingStatistic latency_statistic;
+  StreamingStatistic response_header_size_statistic;
+  StreamingStatistic response_body_size_statistic;
+  StreamingStatistic origin_latency_statistic;
+  NullDecoderCompletionCallback decoder_completion_callback;
+  Envoy::Random::RandomGeneratorImpl random_generator;
+  Envoy::Tracing::TracerSharedPtr tracer;
+  Client::InFlightStreamDecoders in_flight_decoders;
+  const RequestImpl request(Envoy::Http::RequestHeaderMapImpl::create(),
+                            std::make_shared<const std::string>(R"({"message": "hello"})"));
+  uint64_t completed = 0;
+  const auto start_and_complete = [&]() {
+    auto* decoder = new (*arena) Client::StreamDecoder(
+        *dispatcher, api->timeSource(), decoder_completion_callback,
+        [&completed](bool, bool) { completed++; }, connect_statistic, latency_statistic,
+        response_header_size_statistic, response_body_size_statistic, origin_latency_statistic,
+        request.header(), request.body(), /*measure_latencies=*/true, request.body()->size(),
+        random_generator, tracer, "");
+    decoder->track(in_flight_decoders);
+    decoder->onPoolFailure(Envoy::Http::ConnectionPool::PoolFailureReason::Overflow, "", nullptr);
+    dispatcher->clearDeferredDeleteList();
+  };
+  // Warm up, so that the arena and the deferred delete list grow to size before counting starts.
+  start_and_complete();
+  AllocationCounter counter;
+  for (auto _ : state) { // NOLINT
+    start_and_complete();
+  }
+  counter.report(state);
+  benchmark::DoNotOptimize(completed);
+}
+BENCHMARK(streamDecoder);
+
+// Lets the sequencer initiate a batch of requests per pass over its loop.
+class BatchRateLimiter : public RateLimiterBaseImpl {
+public:
+  BatchRateLimiter(Envoy::TimeSource& time_source) : RateLimiterBaseImpl(time_source) {}
+  bool tryAcquireOne() override {
+    if (acquired_in_batch_ == kBatchSize) {
+      acquired_in_batch_ = 0;
+      return false;
+    }
+    acquired_in_batch_++;
+    return true;
+  }
+  void releaseOne() override { acquired_in_batch_--; }
+
+private:
+  static constexpr uint64_t kBatchSize = 64;
+  uint64_t acquired_in_batch_{0};
+};
+
+class CountTerminationPredicate : public TerminationPredicateBaseImpl {
+public:
+  CountTerminationPredicate(const uint64_t& count, const uint64_t limit)
+      : count_(count), limit_(limit) {}
+  TerminationPredicate::Status evaluate() override {
+    return count_ >= limit_ ? TerminationPredicate::Status::TERMINATE
+                            : TerminationPredicate::Status::PROCEED;
+  }
+
+private:
+  const uint64_t& count_;
+  const uint64_t limit_;
+};
+
+// Runs the sequencer loop against a target that completes each request right away, the way the
+// worker wires the sequencer to its benchmark client. Reports the throughput of the loop and the
+// allocations it makes per request.
+void sequencerLoop(benchmark::State& state) {
+  const uint64_t requests = state.range(0);
+  Envoy::Api::ApiPtr api = Envoy::Api::createApiForTest();
+  Envoy::Event::DispatcherPtr dispatcher = api->allocateDispatcher("sequencer");
+  Envoy::Stats::IsolatedStoreImpl store;
+  PlatformUtilImpl platform_util;
+  uint64_t started = 0;
+  SequencerTarget target = [&started](OperationCallback callback) {
+    started++;
+    callback(true, true);
+    return true;
+  };
+  uint64_t total_requests = 0;
+  uint64_t allocations_in_loop = 0;
+  for (auto _ : state) { // NOLINT
+    state.PauseTiming();
+    started = 0;
+    SequencerImpl sequencer(
+        platform_util, *dispatcher, api->timeSource(),
+        std::make_unique<BatchRateLimiter>(api->timeSource()), target,
+        std::make_unique<StreamingStatistic>(), std::make_unique<StreamingStatistic>(),
+        nighthawk::client::SequencerIdleStrategy::POLL,
+        std::make_unique<CountTerminationPredicate>(started, requests), *store.rootScope());
+    state.ResumeTiming();
+    const uint64_t allocations_before = currentAllocations();
+    sequencer.start();
+    sequencer.waitForCompletion();
+    allocations_in_loop += currentAllocations() - allocations_before;
+    total_requests += started;
+  }
+  state.SetItemsProcessed(total_requests);
+#ifdef NIGHTHAWK_COUNT_ALLOCATIONS
+  state.counters["allocations_per_request"] =
+      static_cast<double>(allocations_in_loop) / std::max<uint64_t>(total_requests, 1);
+#endif
+}
+BENCHMARK(sequencerLoop)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Nighthawk
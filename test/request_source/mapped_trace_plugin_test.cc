@@ -0,0 +1,318 @@
+#include <chrono>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nighthawk/common/exception.h"
+#include "nighthawk/request_source/request_source_plugin_config_factory.h"
+
+#include "external/envoy/source/common/config/utility.h"
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/test/mocks/stats/mocks.h"
+#include "external/envoy/test/test_common/status_utility.h"
+#include "external/envoy/test/test_common/utility.h"
+
+#include "api/request_source/request_source_plugin.pb.h"
+
+#include "source/request_source/mapped_trace_plugin_impl.h"
+#include "source/request_source/request_trace.h"
+
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Nighthawk {
+namespace {
+
+using namespace std::chrono_literals;
+using ::Envoy::StatusHelpers::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::Pair;
+using ::testing::Test;
+
+class MappedTraceRequestSourceTest : public Test {
+public:
+  MappedTraceRequestSourceTest() : api_(Envoy::Api::createApiForTest(stats_store_)) {}
+
+  // Writes a trace with the given number of requests, with paths /0, /1, ..., and a body for every
+  // other request.
+  // When timed, request i was sent at i * 100ms.
+  std::string writeTrace(const std::string& name, const uint64_t requests,
+                         const bool timed = false) {
+    RequestTraceWriter writer;
+    for (uint64_t i = 0; i < requests; i++) {
+      absl::optional<std::chrono::nanoseconds> time;
+      if (timed) {
+        time = std::chrono::milliseconds(100 * i);
+      }
+      writer.addRecord({{":path", absl::StrCat("/", i)}, {"x-trace", "yes"}},
+                       i % 2 == 0 ? absl::optional<std::string>() : "body", time);
+    }
+    const std::string path = TestEnvironment::writeStringToFileForTest(name, "");
+    EXPECT_TRUE(writer.writeToFile(path).ok());
+    return path;
+  }
+
+  RequestSourcePtr createSource(const std::string& path, const uint64_t num_requests,
+                                const bool replay_timing = false,
+                                const absl::optional<double> time_scale = absl::nullopt) {
+    nighthawk::request_source::MappedTraceRequestSourceConfig config;
+    config.set_file_path(path);
+    config.set_num_requests(num_requests);
+    config.set_replay_timing(replay_timing);
+    if (time_scale.has_value()) {
+      config.mutable_time_scale()->set_value(time_scale.value());
+    }
+    Envoy::ProtobufWkt::Any config_any;
+    config_any.PackFrom(config);
+    auto& config_factory =
+        Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+            "nighthawk.mapped-trace-request-source-plugin");
+    Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+    header->setPath("/default");
+    header->setHost("default-host");
+    return config_factory.createRequestSourcePlugin(config_any, *api_, std::move(header));
+  }
+
+  Envoy::Stats::MockIsolatedStatsStore stats_store_;
+  Envoy::Api::ApiPtr api_;
+};
+
+TEST(RequestTraceTest, WriteAndMapRoundTrip) {
+  RequestTraceWriter writer;
+  writer.addRecord({{":method", "GET"}, {":path", "/a"}}, absl::nullopt);
+  writer.addRecord({{":method", "POST"}, {":path", "/a"}, {"x-empty", ""}}, "payload");
+  writer.addRecord({}, "payload");
+  EXPECT_EQ(writer.records(), 3);
+  const std::string path = TestEnvironment::writeStringToFileForTest("round_trip.trace", "");
+  ASSERT_TRUE(writer.writeToFile(path).ok());
+
+  absl::StatusOr<MappedRequestTraceSharedPtr> trace = MappedRequestTrace::open(path);
+  ASSERT_TRUE(trace.ok()) << trace.status();
+  ASSERT_EQ((*trace)->records(), 3);
+  RequestTraceRecord record;
+  ASSERT_TRUE((*trace)->read(0, record));
+  EXPECT_THAT(record.headers, ElementsAre(Pair(":method", "GET"), Pair(":path", "/a")));
+  EXPECT_FALSE(record.body.has_value());
+  ASSERT_TRUE((*trace)->read(1, record));
+  EXPECT_THAT(record.headers,
+              ElementsAre(Pair(":method", "POST"), Pair(":path", "/a"), Pair("x-empty", "")));
+  EXPECT_EQ(record.body, "payload");
+  ASSERT_TRUE((*trace)->read(2, record));
+  EXPECT_TRUE(record.headers.empty());
+  EXPECT_EQ(record.body, "payload");
+}
+
+TEST(RequestTraceTest, InternsStringsAndBodies) {
+  RequestTraceWriter small_writer;
+  RequestTraceWriter large_writer;
+  const std::string body(1000, 'b');
+  small_writer.addRecord({{":path", "/same"}}, body);
+  for (int i = 0; i < 100; i++) {
+    large_writer.addRecord({{":path", "/same"}}, body);
+  }
+  const std::string small_path = TestEnvironment::writeStringToFileForTest("small.trace", "");
+  const std::string large_path = TestEnvironment::writeStringToFileForTest("large.trace", "");
+  ASSERT_TRUE(small_writer.writeToFile(small_path).ok());
+  ASSERT_TRUE(large_writer.writeToFile(large_path).ok());
+  // Each additional record only adds its offset, a header field and a body index.
+  EXPECT_EQ(TestEnvironment::readFileToStringForTest(large_path).size() -
+                TestEnvironment::readFileToStringForTest(small_path).size(),
+            99 * (8 + 8 + 4));
+}
+
+TEST(RequestTraceTest, KeepsTimesOnlyWhenAllRecordsHaveOne) {
+  RequestTraceWriter timed_writer;
+  timed_writer.addRecord({{":path", "/a"}}, absl::nullopt, std::chrono::nanoseconds(0));
+  timed_writer.addRecord({{":path", "/b"}}, absl::nullopt, std::chrono::milliseconds(5));
+  const std::string timed_path = TestEnvironment::writeStringToFileForTest("timed.trace", "");
+  ASSERT_TRUE(timed_writer.writeToFile(timed_path).ok());
+  absl::StatusOr<MappedRequestTraceSharedPtr> timed = MappedRequestTrace::open(timed_path);
+  ASSERT_TRUE(timed.ok()) << timed.status();
+  ASSERT_TRUE((*timed)->hasTimes());
+  EXPECT_EQ((*timed)->time(1), std::chrono::milliseconds(5));
+  RequestTraceRecord record;
+  ASSERT_TRUE((*timed)->read(1, record));
+  EXPECT_EQ(record.time, std::chrono::milliseconds(5));
+
+  RequestTraceWriter untimed_writer;
+  untimed_writer.addRecord({{":path", "/a"}}, absl::nullopt, std::chrono::nanoseconds(0));
+  untimed_writer.addRecord({{":path", "/b"}}, absl::nullopt);
+  const std::string untimed_path = TestEnvironment::writeStringToFileForTest("untimed.trace", "");
+  ASSERT_TRUE(untimed_writer.writeToFile(untimed_path).ok());
+  absl::StatusOr<MappedRequestTraceSharedPtr> untimed = MappedRequestTrace::open(untimed_path);
+  ASSERT_TRUE(untimed.ok()) << untimed.status();
+  EXPECT_FALSE((*untimed)->hasTimes());
+  ASSERT_TRUE((*untimed)->read(0, record));
+  EXPECT_FALSE(record.time.has_value());
+}
+
+TEST(RequestTraceTest, StopsInterningPastTheLimit) {
+  // Only "/a" fits the limit, so later copies of "/b" are stored again.
+  RequestTraceWriter writer(2);
+  for (int i = 0; i < 10; i++) {
+    writer.addRecord({{":path", i % 2 == 0 ? "/a" : "/b"}}, absl::nullopt);
+  }
+  const std::string path = TestEnvironment::writeStringToFileForTest("limited.trace", "");
+  ASSERT_TRUE(writer.writeToFile(path).ok());
+  absl::StatusOr<MappedRequestTraceSharedPtr> trace = MappedRequestTrace::open(path);
+  ASSERT_TRUE(trace.ok()) << trace.status();
+  RequestTraceRecord record;
+  for (uint64_t i = 0; i < 10; i++) {
+    ASSERT_TRUE((*trace)->read(i, record));
+    EXPECT_THAT(record.headers, ElementsAre(Pair(":path", i % 2 == 0 ? "/a" : "/b")));
+  }
+}
+
+TEST(RequestTraceTest, RejectsMalformedFiles) {
+  EXPECT_THAT(MappedRequestTrace::open("/does/not/exist").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  const std::string short_file = TestEnvironment::writeStringToFileForTest("short.trace", "NHTR");
+  EXPECT_THAT(MappedRequestTrace::open(short_file).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  const std::string not_a_trace =
+      TestEnvironment::writeStringToFileForTest("not_a.trace", std::string(200, 'x'));
+  EXPECT_THAT(MappedRequestTrace::open(not_a_trace).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("bad magic value")));
+
+  RequestTraceWriter writer;
+  writer.addRecord({{":path", "/a"}}, "body");
+  const std::string path = TestEnvironment::writeStringToFileForTest("truncated.trace", "");
+  ASSERT_TRUE(writer.writeToFile(path).ok());
+  const std::string contents = TestEnvironment::readFileToStringForTest(path);
+  const std::string truncated = TestEnvironment::writeStringToFileForTest(
+      "truncated.trace", contents.substr(0, contents.size() - 4));
+  EXPECT_THAT(MappedRequestTrace::open(truncated).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("truncated")));
+}
+
+TEST_F(MappedTraceRequestSourceTest, ReplaysTraceOnce) {
+  const std::string path = writeTrace("replay_once.trace", 3);
+  RequestSourcePtr source = createSource(path, 0);
+  RequestGenerator generator = source->get();
+  for (int i = 0; i < 3; i++) {
+    RequestPtr request = generator();
+    ASSERT_NE(request, nullptr);
+    EXPECT_EQ(request->header()->getPathValue(), absl::StrCat("/", i));
+    // Values that are not in the trace are taken from the default header.
+    EXPECT_EQ(request->header()->getHostValue(), "default-host");
+    EXPECT_EQ(request->header()->get(Envoy::Http::LowerCaseString("x-trace"))[0]->value(), "yes");
+    if (i % 2 == 1) {
+      EXPECT_EQ(*request->body(), "body");
+      EXPECT_EQ(request->header()->getContentLengthValue(), "4");
+    } else {
+      EXPECT_EQ(request->body(), nullptr);
+      EXPECT_EQ(request->header()->ContentLength(), nullptr);
+    }
+  }
+  EXPECT_EQ(generator(), nullptr);
+  EXPECT_EQ(generator(), nullptr);
+}
+
+TEST_F(MappedTraceRequestSourceTest, LoopsWhenMoreRequestsThanRecords) {
+  const std::string path = writeTrace("loop.trace", 2);
+  RequestSourcePtr source = createSource(path, 5);
+  RequestGenerator generator = source->get();
+  std::vector<std::string> paths;
+  while (RequestPtr request = generator()) {
+    paths.emplace_back(request->header()->getPathValue());
+  }
+  EXPECT_THAT(paths, ElementsAre("/0", "/1", "/0", "/1", "/0"));
+}
+
+TEST_F(MappedTraceRequestSourceTest, WorkersShareTheTrace) {
+  const uint64_t kRequests = 3 * MappedTraceRequestSource::kSliceSize + 7;
+  const std::string path = writeTrace("shared.trace", kRequests);
+  // Sources created while an earlier one is alive share its mapping and position, like the
+  // sources of the workers of an execution do.
+  RequestSourcePtr first = createSource(path, 0);
+  RequestSourcePtr second = createSource(path, 0);
+  RequestGenerator first_generator = first->get();
+  RequestGenerator second_generator = second->get();
+  std::set<std::string> paths;
+  uint64_t replayed = 0;
+  bool first_done = false;
+  bool second_done = false;
+  while (!first_done || !second_done) {
+    for (auto [generator, done] : {std::make_pair(&first_generator, &first_done),
+                                   std::make_pair(&second_generator, &second_done)}) {
+      RequestPtr request = (*generator)();
+      if (request == nullptr) {
+        *done = true;
+      } else {
+        paths.emplace(request->header()->getPathValue());
+        replayed++;
+      }
+    }
+  }
+  // Each request in the trace got replayed by exactly one of the sources.
+  EXPECT_EQ(replayed, kRequests);
+  EXPECT_EQ(paths.size(), kRequests);
+
+  // Once all sources are gone, a new source starts from the beginning.
+  first.reset();
+  second.reset();
+  RequestSourcePtr third = createSource(path, 0);
+  RequestGenerator third_generator = third->get();
+  EXPECT_EQ(third_generator()->header()->getPathValue(), "/0");
+}
+
+TEST_F(MappedTraceRequestSourceTest, UntimedReplayLeavesPacingToTheRateLimiter) {
+  const std::string path = writeTrace("untimed_replay.trace", 2, true);
+  RequestSourcePtr source = createSource(path, 0);
+  EXPECT_EQ(source->releaseTiming(), nullptr);
+}
+
+TEST_F(MappedTraceRequestSourceTest, TimedReplayReleasesAtRecordedTimes) {
+  const std::string path = writeTrace("timed_replay.trace", 3, true);
+  // Replays the trace twice, at twice the recorded speed.
+  RequestSourcePtr source = createSource(path, 6, true, 2.0);
+  RequestReleaseTiming* timing = source->releaseTiming();
+  ASSERT_NE(timing, nullptr);
+  RequestGenerator generator = source->get();
+  std::vector<std::pair<std::string, std::chrono::nanoseconds>> replayed;
+  while (absl::optional<std::chrono::nanoseconds> offset = timing->nextReleaseOffset()) {
+    // The offset sticks to the claimed request until it has been generated.
+    EXPECT_EQ(timing->nextReleaseOffset(), offset);
+    RequestPtr request = generator();
+    ASSERT_NE(request, nullptr);
+    replayed.emplace_back(request->header()->getPathValue(), offset.value());
+  }
+  EXPECT_EQ(generator(), nullptr);
+  // The second pass starts at the time of the last request of the first.
+  EXPECT_THAT(replayed, ElementsAre(Pair("/0", 0ms), Pair("/1", 50ms), Pair("/2", 100ms),
+                                    Pair("/0", 100ms), Pair("/1", 150ms), Pair("/2", 200ms)));
+}
+
+TEST_F(MappedTraceRequestSourceTest, TimedReplayHandsOutRequestsInOrderOfTime) {
+  const std::string path = writeTrace("timed_shared.trace", 4, true);
+  RequestSourcePtr first = createSource(path, 0, true);
+  RequestSourcePtr second = createSource(path, 0, true);
+  // Each source holds on to the earliest request that was not claimed yet.
+  EXPECT_EQ(first->releaseTiming()->nextReleaseOffset(), 0ms);
+  EXPECT_EQ(second->releaseTiming()->nextReleaseOffset(), 100ms);
+  EXPECT_EQ(second->get()()->header()->getPathValue(), "/1");
+  EXPECT_EQ(second->releaseTiming()->nextReleaseOffset(), 200ms);
+  EXPECT_EQ(first->get()()->header()->getPathValue(), "/0");
+  EXPECT_EQ(first->releaseTiming()->nextReleaseOffset(), 300ms);
+}
+
+TEST_F(MappedTraceRequestSourceTest, TimedReplayRequiresTiming) {
+  const std::string path = writeTrace("no_timing.trace", 2);
+  EXPECT_THROW_WITH_REGEX(createSource(path, 0, true), NighthawkException, "holds no timing");
+  const std::string timed_path = writeTrace("bad_scale.trace", 2, true);
+  EXPECT_THROW_WITH_REGEX(createSource(timed_path, 0, true, 0.0), NighthawkException,
+                          "time_scale must be greater than 0");
+}
+
+TEST_F(MappedTraceRequestSourceTest, ThrowsOnMalformedTrace) {
+  const std::string path = TestEnvironment::writeStringToFileForTest("bad.trace", "not a trace");
+  EXPECT_THROW_WITH_REGEX(createSource(path, 0), NighthawkException, "not a request trace file");
+}
+
+} // namespace
+} // namespace Nighthawk
@@ -0,0 +1,251 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nighthawk/common/exception.h"
+#include "nighthawk/request_source/request_source_plugin_config_factory.h"
+
+#include "external/envoy/source/common/config/utility.h"
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/test/mocks/stats/mocks.h"
+#include "external/envoy/test/test_common/utility.h"
+
+#include "api/request_source/request_source_plugin.pb.h"
+
+#include "source/request_source/reloadable_plugin_impl.h"
+
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Nighthawk {
+namespace {
+
+using namespace std::chrono_literals;
+using ::testing::HasSubstr;
+using ::testing::Test;
+
+// Request options with a single entry for each of the paths.
+std::string optionsForPaths(const std::vector<std::string>& paths,
+                            const std::vector<double>& weights = {}) {
+  std::string yaml = "options:\n";
+  for (size_t i = 0; i < paths.size(); i++) {
+    absl::StrAppend(&yaml, "  - request_method: 1\n", "    request_headers:\n",
+                    "      - { header: { key: \":path\", value: \"", paths[i], "\" } }\n");
+    if (i < weights.size()) {
+      absl::StrAppend(&yaml, "    weight: ", weights[i], "\n");
+    }
+  }
+  return yaml;
+}
+
+class ReloadableOptionsListRequestSourceTest : public Test {
+public:
+  ReloadableOptionsListRequestSourceTest() : api_(Envoy::Api::createApiForTest(stats_store_)) {}
+
+  Envoy::Http::RequestHeaderMapPtr defaultHeader() {
+    Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+    header->setPath("/default");
+    header->setHost("default-host");
+    return header;
+  }
+
+  ReloadableRequestTableSharedPtr createTable(const std::string& contents) {
+    path_ = TestEnvironment::writeStringToFileForTest("reloadable_options.yaml", contents);
+    return std::make_shared<ReloadableRequestTable>(*api_, path_, 1000000, defaultHeader());
+  }
+
+  // Replaces the file by renaming a new one over it, so that the poller never sees it partially
+  // written.
+  void rewrite(const std::string& contents) {
+    const std::string path =
+        TestEnvironment::writeStringToFileForTest("reloadable_options.yaml.new", contents);
+    ASSERT_EQ(std::rename(path.c_str(), path_.c_str()), 0);
+  }
+
+  RequestSourcePtr createSource(const std::string& path, const uint32_t num_requests,
+                                const std::chrono::milliseconds poll_interval = 1h) {
+    nighthawk::request_source::ReloadableOptionsListRequestSourceConfig config;
+    config.set_file_path(path);
+    config.set_num_requests(num_requests);
+    config.mutable_poll_interval()->set_seconds(poll_interval.count() / 1000);
+    config.mutable_poll_interval()->set_nanos((poll_interval.count() % 1000) * 1000000);
+    Envoy::ProtobufWkt::Any config_any;
+    config_any.PackFrom(config);
+    return factory_.createRequestSourcePlugin(config_any, *api_, defaultHeader());
+  }
+
+  Envoy::Stats::MockIsolatedStatsStore stats_store_;
+  Envoy::Api::ApiPtr api_;
+  std::string path_;
+  // A factory of our own, so that tables do not outlive the tests.
+  ReloadableOptionsListRequestSourceFactory factory_;
+};
+
+TEST_F(ReloadableOptionsListRequestSourceTest, IsRegistered) {
+  auto& config_factory =
+      Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+          "nighthawk.reloadable-options-list-request-source-plugin");
+  EXPECT_EQ(config_factory.name(), "nighthawk.reloadable-options-list-request-source-plugin");
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, ThrowsWhenTheFileCanNotBeLoaded) {
+  EXPECT_THROW(createSource("/does/not/exist.yaml", 0), NighthawkException);
+  const std::string path =
+      TestEnvironment::writeStringToFileForTest("malformed_options.yaml", "options: [{bogus: 1}]");
+  EXPECT_THROW_WITH_REGEX(createSource(path, 0), NighthawkException,
+                          "Failed to load request options");
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, LoopsOverTheOptions) {
+  ReloadableOptionsListRequestSource source(createTable(optionsForPaths({"/a", "/b"})), 3, 0);
+  RequestGenerator generator = source.get();
+  for (const std::string path : {"/a", "/b", "/a"}) {
+    RequestPtr request = generator();
+    ASSERT_NE(request, nullptr);
+    EXPECT_EQ(request->header()->getPathValue(), path);
+    EXPECT_EQ(request->header()->getHostValue(), "default-host");
+    EXPECT_EQ(request->header()->getMethodValue(), "GET");
+    EXPECT_EQ(request->requestClass(), 0U);
+  }
+  EXPECT_EQ(generator(), nullptr);
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, SendsTheDefaultHeaderWithoutOptions) {
+  ReloadableOptionsListRequestSource source(createTable("options: []"), 0, 0);
+  RequestPtr request = source.get()();
+  ASSERT_NE(request, nullptr);
+  EXPECT_EQ(request->header()->getPathValue(), "/default");
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, LabelsGenerations) {
+  ReloadableOptionsListRequestSource source(createTable(optionsForPaths({"/a"})), 0, 0);
+  const std::vector<std::string> request_classes = source.requestClasses();
+  ASSERT_EQ(request_classes.size(), ReloadableOptionsListRequestSource::kLabelledGenerations);
+  EXPECT_EQ(request_classes.front(), "generation_0");
+  EXPECT_EQ(request_classes[14], "generation_14");
+  EXPECT_EQ(request_classes.back(), "later_generations");
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, PicksUpReloadsAtTheNextRequest) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/a", "/b"}));
+  ReloadableOptionsListRequestSource first(table, 0, 0);
+  ReloadableOptionsListRequestSource second(table, 0, 1);
+  RequestGenerator first_generator = first.get();
+  RequestGenerator second_generator = second.get();
+  EXPECT_EQ(first_generator()->header()->getPathValue(), "/a");
+  EXPECT_EQ(second_generator()->header()->getPathValue(), "/a");
+
+  rewrite(optionsForPaths({"/c", "/d"}));
+  ASSERT_TRUE(table->reloadIfChanged().ok());
+  EXPECT_EQ(table->current()->generation(), 1U);
+  for (RequestGenerator* generator : {&first_generator, &second_generator}) {
+    // Generators start over with the options of a new table.
+    RequestPtr request = (*generator)();
+    EXPECT_EQ(request->header()->getPathValue(), "/c");
+    EXPECT_EQ(request->requestClass(), 1U);
+    EXPECT_EQ((*generator)()->header()->getPathValue(), "/d");
+  }
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, OnlyPublishesChangedFiles) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/a"}));
+  const CompiledRequestTableSharedPtr initial = table->current();
+  ASSERT_TRUE(table->reloadIfChanged().ok());
+  EXPECT_EQ(table->current(), initial);
+  EXPECT_EQ(table->current()->generation(), 0U);
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, KeepsTheCurrentTableWhenAReloadFails) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/a"}));
+  ReloadableOptionsListRequestSource source(table, 0, 0);
+  RequestGenerator generator = source.get();
+  rewrite("options: [{bogus: 1}]");
+  EXPECT_THAT(std::string(table->reloadIfChanged().message()),
+              HasSubstr("Failed to load request options"));
+  EXPECT_EQ(table->current()->generation(), 0U);
+  EXPECT_EQ(generator()->header()->getPathValue(), "/a");
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, KeepsTheCurrentTableWhenReloadedWeightsAreInvalid) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/a"}));
+  ReloadableOptionsListRequestSource source(table, 0, 0);
+  RequestGenerator generator = source.get();
+  rewrite(optionsForPaths({"/b", "/c"}, {1, -1}));
+  EXPECT_THAT(std::string(table->reloadIfChanged().message()),
+              HasSubstr("Invalid request options"));
+  EXPECT_EQ(table->generation(), 0U);
+  EXPECT_EQ(generator()->header()->getPathValue(), "/a");
+  // The file is validated again at the next check.
+  EXPECT_FALSE(table->reloadIfChanged().ok());
+  nighthawk::client::RequestOptionsList options_list;
+  options_list.add_options()->mutable_weight()->set_value(0);
+  EXPECT_THROW(table->publish(options_list), NighthawkException);
+  EXPECT_EQ(table->current()->generation(), 0U);
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, FreesReplacedTablesOnceNoGeneratorHoldsThem) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/a"}));
+  ReloadableOptionsListRequestSource source(table, 0, 0);
+  RequestGenerator generator = source.get();
+  std::weak_ptr<const CompiledRequestTable> initial = table->current();
+  rewrite(optionsForPaths({"/b"}));
+  ASSERT_TRUE(table->reloadIfChanged().ok());
+  // The generator holds on to the table until it creates its next request.
+  EXPECT_FALSE(initial.expired());
+  EXPECT_EQ(generator()->header()->getPathValue(), "/b");
+  EXPECT_TRUE(initial.expired());
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, ShiftsWeightedTraffic) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/old"}));
+  ReloadableOptionsListRequestSource source(table, 0, 0);
+  RequestGenerator generator = source.get();
+  rewrite(optionsForPaths({"/old", "/new"}, {9, 1}));
+  ASSERT_TRUE(table->reloadIfChanged().ok());
+  int new_requests = 0;
+  for (int i = 0; i < 10000; i++) {
+    new_requests += generator()->header()->getPathValue() == "/new" ? 1 : 0;
+  }
+  EXPECT_NEAR(new_requests, 1000, 150);
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, FoldsLaterGenerations) {
+  ReloadableRequestTableSharedPtr table = createTable(optionsForPaths({"/a"}));
+  ReloadableOptionsListRequestSource source(table, 0, 0);
+  RequestGenerator generator = source.get();
+  nighthawk::client::RequestOptionsList options_list;
+  for (uint32_t i = 1; i < ReloadableOptionsListRequestSource::kLabelledGenerations + 4; i++) {
+    table->publish(options_list);
+    EXPECT_EQ(table->current()->generation(), i);
+    EXPECT_EQ(generator()->requestClass(),
+              std::min(i, ReloadableOptionsListRequestSource::kLabelledGenerations - 1));
+  }
+}
+
+TEST_F(ReloadableOptionsListRequestSourceTest, SharesATableThatFollowsTheFile) {
+  path_ = TestEnvironment::writeStringToFileForTest("reloadable_options.yaml",
+                                                    optionsForPaths({"/a"}));
+  RequestSourcePtr first = createSource(path_, 0, 10ms);
+  RequestSourcePtr second = createSource(path_, 0, 10ms);
+  RequestGenerator first_generator = first->get();
+  RequestGenerator second_generator = second->get();
+  EXPECT_EQ(first_generator()->header()->getPathValue(), "/a");
+  rewrite(optionsForPaths({"/b"}));
+  // Wait for the poller to pick up the change.
+  for (int i = 0; i < 1000 && first_generator()->header()->getPathValue() != "/b"; i++) {
+    std::this_thread::sleep_for(10ms);
+  }
+  RequestPtr request = first_generator();
+  EXPECT_EQ(request->header()->getPathValue(), "/b");
+  EXPECT_EQ(request->requestClass(), 1U);
+  EXPECT_EQ(second_generator()->header()->getPathValue(), "/b");
+}
+
+} // namespace
+} // namespace Nighthawk
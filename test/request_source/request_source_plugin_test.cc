@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <cstdint>
+#include <limits>
+#include <random>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "envoy/api/api.h"
 #include "envoy/common/exception.h"
@@ -35,6 +39,8 @@ namespace {
 using nighthawk::request_source::FileBasedOptionsListRequestSourceConfig;
 using nighthawk::request_source::InLineOptionsListRequestSourceConfig;
 using nighthawk::request_source::StubPluginConfig;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::NiceMock;
 using ::testing::Test;
 nighthawk::request_source::FileBasedOptionsListRequestSourceConfig
@@ -213,8 +219,10 @@ TEST_F(FileBasedRequestSourcePluginTest,
   Nighthawk::HeaderMapPtr header2 = request2->header();
   EXPECT_EQ(header1->getPathValue(), "/a");
   EXPECT_EQ(header2->getPathValue(), "/b");
-  std::string body1 = request1->body();
-  std::string body2 = request2->body();
+  ASSERT_NE(request1->body(), nullptr);
+  ASSERT_NE(request2->body(), nullptr);
+  std::string body1 = *request1->body();
+  std::string body2 = *request2->body();
   EXPECT_EQ(body1, R"({"message": "hello1"})");
   EXPECT_EQ(body2, R"({"message": "hellohello2"})");
   EXPECT_EQ(request3, nullptr);
@@ -484,13 +492,47 @@ TEST_F(InLineRequestSourcePluginTest,
   Nighthawk::HeaderMapPtr header2 = request2->header();
   EXPECT_EQ(header1->getPathValue(), "/a");
   EXPECT_EQ(header2->getPathValue(), "/b");
-  std::string body1 = request1->body();
-  std::string body2 = request2->body();
+  ASSERT_NE(request1->body(), nullptr);
+  ASSERT_NE(request2->body(), nullptr);
+  std::string body1 = *request1->body();
+  std::string body2 = *request2->body();
   EXPECT_EQ(body1, R"({"message": "hello1"})");
   EXPECT_EQ(body2, R"({"message": "hellohello2"})");
   EXPECT_EQ(request3, nullptr);
 }
 
+TEST_F(InLineRequestSourcePluginTest, RequestsCreatedFromTheSameOptionsShareTheirBody) {
+  Envoy::MessageUtil util;
+  nighthawk::client::RequestOptionsList options_list;
+  THROW_IF_NOT_OK(
+      util.loadFromFile(/*file to load*/ Nighthawk::TestEnvironment::runfilesPath(
+                            "test/request_source/test_data/test-jsonconfig-ab.yaml"),
+                        /*out parameter*/ options_list,
+                        /*validation visitor*/ Envoy::ProtobufMessage::getStrictValidationVisitor(),
+                        /*Api*/ *api_));
+  nighthawk::request_source::InLineOptionsListRequestSourceConfig config =
+      MakeInLinePluginConfig(options_list, /*num_requests*/ 3);
+  Envoy::Protobuf::Any config_any;
+  config_any.PackFrom(config);
+  auto& config_factory =
+      Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+          "nighthawk.in-line-options-list-request-source-plugin");
+  RequestSourcePtr plugin = config_factory.createRequestSourcePlugin(
+      config_any, *api_, Envoy::Http::RequestHeaderMapImpl::create());
+  plugin->initOnThread();
+  Nighthawk::RequestGenerator generator = plugin->get();
+  Nighthawk::RequestPtr request1 = generator();
+  Nighthawk::RequestPtr request2 = generator();
+  Nighthawk::RequestPtr request3 = generator();
+  ASSERT_NE(request1, nullptr);
+  ASSERT_NE(request2, nullptr);
+  ASSERT_NE(request3, nullptr);
+  ASSERT_NE(request1->body(), nullptr);
+  // The list loops, so the third request is created from the same options as the first.
+  EXPECT_EQ(request1->body(), request3->body());
+  EXPECT_NE(request1->body(), request2->body());
+}
+
 TEST_F(InLineRequestSourcePluginTest, CreateRequestSourcePluginWithJsonBodyGetsRequestSize) {
   Envoy::MessageUtil util;
   nighthawk::client::RequestOptionsList options_list;
@@ -659,5 +701,155 @@ TEST_F(
   EXPECT_EQ(request_c_3, nullptr);
 }
 
+TEST(AliasMethodSamplerTest, SamplesInProportionToWeights) {
+  const std::vector<double> weights = {1, 3, 0.5, 5.5};
+  AliasMethodSampler sampler(weights);
+  std::mt19937_64 random(42);
+  std::vector<uint32_t> counts(weights.size());
+  const uint32_t samples = 100000;
+  for (uint32_t i = 0; i < samples; i++) {
+    counts[sampler.sample(random())]++;
+  }
+  for (uint32_t i = 0; i < weights.size(); i++) {
+    EXPECT_NEAR(static_cast<double>(counts[i]) / samples, weights[i] / 10, 0.01);
+  }
+}
+
+TEST(AliasMethodSamplerTest, SamplesTheExtremesOfTheRandomRange) {
+  AliasMethodSampler sampler({1, 1});
+  EXPECT_EQ(sampler.sample(0), 0);
+  EXPECT_EQ(sampler.sample(UINT64_MAX), 1);
+}
+
+TEST(AliasMethodSamplerTest, RejectsWeightsThatAreNotFiniteAndPositive) {
+  for (const double weight : {0.0, -1.0, std::numeric_limits<double>::infinity(),
+                              std::numeric_limits<double>::quiet_NaN()}) {
+    EXPECT_THROW_WITH_REGEX(AliasMethodSampler({1, weight}), NighthawkException,
+                            "Weight 1 must be finite and positive");
+  }
+  const double max = std::numeric_limits<double>::max();
+  EXPECT_THROW_WITH_REGEX(AliasMethodSampler({max, max}), NighthawkException, "finite total");
+}
+
+TEST(AliasMethodSamplerTest, CreateForOptionsRejectsWeightsThatAreNotFiniteAndPositive) {
+  nighthawk::client::RequestOptionsList options_list;
+  options_list.add_options();
+  options_list.add_options()->mutable_weight()->set_value(-2);
+  EXPECT_THROW_WITH_REGEX(AliasMethodSampler::createForOptions(options_list), NighthawkException,
+                          "The weight of request options 1 must be finite and positive");
+}
+
+nighthawk::client::RequestOptionsList MakeWeightedOptionsList() {
+  nighthawk::client::RequestOptionsList options_list;
+  nighthawk::client::RequestOptions* small = options_list.add_options();
+  small->set_request_method(envoy::config::core::v3::RequestMethod::GET);
+  small->mutable_weight()->set_value(95);
+  small->add_request_headers()->mutable_header()->set_key(":path");
+  small->mutable_request_headers(0)->mutable_header()->set_value("/small");
+  // Options without a weight count as having a weight of 1.
+  nighthawk::client::RequestOptions* large = options_list.add_options();
+  large->set_request_method(envoy::config::core::v3::RequestMethod::POST);
+  large->add_request_headers()->mutable_header()->set_key(":path");
+  large->mutable_request_headers(0)->mutable_header()->set_value("/large");
+  nighthawk::client::RequestOptions* medium = options_list.add_options();
+  medium->set_request_method(envoy::config::core::v3::RequestMethod::GET);
+  medium->mutable_weight()->set_value(4);
+  medium->add_request_headers()->mutable_header()->set_key(":path");
+  medium->mutable_request_headers(0)->mutable_header()->set_value("/medium");
+  return options_list;
+}
+
+std::vector<std::string> GeneratePaths(RequestGenerator& generator) {
+  std::vector<std::string> paths;
+  for (RequestPtr request = generator(); request != nullptr; request = generator()) {
+    paths.push_back(std::string(request->header()->getPathValue()));
+  }
+  return paths;
+}
+
+TEST_F(InLineRequestSourcePluginTest, CreateRequestSourcePluginWithWeightsSamplesTheOptions) {
+  nighthawk::request_source::InLineOptionsListRequestSourceConfig config =
+      MakeInLinePluginConfig(MakeWeightedOptionsList(), /*num_requests*/ 10000);
+  Envoy::Protobuf::Any config_any;
+  config_any.PackFrom(config);
+  auto& config_factory =
+      Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+          "nighthawk.in-line-options-list-request-source-plugin");
+  RequestSourcePtr plugin = config_factory.createRequestSourcePlugin(
+      config_any, *api_, Envoy::Http::RequestHeaderMapImpl::create());
+  plugin->initOnThread();
+  RequestGenerator generator = plugin->get();
+  const std::vector<std::string> paths = GeneratePaths(generator);
+  ASSERT_EQ(paths.size(), 10000);
+  EXPECT_NEAR(std::count(paths.begin(), paths.end(), "/small"), 9500, 150);
+  EXPECT_NEAR(std::count(paths.begin(), paths.end(), "/medium"), 400, 100);
+  EXPECT_NEAR(std::count(paths.begin(), paths.end(), "/large"), 100, 50);
+}
+
+TEST_F(InLineRequestSourcePluginTest, WeightedSamplingIsReproducibleForAGivenSeed) {
+  auto make_source = [](const uint64_t seed) {
+    return std::make_unique<OptionsListRequestSource>(
+        /*total_requests*/ 100, Envoy::Http::RequestHeaderMapImpl::create(),
+        std::make_unique<const nighthawk::client::RequestOptionsList>(MakeWeightedOptionsList()),
+        seed);
+  };
+  std::unique_ptr<OptionsListRequestSource> source = make_source(1);
+  std::unique_ptr<OptionsListRequestSource> same_seed_source = make_source(1);
+  std::unique_ptr<OptionsListRequestSource> other_seed_source = make_source(2);
+  RequestGenerator generator = source->get();
+  RequestGenerator same_seed_generator = same_seed_source->get();
+  RequestGenerator other_seed_generator = other_seed_source->get();
+  const std::vector<std::string> paths = GeneratePaths(generator);
+  EXPECT_EQ(paths, GeneratePaths(same_seed_generator));
+  EXPECT_NE(paths, GeneratePaths(other_seed_generator));
+  // Further generators of the same source draw from a different sequence.
+  RequestGenerator second_generator = source->get();
+  EXPECT_NE(paths, GeneratePaths(second_generator));
+}
+
+TEST_F(InLineRequestSourcePluginTest, SeedsWeightedSamplingFromTheWorker) {
+  Envoy::Protobuf::Any config_any;
+  config_any.PackFrom(MakeInLinePluginConfig(MakeWeightedOptionsList(), /*num_requests*/ 100));
+  auto& config_factory =
+      Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+          "nighthawk.in-line-options-list-request-source-plugin");
+  auto generate_paths_for_worker = [&](const uint32_t worker_id) {
+    RequestSourcePtr plugin = config_factory.createRequestSourcePluginForWorker(
+        config_any, *api_, Envoy::Http::RequestHeaderMapImpl::create(), worker_id);
+    RequestGenerator generator = plugin->get();
+    return GeneratePaths(generator);
+  };
+  // The sequence of a worker does not depend on the request sources created before.
+  const std::vector<std::string> second_worker_paths = generate_paths_for_worker(1);
+  const std::vector<std::string> first_worker_paths = generate_paths_for_worker(0);
+  EXPECT_NE(first_worker_paths, second_worker_paths);
+  EXPECT_EQ(generate_paths_for_worker(1), second_worker_paths);
+  EXPECT_EQ(generate_paths_for_worker(0), first_worker_paths);
+}
+
+TEST_F(InLineRequestSourcePluginTest, RequestsAreClassifiedByTheNameOfTheirOptions) {
+  nighthawk::client::RequestOptionsList options_list = MakeWeightedOptionsList();
+  // Options with the same name share a class, and unnamed options get one of their own.
+  options_list.mutable_options(0)->set_name("get");
+  options_list.mutable_options(2)->set_name("get");
+  OptionsListRequestSource source(
+      /*total_requests*/ 100, Envoy::Http::RequestHeaderMapImpl::create(),
+      std::make_unique<const nighthawk::client::RequestOptionsList>(options_list));
+  EXPECT_THAT(source.requestClasses(), ElementsAre("get", "options_1"));
+  RequestGenerator generator = source.get();
+  for (RequestPtr request = generator(); request != nullptr; request = generator()) {
+    EXPECT_EQ(request->requestClass(), request->header()->getPathValue() == "/large" ? 1 : 0);
+  }
+}
+
+TEST_F(InLineRequestSourcePluginTest, RequestsOfASingleOptionAreNotClassified) {
+  nighthawk::client::RequestOptionsList options_list;
+  options_list.add_options()->set_name("only");
+  OptionsListRequestSource source(
+      /*total_requests*/ 1, Envoy::Http::RequestHeaderMapImpl::create(),
+      std::make_unique<const nighthawk::client::RequestOptionsList>(options_list));
+  EXPECT_THAT(source.requestClasses(), IsEmpty());
+}
+
 } // namespace
 } // namespace Nighthawk
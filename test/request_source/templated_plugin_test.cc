@@ -0,0 +1,277 @@
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nighthawk/common/exception.h"
+#include "nighthawk/request_source/request_source_plugin_config_factory.h"
+
+#include "external/envoy/source/common/config/utility.h"
+#include "external/envoy/source/common/http/header_map_impl.h"
+#include "external/envoy/source/common/protobuf/protobuf.h"
+#include "external/envoy/test/mocks/stats/mocks.h"
+#include "external/envoy/test/test_common/status_utility.h"
+#include "external/envoy/test/test_common/utility.h"
+
+#include "api/request_source/request_source_plugin.pb.h"
+
+#include "source/common/seeded_random_generator_impl.h"
+#include "source/request_source/request_template.h"
+#include "source/request_source/templated_plugin_impl.h"
+
+#include "test/common/fake_time_source.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Nighthawk {
+namespace {
+
+using ::Envoy::StatusHelpers::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::MatchesRegex;
+using ::testing::Test;
+
+std::string headerValue(const Envoy::Http::RequestHeaderMap& header, const std::string& name) {
+  const auto result = header.get(Envoy::Http::LowerCaseString(name));
+  return result.empty() ? "" : std::string(result[0]->value().getStringView());
+}
+
+class RequestTemplateTest : public Test {
+public:
+  RequestTemplateRenderer createRenderer(
+      const std::vector<std::pair<std::string, std::string>>& fields) {
+    absl::StatusOr<RequestTemplateSharedPtr> request_template = RequestTemplate::compile(fields);
+    EXPECT_TRUE(request_template.ok()) << request_template.status();
+    return RequestTemplateRenderer(request_template.value(), random_, time_source_);
+  }
+
+  // Renders the next request and returns the value of the given field.
+  std::string render(RequestTemplateRenderer& renderer, const std::string& name = ":path") {
+    Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+    renderer.render(*header);
+    return headerValue(*header, name);
+  }
+
+  SeededRandomGeneratorImpl random_{42};
+  FakeIncrementingTimeSource time_source_;
+};
+
+TEST_F(RequestTemplateTest, RejectsMalformedTemplates) {
+  const std::vector<std::string> malformed = {
+      "/{rand:1..10",  "/}",           "/{unknown}",    "/{uuid:1}",       "/{rand}",
+      "/{rand:10..1}", "/{rand:1-10}", "/{rand:a..10}", "/{rand:1.5..10}", "/{rand:-1..10}",
+      "/{seq:1..2:3}", "/{zipf:1..10:0}", "/{zipf:1..10:x}"};
+  for (const std::string& text : malformed) {
+    EXPECT_THAT(RequestTemplate::compile({{":path", text}}),
+                StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr(":path")))
+        << text;
+  }
+}
+
+TEST_F(RequestTemplateTest, RendersLiteralsAndEscapedBraces) {
+  RequestTemplateRenderer renderer =
+      createRenderer({{":path", "/a/{{b}}/c"}, {"x-empty", ""}, {"x-plain", "value"}});
+  Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+  header->setCopy(Envoy::Http::LowerCaseString("x-plain"), "replaced");
+  renderer.render(*header);
+  EXPECT_EQ(header->getPathValue(), "/a/{b}/c");
+  EXPECT_EQ(headerValue(*header, "x-plain"), "value");
+  EXPECT_EQ(header->get(Envoy::Http::LowerCaseString("x-plain")).size(), 1U);
+  EXPECT_EQ(header->get(Envoy::Http::LowerCaseString("x-empty")).size(), 1U);
+}
+
+TEST_F(RequestTemplateTest, RendersCounters) {
+  RequestTemplateRenderer renderer = createRenderer({{":path", "/{counter}/{counter}"}});
+  EXPECT_EQ(render(renderer), "/0/0");
+  EXPECT_EQ(render(renderer), "/1/1");
+  EXPECT_EQ(render(renderer), "/2/2");
+}
+
+TEST_F(RequestTemplateTest, RendersTheSameUuidForAllFieldsOfARequest) {
+  RequestTemplateRenderer renderer =
+      createRenderer({{":path", "/{uuid}"}, {"x-request-id", "{uuid}"}});
+  std::set<std::string> uuids;
+  for (int i = 0; i < 100; i++) {
+    Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+    renderer.render(*header);
+    const std::string uuid = headerValue(*header, "x-request-id");
+    EXPECT_THAT(uuid, MatchesRegex("[0-9a-f]{8}-[0-9a-f]{4}-4[0-9a-f]{3}-[89ab][0-9a-f]{3}-"
+                                   "[0-9a-f]{12}"));
+    EXPECT_EQ(header->getPathValue(), "/" + uuid);
+    uuids.insert(uuid);
+  }
+  EXPECT_EQ(uuids.size(), 100U);
+}
+
+TEST_F(RequestTemplateTest, RendersTimestampsTakenOncePerRequest) {
+  time_source_.setSystemTimeSeconds(1234);
+  RequestTemplateRenderer renderer =
+      createRenderer({{":path", "/{timestamp}"}, {"x-sent", "{timestamp}"}});
+  Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+  renderer.render(*header);
+  EXPECT_EQ(header->getPathValue(), "/1234000");
+  EXPECT_EQ(headerValue(*header, "x-sent"), "1234000");
+  // The fake time source ticks a second each time it is read.
+  EXPECT_EQ(render(renderer), "/1235000");
+}
+
+TEST_F(RequestTemplateTest, DrawsUniformKeysWithinTheirBounds) {
+  RequestTemplateRenderer renderer = createRenderer({{":path", "{rand:5..9}"}});
+  std::set<std::string> keys;
+  for (int i = 0; i < 1000; i++) {
+    keys.insert(render(renderer));
+  }
+  EXPECT_EQ(keys, std::set<std::string>({"5", "6", "7", "8", "9"}));
+}
+
+TEST_F(RequestTemplateTest, AcceptsExponentNotationAndFullRanges) {
+  RequestTemplateRenderer renderer =
+      createRenderer({{":path", "{rand:1e6..1e6}"}, {"x-key", "{rand:0..18446744073709551615}"}});
+  EXPECT_EQ(render(renderer), "1000000");
+}
+
+TEST_F(RequestTemplateTest, WalksSequencesAndWrapsAround) {
+  RequestTemplateRenderer renderer = createRenderer({{":path", "{seq:10..13}"}});
+  // Sequences start at a random position.
+  const uint64_t first = std::stoull(render(renderer));
+  ASSERT_GE(first, 10U);
+  ASSERT_LE(first, 13U);
+  for (uint64_t i = 1; i < 10; i++) {
+    EXPECT_EQ(render(renderer), std::to_string(10 + (first - 10 + i) % 4));
+  }
+}
+
+TEST_F(RequestTemplateTest, DrawsZipfianKeys) {
+  RequestTemplateRenderer renderer = createRenderer({{":path", "{zipf:1..1000:1}"}});
+  constexpr int kSamples = 100000;
+  std::vector<int> counts(1001, 0);
+  for (int i = 0; i < kSamples; i++) {
+    const uint64_t key = std::stoull(render(renderer));
+    ASSERT_GE(key, 1U);
+    ASSERT_LE(key, 1000U);
+    counts[key]++;
+  }
+  // With an exponent of 1, key k is drawn with probability 1 / (k * H(1000)), where H(1000) is
+  // about 7.485.
+  EXPECT_NEAR(counts[1] / static_cast<double>(kSamples), 0.1336, 0.005);
+  EXPECT_NEAR(counts[2] / static_cast<double>(kSamples), 0.0668, 0.004);
+  EXPECT_NEAR(counts[10] / static_cast<double>(kSamples), 0.0134, 0.002);
+}
+
+TEST_F(RequestTemplateTest, OffsetsZipfianKeysByTheLowerBound) {
+  RequestTemplateRenderer renderer = createRenderer({{":path", "{zipf:100..101}"}});
+  std::set<std::string> keys;
+  for (int i = 0; i < 1000; i++) {
+    keys.insert(render(renderer));
+  }
+  EXPECT_EQ(keys, std::set<std::string>({"100", "101"}));
+}
+
+TEST(ZipfianDistributionTest, AlwaysDrawsTheOnlyRank) {
+  SeededRandomGeneratorImpl random(1);
+  ZipfianDistribution distribution(1, 0.99);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(distribution.sample(random), 1U);
+  }
+}
+
+class TemplatedRequestSourceTest : public Test {
+public:
+  TemplatedRequestSourceTest() : api_(Envoy::Api::createApiForTest(stats_store_)) {}
+
+  RequestSourcePtr createSource(const std::vector<std::pair<std::string, std::string>>& fields,
+                                const uint64_t num_requests, const uint64_t seed = 0,
+                                const uint32_t worker_id = 0) {
+    nighthawk::request_source::TemplatedRequestSourceConfig config;
+    for (const auto& field : fields) {
+      auto* config_field = config.add_fields();
+      config_field->set_name(field.first);
+      config_field->set_value(field.second);
+    }
+    config.set_num_requests(num_requests);
+    config.set_seed(seed);
+    Envoy::ProtobufWkt::Any config_any;
+    config_any.PackFrom(config);
+    Envoy::Http::RequestHeaderMapPtr header = Envoy::Http::RequestHeaderMapImpl::create();
+    header->setPath("/default");
+    header->setHost("default-host");
+    return factory_.createRequestSourcePluginForWorker(config_any, *api_, std::move(header),
+                                                       worker_id);
+  }
+
+  Envoy::Stats::MockIsolatedStatsStore stats_store_;
+  Envoy::Api::ApiPtr api_;
+  TemplatedRequestSourceFactory factory_;
+};
+
+TEST_F(TemplatedRequestSourceTest, IsRegistered) {
+  auto& config_factory =
+      Envoy::Config::Utility::getAndCheckFactoryByName<RequestSourcePluginConfigFactory>(
+          "nighthawk.templated-request-source-plugin");
+  EXPECT_EQ(config_factory.name(), "nighthawk.templated-request-source-plugin");
+  EXPECT_NE(dynamic_cast<nighthawk::request_source::TemplatedRequestSourceConfig*>(
+                config_factory.createEmptyConfigProto().get()),
+            nullptr);
+}
+
+TEST_F(TemplatedRequestSourceTest, ThrowsOnMalformedTemplates) {
+  EXPECT_THROW_WITH_REGEX(createSource({{":path", "/{rand:1..}"}}, 0), NighthawkException,
+                          "Invalid template for :path");
+}
+
+TEST_F(TemplatedRequestSourceTest, RendersFieldsOverTheDefaultHeader) {
+  RequestSourcePtr source = createSource({{":path", "/item/{counter}"}, {"x-key", "k"}}, 2);
+  RequestGenerator generator = source->get();
+  for (int i = 0; i < 2; i++) {
+    RequestPtr request = generator();
+    ASSERT_NE(request, nullptr);
+    EXPECT_EQ(request->header()->getPathValue(), absl::StrCat("/item/", i));
+    EXPECT_EQ(request->header()->getHostValue(), "default-host");
+    EXPECT_EQ(headerValue(*request->header(), "x-key"), "k");
+  }
+  EXPECT_EQ(generator(), nullptr);
+}
+
+TEST_F(TemplatedRequestSourceTest, GeneratesIndefinitelyWithoutANumberOfRequests) {
+  RequestSourcePtr source = createSource({{":path", "/{counter}"}}, 0);
+  RequestGenerator generator = source->get();
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_NE(generator(), nullptr);
+  }
+}
+
+TEST_F(TemplatedRequestSourceTest, SeedsEachWorkerDifferentlyButReproducibly) {
+  const auto render_paths = [](RequestSource& source) {
+    RequestGenerator generator = source.get();
+    std::vector<std::string> paths;
+    for (int i = 0; i < 10; i++) {
+      paths.emplace_back(generator()->header()->getPathValue());
+    }
+    return paths;
+  };
+  RequestSourcePtr second = createSource({{":path", "/{rand:1..1e9}"}}, 0, 7, 1);
+  RequestSourcePtr first = createSource({{":path", "/{rand:1..1e9}"}}, 0, 7, 0);
+  const std::vector<std::string> first_paths = render_paths(*first);
+  const std::vector<std::string> second_paths = render_paths(*second);
+  EXPECT_NE(first_paths, second_paths);
+  // The sequence of a worker does not depend on the request sources created before.
+  RequestSourcePtr replayed_first = createSource({{":path", "/{rand:1..1e9}"}}, 0, 7, 0);
+  RequestSourcePtr replayed_second = createSource({{":path", "/{rand:1..1e9}"}}, 0, 7, 1);
+  EXPECT_EQ(render_paths(*replayed_first), first_paths);
+  EXPECT_EQ(render_paths(*replayed_second), second_paths);
+  // Without a worker, request sources are seeded as the first worker's.
+  nighthawk::request_source::TemplatedRequestSourceConfig config;
+  auto* field = config.add_fields();
+  field->set_name(":path");
+  field->set_value("/{rand:1..1e9}");
+  config.set_seed(7);
+  Envoy::ProtobufWkt::Any config_any;
+  config_any.PackFrom(config);
+  RequestSourcePtr without_worker = factory_.createRequestSourcePlugin(
+      config_any, *api_, Envoy::Http::RequestHeaderMapImpl::create());
+  EXPECT_EQ(render_paths(*without_worker), first_paths);
+}
+
+} // namespace
+} // namespace Nighthawk
@@ -1,12 +1,15 @@
 #include "envoy/api/v2/core/base.pb.h"
 #include "envoy/config/core/v3/base.pb.h"
 
+#include "external/envoy/test/mocks/event/mocks.h"
+#include "external/envoy/test/mocks/grpc/mocks.h"
 #include "external/envoy/test/test_common/utility.h"
 
 #include "api/request_source/service.pb.h"
 
 #include "source/common/request_impl.h"
 #include "source/common/request_stream_grpc_client_impl.h"
+#include "source/common/statistic_impl.h"
 
 #include "gtest/gtest.h"
 
@@ -16,9 +19,11 @@ namespace Nighthawk {
 namespace {
 
 using ::nighthawk::request_source::RequestSpecifier;
+using ::nighthawk::request_source::RequestStreamRequest;
+using ::nighthawk::request_source::RequestStreamResponse;
 
-// The grpc client itself is tested via the python based integration tests.
-// It is convenient to test message translation here.
+// Stream setup against a real service is tested via the python based integration tests.
+// It is convenient to test message translation and flow control here.
 class ProtoRequestHelperTest : public Test {
 public:
   void translateExpectingEqual() {
@@ -34,7 +39,7 @@ public:
 
 protected:
   nighthawk::request_source::RequestStreamResponse response_;
-  Envoy::Http::TestRequestHeaderMapImpl base_header_;
+  HeaderMapPtr base_header_{std::make_shared<Envoy::Http::TestRequestHeaderMapImpl>()};
   Envoy::Http::TestRequestHeaderMapImpl expected_header_;
 };
 
@@ -104,5 +109,131 @@ TEST_F(ProtoRequestHelperTest, AmbiguousHost) {
   translateExpectingEqual();
 }
 
+TEST_F(ProtoRequestHelperTest, SharesTheBaseHeaderWhenNothingIsOverridden) {
+  response_.mutable_expectations()->mutable_response_code()->set_value(201);
+  RequestPtr request = ProtoRequestHelper::messageToRequest(base_header_, response_);
+  EXPECT_EQ(request->header(), base_header_);
+  EXPECT_TRUE(request->expectations().has_value());
+  response_.mutable_request_specifier()->mutable_v3_headers();
+  EXPECT_EQ(ProtoRequestHelper::messageToRequest(base_header_, response_)->header(), base_header_);
+  response_.mutable_request_specifier()->mutable_path()->set_value("/");
+  EXPECT_NE(ProtoRequestHelper::messageToRequest(base_header_, response_)->header(), base_header_);
+}
+
+TEST_F(ProtoRequestHelperTest, NoExpectations) {
+  EXPECT_FALSE(ProtoRequestHelper::messageToRequest(base_header_, response_)
+                   ->expectations()
+                   .has_value());
+}
+
+TEST_F(ProtoRequestHelperTest, Expectations) {
+  response_.mutable_expectations()->mutable_response_code()->set_value(201);
+  RequestPtr request = ProtoRequestHelper::messageToRequest(base_header_, response_);
+  ASSERT_TRUE(request->expectations().has_value());
+  ASSERT_TRUE(request->expectations()->response_code.has_value());
+  EXPECT_EQ(request->expectations()->response_code.value(), 201);
+  EXPECT_FALSE(request->expectations()->content_length.has_value());
+  response_.mutable_expectations()->mutable_content_length()->set_value(1024);
+  request = ProtoRequestHelper::messageToRequest(base_header_, response_);
+  ASSERT_TRUE(request->expectations().has_value());
+  ASSERT_TRUE(request->expectations()->content_length.has_value());
+  EXPECT_EQ(request->expectations()->content_length.value(), 1024);
+}
+
+class RequestStreamGrpcClientTest : public Test {
+public:
+  RequestStreamGrpcClientTest() {
+    auto async_client = std::make_unique<NiceMock<Envoy::Grpc::MockAsyncClient>>();
+    EXPECT_CALL(*async_client, startRaw(_, _, _, _)).WillOnce(Return(&stream_));
+    ON_CALL(stream_, sendMessageRaw_(_, _))
+        .WillByDefault(Invoke([this](Envoy::Buffer::InstancePtr& buffer, bool) {
+          RequestStreamRequest request;
+          EXPECT_TRUE(request.ParseFromString(buffer->toString()));
+          sent_requests_.push_back(request);
+        }));
+    client_ = std::make_unique<RequestStreamGrpcClientImpl>(
+        std::move(async_client), dispatcher_, base_header_, /*header_buffer_length=*/4,
+        queue_depth_statistic_, stall_statistic_);
+    client_->start();
+  }
+
+  static RequestStreamResponse response(const std::string& path) {
+    RequestStreamResponse response;
+    response.mutable_request_specifier()->mutable_path()->set_value(path);
+    return response;
+  }
+
+  void receive(const RequestStreamResponse& message) {
+    client_->onReceiveMessage(std::make_unique<RequestStreamResponse>(message));
+  }
+
+  std::string dequeuePath() {
+    RequestPtr request = client_->maybeDequeue();
+    return request == nullptr ? "" : std::string(request->header()->getPathValue());
+  }
+
+protected:
+  NiceMock<Envoy::Event::MockDispatcher> dispatcher_;
+  NiceMock<Envoy::Grpc::MockAsyncStream> stream_;
+  HeaderMapPtr base_header_{std::make_shared<Envoy::Http::TestRequestHeaderMapImpl>()};
+  HdrStatistic queue_depth_statistic_;
+  HdrStatistic stall_statistic_;
+  std::vector<RequestStreamRequest> sent_requests_;
+  std::unique_ptr<RequestStreamGrpcClientImpl> client_;
+};
+
+TEST_F(RequestStreamGrpcClientTest, RequestsTheHighWatermarkOnStart) {
+  ASSERT_EQ(sent_requests_.size(), 1);
+  EXPECT_EQ(sent_requests_[0].quantity(), 4);
+  EXPECT_EQ(sent_requests_[0].max_batch_size(), RequestStreamGrpcClientImpl::kMaxBatchSize);
+}
+
+TEST_F(RequestStreamGrpcClientTest, RefillsBelowTheLowWatermark) {
+  for (int i = 0; i < 4; i++) {
+    receive(response(absl::StrCat("/", i)));
+  }
+  EXPECT_EQ(dequeuePath(), "/0");
+  EXPECT_EQ(dequeuePath(), "/1");
+  // Two requests are still queued, which is at the low watermark.
+  EXPECT_EQ(sent_requests_.size(), 1);
+  EXPECT_EQ(dequeuePath(), "/2");
+  ASSERT_EQ(sent_requests_.size(), 2);
+  EXPECT_EQ(sent_requests_[1].quantity(), 3);
+  // What was asked for counts towards the watermark until it is received.
+  EXPECT_EQ(dequeuePath(), "/3");
+  EXPECT_EQ(sent_requests_.size(), 2);
+}
+
+TEST_F(RequestStreamGrpcClientTest, FlattensBatches) {
+  RequestStreamResponse batch;
+  for (int i = 0; i < 3; i++) {
+    *batch.add_requests() = response(absl::StrCat("/", i));
+  }
+  receive(batch);
+  receive(response("/3"));
+  EXPECT_EQ(dequeuePath(), "/0");
+  EXPECT_EQ(dequeuePath(), "/1");
+  EXPECT_EQ(dequeuePath(), "/2");
+  EXPECT_EQ(dequeuePath(), "/3");
+  EXPECT_EQ(client_->maybeDequeue(), nullptr);
+  // The batch counted as three of the four requests that were asked for.
+  ASSERT_EQ(sent_requests_.size(), 2);
+  EXPECT_EQ(sent_requests_[1].quantity(), 3);
+}
+
+TEST_F(RequestStreamGrpcClientTest, TracksQueueDepthAndStalls) {
+  EXPECT_EQ(client_->maybeDequeue(), nullptr);
+  EXPECT_EQ(client_->maybeDequeue(), nullptr);
+  receive(response("/0"));
+  receive(response("/1"));
+  EXPECT_EQ(dequeuePath(), "/0");
+  EXPECT_EQ(queue_depth_statistic_.count(), 3);
+  EXPECT_EQ(queue_depth_statistic_.max(), 2);
+  // The two empty dequeues were a single stall, which ended when a request could be dequeued.
+  EXPECT_EQ(stall_statistic_.count(), 1);
+  EXPECT_EQ(dequeuePath(), "/1");
+  EXPECT_EQ(stall_statistic_.count(), 1);
+}
+
 } // namespace
 } // namespace Nighthawk
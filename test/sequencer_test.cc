@@ -264,6 +264,27 @@ TEST_F(SequencerIntegrationTest, IdleStrategySleep) {
   testRegularFlow(SequencerIdleStrategy::SLEEP);
 }
 
+TEST_F(SequencerIntegrationTest, AccountsPacingDuration) {
+  // Each call to the target takes 1ms.
+  SequencerTarget callback = [this](const OperationCallback& f) {
+    callback_test_count_++;
+    time_system_.setMonotonicTime(time_system_.monotonicTime() + 1ms);
+    f(true, true);
+    return true;
+  };
+  SequencerImpl sequencer(platform_util_, *dispatcher_, time_system_, std::move(rate_limiter_),
+                          callback, std::make_unique<StreamingStatistic>(),
+                          std::make_unique<StreamingStatistic>(), SequencerIdleStrategy::POLL,
+                          std::move(termination_predicate_), scope_);
+  EXPECT_EQ(0ns, sequencer.pacingDuration());
+  sequencer.start();
+  sequencer.waitForCompletion();
+  EXPECT_EQ(test_number_of_intervals_, callback_test_count_);
+  EXPECT_EQ(sequencer.pacingDuration(), test_number_of_intervals_ * 1ms);
+  // Passes that did not initiate anything took no time, as simulated time did not move.
+  EXPECT_EQ(sequencer.idleDuration(), 0ns);
+}
+
 // Test an always saturated sequencer target. A concrete example would be a http benchmark client
 // not being able to start any requests, for example due to misconfiguration or system conditions.
 TEST_F(SequencerIntegrationTest, AlwaysSaturatedTargetTest) {
@@ -222,6 +222,79 @@ TEST_P(ServiceTest, UpdatesNotSupported) {
   EXPECT_FALSE(status.ok());
 }
 
+// With keep-warm, an update request runs another execution on the process of the start request.
+TEST_P(ServiceTest, KeepWarmUpdateReusesProcess) {
+  server_->Shutdown();
+  service_ = std::make_unique<ServiceImpl>(/*keep_warm=*/true);
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(fmt::format("{}:0", loopback_address_),
+                           grpc::InsecureServerCredentials(), &grpc_server_port_);
+  builder.RegisterService(service_.get());
+  server_ = builder.BuildAndStart();
+  setupGrpcClient();
+
+  auto r = stub_->ExecutionStream(&context_);
+  EXPECT_TRUE(r->Write(request_, {}));
+  EXPECT_TRUE(r->Read(&response_));
+  EXPECT_TRUE(response_.has_output());
+  nighthawk::client::ExecutionRequest update_request;
+  *update_request.mutable_update_request()->mutable_options() =
+      request_.start_request().options();
+  update_request.mutable_update_request()->mutable_options()->mutable_duration()->set_seconds(1);
+  EXPECT_TRUE(r->Write(update_request, {}));
+  EXPECT_TRUE(r->Read(&response_));
+  ASSERT_TRUE(response_.has_output());
+  EXPECT_GE(response_.output().results(0).counters().size(), 8);
+  // Changing the uri is not compatible with the warm process.
+  update_request.mutable_update_request()->mutable_options()->mutable_uri()->set_value(
+      "http://127.0.0.1:10002/");
+  EXPECT_TRUE(r->Write(update_request, {}));
+  EXPECT_TRUE(r->Read(&response_));
+  ASSERT_TRUE(response_.has_error_detail());
+  EXPECT_EQ(response_.error_detail().code(), grpc::StatusCode::FAILED_PRECONDITION);
+  EXPECT_TRUE(r->WritesDone());
+  EXPECT_TRUE(r->Finish().ok());
+}
+
+// With a report interval, intermediate responses precede the final response.
+TEST_P(ServiceTest, StreamsIntermediateResponses) {
+  auto options = request_.mutable_start_request()->mutable_options();
+  options->mutable_execution_id()->set_value("foo");
+  options->mutable_report_interval()->set_nanos(500000000);
+  // Keep going despite the connection failures, so that there is something to report.
+  options->mutable_no_default_failure_predicates()->set_value(true);
+  auto r = stub_->ExecutionStream(&context_);
+  EXPECT_TRUE(r->Write(request_, {}));
+  EXPECT_TRUE(r->WritesDone());
+  uint32_t intermediate_responses = 0;
+  while (r->Read(&response_) && response_.intermediate()) {
+    EXPECT_EQ(response_.execution_id(), "foo");
+    ASSERT_EQ(response_.output().results_size(), 1);
+    EXPECT_EQ(response_.output().results(0).name(), "global");
+    intermediate_responses++;
+  }
+  EXPECT_GE(intermediate_responses, 1);
+  EXPECT_FALSE(response_.intermediate());
+  EXPECT_EQ(response_.execution_id(), "foo");
+  EXPECT_TRUE(response_.has_output());
+  EXPECT_TRUE(r->Finish().ok());
+}
+
+// Phase switches apply to a running execution only.
+TEST_P(ServiceTest, PhaseSwitchWithoutRunningExecution) {
+  request_ = nighthawk::client::ExecutionRequest();
+  nighthawk::client::LoadPhase* phase = request_.mutable_update_request()->mutable_phase();
+  phase->mutable_duration()->set_seconds(1);
+  phase->mutable_constant()->mutable_requests_per_second()->set_value(10);
+  auto r = stub_->ExecutionStream(&context_);
+  r->Write(request_, {});
+  r->WritesDone();
+  EXPECT_FALSE(r->Read(&response_));
+  auto status = r->Finish();
+  EXPECT_THAT(status.error_message(), HasSubstr("A phase switch needs a running execution"));
+  EXPECT_FALSE(status.ok());
+}
+
 // We didn't implement cancellations yet, ensure we indicate so.
 TEST_P(ServiceTest, CancelNotSupported) {
   request_ = nighthawk::client::ExecutionRequest();
@@ -293,6 +293,26 @@ TEST(ResponseVectorHandling, MergeThreeYieldsThree) {
   EXPECT_EQ(response.value().output().results().size(), 3);
 }
 
+TEST(ResponseVectorHandling, IntermediateResponsesAreCoveredByFinalResponses) {
+  ExecutionResponse intermediate;
+  intermediate.set_intermediate(true);
+  intermediate.mutable_output()->add_results();
+  ExecutionResponse result;
+  result.mutable_output()->add_results();
+  std::vector<ExecutionResponse> responses{intermediate, intermediate, result, intermediate};
+  absl::StatusOr<ExecutionResponse> response =
+      mergeExecutionResponses(/*execution_id=*/"", responses);
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ(response.value().output().results().size(), 1);
+  EXPECT_FALSE(response.value().intermediate());
+  // Without any final response, the intermediate ones get merged.
+  responses = {intermediate, intermediate};
+  response = mergeExecutionResponses(/*execution_id=*/"", responses);
+  ASSERT_TRUE(response.ok());
+  EXPECT_EQ(response.value().output().results().size(), 2);
+  EXPECT_TRUE(response.value().intermediate());
+}
+
 TEST(MergeOutputs, MergeDivergingOptionsInResultsFails) {
   std::vector<ExecutionResponse> responses;
   nighthawk::client::Output output_1;
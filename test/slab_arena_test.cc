@@ -0,0 +1,114 @@
+#include <vector>
+
+#include "source/common/slab_arena.h"
+
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace Nighthawk {
+namespace {
+
+class ArenaObject {
+public:
+  static void* operator new(size_t size) { return SlabArena::allocateFromHeap(size); }
+  static void* operator new(size_t size, SlabArena& arena) { return arena.allocate(size); }
+  static void operator delete(void* block) { SlabArena::release(block); }
+  static void operator delete(void* block, SlabArena&) { SlabArena::release(block); }
+
+  ArenaObject(const uint64_t value) : value_(value) {}
+  uint64_t value() const { return value_; }
+
+private:
+  uint64_t value_;
+  char padding_[40]{};
+};
+
+TEST(SlabArenaTest, ReusesReleasedBlocks) {
+  SlabArenaPtr arena = SlabArena::create(sizeof(ArenaObject), 4);
+  EXPECT_EQ(arena->blockSize() % alignof(std::max_align_t), 0);
+  auto* a = new (*arena) ArenaObject(1);
+  auto* b = new (*arena) ArenaObject(2);
+  EXPECT_EQ(arena->blocksInUse(), 2);
+  EXPECT_EQ(a->value(), 1);
+  EXPECT_EQ(b->value(), 2);
+  delete a;
+  auto* c = new (*arena) ArenaObject(3);
+  // The block released last is handed out first.
+  EXPECT_EQ(static_cast<void*>(c), static_cast<void*>(a));
+  delete b;
+  delete c;
+  EXPECT_EQ(arena->blocksInUse(), 0);
+  EXPECT_EQ(arena->slabs(), 1);
+  EXPECT_EQ(arena->heapAllocations(), 1);
+}
+
+TEST(SlabArenaTest, SteadyStateDoesNotAllocate) {
+  SlabArenaPtr arena = SlabArena::create(sizeof(ArenaObject), 8);
+  std::vector<ArenaObject*> objects;
+  for (uint64_t round = 0; round < 100; round++) {
+    for (uint64_t i = 0; i < 20; i++) {
+      objects.push_back(new (*arena) ArenaObject(i));
+    }
+    for (ArenaObject* object : objects) {
+      delete object;
+    }
+    objects.clear();
+  }
+  // 20 objects in flight need three slabs of eight blocks, which are allocated once.
+  EXPECT_EQ(arena->slabs(), 3);
+  EXPECT_EQ(arena->heapAllocations(), 3);
+}
+
+TEST(SlabArenaTest, StartEpochTrimsIdleArena) {
+  SlabArenaPtr arena = SlabArena::create(sizeof(ArenaObject), 2);
+  std::vector<ArenaObject*> objects;
+  for (uint64_t i = 0; i < 5; i++) {
+    objects.push_back(new (*arena) ArenaObject(i));
+  }
+  EXPECT_EQ(arena->slabs(), 3);
+  // Blocks are in use, so the arena keeps its slabs.
+  arena->startEpoch();
+  EXPECT_EQ(arena->epoch(), 1);
+  EXPECT_EQ(arena->slabs(), 3);
+  for (ArenaObject* object : objects) {
+    delete object;
+  }
+  arena->startEpoch();
+  EXPECT_EQ(arena->epoch(), 2);
+  EXPECT_EQ(arena->slabs(), 1);
+  // The remaining slab is fully usable.
+  auto* a = new (*arena) ArenaObject(1);
+  auto* b = new (*arena) ArenaObject(2);
+  EXPECT_EQ(arena->slabs(), 1);
+  delete a;
+  delete b;
+}
+
+TEST(SlabArenaTest, OversizedAllocationsFallBackToTheHeap) {
+  SlabArenaPtr arena = SlabArena::create(8);
+  auto* object = new (*arena) ArenaObject(7);
+  EXPECT_EQ(arena->blocksInUse(), 0);
+  EXPECT_EQ(arena->slabs(), 0);
+  EXPECT_EQ(arena->heapAllocations(), 1);
+  EXPECT_EQ(object->value(), 7);
+  delete object;
+}
+
+TEST(SlabArenaTest, HeapAllocatedObjectsCanBeDeleted) {
+  auto* object = new ArenaObject(5);
+  EXPECT_EQ(object->value(), 5);
+  delete object;
+}
+
+TEST(SlabArenaTest, BlocksMayOutliveTheArenaOwner) {
+  SlabArenaPtr arena = SlabArena::create(sizeof(ArenaObject));
+  auto* object = new (*arena) ArenaObject(9);
+  arena.reset();
+  // The arena is destroyed once the object releases the last block in use.
+  EXPECT_EQ(object->value(), 9);
+  delete object;
+}
+
+} // namespace
+} // namespace Nighthawk
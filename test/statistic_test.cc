@@ -402,6 +402,37 @@ TEST(StatisticTest, HdrStatisticOutOfRange) {
   EXPECT_EQ(0, a.count());
 }
 
+TEST(StatisticTest, IntervalTrackingStatistic) {
+  IntervalTrackingStatistic a(std::make_unique<HdrStatistic>());
+  a.setId("foo");
+  a.addValue(1);
+  a.addValue(2);
+  StatisticPtr interval = a.takeInterval();
+  ASSERT_NE(nullptr, interval);
+  EXPECT_EQ(2, interval->count());
+  EXPECT_EQ("foo", interval->id());
+  a.addValue(3);
+  interval = a.takeInterval();
+  EXPECT_EQ(1, interval->count());
+  EXPECT_EQ(3, interval->min());
+  EXPECT_EQ(0, a.takeInterval()->count());
+  // Taking intervals does not affect what the statistic itself reports.
+  EXPECT_EQ(3, a.count());
+  EXPECT_EQ(1, a.min());
+  EXPECT_EQ(3, a.max());
+  // Combining works with both wrapped and unwrapped statistics, and keeps tracking intervals.
+  HdrStatistic b;
+  b.addValue(4);
+  StatisticPtr combined = a.combine(b);
+  EXPECT_EQ(4, combined->count());
+  combined = combined->combine(a);
+  EXPECT_EQ(7, combined->count());
+  combined->addValue(5);
+  EXPECT_EQ(1, combined->takeInterval()->count());
+  EXPECT_NE(nullptr, a.createNewInstanceOfSameType()->takeInterval());
+  EXPECT_EQ(nullptr, b.takeInterval());
+}
+
 TEST(StatisticTest, NullStatistic) {
   NullStatistic stat;
   EXPECT_EQ(0, stat.count());
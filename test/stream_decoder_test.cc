@@ -1,4 +1,6 @@
 #include <chrono>
+#include <list>
+#include <vector>
 
 #include "external/envoy/source/common/common/random_generator.h"
 #include "external/envoy/source/common/event/dispatcher_impl.h"
@@ -29,7 +31,7 @@ public:
         request_headers_(std::make_shared<Envoy::Http::TestRequestHeaderMapImpl>(
             std::initializer_list<std::pair<std::string, std::string>>(
                 {{":method", "GET"}, {":path", "/foo"}}))),
-        request_body_(std::string("")), tracer_(std::make_unique<Envoy::Tracing::NullTracer>()),
+        tracer_(std::make_unique<Envoy::Tracing::NullTracer>()),
         test_header_(std::make_unique<Envoy::Http::TestResponseHeaderMapImpl>(
             std::initializer_list<std::pair<std::string, std::string>>({{":status", "200"}}))),
         test_trailer_(std::make_unique<Envoy::Http::TestResponseTrailerMapImpl>(
@@ -43,6 +45,9 @@ public:
     stream_decoder_export_latency_callbacks_++;
   }
   void handleResponseData(const Envoy::Buffer::Instance&) override { called_data_++; }
+  void onExpectationMismatch(const ExpectationMismatch mismatch) override {
+    expectation_mismatches_.push_back(mismatch);
+  }
 
   Envoy::Event::TestRealTimeSystem time_system_;
   Envoy::Stats::IsolatedStoreImpl store_;
@@ -54,11 +59,12 @@ public:
   StreamingStatistic response_body_size_statistic_;
   StreamingStatistic origin_latency_statistic_;
   HeaderMapPtr request_headers_;
-  std::string request_body_;
+  BodyPtr request_body_;
   uint64_t stream_decoder_completion_callbacks_{0};
   uint64_t pool_failures_{0};
   uint64_t stream_decoder_export_latency_callbacks_{0};
   uint64_t called_data_{0};
+  std::vector<ExpectationMismatch> expectation_mismatches_;
   Envoy::Random::RandomGeneratorImpl random_generator_;
   Envoy::Tracing::TracerSharedPtr tracer_;
   Envoy::Http::ResponseHeaderMapPtr test_header_;
@@ -97,6 +103,45 @@ TEST_F(StreamDecoderTest, HeaderWithBodyTest) {
   EXPECT_EQ(2, called_data_);
 }
 
+TEST_F(StreamDecoderTest, ResponsesMeetingTheirExpectationsAreNotReported) {
+  auto decoder = new StreamDecoder(
+      *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_, latency_statistic_,
+      response_header_size_statistic_, response_body_size_statistic_, origin_latency_statistic_,
+      request_headers_, request_body_, false, 0, random_generator_, tracer_, "",
+      /*request_class_latency_statistic=*/nullptr, ResponseExpectations{200, 2});
+  decoder->decodeHeaders(std::move(test_header_), false);
+  Envoy::Buffer::OwnedImpl buf(std::string(1, 'a'));
+  decoder->decodeData(buf, false);
+  decoder->decodeData(buf, true);
+  EXPECT_EQ(1, stream_decoder_completion_callbacks_);
+  EXPECT_THAT(expectation_mismatches_, IsEmpty());
+}
+
+TEST_F(StreamDecoderTest, ResponsesMissingTheirExpectationsAreReported) {
+  auto decoder = new StreamDecoder(
+      *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_, latency_statistic_,
+      response_header_size_statistic_, response_body_size_statistic_, origin_latency_statistic_,
+      request_headers_, request_body_, false, 0, random_generator_, tracer_, "",
+      /*request_class_latency_statistic=*/nullptr, ResponseExpectations{404, 10});
+  decoder->decodeHeaders(std::move(test_header_), false);
+  Envoy::Buffer::OwnedImpl buf(std::string(1, 'a'));
+  decoder->decodeData(buf, true);
+  EXPECT_THAT(expectation_mismatches_,
+              ElementsAre(ExpectationMismatch::ResponseCode, ExpectationMismatch::ContentLength));
+}
+
+TEST_F(StreamDecoderTest, OnlySetExpectationsAreVerified) {
+  ResponseExpectations expectations;
+  expectations.content_length = 0;
+  auto decoder = new StreamDecoder(
+      *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_, latency_statistic_,
+      response_header_size_statistic_, response_body_size_statistic_, origin_latency_statistic_,
+      request_headers_, request_body_, false, 0, random_generator_, tracer_, "",
+      /*request_class_latency_statistic=*/nullptr, expectations);
+  decoder->decodeHeaders(std::move(test_header_), true);
+  EXPECT_THAT(expectation_mismatches_, IsEmpty());
+}
+
 TEST_F(StreamDecoderTest, TrailerTest) {
   bool is_complete = false;
   auto decoder = new StreamDecoder(
@@ -176,7 +221,7 @@ TEST_F(StreamDecoderTest, EmptyRequestBodyWithNonZeroRequestBodySize) {
   auto decoder = new StreamDecoder(
       *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_, latency_statistic_,
       response_header_size_statistic_, response_body_size_statistic_, origin_latency_statistic_,
-      request_headers_, "", false, 4, random_generator_, tracer_, "");
+      request_headers_, nullptr, false, 4, random_generator_, tracer_, "");
   Envoy::Http::MockRequestEncoder stream_encoder;
   EXPECT_CALL(stream_encoder, getStream());
   Envoy::Upstream::HostDescriptionConstSharedPtr ptr;
@@ -200,7 +245,8 @@ TEST_F(StreamDecoderTest, NonEmptyRequestBodyIgnoresProvidedRequestBodySize) {
   auto decoder = new StreamDecoder(
       *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_, latency_statistic_,
       response_header_size_statistic_, response_body_size_statistic_, origin_latency_statistic_,
-      request_headers_, json_body, false, 0, random_generator_, tracer_, "");
+      request_headers_, std::make_shared<const std::string>(json_body), false, 0, random_generator_,
+      tracer_, "");
   Envoy::Http::MockRequestEncoder stream_encoder;
   EXPECT_CALL(stream_encoder, getStream());
   Envoy::Upstream::HostDescriptionConstSharedPtr ptr;
@@ -245,6 +291,65 @@ TEST_F(StreamDecoderTest, PoolFailureTest) {
   EXPECT_EQ(1, pool_failures_);
 }
 
+TEST_F(StreamDecoderTest, ResetCancelsPendingRequestsAndStopsTrackingThem) {
+  class FakeCancellable : public Envoy::Http::ConnectionPool::Cancellable {
+  public:
+    void cancel(Envoy::ConnectionPool::CancelPolicy) override { cancelled = true; }
+    bool cancelled{false};
+  };
+  FakeCancellable pool_handle;
+  bool success = true;
+  InFlightStreamDecoders in_flight_decoders;
+  auto decoder = new StreamDecoder(
+      *dispatcher_, time_system_, *this, [&success](bool, bool ok) { success = ok; },
+      connect_statistic_, latency_statistic_, response_header_size_statistic_,
+      response_body_size_statistic_, origin_latency_statistic_, request_headers_, request_body_,
+      false, 0, random_generator_, tracer_, "");
+  decoder->track(in_flight_decoders);
+  decoder->setPoolHandle(&pool_handle);
+  EXPECT_EQ(in_flight_decoders.front(), decoder);
+  decoder->resetStream();
+  EXPECT_TRUE(pool_handle.cancelled);
+  EXPECT_FALSE(success);
+  EXPECT_EQ(1, stream_decoder_completion_callbacks_);
+  EXPECT_TRUE(in_flight_decoders.empty());
+  dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
+}
+
+TEST_F(StreamDecoderTest, CompletedRequestsAreNoLongerTracked) {
+  InFlightStreamDecoders in_flight_decoders;
+  auto decoder = new StreamDecoder(
+      *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_, latency_statistic_,
+      response_header_size_statistic_, response_body_size_statistic_, origin_latency_statistic_,
+      request_headers_, request_body_, false, 0, random_generator_, tracer_, "");
+  decoder->track(in_flight_decoders);
+  decoder->decodeHeaders(std::move(test_header_), true);
+  EXPECT_TRUE(in_flight_decoders.empty());
+  dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
+}
+
+TEST_F(StreamDecoderTest, DecodersUnlinkThemselvesInAnyOrder) {
+  InFlightStreamDecoders in_flight_decoders;
+  std::vector<StreamDecoder*> decoders;
+  for (int i = 0; i < 3; i++) {
+    decoders.push_back(new StreamDecoder(
+        *dispatcher_, time_system_, *this, [](bool, bool) {}, connect_statistic_,
+        latency_statistic_, response_header_size_statistic_, response_body_size_statistic_,
+        origin_latency_statistic_, request_headers_, request_body_, false, 0, random_generator_,
+        tracer_, ""));
+    decoders.back()->track(in_flight_decoders);
+  }
+  EXPECT_EQ(in_flight_decoders.front(), decoders[2]);
+  decoders[1]->resetStream();
+  EXPECT_EQ(in_flight_decoders.front(), decoders[2]);
+  decoders[2]->resetStream();
+  EXPECT_EQ(in_flight_decoders.front(), decoders[0]);
+  decoders[0]->resetStream();
+  EXPECT_TRUE(in_flight_decoders.empty());
+  EXPECT_EQ(3, stream_decoder_completion_callbacks_);
+  dispatcher_->run(Envoy::Event::Dispatcher::RunType::NonBlock);
+}
+
 TEST_F(StreamDecoderTest, StreamResetReasonToResponseFlag) {
   ASSERT_EQ(StreamDecoder::streamResetReasonToResponseFlag(
                 Envoy::Http::StreamResetReason::LocalConnectionFailure),
@@ -329,5 +434,22 @@ TEST_F(StreamDecoderTest, LatencyTrackingWithMultipleResponseHeadersFails) {
   EXPECT_EQ(origin_latency_statistic_.count(), 0);
 }
 
+// Test that decoders allocated from a slab arena return their block once deleted.
+TEST_F(StreamDecoderTest, ArenaAllocatedDecoderReleasesBlock) {
+  SlabArenaPtr arena = SlabArena::create(sizeof(StreamDecoder));
+  bool is_complete = false;
+  auto decoder = new (*arena) StreamDecoder(
+      *dispatcher_, time_system_, *this, [&is_complete](bool, bool) { is_complete = true; },
+      connect_statistic_, latency_statistic_, response_header_size_statistic_,
+      response_body_size_statistic_, origin_latency_statistic_, request_headers_, request_body_,
+      false, 0, random_generator_, tracer_, "");
+  EXPECT_EQ(arena->blocksInUse(), 1);
+  decoder->decodeHeaders(std::move(test_header_), true);
+  EXPECT_TRUE(is_complete);
+  dispatcher_->clearDeferredDeleteList();
+  EXPECT_EQ(arena->blocksInUse(), 0);
+  EXPECT_EQ(arena->heapAllocations(), 1);
+}
+
 } // namespace Client
 } // namespace Nighthawk
@@ -35,6 +35,20 @@ TEST_F(TerminationPredicateTest, DurationTerminationPredicateImplTest) {
   EXPECT_EQ(pred.evaluate(), TerminationPredicate::Status::TERMINATE);
 }
 
+TEST_F(TerminationPredicateTest, DeadlineTerminationPredicateImplTest) {
+  std::atomic<Envoy::MonotonicTime> deadline{Envoy::MonotonicTime::max()};
+  DeadlineTerminationPredicateImpl pred(time_system, deadline);
+  EXPECT_EQ(pred.evaluate(), TerminationPredicate::Status::PROCEED);
+  deadline.store(time_system.monotonicTime() + 100us);
+  time_system.advanceTimeWait(99us);
+  EXPECT_EQ(pred.evaluate(), TerminationPredicate::Status::PROCEED);
+  time_system.advanceTimeWait(1us);
+  EXPECT_EQ(pred.evaluate(), TerminationPredicate::Status::TERMINATE);
+  // Moving the deadline out again makes the predicate proceed.
+  deadline.store(Envoy::MonotonicTime::max());
+  EXPECT_EQ(pred.evaluate(), TerminationPredicate::Status::PROCEED);
+}
+
 TEST_F(TerminationPredicateTest, StatsCounterAbsoluteThresholdTerminationPredicateImpl) {
   auto& counter = stats_store_.counter("foo");
   const TerminationPredicate::Status termination_status = TerminationPredicate::Status::FAIL;
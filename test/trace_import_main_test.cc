@@ -0,0 +1,168 @@
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "nighthawk/common/exception.h"
+
+#include "source/client/trace_import_main.h"
+#include "source/request_source/request_trace.h"
+
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Nighthawk {
+namespace Client {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+using ::testing::Test;
+
+class TraceImportMainTest : public Test {
+public:
+  // Runs the importer on the input, and returns its exit code.
+  uint32_t import(const std::string& input_format, const std::string& input,
+                  const std::string& reorder_window = "100000") {
+    output_path_ = TestEnvironment::writeStringToFileForTest("imported.trace", "");
+    std::vector<const char*> argv = {"foo",
+                                     "--input-format",
+                                     input_format.c_str(),
+                                     "--output",
+                                     output_path_.c_str(),
+                                     "--reorder-window",
+                                     reorder_window.c_str()};
+    std::stringstream input_stream(input);
+    TraceImportMain main(argv.size(), argv.data(), input_stream);
+    return main.run();
+  }
+
+  MappedRequestTraceSharedPtr openTrace() {
+    absl::StatusOr<MappedRequestTraceSharedPtr> trace = MappedRequestTrace::open(output_path_);
+    EXPECT_TRUE(trace.ok()) << trace.status();
+    return trace.ok() ? trace.value() : nullptr;
+  }
+
+  std::stringstream stream_;
+  std::string output_path_;
+};
+
+TEST_F(TraceImportMainTest, BadArgs) {
+  std::vector<const char*> argv = {"foo", "--input-format", "har"};
+  EXPECT_THROW(TraceImportMain(argv.size(), argv.data(), stream_), MalformedArgvException);
+}
+
+TEST_F(TraceImportMainTest, BadInputFormat) {
+  std::vector<const char*> argv = {"foo", "--input-format", "nonsense", "--output", "x"};
+  EXPECT_THROW(TraceImportMain(argv.size(), argv.data(), stream_), MalformedArgvException);
+}
+
+TEST_F(TraceImportMainTest, BadReorderWindow) {
+  std::vector<const char*> argv = {"foo", "--input-format", "har", "--output", "x",
+                                   "--reorder-window", "0"};
+  EXPECT_THROW(TraceImportMain(argv.size(), argv.data(), stream_), MalformedArgvException);
+}
+
+TEST_F(TraceImportMainTest, ImportsEnvoyJsonAccessLog) {
+  // Entries are logged on completion, so the second request started before the first one.
+  const std::string input =
+      R"({"start_time":"2023-05-01T10:00:00.500Z","method":"GET","path":"/b?q=1",)"
+      R"("authority":"example.com","user_agent":"curl",)"
+      R"("request_headers":{"X-Id":"1","Host":"h"}})"
+      "\n"
+      R"({"start_time":"2023-05-01T10:00:00.000Z","method":"POST","path":"/a","authority":"-"})"
+      "\n\n"
+      "not json\n"
+      R"({"method":"GET","path":"/no-start-time"})"
+      "\n"
+      R"({"start_time":"2023-05-01T10:00:01.250Z","method":"GET","path":"/c"})"
+      "\n";
+  ASSERT_EQ(import("envoy-json", input), 0);
+  MappedRequestTraceSharedPtr trace = openTrace();
+  ASSERT_NE(trace, nullptr);
+  ASSERT_EQ(trace->records(), 3);
+  ASSERT_TRUE(trace->hasTimes());
+  RequestTraceRecord record;
+  ASSERT_TRUE(trace->read(0, record));
+  EXPECT_THAT(record.headers, ElementsAre(Pair(":method", "POST"), Pair(":path", "/a")));
+  EXPECT_EQ(record.time, std::chrono::milliseconds(0));
+  ASSERT_TRUE(trace->read(1, record));
+  EXPECT_THAT(record.headers,
+              ElementsAre(Pair(":method", "GET"), Pair(":path", "/b?q=1"),
+                          Pair(":authority", "example.com"), Pair("user-agent", "curl"),
+                          Pair("x-id", "1")));
+  EXPECT_FALSE(record.body.has_value());
+  EXPECT_EQ(record.time, std::chrono::milliseconds(500));
+  ASSERT_TRUE(trace->read(2, record));
+  EXPECT_EQ(record.time, std::chrono::milliseconds(1250));
+}
+
+TEST_F(TraceImportMainTest, ImportsHar) {
+  const std::string input = R"({"log": {"version": "1.2", "entries": [
+    {"startedDateTime": "2023-05-01T12:00:00.100+02:00", "time": 12.5,
+     "request": {"method": "POST", "url": "https://example.com:8443/submit?x=1",
+                 "headers": [{"name": "Content-Type", "value": "text/plain"},
+                             {"name": "Content-Length", "value": "4"},
+                             {"name": ":path", "value": "/submit?x=1"},
+                             {"name": "Connection", "value": "keep-alive"}],
+                 "postData": {"mimeType": "text/plain", "text": "data"}},
+     "response": {"status": 200, "headers": [{"name": "server", "value": "envoy"}]}},
+    {"startedDateTime": "2023-05-01T10:00:00.000Z",
+     "request": {"method": "GET", "url": "http://example.com/", "headers": []}},
+    {"startedDateTime": "not a time",
+     "request": {"method": "GET", "url": "http://example.com/skipped", "headers": []}}
+  ]}})";
+  ASSERT_EQ(import("har", input), 0);
+  MappedRequestTraceSharedPtr trace = openTrace();
+  ASSERT_NE(trace, nullptr);
+  ASSERT_EQ(trace->records(), 2);
+  RequestTraceRecord record;
+  ASSERT_TRUE(trace->read(0, record));
+  EXPECT_THAT(record.headers, ElementsAre(Pair(":method", "GET"), Pair(":path", "/"),
+                                          Pair(":authority", "example.com")));
+  EXPECT_FALSE(record.body.has_value());
+  EXPECT_EQ(record.time, std::chrono::milliseconds(0));
+  ASSERT_TRUE(trace->read(1, record));
+  EXPECT_THAT(record.headers,
+              ElementsAre(Pair(":method", "POST"), Pair(":path", "/submit?x=1"),
+                          Pair(":authority", "example.com:8443"),
+                          Pair("content-type", "text/plain")));
+  EXPECT_EQ(record.body, "data");
+  EXPECT_EQ(record.time, std::chrono::milliseconds(100));
+}
+
+TEST_F(TraceImportMainTest, MovesUpEntriesOutsideOfTheReorderWindow) {
+  const std::string input =
+      R"({"start_time":"2023-05-01T10:00:02.000Z","method":"GET","path":"/2"})"
+      "\n"
+      R"({"start_time":"2023-05-01T10:00:03.000Z","method":"GET","path":"/3"})"
+      "\n"
+      R"({"start_time":"2023-05-01T10:00:01.000Z","method":"GET","path":"/1"})"
+      "\n";
+  ASSERT_EQ(import("envoy-json", input, "1"), 0);
+  MappedRequestTraceSharedPtr trace = openTrace();
+  ASSERT_NE(trace, nullptr);
+  ASSERT_EQ(trace->records(), 3);
+  std::vector<std::chrono::nanoseconds> times;
+  for (uint64_t i = 0; i < trace->records(); i++) {
+    times.push_back(trace->time(i));
+  }
+  // The last entry started before the first, which had already been written when it arrived.
+  EXPECT_THAT(times, ElementsAre(std::chrono::seconds(0), std::chrono::seconds(0),
+                                 std::chrono::seconds(1)));
+}
+
+TEST_F(TraceImportMainTest, MalformedHar) {
+  EXPECT_NE(import("har", R"({"log": {"entries": [)"), 0);
+}
+
+TEST_F(TraceImportMainTest, NoRequests) {
+  EXPECT_NE(import("envoy-json", "not json\n"), 0);
+  EXPECT_NE(import("har", R"({"log": {"entries": []}})"), 0);
+}
+
+} // namespace
+} // namespace Client
+} // namespace Nighthawk
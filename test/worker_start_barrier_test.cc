@@ -0,0 +1,80 @@
+#include <thread>
+#include <vector>
+
+#include "external/envoy/test/test_common/simulated_time_system.h"
+
+#include "source/client/worker_start_barrier.h"
+
+#include "gtest/gtest.h"
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace Nighthawk {
+namespace Client {
+
+class WorkerStartBarrierTest : public Test {
+public:
+  Envoy::Event::SimulatedTimeSystem time_system_;
+};
+
+TEST_F(WorkerStartBarrierTest, ReleasesWorkersOnceAllAreReady) {
+  constexpr uint32_t kWorkers = 4;
+  WorkerStartBarrier barrier(time_system_, kWorkers, 1ms, absl::nullopt);
+  const Envoy::MonotonicTime begin = time_system_.monotonicTime();
+  std::vector<Envoy::MonotonicTime> start_times(kWorkers);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < kWorkers - 1; i++) {
+    threads.emplace_back(
+        [&barrier, &start_times, i]() { start_times[i] = barrier.arriveAndWait(i); });
+  }
+  // Let the last worker arrive a while after the others did.
+  while (!barrier.firstArrivalTime().has_value()) {
+    std::this_thread::yield();
+  }
+  EXPECT_FALSE(barrier.startTime().has_value());
+  time_system_.advanceTimeWait(100ms);
+  start_times[kWorkers - 1] = barrier.arriveAndWait(kWorkers - 1);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const Envoy::MonotonicTime last_arrival = begin + 100ms;
+  EXPECT_EQ(barrier.lastArrivalTime(), last_arrival);
+  EXPECT_EQ(barrier.startTime(), last_arrival + WorkerStartBarrier::kStartMargin);
+  for (uint32_t i = 0; i < kWorkers; i++) {
+    EXPECT_EQ(start_times[i], last_arrival + WorkerStartBarrier::kStartMargin + i * 1ms);
+  }
+}
+
+TEST_F(WorkerStartBarrierTest, ScheduledStartDoesNotWait) {
+  const Envoy::MonotonicTime scheduled_start = time_system_.monotonicTime() + 5s;
+  WorkerStartBarrier barrier(time_system_, 2, 10ms, scheduled_start);
+  // Only one of the two workers arrives, and must not be blocked.
+  EXPECT_EQ(barrier.arriveAndWait(1), scheduled_start + 10ms);
+  EXPECT_TRUE(barrier.firstArrivalTime().has_value());
+  EXPECT_FALSE(barrier.lastArrivalTime().has_value());
+  EXPECT_EQ(barrier.startTime(), scheduled_start);
+}
+
+TEST_F(WorkerStartBarrierTest, ResetAllowsWorkersToArriveAgain) {
+  WorkerStartBarrier barrier(time_system_, 1, 0ms, time_system_.monotonicTime() + 1s);
+  barrier.arriveAndWait(0);
+  barrier.reset(0ms);
+  EXPECT_FALSE(barrier.firstArrivalTime().has_value());
+  EXPECT_FALSE(barrier.startTime().has_value());
+  time_system_.advanceTimeWait(5s);
+  EXPECT_EQ(barrier.arriveAndWait(0),
+            time_system_.monotonicTime() + WorkerStartBarrier::kStartMargin);
+}
+
+TEST_F(WorkerStartBarrierTest, ResetAppliesTheNewInterWorkerDelay) {
+  WorkerStartBarrier barrier(time_system_, 1, 10ms, absl::nullopt);
+  EXPECT_EQ(barrier.arriveAndWait(3),
+            time_system_.monotonicTime() + WorkerStartBarrier::kStartMargin + 30ms);
+  barrier.reset(1ms);
+  EXPECT_EQ(barrier.arriveAndWait(3),
+            time_system_.monotonicTime() + WorkerStartBarrier::kStartMargin + 3ms);
+}
+
+} // namespace Client
+} // namespace Nighthawk
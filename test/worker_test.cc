@@ -9,6 +9,7 @@
 
 #include "source/common/worker_impl.h"
 
+#include "absl/synchronization/notification.h"
 #include "gtest/gtest.h"
 
 using namespace testing;
@@ -22,10 +23,13 @@ public:
   void work() override {
     EXPECT_NE(thread_id_, std::this_thread::get_id());
     ran_ = true;
+    rounds_++;
   }
   void shutdownThread() override {}
+  Envoy::Event::Dispatcher& dispatcher() { return *dispatcher_; }
 
   bool ran_{};
+  int rounds_{};
   Envoy::Stats::IsolatedStoreImpl test_store_;
   std::thread::id thread_id_;
 };
@@ -63,4 +67,35 @@ TEST_F(WorkerTest, WorkerExecutesOnThread) {
   worker.shutdown();
 }
 
+TEST_F(WorkerTest, WorkerExecutesMultipleRoundsOnThread) {
+  EXPECT_CALL(tls_, registerThread(_, false));
+  TestWorker worker(*api_, tls_);
+  worker.start();
+  worker.waitForCompletion();
+  EXPECT_EQ(worker.rounds_, 1);
+  worker.startNextRound();
+  worker.waitForCompletion();
+  EXPECT_EQ(worker.rounds_, 2);
+  EXPECT_CALL(tls_, shutdownThread());
+  worker.shutdown();
+  EXPECT_EQ(worker.rounds_, 2);
+}
+
+TEST_F(WorkerTest, WorkerDispatchesWhileIdle) {
+  EXPECT_CALL(tls_, registerThread(_, false));
+  TestWorker worker(*api_, tls_);
+  worker.start();
+  worker.waitForCompletion();
+  worker.dispatchWhileIdle();
+  absl::Notification dispatched;
+  worker.dispatcher().post([&dispatched]() { dispatched.Notify(); });
+  EXPECT_TRUE(dispatched.WaitForNotificationWithTimeout(absl::Seconds(30)));
+  // The next round wakes the worker up.
+  worker.startNextRound();
+  worker.waitForCompletion();
+  EXPECT_EQ(worker.rounds_, 2);
+  EXPECT_CALL(tls_, shutdownThread());
+  worker.shutdown();
+}
+
 } // namespace Nighthawk